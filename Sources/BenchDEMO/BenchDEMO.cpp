@@ -0,0 +1,150 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+// BenchDEMO - Headless Demo Playback Benchmark
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Engine/Engine.h>
+#include <Engine/Network/DemoBenchmark.h>
+
+// Command line arguments
+static CTString _strDemo;
+static CTString _strJSON;
+static CTString _strCSV;
+static FLOAT _fFPS = 0.0f; // Tick rate by default
+static INDEX _ctFrames = 0;
+static PIX _pixWidth = 0;
+static PIX _pixHeight = 0;
+
+// Parsed arguments
+static INDEX _ctParsedArgs = 0;
+
+// Handle program's launch arguments
+static void HandleInitialArgs(const CommandLineArgs_t &aArgs) {
+  _ctParsedArgs = aArgs.Count();
+  _strDemo = aArgs[0];
+};
+
+static void HandleJSON(const CommandLineArgs_t &aArgs) {
+  _strJSON = aArgs[0];
+};
+
+static void HandleCSV(const CommandLineArgs_t &aArgs) {
+  _strCSV = aArgs[0];
+};
+
+static void HandleFPS(const CommandLineArgs_t &aArgs) {
+  _fFPS = Clamp((FLOAT)atof(aArgs[0].ConstData()), 1.0f, 1000.0f);
+};
+
+static void HandleFrames(const CommandLineArgs_t &aArgs) {
+  _ctFrames = ClampDn(atoi(aArgs[0].ConstData()), 0);
+};
+
+static void HandleSize(const CommandLineArgs_t &aArgs) {
+  _pixWidth = Clamp(atoi(aArgs[0].ConstData()), 1, 8192);
+  _pixHeight = Clamp(atoi(aArgs[1].ConstData()), 1, 8192);
+};
+
+void SubMain(int argc, char **argv) {
+  // Parse command line arguments
+  {
+    CommandLineSetup cmd(argc, argv);
+    cmd.AddInitialParser(&HandleInitialArgs, 1);
+    cmd.AddCommand("-json", &HandleJSON, 1);
+    cmd.AddCommand("-csv", &HandleCSV, 1);
+    cmd.AddCommand("-fps", &HandleFPS, 1);
+    cmd.AddCommand("-frames", &HandleFrames, 1);
+    cmd.AddCommand("-size", &HandleSize, 2);
+    SE_ParseCommandLine(cmd);
+  }
+
+  printf("\nBenchDEMO - Headless Demo Playback Benchmark\n\n");
+
+  // Command line output in the console
+  printf("%s", SE_CommandLineOutput().ConstData());
+
+  if (_ctParsedArgs != 1)
+  {
+    printf("USAGE: BenchDEMO <demo> [-json <file>] [-csv <file>] [-fps <rate>] [-frames <count>] [-size <width> <height>]\n");
+    printf("\n");
+    printf("demo: demo file relative to the game directory\n");
+    printf("-json: write summary and times of all frames into a JSON file\n");
+    printf("-csv: write times of all frames into a CSV file\n");
+    printf("-fps: frames per one second of demo time (game tick rate by default)\n");
+    printf("-frames: stop after this many frames instead of at the end of the demo\n");
+    printf("-size: size of the rendered view (1280x720 by default)\n");
+    printf("\n");
+    printf("NOTES: - the demo is played at a fixed step instead of real time, so each run plays the same frames\n");
+    printf("       - every frame is rendered from the first player's view without a graphics API,\n");
+    printf("         so only CPU time of the engine is measured\n");
+    printf("       - frame times are split into network, physics (game ticks), render and sound,\n");
+    printf("         with min/avg/p99/max of each one\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // Initialize engine
+  SeriousEngineSetup se1setup("BenchDEMO");
+  se1setup.eAppType = SeriousEngineSetup::E_OTHER;
+  SE_InitEngine(se1setup);
+
+  CDemoBenchmark db;
+  if (_fFPS > 0.0f) db.db_fFPS = _fFPS;
+  if (_pixWidth > 0) db.db_pixWidth = _pixWidth;
+  if (_pixHeight > 0) db.db_pixHeight = _pixHeight;
+  db.db_ctMaxFrames = _ctFrames;
+
+  printf("- Playing '%s' at %.1f FPS in %dx%d.\n", _strDemo.ConstData(), db.db_fFPS, db.db_pixWidth, db.db_pixHeight);
+
+  try {
+    db.Run_t(_strDemo);
+
+  } catch (char *strError) {
+    printf("! Cannot play the demo:\n  %s\n", strError);
+    exit(EXIT_FAILURE);
+  }
+
+  printf("\n%s\n", db.GetSummary().ConstData());
+
+  try {
+    if (_strJSON != "") {
+      db.WriteJSON_t(_strJSON);
+      printf("- Saved '%s'\n", _strJSON.ConstData());
+    }
+
+    if (_strCSV != "") {
+      db.WriteCSV_t(_strCSV);
+      printf("- Saved '%s'\n", _strCSV.ConstData());
+    }
+
+  } catch (char *strError) {
+    printf("! Cannot save the results:\n  %s\n", strError);
+    exit(EXIT_FAILURE);
+  }
+
+  exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char **argv) {
+  CTSTREAM_BEGIN {
+    SubMain(argc, argv);
+  } CTSTREAM_END;
+
+  return 0;
+}
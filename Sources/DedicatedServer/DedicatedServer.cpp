@@ -15,6 +15,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include "StdAfx.h"
 #include <Game/Game.h>
+#include <Engine/Network/TickTrace.h> // [Cecil]
 
 #if SE1_UNIX
   #include <signal.h>
@@ -365,6 +366,9 @@ void RoundEnd(void)
 // do the main game loop and render screen
 void DoGame(void)
 {
+  // [Cecil] Trace the frame without the frame rate limit
+  const CTimerValue tvTrace = TickTrace_Begin();
+
 #if SE1_SINGLE_THREAD
   // [Cecil] Run timer logic in the same thread
   _pTimer->HandleTimerHandlers();
@@ -405,6 +409,8 @@ void DoGame(void)
     _pNetwork->GameInactive();
   }
 
+  TickTrace_End(TTE_SERVERFRAME, tvTrace); // [Cecil]
+
   // limit current frame rate if needed
   LimitFrameRate();
 }
@@ -0,0 +1,1137 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "StdH.h"
+
+#include <Engine/Base/SIMDKernels.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Graphics/TextureEffects.h>
+#include <Engine/Math/Functions.h>
+#include <Engine/Sound/SoundLibrary.h>
+
+#if SE1_SIMD_SSE2
+  #include <emmintrin.h>
+#elif SE1_SIMD_NEON
+  #include <arm_neon.h>
+#endif
+
+// Use vector kernels when the CPU supports them
+INDEX sys_bSIMDKernels = TRUE;
+
+// CPU supports the instruction set that the kernels have been compiled with
+static BOOL _bSIMDSupported = FALSE;
+
+// Check if vector kernels are supported by the CPU and enabled
+BOOL UseSIMDKernels(void) {
+  return _bSIMDSupported && sys_bSIMDKernels;
+};
+
+// Convert samples
+
+static void ConvertSamples_Scalar(const SLONG *pslSrc, SWORD *pswDst, INDEX ctSamples) {
+  for (INDEX i = 0; i < ctSamples; i++) {
+    pswDst[i] = (SWORD)Clamp(pslSrc[i], (SLONG)-32767, (SLONG)32767);
+  }
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+static void ConvertSamples_SIMD(const SLONG *pslSrc, SWORD *pswDst, INDEX ctSamples) {
+  INDEX i = 0;
+
+#if SE1_SIMD_SSE2
+  const __m128i mMin = _mm_set1_epi16(-32767);
+
+  for (; i + 8 <= ctSamples; i += 8) {
+    // Load both halves before storing in case the buffers overlap
+    __m128i m0 = _mm_loadu_si128((const __m128i *)(pslSrc + i));
+    __m128i m1 = _mm_loadu_si128((const __m128i *)(pslSrc + i + 4));
+
+    // Saturate into [-32768, 32767] and then raise the lower bound
+    __m128i mPacked = _mm_max_epi16(_mm_packs_epi32(m0, m1), mMin);
+    _mm_storeu_si128((__m128i *)(pswDst + i), mPacked);
+  }
+
+#else
+  const int16x8_t mMin = vdupq_n_s16(-32767);
+
+  for (; i + 8 <= ctSamples; i += 8) {
+    int32x4_t m0 = vld1q_s32((const int32_t *)(pslSrc + i));
+    int32x4_t m1 = vld1q_s32((const int32_t *)(pslSrc + i + 4));
+
+    int16x8_t mPacked = vmaxq_s16(vcombine_s16(vqmovn_s32(m0), vqmovn_s32(m1)), mMin);
+    vst1q_s16((int16_t *)(pswDst + i), mPacked);
+  }
+#endif
+
+  // Remaining samples
+  ConvertSamples_Scalar(pslSrc + i, pswDst + i, ctSamples - i);
+};
+
+#endif // SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+#if SE1_USE_ASM
+
+static void ConvertSamples_Asm(const SLONG *pslSrc, SWORD *pswDst, INDEX ctSamples) {
+  INDEX ctPairs = ctSamples / 2;
+
+  if (ctPairs > 0) {
+    __asm {
+      mov     esi,D [pslSrc]
+      mov     edi,D [pswDst]
+      mov     ecx,D [ctPairs]
+  copyLoop:
+      movq    mm0,Q [esi]
+      packssdw mm0,mm0
+      movd    D [edi],mm0
+      add     esi,8
+      add     edi,4
+      dec     ecx
+      jnz     copyLoop
+      emms
+    }
+  }
+
+  // MMX saturates to -32768, so clamp the same way as other paths
+  for (INDEX i = 0; i < ctPairs * 2; i++) {
+    if (pswDst[i] == -32768) pswDst[i] = -32767;
+  }
+
+  ConvertSamples_Scalar(pslSrc + ctPairs * 2, pswDst + ctPairs * 2, ctSamples - ctPairs * 2);
+};
+
+#endif // SE1_USE_ASM
+
+void Kernel_ConvertSamples(const SLONG *pslSrc, SWORD *pswDst, INDEX ctSamples) {
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  if (UseSIMDKernels()) {
+    ConvertSamples_SIMD(pslSrc, pswDst, ctSamples);
+    return;
+  }
+#endif
+
+#if SE1_USE_ASM
+  ConvertSamples_Asm(pslSrc, pswDst, ctSamples);
+#else
+  ConvertSamples_Scalar(pslSrc, pswDst, ctSamples);
+#endif
+};
+
+// Extract samples
+
+static void ExtractSamples_Scalar(const ULONG *pulSrc, UWORD *puwDst, INDEX ctSamples) {
+  for (INDEX i = 0; i < ctSamples; i++) {
+    puwDst[i] = (UWORD)(pulSrc[i] & 0xFFFF);
+  }
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+static void ExtractSamples_SIMD(const ULONG *pulSrc, UWORD *puwDst, INDEX ctSamples) {
+  INDEX i = 0;
+
+#if SE1_SIMD_SSE2
+  for (; i + 8 <= ctSamples; i += 8) {
+    __m128i m0 = _mm_loadu_si128((const __m128i *)(pulSrc + i));
+    __m128i m1 = _mm_loadu_si128((const __m128i *)(pulSrc + i + 4));
+
+    // Sign-extend lower halves, so that signed saturation keeps them intact
+    m0 = _mm_srai_epi32(_mm_slli_epi32(m0, 16), 16);
+    m1 = _mm_srai_epi32(_mm_slli_epi32(m1, 16), 16);
+    _mm_storeu_si128((__m128i *)(puwDst + i), _mm_packs_epi32(m0, m1));
+  }
+
+#else
+  for (; i + 8 <= ctSamples; i += 8) {
+    uint32x4_t m0 = vld1q_u32((const uint32_t *)(pulSrc + i));
+    uint32x4_t m1 = vld1q_u32((const uint32_t *)(pulSrc + i + 4));
+    vst1q_u16((uint16_t *)(puwDst + i), vcombine_u16(vmovn_u32(m0), vmovn_u32(m1)));
+  }
+#endif
+
+  ExtractSamples_Scalar(pulSrc + i, puwDst + i, ctSamples - i);
+};
+
+#endif // SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+#if SE1_USE_ASM
+
+static void ExtractSamples_Asm(const ULONG *pulSrc, UWORD *puwDst, INDEX ctSamples) {
+  if (ctSamples <= 0) return;
+
+  __asm {
+    mov     esi,D [pulSrc]
+    mov     edi,D [puwDst]
+    mov     ecx,D [ctSamples]
+copyLoop:
+    movzx   eax,W [esi]
+    mov     W [edi],ax
+    add     esi,4
+    add     edi,2
+    dec     ecx
+    jnz     copyLoop
+  }
+};
+
+#endif // SE1_USE_ASM
+
+void Kernel_ExtractSamples(const ULONG *pulSrc, UWORD *puwDst, INDEX ctSamples) {
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  if (UseSIMDKernels()) {
+    ExtractSamples_SIMD(pulSrc, puwDst, ctSamples);
+    return;
+  }
+#endif
+
+#if SE1_USE_ASM
+  ExtractSamples_Asm(pulSrc, puwDst, ctSamples);
+#else
+  ExtractSamples_Scalar(pulSrc, puwDst, ctSamples);
+#endif
+};
+
+// Downsample bitmap
+
+// Average one 2x2 block of texels
+static inline void AverageTexelBlock(const UBYTE *pubUp, const UBYTE *pubDown, UBYTE *pubDst) {
+  for (INDEX iCh = 0; iCh < 4; iCh++) {
+    UWORD uwSum = pubUp[iCh] + pubUp[iCh + 4] + pubDown[iCh] + pubDown[iCh + 4] + 2;
+    pubDst[iCh] = UBYTE(uwSum >> 2);
+  }
+};
+
+static void DownsampleBilinear_Scalar(const ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight) {
+  for (PIX pixY = 0; pixY < pixHeight; pixY++) {
+    const ULONG *pulUp = pulSrc + pixY * pixWidth * 4;
+    const ULONG *pulDown = pulUp + pixWidth * 2;
+    ULONG *pulRow = pulDst + pixY * pixWidth;
+
+    for (PIX pixX = 0; pixX < pixWidth; pixX++) {
+      AverageTexelBlock((const UBYTE *)(pulUp + pixX * 2), (const UBYTE *)(pulDown + pixX * 2), (UBYTE *)(pulRow + pixX));
+    }
+  }
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+static void DownsampleBilinear_SIMD(const ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight) {
+  for (PIX pixY = 0; pixY < pixHeight; pixY++) {
+    const ULONG *pulUp = pulSrc + pixY * pixWidth * 4;
+    const ULONG *pulDown = pulUp + pixWidth * 2;
+    ULONG *pulRow = pulDst + pixY * pixWidth;
+    PIX pixX = 0;
+
+  #if SE1_SIMD_SSE2
+    const __m128i mZero = _mm_setzero_si128();
+    const __m128i mRounder = _mm_set1_epi16(2);
+
+    // Two destination texels at a time
+    for (; pixX + 2 <= pixWidth; pixX += 2) {
+      __m128i mUp   = _mm_loadu_si128((const __m128i *)(pulUp   + pixX * 2));
+      __m128i mDown = _mm_loadu_si128((const __m128i *)(pulDown + pixX * 2));
+
+      // Sum columns of source texels
+      __m128i mLo = _mm_add_epi16(_mm_unpacklo_epi8(mUp, mZero), _mm_unpacklo_epi8(mDown, mZero));
+      __m128i mHi = _mm_add_epi16(_mm_unpackhi_epi8(mUp, mZero), _mm_unpackhi_epi8(mDown, mZero));
+
+      // Sum neighbouring columns
+      mLo = _mm_add_epi16(mLo, _mm_srli_si128(mLo, 8));
+      mHi = _mm_add_epi16(mHi, _mm_srli_si128(mHi, 8));
+
+      __m128i mSum = _mm_unpacklo_epi64(mLo, mHi);
+      mSum = _mm_srli_epi16(_mm_add_epi16(mSum, mRounder), 2);
+      _mm_storel_epi64((__m128i *)(pulRow + pixX), _mm_packus_epi16(mSum, mZero));
+    }
+
+  #else
+    const uint16x8_t mRounder = vdupq_n_u16(2);
+
+    for (; pixX + 2 <= pixWidth; pixX += 2) {
+      uint8x16_t mUp   = vld1q_u8((const uint8_t *)(pulUp   + pixX * 2));
+      uint8x16_t mDown = vld1q_u8((const uint8_t *)(pulDown + pixX * 2));
+
+      uint16x8_t mLo = vaddl_u8(vget_low_u8(mUp),  vget_low_u8(mDown));
+      uint16x8_t mHi = vaddl_u8(vget_high_u8(mUp), vget_high_u8(mDown));
+
+      uint16x4_t mTexel0 = vadd_u16(vget_low_u16(mLo), vget_high_u16(mLo));
+      uint16x4_t mTexel1 = vadd_u16(vget_low_u16(mHi), vget_high_u16(mHi));
+
+      uint16x8_t mSum = vshrq_n_u16(vaddq_u16(vcombine_u16(mTexel0, mTexel1), mRounder), 2);
+      vst1_u8((uint8_t *)(pulRow + pixX), vmovn_u16(mSum));
+    }
+  #endif
+
+    // Remaining texel
+    if (pixX < pixWidth) {
+      AverageTexelBlock((const UBYTE *)(pulUp + pixX * 2), (const UBYTE *)(pulDown + pixX * 2), (UBYTE *)(pulRow + pixX));
+    }
+  }
+};
+
+#endif // SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+#if SE1_USE_ASM
+
+static SQUAD mmRounder = 0x0002000200020002;
+
+static void DownsampleBilinear_Asm(const ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight) {
+  __asm {
+    pxor    mm0,mm0
+    mov     ebx,D [pixWidth]
+    mov     esi,D [pulSrc]
+    mov     edi,D [pulDst]
+    mov     edx,D [pixHeight]
+rowLoop:
+    mov     ecx,D [pixWidth]
+pixLoopN:
+    movd    mm1,D [esi+ 0]        // up-left
+    movd    mm2,D [esi+ 4]        // up-right
+    movd    mm3,D [esi+ ebx*8 +0] // down-left
+    movd    mm4,D [esi+ ebx*8 +4] // down-right
+    punpcklbw mm1,mm0
+    punpcklbw mm2,mm0
+    punpcklbw mm3,mm0
+    punpcklbw mm4,mm0
+    paddw   mm1,mm2
+    paddw   mm1,mm3
+    paddw   mm1,mm4
+    paddw   mm1,Q [mmRounder]
+    psrlw   mm1,2
+    packuswb mm1,mm0
+    movd    D [edi],mm1
+    // advance to next pixel
+    add     esi,4*2
+    add     edi,4
+    dec     ecx
+    jnz     pixLoopN
+    // advance to next row
+    lea     esi,[esi+ ebx*8] // skip one row in source mip-map
+    dec     edx
+    jnz     rowLoop
+    emms
+  }
+};
+
+#endif // SE1_USE_ASM
+
+void Kernel_DownsampleBilinear(const ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight) {
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  if (UseSIMDKernels()) {
+    DownsampleBilinear_SIMD(pulSrc, pulDst, pixWidth, pixHeight);
+    return;
+  }
+#endif
+
+#if SE1_USE_ASM
+  DownsampleBilinear_Asm(pulSrc, pulDst, pixWidth, pixHeight);
+#else
+  DownsampleBilinear_Scalar(pulSrc, pulDst, pixWidth, pixHeight);
+#endif
+};
+
+// Accumulate samples
+
+static void AccumulateSamples_Scalar(FLOAT *pfDst, const SLONG *pslSrc, INDEX ctSamples) {
+  for (INDEX i = 0; i < ctSamples; i++) {
+    pfDst[i] += (FLOAT)pslSrc[i];
+  }
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+static void AccumulateSamples_SIMD(FLOAT *pfDst, const SLONG *pslSrc, INDEX ctSamples) {
+  INDEX i = 0;
+
+#if SE1_SIMD_SSE2
+  for (; i + 4 <= ctSamples; i += 4) {
+    __m128 mSrc = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(pslSrc + i)));
+    _mm_storeu_ps(pfDst + i, _mm_add_ps(_mm_loadu_ps(pfDst + i), mSrc));
+  }
+
+#else
+  for (; i + 4 <= ctSamples; i += 4) {
+    float32x4_t mSrc = vcvtq_f32_s32(vld1q_s32((const int32_t *)(pslSrc + i)));
+    vst1q_f32(pfDst + i, vaddq_f32(vld1q_f32(pfDst + i), mSrc));
+  }
+#endif
+
+  AccumulateSamples_Scalar(pfDst + i, pslSrc + i, ctSamples - i);
+};
+
+#endif // SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+void Kernel_AccumulateSamples(FLOAT *pfDst, const SLONG *pslSrc, INDEX ctSamples) {
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  if (UseSIMDKernels()) {
+    AccumulateSamples_SIMD(pfDst, pslSrc, ctSamples);
+    return;
+  }
+#endif
+
+  AccumulateSamples_Scalar(pfDst, pslSrc, ctSamples);
+};
+
+// Find peak sample
+
+static FLOAT FindPeak_Scalar(const FLOAT *pfSrc, INDEX ctSamples) {
+  FLOAT fPeak = 0.0f;
+
+  for (INDEX i = 0; i < ctSamples; i++) {
+    fPeak = Max(fPeak, Abs(pfSrc[i]));
+  }
+
+  return fPeak;
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+static FLOAT FindPeak_SIMD(const FLOAT *pfSrc, INDEX ctSamples) {
+  INDEX i = 0;
+  FLOAT afPeaks[4];
+
+#if SE1_SIMD_SSE2
+  // Clear sign bits to get absolute values
+  const __m128 mAbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+  __m128 mPeak = _mm_setzero_ps();
+
+  for (; i + 4 <= ctSamples; i += 4) {
+    mPeak = _mm_max_ps(mPeak, _mm_and_ps(_mm_loadu_ps(pfSrc + i), mAbsMask));
+  }
+
+  _mm_storeu_ps(afPeaks, mPeak);
+
+#else
+  float32x4_t mPeak = vdupq_n_f32(0.0f);
+
+  for (; i + 4 <= ctSamples; i += 4) {
+    mPeak = vmaxq_f32(mPeak, vabsq_f32(vld1q_f32(pfSrc + i)));
+  }
+
+  vst1q_f32(afPeaks, mPeak);
+#endif
+
+  const FLOAT fPeak = Max(Max(afPeaks[0], afPeaks[1]), Max(afPeaks[2], afPeaks[3]));
+  return Max(fPeak, FindPeak_Scalar(pfSrc + i, ctSamples - i));
+};
+
+#endif // SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+FLOAT Kernel_FindPeak(const FLOAT *pfSrc, INDEX ctSamples) {
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  if (UseSIMDKernels()) {
+    return FindPeak_SIMD(pfSrc, ctSamples);
+  }
+#endif
+
+  return FindPeak_Scalar(pfSrc, ctSamples);
+};
+
+// Convert float samples
+
+// Gain of a specific sample while it's being interpolated towards the target
+static inline FLOAT InterpolatedGain(FLOAT fGain, FLOAT fGainStep, FLOAT fGainTarget, INDEX iSample) {
+  const FLOAT fCurrent = fGain + fGainStep * iSample;
+
+  if (fGainStep < 0.0f) return Max(fCurrent, fGainTarget);
+  if (fGainStep > 0.0f) return Min(fCurrent, fGainTarget);
+  return fGain;
+};
+
+static void ConvertFloatSamples_Scalar(const FLOAT *pfSrc, SWORD *pswDst, INDEX iFirst, INDEX ctSamples,
+  FLOAT fGain, FLOAT fGainStep, FLOAT fGainTarget)
+{
+  for (INDEX i = iFirst; i < ctSamples; i++) {
+    const SLONG slSample = FloatToInt(pfSrc[i] * InterpolatedGain(fGain, fGainStep, fGainTarget, i));
+    pswDst[i] = (SWORD)Clamp(slSample, (SLONG)-32767, (SLONG)32767);
+  }
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+static void ConvertFloatSamples_SIMD(const FLOAT *pfSrc, SWORD *pswDst, INDEX ctSamples,
+  FLOAT fGain, FLOAT fGainStep, FLOAT fGainTarget)
+{
+  INDEX i = 0;
+
+  // Clamp gain from the opposite side if it isn't interpolated
+  const FLOAT fGainMin = (fGainStep < 0.0f ? fGainTarget : (fGainStep > 0.0f ? -1E30f : fGain));
+  const FLOAT fGainMax = (fGainStep > 0.0f ? fGainTarget : (fGainStep < 0.0f ? +1E30f : fGain));
+
+#if SE1_SIMD_SSE2
+  const __m128 mGainMin = _mm_set1_ps(fGainMin);
+  const __m128 mGainMax = _mm_set1_ps(fGainMax);
+  const __m128 mStep = _mm_set1_ps(fGainStep);
+  const __m128 mGain = _mm_set1_ps(fGain);
+  const __m128i mMin = _mm_set1_epi16(-32767);
+
+  for (; i + 8 <= ctSamples; i += 8) {
+    // Load both halves before storing in case the buffers overlap
+    __m128 m0 = _mm_loadu_ps(pfSrc + i);
+    __m128 m1 = _mm_loadu_ps(pfSrc + i + 4);
+
+    const __m128 mIndex0 = _mm_set_ps(FLOAT(i + 3), FLOAT(i + 2), FLOAT(i + 1), FLOAT(i));
+    const __m128 mIndex1 = _mm_add_ps(mIndex0, _mm_set1_ps(4.0f));
+
+    __m128 mGain0 = _mm_min_ps(_mm_max_ps(_mm_add_ps(mGain, _mm_mul_ps(mStep, mIndex0)), mGainMin), mGainMax);
+    __m128 mGain1 = _mm_min_ps(_mm_max_ps(_mm_add_ps(mGain, _mm_mul_ps(mStep, mIndex1)), mGainMin), mGainMax);
+
+    __m128i mInt0 = _mm_cvtps_epi32(_mm_mul_ps(m0, mGain0));
+    __m128i mInt1 = _mm_cvtps_epi32(_mm_mul_ps(m1, mGain1));
+
+    // Saturate into [-32768, 32767] and then raise the lower bound
+    _mm_storeu_si128((__m128i *)(pswDst + i), _mm_max_epi16(_mm_packs_epi32(mInt0, mInt1), mMin));
+  }
+
+#else
+  const float32x4_t mGainMin = vdupq_n_f32(fGainMin);
+  const float32x4_t mGainMax = vdupq_n_f32(fGainMax);
+  const float32x4_t mStep = vdupq_n_f32(fGainStep);
+  const float32x4_t mGain = vdupq_n_f32(fGain);
+  const int16x8_t mMin = vdupq_n_s16(-32767);
+  const FLOAT afIndex[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+  const float32x4_t mIndexOffsets = vld1q_f32(afIndex);
+  const float32x4_t mZero = vdupq_n_f32(0.0f);
+  const float32x4_t mHalfPos = vdupq_n_f32(+0.5f);
+  const float32x4_t mHalfNeg = vdupq_n_f32(-0.5f);
+
+  for (; i + 8 <= ctSamples; i += 8) {
+    float32x4_t m0 = vld1q_f32(pfSrc + i);
+    float32x4_t m1 = vld1q_f32(pfSrc + i + 4);
+
+    const float32x4_t mIndex0 = vaddq_f32(vdupq_n_f32(FLOAT(i)), mIndexOffsets);
+    const float32x4_t mIndex1 = vaddq_f32(mIndex0, vdupq_n_f32(4.0f));
+
+    float32x4_t mGain0 = vminq_f32(vmaxq_f32(vmlaq_f32(mGain, mStep, mIndex0), mGainMin), mGainMax);
+    float32x4_t mGain1 = vminq_f32(vmaxq_f32(vmlaq_f32(mGain, mStep, mIndex1), mGainMin), mGainMax);
+
+    m0 = vmulq_f32(m0, mGain0);
+    m1 = vmulq_f32(m1, mGain1);
+
+    // Round to the nearest by adding/subtracting 0.5
+    int32x4_t mInt0 = vcvtq_s32_f32(vaddq_f32(m0, vbslq_f32(vcltq_f32(m0, mZero), mHalfNeg, mHalfPos)));
+    int32x4_t mInt1 = vcvtq_s32_f32(vaddq_f32(m1, vbslq_f32(vcltq_f32(m1, mZero), mHalfNeg, mHalfPos)));
+
+    vst1q_s16((int16_t *)(pswDst + i), vmaxq_s16(vcombine_s16(vqmovn_s32(mInt0), vqmovn_s32(mInt1)), mMin));
+  }
+#endif
+
+  ConvertFloatSamples_Scalar(pfSrc, pswDst, i, ctSamples, fGain, fGainStep, fGainTarget);
+};
+
+#endif // SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+void Kernel_ConvertFloatSamples(const FLOAT *pfSrc, SWORD *pswDst, INDEX ctSamples, FLOAT fGain, FLOAT fGainStep, FLOAT fGainTarget) {
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  if (UseSIMDKernels()) {
+    ConvertFloatSamples_SIMD(pfSrc, pswDst, ctSamples, fGain, fGainStep, fGainTarget);
+    return;
+  }
+#endif
+
+  ConvertFloatSamples_Scalar(pfSrc, pswDst, 0, ctSamples, fGain, fGainStep, fGainTarget);
+};
+
+// Animate water height map
+
+static void AnimateWater_Scalar(const SWORD *pswOld, SWORD *pswNew, PIX pixStride, INDEX ctPixels, SLONG slDensity) {
+  for (INDEX i = 0; i < ctPixels; i++) {
+    const SLONG slNew = (((SLONG)pswOld[i - pixStride] + (SLONG)pswOld[i + pixStride]
+                        + (SLONG)pswOld[i - 1] + (SLONG)pswOld[i + 1]) >> 1) - (SLONG)pswNew[i];
+    pswNew[i] = slNew - (slNew >> slDensity);
+  }
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+#if SE1_SIMD_SSE2
+// Sign-extend lower or upper four 16-bit values into 32-bit values
+#define WIDEN_LO(m) _mm_srai_epi32(_mm_unpacklo_epi16(m, m), 16)
+#define WIDEN_HI(m) _mm_srai_epi32(_mm_unpackhi_epi16(m, m), 16)
+#endif
+
+static void AnimateWater_SIMD(const SWORD *pswOld, SWORD *pswNew, PIX pixStride, INDEX ctPixels, SLONG slDensity) {
+  INDEX i = 0;
+
+#if SE1_SIMD_SSE2
+  const __m128i mDensity = _mm_cvtsi32_si128(slDensity);
+
+  for (; i + 8 <= ctPixels; i += 8) {
+    const __m128i mAbove = _mm_loadu_si128((const __m128i *)(pswOld + i - pixStride));
+    const __m128i mBelow = _mm_loadu_si128((const __m128i *)(pswOld + i + pixStride));
+    const __m128i mLeft  = _mm_loadu_si128((const __m128i *)(pswOld + i - 1));
+    const __m128i mRight = _mm_loadu_si128((const __m128i *)(pswOld + i + 1));
+    const __m128i mCur   = _mm_loadu_si128((const __m128i *)(pswNew + i));
+
+    __m128i mLo = _mm_add_epi32(_mm_add_epi32(WIDEN_LO(mAbove), WIDEN_LO(mBelow)), _mm_add_epi32(WIDEN_LO(mLeft), WIDEN_LO(mRight)));
+    __m128i mHi = _mm_add_epi32(_mm_add_epi32(WIDEN_HI(mAbove), WIDEN_HI(mBelow)), _mm_add_epi32(WIDEN_HI(mLeft), WIDEN_HI(mRight)));
+    mLo = _mm_sub_epi32(_mm_srai_epi32(mLo, 1), WIDEN_LO(mCur));
+    mHi = _mm_sub_epi32(_mm_srai_epi32(mHi, 1), WIDEN_HI(mCur));
+    mLo = _mm_sub_epi32(mLo, _mm_sra_epi32(mLo, mDensity));
+    mHi = _mm_sub_epi32(mHi, _mm_sra_epi32(mHi, mDensity));
+
+    // Truncate to 16 bits before packing to avoid saturation
+    mLo = _mm_srai_epi32(_mm_slli_epi32(mLo, 16), 16);
+    mHi = _mm_srai_epi32(_mm_slli_epi32(mHi, 16), 16);
+    _mm_storeu_si128((__m128i *)(pswNew + i), _mm_packs_epi32(mLo, mHi));
+  }
+
+#else
+  const int32x4_t mDensity = vdupq_n_s32(-slDensity);
+
+  for (; i + 4 <= ctPixels; i += 4) {
+    int32x4_t mNew = vaddq_s32(vaddq_s32(vmovl_s16(vld1_s16(pswOld + i - pixStride)), vmovl_s16(vld1_s16(pswOld + i + pixStride))),
+                               vaddq_s32(vmovl_s16(vld1_s16(pswOld + i - 1)),         vmovl_s16(vld1_s16(pswOld + i + 1))));
+    mNew = vsubq_s32(vshrq_n_s32(mNew, 1), vmovl_s16(vld1_s16(pswNew + i)));
+    mNew = vsubq_s32(mNew, vshlq_s32(mNew, mDensity));
+    vst1_s16(pswNew + i, vmovn_s32(mNew));
+  }
+#endif
+
+  AnimateWater_Scalar(pswOld + i, pswNew + i, pixStride, ctPixels - i, slDensity);
+};
+
+#endif // SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+void Kernel_AnimateWater(const SWORD *pswOld, SWORD *pswNew, PIX pixStride, INDEX ctPixels, SLONG slDensity) {
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  if (UseSIMDKernels()) {
+    AnimateWater_SIMD(pswOld, pswNew, pixStride, ctPixels, slDensity);
+    return;
+  }
+#endif
+
+  AnimateWater_Scalar(pswOld, pswNew, pixStride, ctPixels, slDensity);
+};
+
+// Animate plasma intensity map
+
+static void AnimatePlasma_Scalar(const UBYTE *pubOld, UBYTE *pubNew, PIX pixStride, INDEX ctPixels, SLONG slDensity) {
+  for (INDEX i = 0; i < ctPixels; i++) {
+    const ULONG ulNew = ((((ULONG)pubOld[i - pixStride] + (ULONG)pubOld[i + pixStride]
+                         + (ULONG)pubOld[i - 1] + (ULONG)pubOld[i + 1]) >> 2) + (ULONG)pubOld[i]) >> 1;
+    pubNew[i] = ulNew - (ulNew >> slDensity);
+  }
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+static void AnimatePlasma_SIMD(const UBYTE *pubOld, UBYTE *pubNew, PIX pixStride, INDEX ctPixels, SLONG slDensity) {
+  INDEX i = 0;
+
+#if SE1_SIMD_SSE2
+  const __m128i mZero = _mm_setzero_si128();
+  const __m128i mDensity = _mm_cvtsi32_si128(slDensity);
+
+  for (; i + 16 <= ctPixels; i += 16) {
+    const __m128i mAbove = _mm_loadu_si128((const __m128i *)(pubOld + i - pixStride));
+    const __m128i mBelow = _mm_loadu_si128((const __m128i *)(pubOld + i + pixStride));
+    const __m128i mLeft  = _mm_loadu_si128((const __m128i *)(pubOld + i - 1));
+    const __m128i mRight = _mm_loadu_si128((const __m128i *)(pubOld + i + 1));
+    const __m128i mMid   = _mm_loadu_si128((const __m128i *)(pubOld + i));
+
+    __m128i mLo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(mAbove, mZero), _mm_unpacklo_epi8(mBelow, mZero)),
+                                _mm_add_epi16(_mm_unpacklo_epi8(mLeft,  mZero), _mm_unpacklo_epi8(mRight, mZero)));
+    __m128i mHi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(mAbove, mZero), _mm_unpackhi_epi8(mBelow, mZero)),
+                                _mm_add_epi16(_mm_unpackhi_epi8(mLeft,  mZero), _mm_unpackhi_epi8(mRight, mZero)));
+    mLo = _mm_srli_epi16(_mm_add_epi16(_mm_srli_epi16(mLo, 2), _mm_unpacklo_epi8(mMid, mZero)), 1);
+    mHi = _mm_srli_epi16(_mm_add_epi16(_mm_srli_epi16(mHi, 2), _mm_unpackhi_epi8(mMid, mZero)), 1);
+    mLo = _mm_sub_epi16(mLo, _mm_srl_epi16(mLo, mDensity));
+    mHi = _mm_sub_epi16(mHi, _mm_srl_epi16(mHi, mDensity));
+
+    _mm_storeu_si128((__m128i *)(pubNew + i), _mm_packus_epi16(mLo, mHi));
+  }
+
+#else
+  const int16x8_t mDensity = vdupq_n_s16(-slDensity);
+
+  for (; i + 8 <= ctPixels; i += 8) {
+    uint16x8_t mNew = vaddq_u16(vaddl_u8(vld1_u8(pubOld + i - pixStride), vld1_u8(pubOld + i + pixStride)),
+                                vaddl_u8(vld1_u8(pubOld + i - 1),         vld1_u8(pubOld + i + 1)));
+    mNew = vshrq_n_u16(vaddw_u8(vshrq_n_u16(mNew, 2), vld1_u8(pubOld + i)), 1);
+    mNew = vsubq_u16(mNew, vshlq_u16(mNew, mDensity));
+    vst1_u8(pubNew + i, vmovn_u16(mNew));
+  }
+#endif
+
+  AnimatePlasma_Scalar(pubOld + i, pubNew + i, pixStride, ctPixels - i, slDensity);
+};
+
+#endif // SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+void Kernel_AnimatePlasma(const UBYTE *pubOld, UBYTE *pubNew, PIX pixStride, INDEX ctPixels, SLONG slDensity) {
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  if (UseSIMDKernels()) {
+    AnimatePlasma_SIMD(pubOld, pubNew, pixStride, ctPixels, slDensity);
+    return;
+  }
+#endif
+
+  AnimatePlasma_Scalar(pubOld, pubNew, pixStride, ctPixels, slDensity);
+};
+
+// Filter bitmap row
+
+// Filter one texel of a row with its column neighbours clamped to the row edges
+static inline ULONG FilterTexel(const ULONG *pulAbove, const ULONG *pulRow, const ULONG *pulBelow,
+  PIX pixL, PIX pixX, PIX pixR, SWORD swCorner, SWORD swEdge, SWORD swMiddle, SWORD swInvDiv)
+{
+  ULONG ulResult = 0;
+
+  for (INDEX iCh = 0; iCh < 32; iCh += 8) {
+    #define CH(_pul, _pix) SLONG((_pul[_pix] >> iCh) & 0xFF)
+    const SLONG slCorners = CH(pulAbove, pixL) + CH(pulAbove, pixR) + CH(pulBelow, pixL) + CH(pulBelow, pixR);
+    const SLONG slEdges   = CH(pulAbove, pixX) + CH(pulBelow, pixX) + CH(pulRow,   pixL) + CH(pulRow,   pixR);
+    #undef CH
+
+    // Same wrapping and saturation as 16-bit vector arithmetic
+    SLONG slSum = SWORD(slCorners * swCorner + slEdges * swEdge + SLONG((pulRow[pixX] >> iCh) & 0xFF) * swMiddle);
+    slSum = Clamp(slSum + 7L, -32768L, 32767L);
+    slSum = (slSum * swInvDiv) >> 16;
+
+    ulResult |= ULONG(Clamp(slSum, 0L, 255L)) << iCh;
+  }
+
+  return ulResult;
+};
+
+static void FilterRow_Scalar(const ULONG *pulAbove, const ULONG *pulRow, const ULONG *pulBelow, ULONG *pulDst,
+  PIX pixFirst, PIX pixWidth, SWORD swCorner, SWORD swEdge, SWORD swMiddle, SWORD swInvDiv)
+{
+  for (PIX pixX = pixFirst; pixX < pixWidth; pixX++) {
+    const PIX pixL = ClampDn(pixX - 1, (PIX)0);
+    const PIX pixR = Min(pixX + 1, pixWidth - 1);
+    pulDst[pixX] = FilterTexel(pulAbove, pulRow, pulBelow, pixL, pixX, pixR, swCorner, swEdge, swMiddle, swInvDiv);
+  }
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+static void FilterRow_SIMD(const ULONG *pulAbove, const ULONG *pulRow, const ULONG *pulBelow, ULONG *pulDst,
+  PIX pixWidth, SWORD swCorner, SWORD swEdge, SWORD swMiddle, SWORD swInvDiv)
+{
+  // Left edge
+  pulDst[0] = FilterTexel(pulAbove, pulRow, pulBelow, 0, 0, Min((PIX)1, pixWidth - 1), swCorner, swEdge, swMiddle, swInvDiv);
+  PIX pixX = 1;
+
+#if SE1_SIMD_SSE2
+  const __m128i mZero = _mm_setzero_si128();
+  const __m128i mCorner = _mm_set1_epi16(swCorner);
+  const __m128i mEdge   = _mm_set1_epi16(swEdge);
+  const __m128i mMiddle = _mm_set1_epi16(swMiddle);
+  const __m128i mInvDiv = _mm_set1_epi16(swInvDiv);
+  const __m128i mAdd    = _mm_set1_epi16(7);
+
+  // Four texels at a time without touching the right edge
+  for (; pixX + 5 <= pixWidth; pixX += 4) {
+    #define LOAD(_pul, _iOffset) _mm_loadu_si128((const __m128i *)(_pul + pixX + _iOffset))
+    const __m128i mAL = LOAD(pulAbove, -1), mAC = LOAD(pulAbove, 0), mAR = LOAD(pulAbove, 1);
+    const __m128i mRL = LOAD(pulRow,   -1), mRC = LOAD(pulRow,   0), mRR = LOAD(pulRow,   1);
+    const __m128i mBL = LOAD(pulBelow, -1), mBC = LOAD(pulBelow, 0), mBR = LOAD(pulBelow, 1);
+    #undef LOAD
+
+    #define FILTER_HALF(_Unpack) _mm_mulhi_epi16(_mm_adds_epi16(_mm_add_epi16(_mm_add_epi16( \
+      _mm_mullo_epi16(_mm_add_epi16(_mm_add_epi16(_Unpack(mAL, mZero), _Unpack(mAR, mZero)), \
+                                    _mm_add_epi16(_Unpack(mBL, mZero), _Unpack(mBR, mZero))), mCorner), \
+      _mm_mullo_epi16(_mm_add_epi16(_mm_add_epi16(_Unpack(mAC, mZero), _Unpack(mBC, mZero)), \
+                                    _mm_add_epi16(_Unpack(mRL, mZero), _Unpack(mRR, mZero))), mEdge)), \
+      _mm_mullo_epi16(_Unpack(mRC, mZero), mMiddle)), mAdd), mInvDiv)
+
+    const __m128i mLo = FILTER_HALF(_mm_unpacklo_epi8);
+    const __m128i mHi = FILTER_HALF(_mm_unpackhi_epi8);
+    #undef FILTER_HALF
+
+    _mm_storeu_si128((__m128i *)(pulDst + pixX), _mm_packus_epi16(mLo, mHi));
+  }
+
+#else
+  const int16x8_t mCorner = vdupq_n_s16(swCorner);
+  const int16x8_t mEdge   = vdupq_n_s16(swEdge);
+  const int16x8_t mMiddle = vdupq_n_s16(swMiddle);
+  const int16x4_t mInvDiv = vdup_n_s16(swInvDiv);
+  const int16x8_t mAdd    = vdupq_n_s16(7);
+
+  // Two texels at a time without touching the right edge
+  for (; pixX + 3 <= pixWidth; pixX += 2) {
+    #define LOAD(_pul, _iOffset) vld1_u8((const uint8_t *)(_pul + pixX + _iOffset))
+    const int16x8_t mCorners = vreinterpretq_s16_u16(vaddq_u16(vaddl_u8(LOAD(pulAbove, -1), LOAD(pulAbove, 1)),
+                                                               vaddl_u8(LOAD(pulBelow, -1), LOAD(pulBelow, 1))));
+    const int16x8_t mEdges   = vreinterpretq_s16_u16(vaddq_u16(vaddl_u8(LOAD(pulAbove,  0), LOAD(pulBelow, 0)),
+                                                               vaddl_u8(LOAD(pulRow,   -1), LOAD(pulRow,   1))));
+    const int16x8_t mMid     = vreinterpretq_s16_u16(vmovl_u8(LOAD(pulRow, 0)));
+    #undef LOAD
+
+    int16x8_t mSum = vaddq_s16(vaddq_s16(vmulq_s16(mCorners, mCorner), vmulq_s16(mEdges, mEdge)), vmulq_s16(mMid, mMiddle));
+    mSum = vqaddq_s16(mSum, mAdd);
+    mSum = vcombine_s16(vshrn_n_s32(vmull_s16(vget_low_s16(mSum), mInvDiv), 16),
+                        vshrn_n_s32(vmull_s16(vget_high_s16(mSum), mInvDiv), 16));
+
+    vst1_u8((uint8_t *)(pulDst + pixX), vqmovun_s16(mSum));
+  }
+#endif
+
+  // Remaining texels and the right edge
+  FilterRow_Scalar(pulAbove, pulRow, pulBelow, pulDst, pixX, pixWidth, swCorner, swEdge, swMiddle, swInvDiv);
+};
+
+#endif // SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+void Kernel_FilterRow(const ULONG *pulAbove, const ULONG *pulRow, const ULONG *pulBelow, ULONG *pulDst,
+  PIX pixWidth, SWORD swCorner, SWORD swEdge, SWORD swMiddle, SWORD swInvDiv)
+{
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  if (UseSIMDKernels()) {
+    FilterRow_SIMD(pulAbove, pulRow, pulBelow, pulDst, pixWidth, swCorner, swEdge, swMiddle, swInvDiv);
+    return;
+  }
+#endif
+
+  FilterRow_Scalar(pulAbove, pulRow, pulBelow, pulDst, 0, pixWidth, swCorner, swEdge, swMiddle, swInvDiv);
+};
+
+// Add light to texels
+
+static void AddLightRow_Scalar(ULONG *pulPixels, const SWORD *pswIntensities, INDEX ctPixels, ULONG ulLightRGB) {
+  for (INDEX i = 0; i < ctPixels; i++) {
+    UBYTE *pubPixel = (UBYTE *)(pulPixels + i);
+    const SLONG slIntensity = pswIntensities[i];
+
+    for (INDEX iCh = 0; iCh < 4; iCh++) {
+      // Same as multiplying by doubled color channels and keeping upper 16 bits
+      const SLONG slColor = SLONG((ulLightRGB >> (iCh * 8)) & 0xFF) << 1;
+      const SLONG slAdd = (slIntensity * slColor) >> 16;
+      pubPixel[iCh] = (UBYTE)Clamp(SLONG(pubPixel[iCh]) + slAdd, (SLONG)0, (SLONG)255);
+    }
+  }
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+static void AddLightRow_SIMD(ULONG *pulPixels, const SWORD *pswIntensities, INDEX ctPixels, ULONG ulLightRGB) {
+  INDEX i = 0;
+
+#if SE1_SIMD_SSE2
+  const __m128i mZero = _mm_setzero_si128();
+  __m128i mColor = _mm_slli_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(ulLightRGB), mZero), 1);
+  mColor = _mm_unpacklo_epi64(mColor, mColor);
+
+  for (; i + 4 <= ctPixels; i += 4) {
+    const __m128i mPixels = _mm_loadu_si128((const __m128i *)(pulPixels + i));
+
+    // Spread intensity of each pixel over its channels
+    __m128i mIntensity = _mm_loadl_epi64((const __m128i *)(pswIntensities + i));
+    mIntensity = _mm_unpacklo_epi16(mIntensity, mIntensity);
+
+    const __m128i mLo = _mm_add_epi16(_mm_unpacklo_epi8(mPixels, mZero), _mm_mulhi_epi16(_mm_unpacklo_epi32(mIntensity, mIntensity), mColor));
+    const __m128i mHi = _mm_add_epi16(_mm_unpackhi_epi8(mPixels, mZero), _mm_mulhi_epi16(_mm_unpackhi_epi32(mIntensity, mIntensity), mColor));
+    _mm_storeu_si128((__m128i *)(pulPixels + i), _mm_packus_epi16(mLo, mHi));
+  }
+
+#else
+  const int16x4_t mColor = vreinterpret_s16_u16(vget_low_u16(vshll_n_u8(vreinterpret_u8_u32(vdup_n_u32(ulLightRGB)), 1)));
+
+  for (; i + 4 <= ctPixels; i += 4) {
+    const uint8x16_t mPixels = vld1q_u8((const uint8_t *)(pulPixels + i));
+    const int16x4_t mIntensity = vld1_s16((const int16_t *)(pswIntensities + i));
+
+    // Upper 16 bits of each product
+    #define MULHI(_iLane) vshrn_n_s32(vmull_s16(vdup_lane_s16(mIntensity, _iLane), mColor), 16)
+    const int16x8_t mLo = vaddq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(mPixels))),  vcombine_s16(MULHI(0), MULHI(1)));
+    const int16x8_t mHi = vaddq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(mPixels))), vcombine_s16(MULHI(2), MULHI(3)));
+    #undef MULHI
+
+    vst1q_u8((uint8_t *)(pulPixels + i), vcombine_u8(vqmovun_s16(mLo), vqmovun_s16(mHi)));
+  }
+#endif
+
+  AddLightRow_Scalar(pulPixels + i, pswIntensities + i, ctPixels - i, ulLightRGB);
+};
+
+#endif // SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+void Kernel_AddLightRow(ULONG *pulPixels, const SWORD *pswIntensities, INDEX ctPixels, ULONG ulLightRGB) {
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  if (UseSIMDKernels()) {
+    AddLightRow_SIMD(pulPixels, pswIntensities, ctPixels, ulLightRGB);
+    return;
+  }
+#endif
+
+  AddLightRow_Scalar(pulPixels, pswIntensities, ctPixels, ulLightRGB);
+};
+
+// Dither bitmap row
+
+static void DitherRow_Scalar(const ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, const ULONG *pulPattern) {
+  const UBYTE *pubPattern = (const UBYTE *)pulPattern;
+
+  for (PIX pixX = 0; pixX < pixWidth; pixX += 4) {
+    // Whole group is read before writing it in case the row is dithered in place
+    UBYTE aubGroup[16];
+    memcpy(aubGroup, pulSrc + pixX, sizeof(aubGroup));
+
+    for (INDEX i = 0; i < 16; i++) {
+      aubGroup[i] = (UBYTE)Min(SLONG(aubGroup[i]) + SLONG(pubPattern[i]), (SLONG)255);
+    }
+
+    memcpy(pulDst + pixX, aubGroup, sizeof(aubGroup));
+  }
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+static void DitherRow_SIMD(const ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, const ULONG *pulPattern) {
+#if SE1_SIMD_SSE2
+  const __m128i mPattern = _mm_loadu_si128((const __m128i *)pulPattern);
+
+  for (PIX pixX = 0; pixX < pixWidth; pixX += 4) {
+    const __m128i mGroup = _mm_loadu_si128((const __m128i *)(pulSrc + pixX));
+    _mm_storeu_si128((__m128i *)(pulDst + pixX), _mm_adds_epu8(mGroup, mPattern));
+  }
+
+#else
+  const uint8x16_t mPattern = vld1q_u8((const uint8_t *)pulPattern);
+
+  for (PIX pixX = 0; pixX < pixWidth; pixX += 4) {
+    const uint8x16_t mGroup = vld1q_u8((const uint8_t *)(pulSrc + pixX));
+    vst1q_u8((uint8_t *)(pulDst + pixX), vqaddq_u8(mGroup, mPattern));
+  }
+#endif
+};
+
+#endif // SE1_SIMD_SSE2 || SE1_SIMD_NEON
+
+void Kernel_DitherRow(const ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, const ULONG *pulPattern) {
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  if (UseSIMDKernels()) {
+    DitherRow_SIMD(pulSrc, pulDst, pixWidth, pulPattern);
+    return;
+  }
+#endif
+
+  DitherRow_Scalar(pulSrc, pulDst, pixWidth, pulPattern);
+};
+
+// Fill a buffer with pseudo-random data
+static void FillRandom(void *pBuffer, SLONG slSize, ULONG ulSeed) {
+  UBYTE *pub = (UBYTE *)pBuffer;
+
+  for (SLONG i = 0; i < slSize; i++) {
+    ulSeed = ulSeed * 1103515245UL + 12345UL;
+    pub[i] = UBYTE(ulSeed >> 16);
+  }
+};
+
+// Function that runs one kernel variant on the benchmark buffers
+typedef void (*FKernelRun)(void *pSrc, void *pDst, INDEX ctItems);
+
+// Highest ordered dither pattern from the bitmap dithering routine
+static const ULONG _aulDitherPattern[16] = {
+  0x0F0F0F0F, 0x07070707, 0x0D0D0D0D, 0x05050505,
+  0x03030303, 0x0B0B0B0B, 0x01010101, 0x09090909,
+  0x0C0C0C0C, 0x04040404, 0x0E0E0E0E, 0x06060606,
+  0x00000000, 0x08080808, 0x02020202, 0x0A0A0A0A,
+};
+
+static void RunConvert_Scalar(void *pSrc, void *pDst, INDEX ct) { ConvertSamples_Scalar((SLONG *)pSrc, (SWORD *)pDst, ct); };
+static void RunExtract_Scalar(void *pSrc, void *pDst, INDEX ct) { ExtractSamples_Scalar((ULONG *)pSrc, (UWORD *)pDst, ct); };
+static void RunDownsample_Scalar(void *pSrc, void *pDst, INDEX ct) { DownsampleBilinear_Scalar((ULONG *)pSrc, (ULONG *)pDst, ct, ct); };
+static void RunWater_Scalar(void *pSrc, void *pDst, INDEX ct) { AnimateWater_Scalar((SWORD *)pSrc + 256, (SWORD *)pDst, 256, ct, 3); };
+static void RunPlasma_Scalar(void *pSrc, void *pDst, INDEX ct) { AnimatePlasma_Scalar((UBYTE *)pSrc + 256, (UBYTE *)pDst, 256, ct, 4); };
+static void RunFilter_Scalar(void *pSrc, void *pDst, INDEX ct) {
+  for (INDEX iRow = 1; iRow <= ct; iRow++) {
+    const ULONG *pulRow = (ULONG *)pSrc + iRow * 256;
+    FilterRow_Scalar(pulRow - 256, pulRow, pulRow + 256, (ULONG *)pDst + (iRow - 1) * 256, 0, 256, 1, 2, 7, 2731);
+  }
+};
+static void RunAddLight_Scalar(void *pSrc, void *pDst, INDEX ct) { AddLightRow_Scalar((ULONG *)pDst, (SWORD *)pSrc, ct, 0x40FFC080); };
+static void RunDither_Scalar(void *pSrc, void *pDst, INDEX ct) {
+  for (INDEX iRow = 0; iRow < ct; iRow++) {
+    DitherRow_Scalar((ULONG *)pSrc + iRow * 256, (ULONG *)pDst + iRow * 256, 256, _aulDitherPattern + (iRow & 3) * 4);
+  }
+};
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+static void RunConvert_SIMD(void *pSrc, void *pDst, INDEX ct) { ConvertSamples_SIMD((SLONG *)pSrc, (SWORD *)pDst, ct); };
+static void RunExtract_SIMD(void *pSrc, void *pDst, INDEX ct) { ExtractSamples_SIMD((ULONG *)pSrc, (UWORD *)pDst, ct); };
+static void RunDownsample_SIMD(void *pSrc, void *pDst, INDEX ct) { DownsampleBilinear_SIMD((ULONG *)pSrc, (ULONG *)pDst, ct, ct); };
+static void RunWater_SIMD(void *pSrc, void *pDst, INDEX ct) { AnimateWater_SIMD((SWORD *)pSrc + 256, (SWORD *)pDst, 256, ct, 3); };
+static void RunPlasma_SIMD(void *pSrc, void *pDst, INDEX ct) { AnimatePlasma_SIMD((UBYTE *)pSrc + 256, (UBYTE *)pDst, 256, ct, 4); };
+static void RunFilter_SIMD(void *pSrc, void *pDst, INDEX ct) {
+  for (INDEX iRow = 1; iRow <= ct; iRow++) {
+    const ULONG *pulRow = (ULONG *)pSrc + iRow * 256;
+    FilterRow_SIMD(pulRow - 256, pulRow, pulRow + 256, (ULONG *)pDst + (iRow - 1) * 256, 256, 1, 2, 7, 2731);
+  }
+};
+static void RunAddLight_SIMD(void *pSrc, void *pDst, INDEX ct) { AddLightRow_SIMD((ULONG *)pDst, (SWORD *)pSrc, ct, 0x40FFC080); };
+static void RunDither_SIMD(void *pSrc, void *pDst, INDEX ct) {
+  for (INDEX iRow = 0; iRow < ct; iRow++) {
+    DitherRow_SIMD((ULONG *)pSrc + iRow * 256, (ULONG *)pDst + iRow * 256, 256, _aulDitherPattern + (iRow & 3) * 4);
+  }
+};
+#endif
+
+#if SE1_USE_ASM
+static void RunConvert_Asm(void *pSrc, void *pDst, INDEX ct) { ConvertSamples_Asm((SLONG *)pSrc, (SWORD *)pDst, ct); };
+static void RunExtract_Asm(void *pSrc, void *pDst, INDEX ct) { ExtractSamples_Asm((ULONG *)pSrc, (UWORD *)pDst, ct); };
+static void RunDownsample_Asm(void *pSrc, void *pDst, INDEX ct) { DownsampleBilinear_Asm((ULONG *)pSrc, (ULONG *)pDst, ct, ct); };
+#endif
+
+// Time one kernel variant and compare its output against the scalar one
+static void BenchmarkVariant(const char *strName, FKernelRun pRun, void *pSrc, void *pDst, SLONG slDstSize,
+  INDEX ctItems, INDEX ctIterations, const UBYTE *pubReference, DOUBLE dReference)
+{
+  memset(pDst, 0, slDstSize);
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX iIter = 0; iIter < ctIterations; iIter++) {
+    pRun(pSrc, pDst, ctItems);
+  }
+
+  const DOUBLE dTime = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+  const BOOL bMatches = (pubReference == NULL || memcmp(pDst, pubReference, slDstSize) == 0);
+
+  CPrintF("    %-7s %8.3f ms", strName, dTime * 1000.0);
+
+  if (pubReference != NULL) {
+    CPrintF(TRANS(" (x%.2f, %s)"), dReference / ClampDn(dTime, 1e-9), bMatches ? TRANS("exact") : TRANS("MISMATCH"));
+  }
+
+  CPutString("\n");
+};
+
+// Benchmark all variants of one kernel
+static void BenchmarkKernel(const char *strKernel, INDEX ctItems, SLONG slSrcSize, SLONG slDstSize, INDEX ctIterations,
+  FKernelRun pScalar, FKernelRun pSIMD, FKernelRun pAsm)
+{
+  // Some extra space to catch overflows
+  UBYTE *pubSrc = (UBYTE *)AllocMemory(slSrcSize + 64);
+  UBYTE *pubDst = (UBYTE *)AllocMemory(slDstSize + 64);
+  UBYTE *pubRef = (UBYTE *)AllocMemory(slDstSize + 64);
+
+  FillRandom(pubSrc, slSrcSize + 64, 0x1234567);
+
+  CPrintF("  %s:\n", strKernel);
+
+  // Scalar results are the reference
+  memset(pubRef, 0, slDstSize);
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX iIter = 0; iIter < ctIterations; iIter++) {
+    pScalar(pubSrc, pubRef, ctItems);
+  }
+
+  const DOUBLE dScalar = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+  CPrintF("    %-7s %8.3f ms\n", "scalar", dScalar * 1000.0);
+
+  if (pSIMD != NULL) {
+    if (_bSIMDSupported) {
+      BenchmarkVariant(SE1_SIMD_NEON ? "neon" : "sse2", pSIMD, pubSrc, pubDst, slDstSize, ctItems, ctIterations, pubRef, dScalar);
+    } else {
+      CPrintF(TRANS("    Vector instructions are not supported by the CPU\n"));
+    }
+  }
+
+  if (pAsm != NULL) {
+    BenchmarkVariant("asm", pAsm, pubSrc, pubDst, slDstSize, ctItems, ctIterations, pubRef, dScalar);
+  }
+
+  FreeMemory(pubSrc);
+  FreeMemory(pubDst);
+  FreeMemory(pubRef);
+};
+
+// Compare speed and output of scalar, vector and assembly kernels
+static void BenchmarkSIMDKernels(void *pArgs) {
+  INDEX ctIterations = NEXTARGUMENT(INDEX);
+  if (ctIterations <= 0) ctIterations = 100;
+
+  FKernelRun pConvertSIMD = NULL, pExtractSIMD = NULL, pDownsampleSIMD = NULL;
+  FKernelRun pWaterSIMD = NULL, pPlasmaSIMD = NULL, pFilterSIMD = NULL;
+  FKernelRun pAddLightSIMD = NULL, pDitherSIMD = NULL;
+  FKernelRun pConvertAsm = NULL, pExtractAsm = NULL, pDownsampleAsm = NULL;
+
+#if SE1_SIMD_SSE2 || SE1_SIMD_NEON
+  pConvertSIMD = &RunConvert_SIMD;
+  pExtractSIMD = &RunExtract_SIMD;
+  pDownsampleSIMD = &RunDownsample_SIMD;
+  pWaterSIMD = &RunWater_SIMD;
+  pPlasmaSIMD = &RunPlasma_SIMD;
+  pFilterSIMD = &RunFilter_SIMD;
+  pAddLightSIMD = &RunAddLight_SIMD;
+  pDitherSIMD = &RunDither_SIMD;
+#endif
+
+#if SE1_USE_ASM
+  pConvertAsm = &RunConvert_Asm;
+  pExtractAsm = &RunExtract_Asm;
+  pDownsampleAsm = &RunDownsample_Asm;
+#endif
+
+  // One second of 44.1 kHz stereo
+  const INDEX ctSamples = 44100 * 2;
+  // Destination size of a 1024x1024 texture
+  const INDEX ctTexels = 512;
+  // 256x256 effect texture buffer without its top and bottom rows
+  const INDEX ctEffectPixels = 256 * 254;
+
+  CPrintF(TRANS("Kernel benchmark (%d iterations):\n"), ctIterations);
+
+  BenchmarkKernel("ConvertSamples", ctSamples, ctSamples * sizeof(SLONG), ctSamples * sizeof(SWORD),
+    ctIterations, &RunConvert_Scalar, pConvertSIMD, pConvertAsm);
+
+  BenchmarkKernel("ExtractSamples", ctSamples, ctSamples * sizeof(ULONG), ctSamples * sizeof(UWORD),
+    ctIterations, &RunExtract_Scalar, pExtractSIMD, pExtractAsm);
+
+  BenchmarkKernel("DownsampleBilinear", ctTexels, ctTexels * ctTexels * 4 * sizeof(ULONG), ctTexels * ctTexels * sizeof(ULONG),
+    ctIterations, &RunDownsample_Scalar, pDownsampleSIMD, pDownsampleAsm);
+
+  BenchmarkKernel("AnimateWater", ctEffectPixels, 256 * 256 * sizeof(SWORD), ctEffectPixels * sizeof(SWORD),
+    ctIterations, &RunWater_Scalar, pWaterSIMD, NULL);
+
+  BenchmarkKernel("AnimatePlasma", ctEffectPixels, 256 * 256 * sizeof(UBYTE), ctEffectPixels * sizeof(UBYTE),
+    ctIterations, &RunPlasma_Scalar, pPlasmaSIMD, NULL);
+
+  // Inner rows of a 256x256 texture
+  BenchmarkKernel("FilterRow", 254, 256 * 256 * sizeof(ULONG), 256 * 254 * sizeof(ULONG),
+    ctIterations, &RunFilter_Scalar, pFilterSIMD, NULL);
+
+  // Light added to a 256x256 shadow map over itself on each iteration
+  BenchmarkKernel("AddLightRow", 256 * 256, 256 * 256 * sizeof(SWORD), 256 * 256 * sizeof(ULONG),
+    ctIterations, &RunAddLight_Scalar, pAddLightSIMD, NULL);
+
+  BenchmarkKernel("DitherRow", 256, 256 * 256 * sizeof(ULONG), 256 * 256 * sizeof(ULONG),
+    ctIterations, &RunDither_Scalar, pDitherSIMD, NULL);
+
+  // Per-sound mixer against the blocked one
+  BenchmarkMixers(ctIterations);
+
+  // Effect texture routines that only have scalar versions
+  BenchmarkEffectTextures(ctIterations);
+};
+
+// Remember vector instruction support of the CPU and declare kernel settings
+void InitSIMDKernels(BOOL bCPUHasSSE2) {
+#if SE1_SIMD_SSE2
+  // Always available on x64 even if CPU detection failed
+  _bSIMDSupported = bCPUHasSSE2 || SE1_X64;
+#elif SE1_SIMD_NEON
+  _bSIMDSupported = TRUE; // Always available on 64-bit ARM
+#endif
+
+  _pShell->DeclareSymbol("persistent user INDEX sys_bSIMDKernels;", &sys_bSIMDKernels);
+  _pShell->DeclareSymbol("user void BenchmarkSIMDKernels(INDEX);", &BenchmarkSIMDKernels);
+};
@@ -0,0 +1,77 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_SIMDKERNELS_H
+#define SE_INCL_SIMDKERNELS_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+// Vector instruction sets that the kernels can be compiled with
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+  #define SE1_SIMD_NEON 1
+  #define SE1_SIMD_SSE2 0
+#elif SE1_X64 || defined(__SSE2__) || defined(_MSC_VER)
+  #define SE1_SIMD_NEON 0
+  #define SE1_SIMD_SSE2 1
+#else
+  #define SE1_SIMD_NEON 0
+  #define SE1_SIMD_SSE2 0
+#endif
+
+// Check if vector kernels are supported by the CPU and enabled
+ENGINE_API BOOL UseSIMDKernels(void);
+
+// Clamp 32-bit mixer samples into 16-bit samples in the [-32767, 32767] range (buffers may overlap if pswDst <= pslSrc)
+ENGINE_API void Kernel_ConvertSamples(const SLONG *pslSrc, SWORD *pswDst, INDEX ctSamples);
+
+// Copy lower 16 bits of each 32-bit value (e.g. one channel of 16-bit stereo samples)
+ENGINE_API void Kernel_ExtractSamples(const ULONG *pulSrc, UWORD *puwDst, INDEX ctSamples);
+
+// Average each 2x2 block of 32-bit texels into one texel (dimensions are of the destination bitmap)
+ENGINE_API void Kernel_DownsampleBilinear(const ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight);
+
+// Add 32-bit integer samples to float samples
+ENGINE_API void Kernel_AccumulateSamples(FLOAT *pfDst, const SLONG *pslSrc, INDEX ctSamples);
+
+// Find the highest absolute value among float samples
+ENGINE_API FLOAT Kernel_FindPeak(const FLOAT *pfSrc, INDEX ctSamples);
+
+// Multiply float samples by a gain that linearly moves towards the target with each sample and clamp them into 16-bit samples
+// in the [-32767, 32767] range (buffers may overlap if pswDst <= pfSrc)
+ENGINE_API void Kernel_ConvertFloatSamples(const FLOAT *pfSrc, SWORD *pswDst, INDEX ctSamples, FLOAT fGain, FLOAT fGainStep, FLOAT fGainTarget);
+
+// Calculate the next state of a water height map for each pixel from its neighbours (pixStride is the buffer width)
+ENGINE_API void Kernel_AnimateWater(const SWORD *pswOld, SWORD *pswNew, PIX pixStride, INDEX ctPixels, SLONG slDensity);
+
+// Calculate the next state of a plasma intensity map for each pixel from its neighbours (pixStride is the buffer width)
+ENGINE_API void Kernel_AnimatePlasma(const UBYTE *pubOld, UBYTE *pubNew, PIX pixStride, INDEX ctPixels, SLONG slDensity);
+
+// Apply 3x3 convolution filter with 16-bit weights to one row of 32-bit texels (neighbours beyond row edges are clamped)
+ENGINE_API void Kernel_FilterRow(const ULONG *pulAbove, const ULONG *pulRow, const ULONG *pulBelow, ULONG *pulDst,
+  PIX pixWidth, SWORD swCorner, SWORD swEdge, SWORD swMiddle, SWORD swInvDiv);
+
+// Add light color scaled by 16-bit intensities to 32-bit texels with saturation, like mixing of point light layers does
+// (intensities are multiplied by doubled color channels and only the upper 16 bits of the products are added)
+ENGINE_API void Kernel_AddLightRow(ULONG *pulPixels, const SWORD *pswIntensities, INDEX ctPixels, ULONG ulLightRGB);
+
+// Add a pattern of 4 texels to a row of 32-bit texels with saturation, one group of 4 texels at a time
+// (width is rounded up to whole groups, so the last group may go past the row; can be in-place)
+ENGINE_API void Kernel_DitherRow(const ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, const ULONG *pulPattern);
+
+// Remember vector instruction support of the CPU and declare kernel settings
+void InitSIMDKernels(BOOL bCPUHasSSE2);
+
+#endif  /* include-once check. */
@@ -19,11 +19,27 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Base/Stream.h>
 #include <Engine/Base/CRCTable.h>
+#include <Engine/Base/Synchronization.h> // [Cecil]
+
+// [Cecil] Thread that loads objects for stocks
+struct StockLoader {
+  CSerial *sl_pserLoading;    // innermost object that the thread is loading (others are linked via CSerial::ser_pserLoadingOuter)
+  CSerial *sl_pserWaitingFor; // object that the thread waits for
+  StockLoader *sl_pslWaitingFor; // thread that was loading that object when the thread started waiting
+};
+
+// [Cecil] Loading state of this thread
+static SE1_THREADLOCAL StockLoader _slThisThread = { NULL, NULL, NULL };
+
+// [Cecil] Guards loading state of all objects and threads
+CTCriticalSection _csStockLoading;
 
 /*
  * Default constructor.
  */
 CSerial::CSerial( void) : ser_ctUsed(0) // not used initially
+  , ser_bLoading(FALSE), ser_slUnusedMemory(0), ser_pcsStock(NULL), ser_pslStockUnused(NULL) // [Cecil]
+  , ser_pslLoader(NULL), ser_pserLoadingOuter(NULL) // [Cecil]
 {
 }
 
@@ -122,6 +138,17 @@ void CSerial::Save_t(const CTFileName fnFileName)  // throw char *
  */
 void CSerial::MarkUsed(void)
 {
+  // [Cecil] Objects in stocks can be revived without obtaining them again,
+  // so take them out of unused objects before they can be freed
+  if (ser_pcsStock != NULL) {
+    CTSingleLock slStock(ser_pcsStock, TRUE);
+    RemoveFromUnused();
+
+    ASSERT(ser_ctUsed>=0);
+    ser_ctUsed++;
+    return;
+  }
+
   // use count must not have dropped below zero
   ASSERT(ser_ctUsed>=0);
   // increment use count
@@ -160,3 +187,82 @@ void CSerial::AddToCRCTable(void)
   // add the file to CRC table
   CRCT_AddFile_t(ser_FileName);
 }
+
+// [Cecil] Forget that the object is unused in its stock (stock must be locked)
+void CSerial::RemoveFromUnused(void)
+{
+  // Objects that have been unreferenced without being released aren't in the list
+  if (!ser_lnUnused.IsLinked()) return;
+
+  *ser_pslStockUnused -= ser_slUnusedMemory;
+  ser_slUnusedMemory = 0;
+  ser_lnUnused.Remove();
+}
+
+// [Cecil] Mark that the object is being loaded by this thread
+void CSerial::StartLoadingInStock(void)
+{
+  CTSingleLock slLoading(&_csStockLoading, TRUE);
+  ASSERT(ser_pslLoader == NULL);
+
+  ser_bLoading = TRUE;
+  ser_pslLoader = &_slThisThread;
+  ser_pserLoadingOuter = _slThisThread.sl_pserLoading;
+  _slThisThread.sl_pserLoading = this;
+}
+
+// [Cecil] Mark that the object has been loaded or failed to load
+void CSerial::StopLoadingInStock(void)
+{
+  CTSingleLock slLoading(&_csStockLoading, TRUE);
+  ASSERT(_slThisThread.sl_pserLoading == this);
+
+  ser_bLoading = FALSE;
+  ser_pslLoader = NULL;
+  _slThisThread.sl_pserLoading = ser_pserLoadingOuter;
+  ser_pserLoadingOuter = NULL;
+}
+
+// [Cecil] Check if some thread is still loading an object
+static BOOL IsLoadingObject(StockLoader *psl, CSerial *pser)
+{
+  // Only compare pointers, since objects that aren't in the list anymore may have been deleted
+  for (CSerial *pserLoading = psl->sl_pserLoading; pserLoading != NULL; pserLoading = pserLoading->ser_pserLoadingOuter) {
+    if (pserLoading == pser) return TRUE;
+  }
+
+  return FALSE;
+}
+
+// [Cecil] Start waiting for another thread to load the object; returns FALSE if it would
+// never happen because this thread is loading it, directly or through threads waiting for it
+BOOL CSerial::StartWaitingForLoad(void)
+{
+  CTSingleLock slLoading(&_csStockLoading, TRUE);
+
+  // Follow the threads that wait for each other
+  StockLoader *psl = ser_pslLoader;
+
+  while (psl != NULL) {
+    if (psl == &_slThisThread) return FALSE;
+
+    // Stop at threads that aren't waiting for anything that's still being loaded
+    StockLoader *pslNext = psl->sl_pslWaitingFor;
+    if (pslNext == NULL || !IsLoadingObject(pslNext, psl->sl_pserWaitingFor)) break;
+
+    psl = pslNext;
+  }
+
+  _slThisThread.sl_pserWaitingFor = this;
+  _slThisThread.sl_pslWaitingFor = ser_pslLoader;
+  return TRUE;
+}
+
+// [Cecil] Stop waiting for any object to be loaded
+void CSerial::StopWaitingForLoad(void)
+{
+  CTSingleLock slLoading(&_csStockLoading, TRUE);
+
+  _slThisThread.sl_pserWaitingFor = NULL;
+  _slThisThread.sl_pslWaitingFor = NULL;
+}
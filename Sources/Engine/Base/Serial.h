@@ -21,6 +21,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Base/Changeable.h>
 #include <Engine/Base/FileName.h>
+#include <Engine/Base/Lists.h> // [Cecil]
 
  /*
  * Abstract base class for objects that can be saved and loaded.
@@ -30,6 +31,17 @@ public:
   INDEX ser_ctUsed;         // use count
   CTFileName ser_FileName;  // last file name loaded
 
+  // [Cecil] Stock state (guarded by the lock of the stock that the object is in)
+  BOOL ser_bLoading;        // still being loaded by the stock
+  CListNode ser_lnUnused;   // node in the list of unused objects of the stock
+  SLONG ser_slUnusedMemory; // memory that the unused object counts towards the stock budget
+  class CTCriticalSection *ser_pcsStock; // lock of the stock that the object is in (NULL if not in a stock)
+  SLONG *ser_pslStockUnused; // total memory of unused objects in that stock
+
+  // [Cecil] Loading state (guarded by a common lock for all stocks)
+  struct StockLoader *ser_pslLoader; // thread that is loading the object (NULL if loaded)
+  CSerial *ser_pserLoadingOuter;     // object that the same thread has been loading before this one
+
 public:
   /* Default constructor. */
   CSerial(void);
@@ -54,6 +66,19 @@ public:
   BOOL IsUsed(void);
   INDEX GetUsedCount(void);
 
+  // [Cecil] Forget that the object is unused in its stock (stock must be locked)
+  void RemoveFromUnused(void);
+
+  // [Cecil] Mark that the object is being loaded by this thread
+  void StartLoadingInStock(void);
+  // [Cecil] Mark that the object has been loaded or failed to load
+  void StopLoadingInStock(void);
+  // [Cecil] Start waiting for another thread to load the object; returns FALSE if it would
+  // never happen because this thread is loading it, directly or through threads waiting for it
+  BOOL StartWaitingForLoad(void);
+  // [Cecil] Stop waiting for any object to be loaded
+  static void StopWaitingForLoad(void);
+
   /* Clear the object. */
   virtual void Clear(void);
   /* Read from stream. */
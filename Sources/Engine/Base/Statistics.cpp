@@ -73,10 +73,14 @@ CStatForm::CStatForm()
   InitTimer( STI_SOUNDMIXING, 101, "\nsndmix=%2.0f ms", 1000.0f);
   InitTimer( STI_TIMER,       101, "\ntimer =%2.0f ms", 1000.0f);
   InitTimer( STI_MAINLOOP,    101, "\nmainlp=%2.0f ms", 1000.0f);
+  InitTimer( STI_GAMETICK,    101, "\ngametk=%2.0f ms", 1000.0f); // [Cecil]
   InitTimer( STI_RAYCAST,     101, "\nraycst=%2.0f ms", 1000.0f);
              
   InitTimer( STI_SHADOWUPDATE, 101, "^cFFFF00\nshdupd=%2.0f ms", 1000.0f);
   InitTimer( STI_EFFECTRENDER, 101, "\nefftex=%2.0f ms", 1000.0f);
+  InitTimer( STI_EFFECTWATER,  101, "\n water=%2.0f ms", 1000.0f); // [Cecil]
+  InitTimer( STI_EFFECTPLASMA, 101, "\n plasm=%2.0f ms", 1000.0f); // [Cecil]
+  InitTimer( STI_EFFECTFIRE,   101, "\n fire =%2.0f ms", 1000.0f); // [Cecil]
   InitTimer( STI_BINDTEXTURE,  101, "\nbindtx=%2.0f ms", 1000.0f);      
 
   InitTimer( STI_GFXAPI,      101, "^cFFFFFF\n\ngfxapi=%2.0f ms", 1000.0f);
@@ -97,10 +97,14 @@ public:
     STI_SOUNDMIXING,
     STI_TIMER,
     STI_MAINLOOP,
+    STI_GAMETICK, // [Cecil]
     STI_RAYCAST,
 
     STI_SHADOWUPDATE,
     STI_EFFECTRENDER,
+    STI_EFFECTWATER,  // [Cecil]
+    STI_EFFECTPLASMA, // [Cecil]
+    STI_EFFECTFIRE,   // [Cecil]
     STI_BINDTEXTURE, 
 
     STI_GFXAPI,
@@ -42,6 +42,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Templates/Stock_CTextureData.h>
 #include <Engine/Templates/Stock_CModelData.h>
+#include <Engine/Templates/Stock_CSoundData.h>
+#include <Engine/Base/WorkerThreads.h> // [Cecil]
 
 // maximum lenght of file that can be saved (default: 128Mb)
 ULONG _ulMaxLenghtOfSavingFile = (1UL<<20)*128;
@@ -55,6 +57,38 @@ static SE1_THREADLOCAL CListHead *_plhOpenedStreams = NULL;
 // [Cecil] Stream synchronization mutex
 static CTCriticalSection _csStreams;
 
+// [Cecil] File from an archive that's being read ahead of opening it
+struct SPrefetchedFile {
+  enum EState {
+    E_QUEUED,  // Waiting for a worker thread
+    E_READING, // Being read by a worker thread
+    E_READY,   // Data can be taken
+    E_DONE,    // Data has been taken or couldn't be read
+  };
+
+  CTString pf_fnmExpanded; // Full path of the file in the archive
+  IZip::CEntry pf_ze; // Archive entry of the file
+  UBYTE *pf_pubData; // Uncompressed file contents
+  SLONG pf_slMemory; // Memory reserved for the contents until they are taken
+  EState pf_eState;
+
+  // Get name for the name table
+  inline const CTString &GetName(void) const {
+    return pf_fnmExpanded;
+  };
+};
+
+// [Cecil] Maximum amount of memory that can be held by prefetched files (128 MB)
+static const SLONG _slMaxPrefetchMemory = (1UL << 20) * 128;
+
+static CTCriticalSection _csPrefetch; // [Cecil] Guards states of prefetched files
+static CDynamicContainer<SPrefetchedFile> _cPrefetched; // [Cecil] All currently prefetched files
+static CNameTable<SPrefetchedFile> _ntPrefetched; // [Cecil] Prefetched files by their full paths
+static CJobGroup *_pjgPrefetch = NULL; // [Cecil] Jobs for reading prefetched files
+static SLONG _slPrefetchMemory = 0; // [Cecil] Memory allocated for prefetched files
+static INDEX _ctPrefetchOpened = 0; // [Cecil] Prefetched files that have been opened
+static DOUBLE _dPrefetchWait = 0.0; // [Cecil] Time spent waiting for prefetched files
+
 // [Cecil] Global overrideable flags for the CTFileStream::Open_t() wrapper method
 ULONG CTFileStream::ulFileStreamOpenFlags = DLI_SEARCHGAMES; // Search extra game directories by default
 
@@ -169,6 +203,7 @@ static void LoadExtraPackages(const CTString &fnmDirList, BOOL bGameDir) {
 void InitStreams(void)
 {
   _csStreams.cs_eIndex = EThreadMutexType::E_MTX_IGNORE; // [Cecil]
+  _csPrefetch.cs_eIndex = EThreadMutexType::E_MTX_IGNORE; // [Cecil]
 
   // if no mod defined yet
   if (_fnmMod=="") {
@@ -264,6 +299,8 @@ void InitStreams(void)
 
 void EndStreams(void)
 {
+  // [Cecil] Free files that have never been opened
+  ClearPrefetchedFiles();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -871,6 +908,9 @@ SLONG CTStream::DictionaryReadBegin_t(void)
 
 void CTStream::DictionaryReadEnd_t(void)
 {
+  // [Cecil] Collect models from worker threads before locking the streams that they read from
+  FinishPreloading();
+
   CTSingleLock slStrm(&_csStreams, TRUE); // [Cecil]
 
   if (strm_dmDictionaryMode == DM_ENABLED) {
@@ -881,6 +921,9 @@ void CTStream::DictionaryReadEnd_t(void)
     strm_dmDictionaryMode = DM_NONE;
     strm_ntDictionary.Clear();
 
+    // [Cecil] Files from the dictionary that haven't been opened by now won't be needed
+    ClearPrefetchedFiles();
+
     // [Cecil] Free all preloaded instances
     FOREACHINDYNAMICCONTAINER(strm_cserPreloaded, CSerial, itser) {
       CSerial *pser = itser;
@@ -897,22 +940,237 @@ void CTStream::DictionaryReadEnd_t(void)
     strm_cserPreloaded.Clear(); // [Cecil]
   }
 }
+// [Cecil] Stop counting memory reserved for a prefetched file (must be called under the prefetch lock)
+static void ReleasePrefetchMemory(SPrefetchedFile &pf) {
+  _slPrefetchMemory -= pf.pf_slMemory;
+  pf.pf_slMemory = 0;
+  ASSERT(_slPrefetchMemory >= 0);
+};
+
+// [Cecil] Read one prefetched file on a worker thread
+static void PrefetchFileJob(void *pData, INDEX iItem) {
+  SPrefetchedFile &pf = *(SPrefetchedFile *)pData;
+
+  {
+    CTSingleLock slPrefetch(&_csPrefetch, TRUE);
+
+    // Already opened by the loading thread
+    if (pf.pf_eState != SPrefetchedFile::E_QUEUED) return;
+    pf.pf_eState = SPrefetchedFile::E_READING;
+  }
+
+  UBYTE *pubData = (UBYTE *)AllocMemory(pf.pf_ze.GetUncompressedSize());
+
+  try {
+    IZip::ReadEntry_t(pf.pf_ze, pubData);
+
+  // Let the file be read normally when it's opened
+  } catch (char *) {
+    FreeMemory(pubData);
+    pubData = NULL;
+  }
+
+  CTSingleLock slPrefetch(&_csPrefetch, TRUE);
+  pf.pf_pubData = pubData;
+
+  if (pubData != NULL) {
+    pf.pf_eState = SPrefetchedFile::E_READY;
+  } else {
+    pf.pf_eState = SPrefetchedFile::E_DONE;
+    ReleasePrefetchMemory(pf);
+  }
+};
+
+// [Cecil] Find prefetched file by its full path
+static SPrefetchedFile *FindPrefetchedFile(const CTString &fnmExpanded) {
+  // Nothing has been prefetched yet
+  if (_ntPrefetched.nt_ctCompartments == 0) return NULL;
+
+  return _ntPrefetched.Find(fnmExpanded);
+};
+
+// [Cecil] Check if some file is already loaded in one of the stocks
+static BOOL IsFileInStock(const CTFileName &fnm) {
+  const CTString strExt = fnm.FileExt();
+
+  if (strExt == ".tex") return _pTextureStock->IsStocked(fnm);
+  if (strExt == ".mdl") return _pModelStock->IsStocked(fnm);
+  if (strExt == ".wav" || strExt == ".ogg" || strExt == ".mp3") return _pSoundStock->IsStocked(fnm);
+
+  return FALSE;
+};
+
+// [Cecil] Start reading files from archives on worker threads ahead of opening them
+void PrefetchFiles(const CDynamicStackArray<CTFileName> &afnmFiles)
+{
+  // Not worth it without worker threads
+  if (GetWorkerThreadCount() == 0) return;
+
+  if (_pjgPrefetch == NULL) {
+    _pjgPrefetch = new CJobGroup;
+  }
+
+  {
+    CTSingleLock slPrefetch(&_csPrefetch, TRUE);
+
+    if (_ntPrefetched.nt_ctCompartments == 0) {
+      _ntPrefetched.SetAllocationParameters(100, 5, 5);
+    }
+  }
+
+  const INDEX ctFiles = afnmFiles.Count();
+
+  for (INDEX iFile = 0; iFile < ctFiles; iFile++) {
+    const CTFileName &fnm = afnmFiles[iFile];
+
+    // Loaded resources won't be opened again
+    if (IsFileInStock(fnm)) continue;
+
+    // Only files from archives need to be decompressed
+    ExpandPath expath;
+    if (!expath.ForReading(fnm, CTFileStream::ulFileStreamOpenFlags) || !expath.bArchive) continue;
+
+    const IZip::CEntry *pze = IZip::FindEntry(expath.fnmExpanded);
+    if (pze == NULL) continue;
+
+    CTSingleLock slPrefetch(&_csPrefetch, TRUE);
+
+    // Too much memory is already held
+    const SLONG slSize = pze->GetUncompressedSize();
+    if (slSize <= 0 || _slPrefetchMemory + slSize > _slMaxPrefetchMemory) continue;
+
+    // Already prefetched
+    if (FindPrefetchedFile(expath.fnmExpanded) != NULL) continue;
+
+    SPrefetchedFile *ppf = new SPrefetchedFile;
+    ppf->pf_fnmExpanded = expath.fnmExpanded;
+    ppf->pf_ze = *pze;
+    ppf->pf_pubData = NULL;
+    ppf->pf_slMemory = slSize;
+    ppf->pf_eState = SPrefetchedFile::E_QUEUED;
+
+    _cPrefetched.Add(ppf);
+    _ntPrefetched.Add(ppf);
+    _slPrefetchMemory += slSize;
+
+    _pjgPrefetch->Add(&PrefetchFileJob, ppf, iFile);
+  }
+};
+
+// [Cecil] Take contents of a prefetched file, if there are any
+static UBYTE *TakePrefetchedFile(const CTString &fnmExpanded)
+{
+  CTSingleLock slPrefetch(&_csPrefetch, TRUE);
+
+  SPrefetchedFile *ppf = FindPrefetchedFile(fnmExpanded);
+  if (ppf == NULL) return NULL;
+
+  // Not read yet, so read it normally right now
+  if (ppf->pf_eState == SPrefetchedFile::E_QUEUED) {
+    ppf->pf_eState = SPrefetchedFile::E_DONE;
+    ReleasePrefetchMemory(*ppf);
+    return NULL;
+  }
+
+  // Wait until the worker thread is done with it
+  if (ppf->pf_eState == SPrefetchedFile::E_READING) {
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+    while (ppf->pf_eState == SPrefetchedFile::E_READING) {
+      slPrefetch.Unlock();
+      _pTimer->Suspend(0);
+      slPrefetch.Lock();
+    }
+
+    _dPrefetchWait += (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+  }
+
+  if (ppf->pf_eState != SPrefetchedFile::E_READY) return NULL;
+
+  // Hand the buffer over to the stream
+  UBYTE *pubData = ppf->pf_pubData;
+  ppf->pf_pubData = NULL;
+  ppf->pf_eState = SPrefetchedFile::E_DONE;
+  ReleasePrefetchMemory(*ppf);
+  _ctPrefetchOpened++;
+
+  return pubData;
+};
+
+// [Cecil] Free prefetched files that haven't been opened
+void ClearPrefetchedFiles(void)
+{
+  // Finish reading first
+  if (_pjgPrefetch != NULL) {
+    delete _pjgPrefetch;
+    _pjgPrefetch = NULL;
+  }
+
+  CTSingleLock slPrefetch(&_csPrefetch, TRUE);
+
+  _cPrefetched.Lock();
+
+  for (INDEX iFile = 0; iFile < _cPrefetched.Count(); iFile++) {
+    SPrefetchedFile *ppf = _cPrefetched.Pointer(iFile);
+
+    if (ppf->pf_pubData != NULL) {
+      FreeMemory(ppf->pf_pubData);
+    }
+    delete ppf;
+  }
+
+  _cPrefetched.Unlock();
+  _cPrefetched.Clear();
+  _ntPrefetched.Clear();
+
+  _slPrefetchMemory = 0;
+};
+
+// [Cecil] Get amount of prefetched files that have been opened and time spent waiting for them
+void GetPrefetchStats(INDEX &ctOpened, DOUBLE &dWaitTime)
+{
+  ctOpened = _ctPrefetchOpened;
+  dWaitTime = _dPrefetchWait;
+
+  _ctPrefetchOpened = 0;
+  _dPrefetchWait = 0.0;
+};
+
 void CTStream::DictionaryPreload_t(void)
 {
-  CTSingleLock slStrm(&_csStreams, TRUE); // [Cecil]
+  // [Cecil] Copy the dictionary, so worker threads can open other streams while it's being preloaded
+  CDynamicStackArray<CTFileName> afnmPreload;
+  {
+    CTSingleLock slStrm(&_csStreams, TRUE);
+    afnmPreload = strm_afnmDictionary;
+  }
 
-  INDEX ctFileNames = strm_afnmDictionary.Count();
+  // [Cecil] Let worker threads decompress the files while they are being loaded one by one
+  PrefetchFiles(afnmPreload);
+
+  // [Cecil] Model geometry can be loaded in the background while textures are being loaded and
+  // the rest of the file is being read on this thread; patch textures of models obtained in the
+  // background are deferred until FinishPreloading() because textures touch the graphics API
+  const BOOL bAsyncModels = (GetWorkerThreadCount() > 0);
+
+  INDEX ctFileNames = afnmPreload.Count();
   // for each filename
   for(INDEX iFileName=0; iFileName<ctFileNames; iFileName++) {
     // preload it
-    CTFileName &fnm = strm_afnmDictionary[iFileName];
+    CTFileName &fnm = afnmPreload[iFileName];
     CTString strExt = fnm.FileExt();
     CallProgressHook_t(FLOAT(iFileName)/ctFileNames);
     try {
       if (strExt==".tex") {
         strm_cserPreloaded.Add(_pTextureStock->Obtain_t(fnm));
       } else if (strExt==".mdl") {
-        strm_cserPreloaded.Add(_pModelStock->Obtain_t(fnm));
+        if (bAsyncModels) {
+          CStockRequest<CModelData> *psr = new CStockRequest<CModelData>;
+          CStock_CModelData::ObtainAsync(fnm, *psr);
+          strm_csrPreloading.Add(psr);
+        } else {
+          strm_cserPreloaded.Add(_pModelStock->Obtain_t(fnm));
+        }
       }
     } catch (char *strError) {
       CPrintF(TRANS("Cannot preload %s: %s\n"), fnm.ConstData(), strError);
@@ -920,6 +1178,29 @@ void CTStream::DictionaryPreload_t(void)
   }
 }
 
+// [Cecil] Wait for models that are being preloaded in the background
+void CTStream::FinishPreloading(void)
+{
+  FOREACHINDYNAMICCONTAINER(strm_csrPreloading, CStockRequest<CModelData>, itsr) {
+    CStockRequest<CModelData> *psr = itsr;
+
+    try {
+      CModelData *pmd = psr->Get_t();
+      strm_cserPreloaded.Add(pmd);
+
+      // Obtain textures that couldn't be obtained on a worker thread
+      pmd->ObtainDeferredPatches();
+
+    } catch (char *strError) {
+      CPrintF(TRANS("Cannot preload %s: %s\n"), psr->sr_fnmFileName.ConstData(), strError);
+    }
+
+    delete psr;
+  }
+
+  strm_csrPreloading.Clear();
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // General construction/destruction
 
@@ -936,6 +1217,9 @@ CTStream::CTStream(void) : strm_ntDictionary(*new CNameTable<CTFileName>)
 /* Destructor. */
 CTStream::~CTStream(void)
 {
+  // [Cecil] Don't leave worker threads with dangling requests
+  FinishPreloading();
+
   CTSingleLock slStrm(&_csStreams, TRUE); // [Cecil]
 
   strm_ntDictionary.Clear();
@@ -1006,9 +1290,15 @@ void CTFileStream::OpenEx_t(const CTFileName &fnm, ULONG ulFlags, CTStream::Open
         // open from zip
         fstrm_pZipHandle = IZip::Open_t(expath.fnmExpanded);
         fstrm_slZipSize = IZip::GetEntry(fstrm_pZipHandle)->GetUncompressedSize();
-        // load the file from the zip in the buffer
-        fstrm_pubZipBuffer = (UBYTE *)AllocMemory(fstrm_slZipSize);
-        IZip::ReadBlock_t(fstrm_pZipHandle, (UBYTE *)fstrm_pubZipBuffer, 0, fstrm_slZipSize);
+
+        // [Cecil] Take the buffer if the file has already been read ahead
+        fstrm_pubZipBuffer = TakePrefetchedFile(expath.fnmExpanded);
+
+        if (fstrm_pubZipBuffer == NULL) {
+          // load the file from the zip in the buffer
+          fstrm_pubZipBuffer = (UBYTE *)AllocMemory(fstrm_slZipSize);
+          IZip::ReadBlock_t(fstrm_pZipHandle, (UBYTE *)fstrm_pubZipBuffer, 0, fstrm_slZipSize);
+        }
 
       // if it is a physical file
       } else {
@@ -30,6 +30,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/DynamicContainer.h>
 #include <Engine/Templates/NameTable.h>
 
+// [Cecil] Background stock requests for preloading dictionary files
+template<class Type> class CStockRequest;
+
 // [Cecil] Exception handling for streams only on Windows OS
 #if SE1_WIN
 
@@ -95,6 +98,7 @@ public:
   CNameTable<CTFileName> &strm_ntDictionary;  // name table for the dictionary
   CDynamicStackArray<CTFileName> strm_afnmDictionary; // dictionary is stored here
   CDynamicContainer<CSerial> strm_cserPreloaded; // [Cecil] Replacement for 'fnm_pserPreloaded' from old CTFileName
+  CDynamicContainer<CStockRequest<CModelData> > strm_csrPreloading; // [Cecil] Models that are being preloaded in the background
 
   /* Throw an exception of formatted string. */
   void Throw_t(const char *strFormat, ...); // throw char *
@@ -102,6 +106,8 @@ public:
   void ReadDictionary_intenal_t(SLONG slOffset);
   // copy filename dictionary from another stream
   void CopyDictionary(CTStream &strmOther);
+  // [Cecil] Wait for models that are being preloaded in the background
+  void FinishPreloading(void);
 public:
   // modes for opening streams
   enum OpenMode {
@@ -405,6 +411,13 @@ ENGINE_API BOOL IsFileReadOnly(const CTFileName &fnmFile);
 // Delete a file (called 'remove' to avid name clashes with win32)
 ENGINE_API BOOL RemoveFile(const CTFileName &fnmFile);
 
+// [Cecil] Start reading files from archives on worker threads ahead of opening them
+ENGINE_API void PrefetchFiles(const CDynamicStackArray<CTFileName> &afnmFiles);
+// [Cecil] Free prefetched files that haven't been opened
+ENGINE_API void ClearPrefetchedFiles(void);
+// [Cecil] Get amount of prefetched files that have been opened and time spent waiting for them
+ENGINE_API void GetPrefetchStats(INDEX &ctOpened, DOUBLE &dWaitTime);
+
 // [Cecil] New flags for using specific paths in specified directories using various methods that accept flags
 enum EDirListFlags {
   DLI_RECURSIVE   = (1 << 0), // Look into subdirectories
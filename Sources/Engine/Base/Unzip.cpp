@@ -728,4 +728,89 @@ void Close(Handle_t pHandle) {
   pHandle->Clear();
 };
 
+// Input buffer size for reading entire entries at once
+static const size_t _ctEntryBufferSize = 64 * 1024;
+
+// Read entire uncompressed contents of a ZIP entry into a buffer of its uncompressed size
+void ReadEntry_t(const CEntry &ze, UBYTE *pub) {
+  FILE *pFile = FileSystem::Open(ze.GetArchive(), "rb");
+
+  if (pFile == NULL) {
+    ThrowF_t(TRANS("Cannot open '%s': %s"), ze.GetArchive().ConstData(), strerror(errno));
+  }
+
+  // Go to the local header of the entry and check its signature
+  fseek(pFile, ze.GetDataOffset(), SEEK_SET);
+
+  int slSig = 0;
+  LocalFileHeader lfh;
+  fread(&slSig, sizeof(slSig), 1, pFile);
+  fread(&lfh, sizeof(lfh), 1, pFile);
+
+  if (slSig != SIGNATURE_LFH) {
+    fclose(pFile);
+    ThrowF_t(TRANS("%s/%s: Wrong signature for 'local file header'"),
+      ze.GetArchive().ConstData(), ze.GetFileName().ConstData());
+  }
+
+  // Go to the compressed data
+  fseek(pFile, lfh.lfh_swFileNameLen + lfh.lfh_swExtraFieldLen, SEEK_CUR);
+
+  const SLONG slSize = ze.GetUncompressedSize();
+
+  // Just read the file if it's not compressed
+  if (ze.IsStored()) {
+    const size_t slRead = fread(pub, 1, slSize, pFile);
+    fclose(pFile);
+
+    if (slRead != (size_t)slSize) {
+      ThrowF_t(TRANS("%s/%s: Unexpected end of file"), ze.GetArchive().ConstData(), ze.GetFileName().ConstData());
+    }
+    return;
+  }
+
+  // Own zlib stream that isn't shared with any handle
+  z_stream zs;
+  zs.next_out  = pub;
+  zs.avail_out = slSize;
+  zs.next_in   = NULL;
+  zs.avail_in  = 0;
+  zs.zalloc = (alloc_func)Z_NULL;
+  zs.zfree = (free_func)Z_NULL;
+  zs.opaque = Z_NULL;
+
+  int ierr = inflateInit2(&zs, -15); // 32k windows
+
+  if (ierr != Z_OK) {
+    fclose(pFile);
+    ThrowF_t(TRANS("%s/%s: Cannot init inflation"), ze.GetArchive().ConstData(), ze.GetFileName().ConstData());
+  }
+
+  UBYTE *pubBufIn = (UBYTE *)AllocMemory(_ctEntryBufferSize);
+
+  // Decode until the whole entry is read
+  while (zs.avail_out > 0 && ierr != Z_STREAM_END) {
+    if (zs.avail_in == 0) {
+      const size_t slRead = fread(pubBufIn, 1, _ctEntryBufferSize, pFile);
+      if (slRead == 0) break;
+
+      zs.next_in = pubBufIn;
+      zs.avail_in = (uInt)slRead;
+    }
+
+    ierr = inflate(&zs, Z_SYNC_FLUSH);
+    if (ierr != Z_OK && ierr != Z_STREAM_END) break;
+  }
+
+  const BOOL bComplete = (zs.avail_out == 0);
+
+  inflateEnd(&zs);
+  FreeMemory(pubBufIn);
+  fclose(pFile);
+
+  if (!bComplete) {
+    ThrowF_t(TRANS("%s/%s: Error reading from zip"), ze.GetArchive().ConstData(), ze.GetFileName().ConstData());
+  }
+};
+
 }; // namespace
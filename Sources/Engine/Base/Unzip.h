@@ -104,6 +104,10 @@ void ReadBlock_t(Handle_t pHandle, UBYTE *pub, SLONG slStart, SLONG slLen);
 // Close a ZIP file
 void Close(Handle_t pHandle);
 
+// Read entire uncompressed contents of a ZIP entry into a buffer of its uncompressed size
+// NOTE: Doesn't use any shared handles, so it can be called from worker threads
+void ReadEntry_t(const CEntry &ze, UBYTE *pub);
+
 }; // namespace
 
 #endif  /* include-once check. */
@@ -0,0 +1,273 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "StdH.h"
+
+#include <Engine/Base/WorkerThreads.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Stream.h>
+
+#if SE1_WORKER_THREADS
+  #include <thread>
+  #include <mutex>
+  #include <condition_variable>
+  #include <deque>
+  #include <vector>
+#endif
+
+// Amount of worker threads to start (-1 for one less than the amount of CPU cores, 0 to run everything on the calling thread)
+INDEX sys_iWorkerThreads = -1;
+
+// Maximum amount of worker threads
+static const INDEX _ctMaxWorkerThreads = 16;
+
+#if SE1_WORKER_THREADS
+
+// State of a job group shared with the worker threads
+struct SJobGroupState {
+  INDEX jgs_ctPending; // Queued jobs that haven't finished yet
+};
+
+// One queued job
+struct SWorkerJob {
+  FWorkerJob wj_pFunc;
+  void *wj_pData;
+  INDEX wj_iItem;
+  SJobGroupState *wj_pGroup;
+};
+
+static std::mutex _mtxJobs; // Guards the queue and all job group states
+static std::condition_variable _cvJobQueued; // Signaled when new jobs are queued
+static std::condition_variable _cvJobDone; // Signaled when some job group has been finished
+static std::deque<SWorkerJob> _aJobs;
+static std::vector<std::thread> _aWorkers;
+static std::mutex _mtxStart; // Guards starting and stopping of the threads
+static BOOL _bWorkersStarted = FALSE;
+static BOOL _bStopWorkers = FALSE;
+
+// Execute one job that has been taken from the queue
+static void RunJob(const SWorkerJob &job) {
+  try {
+    job.wj_pFunc(job.wj_pData, job.wj_iItem);
+
+  } catch (char *strError) {
+    // Jobs should handle their own errors
+    ASSERTALWAYS("Unhandled error in a worker job!");
+    CPrintF(TRANS("Unhandled error in a worker job: %s\n"), strError);
+  }
+
+  std::lock_guard<std::mutex> lock(_mtxJobs);
+
+  // Notify waiting threads when the last job of the group has been done
+  if (--job.wj_pGroup->jgs_ctPending == 0) {
+    _cvJobDone.notify_all();
+  }
+};
+
+// Loop of each worker thread
+static void WorkerThreadLoop(void) {
+  // Jobs may need to open files
+  CTStream::EnableStreamHandling();
+
+  FOREVER {
+    SWorkerJob job;
+
+    {
+      std::unique_lock<std::mutex> lock(_mtxJobs);
+
+      while (_aJobs.empty() && !_bStopWorkers) {
+        _cvJobQueued.wait(lock);
+      }
+
+      // Finish remaining jobs before stopping
+      if (_aJobs.empty()) break;
+
+      job = _aJobs.front();
+      _aJobs.pop_front();
+    }
+
+    RunJob(job);
+  }
+
+  CTStream::DisableStreamHandling();
+};
+
+// Start worker threads on demand
+static void StartWorkers(void) {
+  std::lock_guard<std::mutex> lockStart(_mtxStart);
+
+  if (_bWorkersStarted) return;
+  _bWorkersStarted = TRUE;
+
+  INDEX ctThreads = sys_iWorkerThreads;
+
+  if (ctThreads < 0) {
+    ctThreads = (INDEX)std::thread::hardware_concurrency() - 1;
+  }
+
+  ctThreads = Clamp(ctThreads, (INDEX)0, _ctMaxWorkerThreads);
+  _bStopWorkers = FALSE;
+
+  for (INDEX iThread = 0; iThread < ctThreads; iThread++) {
+    _aWorkers.push_back(std::thread(WorkerThreadLoop));
+  }
+};
+
+#endif // SE1_WORKER_THREADS
+
+CJobGroup::CJobGroup(void) {
+#if SE1_WORKER_THREADS
+  SJobGroupState *pState = new SJobGroupState;
+  pState->jgs_ctPending = 0;
+  jg_pState = pState;
+#else
+  jg_pState = NULL;
+#endif
+};
+
+CJobGroup::~CJobGroup(void) {
+#if SE1_WORKER_THREADS
+  Wait();
+  delete (SJobGroupState *)jg_pState;
+#endif
+};
+
+// Queue one job item (executed immediately if there are no worker threads)
+void CJobGroup::Add(FWorkerJob pFunc, void *pData, INDEX iItem) {
+#if SE1_WORKER_THREADS
+  StartWorkers();
+
+  if (!_aWorkers.empty()) {
+    SWorkerJob job;
+    job.wj_pFunc = pFunc;
+    job.wj_pData = pData;
+    job.wj_iItem = iItem;
+    job.wj_pGroup = (SJobGroupState *)jg_pState;
+
+    {
+      std::lock_guard<std::mutex> lock(_mtxJobs);
+      job.wj_pGroup->jgs_ctPending++;
+      _aJobs.push_back(job);
+    }
+
+    _cvJobQueued.notify_one();
+    return;
+  }
+#endif
+
+  // No workers
+  pFunc(pData, iItem);
+};
+
+// Check if all queued jobs have been finished
+BOOL CJobGroup::IsDone(void) const {
+#if SE1_WORKER_THREADS
+  std::lock_guard<std::mutex> lock(_mtxJobs);
+  return ((SJobGroupState *)jg_pState)->jgs_ctPending == 0;
+#else
+  return TRUE;
+#endif
+};
+
+// Wait until all queued jobs have been finished while helping with them on this thread
+// NOTE: Only jobs of this group are taken, so unrelated long jobs in the queue cannot delay the caller
+void CJobGroup::Wait(void) {
+#if SE1_WORKER_THREADS
+  SJobGroupState *pState = (SJobGroupState *)jg_pState;
+
+  FOREVER {
+    SWorkerJob job;
+
+    {
+      std::unique_lock<std::mutex> lock(_mtxJobs);
+      if (pState->jgs_ctPending == 0) return;
+
+      // Find the next queued job of this group
+      std::deque<SWorkerJob>::iterator itJob = _aJobs.begin();
+
+      for (; itJob != _aJobs.end(); ++itJob) {
+        if (itJob->wj_pGroup == pState) break;
+      }
+
+      // Wait for the workers if there's nothing left to take
+      if (itJob == _aJobs.end()) {
+        _cvJobDone.wait(lock);
+        continue;
+      }
+
+      job = *itJob;
+      _aJobs.erase(itJob);
+    }
+
+    RunJob(job);
+  }
+#endif
+};
+
+// Get amount of currently running worker threads (0 if all jobs run on the calling thread)
+INDEX GetWorkerThreadCount(void) {
+#if SE1_WORKER_THREADS
+  StartWorkers();
+  return (INDEX)_aWorkers.size();
+#else
+  return 0;
+#endif
+};
+
+// Process all items in the [0, ctItems - 1] range on worker threads and wait for them
+void ParallelFor(INDEX ctItems, FWorkerJob pFunc, void *pData) {
+  // Not worth queueing
+  if (ctItems <= 1 || GetWorkerThreadCount() == 0) {
+    for (INDEX iItem = 0; iItem < ctItems; iItem++) {
+      pFunc(pData, iItem);
+    }
+    return;
+  }
+
+  CJobGroup jg;
+
+  for (INDEX iItem = 0; iItem < ctItems; iItem++) {
+    jg.Add(pFunc, pData, iItem);
+  }
+
+  jg.Wait();
+};
+
+// Declare worker thread settings (threads themselves are started on demand)
+void InitWorkerThreads(void) {
+  _pShell->DeclareSymbol("persistent user INDEX sys_iWorkerThreads;", &sys_iWorkerThreads);
+};
+
+// Stop worker threads
+void EndWorkerThreads(void) {
+#if SE1_WORKER_THREADS
+  std::lock_guard<std::mutex> lockStart(_mtxStart);
+
+  {
+    std::lock_guard<std::mutex> lock(_mtxJobs);
+    _bStopWorkers = TRUE;
+  }
+
+  _cvJobQueued.notify_all();
+
+  for (size_t iThread = 0; iThread < _aWorkers.size(); iThread++) {
+    _aWorkers[iThread].join();
+  }
+
+  _aWorkers.clear();
+  _bWorkersStarted = FALSE;
+#endif
+};
@@ -0,0 +1,61 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_WORKERTHREADS_H
+#define SE_INCL_WORKERTHREADS_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+// Worker threads are only available with complete C++11 support
+#define SE1_WORKER_THREADS (!SE1_INCOMPLETE_CPP11 && !SE1_SINGLE_THREAD)
+
+// Function that processes one item of some job
+// NOTE: Jobs must catch their own exceptions and must not touch the engine state that isn't thread-safe
+typedef void (*FWorkerJob)(void *pData, INDEX iItem);
+
+// Group of jobs queued for the worker threads that can be waited on
+class ENGINE_API CJobGroup {
+  public:
+    void *jg_pState; // Internal state shared with the worker threads
+
+  public:
+    // Constructor
+    CJobGroup(void);
+
+    // Destructor (waits for all remaining jobs)
+    ~CJobGroup(void);
+
+    // Queue one job item (executed immediately if there are no worker threads)
+    void Add(FWorkerJob pFunc, void *pData, INDEX iItem);
+
+    // Check if all queued jobs have been finished
+    BOOL IsDone(void) const;
+
+    // Wait until all queued jobs have been finished while helping with them on this thread
+    void Wait(void);
+};
+
+// Get amount of currently running worker threads (0 if all jobs run on the calling thread)
+ENGINE_API INDEX GetWorkerThreadCount(void);
+
+// Process all items in the [0, ctItems - 1] range on worker threads and wait for them
+ENGINE_API void ParallelFor(INDEX ctItems, FWorkerJob pFunc, void *pData);
+
+// Start and stop worker threads
+void InitWorkerThreads(void);
+void EndWorkerThreads(void);
+
+#endif  /* include-once check. */
@@ -44,6 +44,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/Stock_CModelConfig.h> // [Cecil]
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Base/IFeel.h>
+#include <Engine/Base/WorkerThreads.h> // [Cecil]
+#include <Engine/Base/SIMDKernels.h> // [Cecil]
 
 #if SE1_UNIX
   #include <cpuid.h>
@@ -89,6 +91,7 @@ static INDEX sys_iCPUModel = 0;
 static INDEX sys_iCPUStepping = 0;
 static BOOL  sys_bCPUHasMMX = 0;
 static BOOL  sys_bCPUHasCMOV = 0;
+static BOOL  sys_bCPUHasSSE2 = 0; // [Cecil]
 static INDEX sys_iCPUMHz = 0;
        INDEX sys_iCPUMisc = 0;
 
@@ -176,12 +179,14 @@ static void DetectCPU(void)
 
   BOOL bMMX  = ulFeatures & (1<<23);
   BOOL bCMOV = ulFeatures & (1<<15);
+  BOOL bSSE2 = ulFeatures & (1<<26); // [Cecil]
 
   const char *strYes = TRANS("Yes");
   const char *strNo = TRANS("No");
 
   CPrintF(TRANS("  MMX : %s\n"), bMMX ?strYes:strNo);
   CPrintF(TRANS("  CMOV: %s\n"), bCMOV?strYes:strNo);
+  CPrintF(TRANS("  SSE2: %s\n"), bSSE2?strYes:strNo); // [Cecil]
   CPrintF(TRANS("  Clock: %.0fMHz\n"), _pTimer->GetCPUSpeedHz() / 1E6);
 
   sys_strCPUVendor = strVendor;
@@ -191,6 +196,7 @@ static void DetectCPU(void)
   sys_iCPUStepping = iStepping;
   sys_bCPUHasMMX = bMMX!=0;
   sys_bCPUHasCMOV = bCMOV!=0;
+  sys_bCPUHasSSE2 = bSSE2!=0; // [Cecil]
   sys_iCPUMHz = INDEX(_pTimer->GetCPUSpeedHz() / 1E6);
 
   if( !bMMX) FatalError( TRANS("MMX support required but not present!"));
@@ -476,6 +482,10 @@ void SE_InitEngine(const SeriousEngineSetup &engineSetup) {
 
   // initialize zip semaphore
   zip_csLock.cs_eIndex = EThreadMutexType::E_MTX_IGNORE;  // not checked for locking order
+
+  // [Cecil] Loading state of stock objects
+  extern CTCriticalSection _csStockLoading;
+  _csStockLoading.cs_eIndex = EThreadMutexType::E_MTX_IGNORE;
  
   // add console variables
   extern INDEX con_bNoWarnings;
@@ -484,6 +494,11 @@ void SE_InitEngine(const SeriousEngineSetup &engineSetup) {
   extern FLOAT mth_fCSGEpsilon;
   _pShell->DeclareSymbol("user INDEX con_bNoWarnings;", &con_bNoWarnings);
   _pShell->DeclareSymbol("user INDEX wld_bFastObjectOptimization;", &wld_bFastObjectOptimization);
+  extern INDEX wld_bReportLoadTimes; // [Cecil]
+  _pShell->DeclareSymbol("user INDEX wld_bReportLoadTimes;", &wld_bReportLoadTimes);
+  extern INDEX wld_bReferrerIndex; // [Cecil]
+  _pShell->DeclareSymbol("persistent user INDEX wld_bReferrerIndex;", &wld_bReferrerIndex);
+  _pShell->DeclareSymbol("persistent user INDEX res_iUnusedStockKB;", &res_iUnusedStockKB); // [Cecil]
   _pShell->DeclareSymbol("user FLOAT mth_fCSGEpsilon;", &mth_fCSGEpsilon);
   _pShell->DeclareSymbol("persistent user INDEX fil_bPreferZips;", &fil_bPreferZips);
   // OS info
@@ -500,6 +515,7 @@ void SE_InitEngine(const SeriousEngineSetup &engineSetup) {
   _pShell->DeclareSymbol("user const INDEX sys_iCPUStepping   ;", &sys_iCPUStepping);
   _pShell->DeclareSymbol("user const INDEX sys_bCPUHasMMX     ;", &sys_bCPUHasMMX  );
   _pShell->DeclareSymbol("user const INDEX sys_bCPUHasCMOV    ;", &sys_bCPUHasCMOV );
+  _pShell->DeclareSymbol("user const INDEX sys_bCPUHasSSE2    ;", &sys_bCPUHasSSE2 ); // [Cecil]
   _pShell->DeclareSymbol("user const INDEX sys_iCPUMHz        ;", &sys_iCPUMHz     );
   _pShell->DeclareSymbol("     const INDEX sys_iCPUMisc       ;", &sys_iCPUMisc    );
   // RAM info
@@ -524,6 +540,36 @@ void SE_InitEngine(const SeriousEngineSetup &engineSetup) {
   _pShell->DeclareSymbol("user void DisplayRegistryContents(void);", &DisplayRegistryContents);
   _pShell->DeclareSymbol("user void CheckEntityClasses(void);", &CheckEntityClasses);
 
+  // [Cecil] Worker thread settings
+  InitWorkerThreads();
+
+  // [Cecil] Vector kernel settings
+  InitSIMDKernels(sys_bCPUHasSSE2);
+
+  // [Cecil] Entity container benchmarks
+  extern void BenchmarkEntityRemoval(void *pArgs);
+  extern void BenchmarkEntityLookup(void *pArgs);
+  _pShell->DeclareSymbol("user void BenchmarkEntityRemoval(INDEX, CTString);", &BenchmarkEntityRemoval);
+  _pShell->DeclareSymbol("user void BenchmarkEntityLookup(INDEX);", &BenchmarkEntityLookup);
+
+  // [Cecil] Entity linking to sectors
+  extern INDEX wld_bParallelSectorLinks;
+  extern void BenchmarkSectorLinking(void *pArgs);
+  _pShell->DeclareSymbol("persistent user INDEX wld_bParallelSectorLinks;", &wld_bParallelSectorLinks);
+  _pShell->DeclareSymbol("user void BenchmarkSectorLinking(INDEX);", &BenchmarkSectorLinking);
+
+  // [Cecil] Entity class lookup benchmark
+  extern void BenchmarkClassLookup(void *pArgs);
+  _pShell->DeclareSymbol("user void BenchmarkClassLookup(CTString, INDEX);", &BenchmarkClassLookup);
+
+  // [Cecil] Particle sorting and submission benchmark
+  extern void BenchmarkParticles(void *pArgs);
+  _pShell->DeclareSymbol("user void BenchmarkParticles(INDEX, INDEX);", &BenchmarkParticles);
+
+  // [Cecil] Calculation of potentially visible sectors
+  extern void MakeWorldPVS(void *pArgs);
+  _pShell->DeclareSymbol("user void MakeWorldPVS(CTString);", &MakeWorldPVS);
+
   // init MODs and stuff ...
   extern void InitStreams(void);
   InitStreams();
@@ -594,6 +640,9 @@ void SE_InitEngine(const SeriousEngineSetup &engineSetup) {
 void SE_EndEngine(void) {
   ASSERT(_bSeriousEngineInitialized);
 
+  // [Cecil] Stop worker threads before anything they might use is destroyed
+  EndWorkerThreads();
+
   // [Cecil] Remove default fonts *before* deleting the stocks, not after
   if (_pfdDisplayFont != NULL) { delete _pfdDisplayFont; _pfdDisplayFont = NULL; }
   if (_pfdConsoleFont != NULL) { delete _pfdConsoleFont; _pfdConsoleFont = NULL; }
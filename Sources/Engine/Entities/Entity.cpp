@@ -153,10 +153,12 @@ CEntity::~CEntity(void)
 {
   ASSERT(en_ctReferences==0);
   ASSERT(en_ulID!=0);
+  ASSERT(en_lhReferrers.IsEmpty()); // [Cecil]
   ASSERT(en_RenderType==RT_NONE);
   // remove it from container in its world
   ASSERT(!en_pwoWorld->wo_cenEntities.IsMember(this));
   en_pwoWorld->wo_cenAllEntities.Remove(this);
+  en_pwoWorld->RemoveEntityID(this); // [Cecil]
 
   // unset spatial clasification
   en_rdSectors.Clear();
@@ -1825,6 +1827,21 @@ void CEntity::UpdateSpatialRange(void)
 
 /* Find and remember all sectors that this entity is in. */
 void CEntity::FindSectorsAroundEntity(void)
+{
+  // if not in spatial clasification
+  if (en_fSpatialClassificationRadius<0) {
+    // do nothing
+    return;
+  }
+
+  // [Cecil] Gather sectors and link to them
+  CStaticStackArray<CBrushSector *> apbsc;
+  GetSectorsAroundEntity(apbsc);
+  LinkToSectors(apbsc);
+}
+
+// [Cecil] Gather all sectors that this entity is in without linking to them (only reads the world)
+void CEntity::GetSectorsAroundEntity(CStaticStackArray<CBrushSector *> &apbsc)
 {
   CSetFPUPrecision sfp(FPT_53BIT);
 
@@ -1841,9 +1858,6 @@ void CEntity::FindSectorsAroundEntity(void)
     en_plPlacement.pl_PositionVector, en_mRotation);
   DOUBLEobbox3D boxdEntity = FLOATtoDOUBLE(boxEntity);
 
-  // unset spatial clasification
-  en_rdSectors.Clear();
-
   // for each brush in the world
   FOREACHINDYNAMICARRAY(en_pwoWorld->wo_baBrushes.ba_abrBrushes, CBrush3D, itbr) {
     CBrush3D &br=*itbr;
@@ -1867,14 +1881,8 @@ void CEntity::FindSectorsAroundEntity(void)
 
             // if the box is inside the sector
             if (itbsc->bsc_bspBSPTree.TestBox(boxdEntity)>=0) {
-              // relate the entity to the sector
-              if (en_RenderType==RT_BRUSH
-                ||en_RenderType==RT_FIELDBRUSH
-                ||en_RenderType==RT_TERRAIN) {  // brushes first
-                AddRelationPairHeadHead(itbsc->bsc_rsEntities, en_rdSectors);
-              } else {
-                AddRelationPairTailTail(itbsc->bsc_rsEntities, en_rdSectors);
-              }
+              // [Cecil] Remember the sector
+              apbsc.Push() = itbsc;
             }
           }
         }
@@ -1883,6 +1891,28 @@ void CEntity::FindSectorsAroundEntity(void)
   }
 }
 
+// [Cecil] Replace links to sectors with new ones
+void CEntity::LinkToSectors(const CStaticStackArray<CBrushSector *> &apbsc)
+{
+  // unset spatial clasification
+  en_rdSectors.Clear();
+
+  const INDEX ctSectors = apbsc.Count();
+
+  for (INDEX iSector = 0; iSector < ctSectors; iSector++) {
+    CBrushSector *pbsc = apbsc[iSector];
+
+    // relate the entity to the sector
+    if (en_RenderType==RT_BRUSH
+      ||en_RenderType==RT_FIELDBRUSH
+      ||en_RenderType==RT_TERRAIN) {  // brushes first
+      AddRelationPairHeadHead(pbsc->bsc_rsEntities, en_rdSectors);
+    } else {
+      AddRelationPairTailTail(pbsc->bsc_rsEntities, en_rdSectors);
+    }
+  }
+}
+
 void CEntity::FindSectorsAroundEntityNear(void)
 {
   ASSERT(GetFPUPrecision()==FPT_24BIT);
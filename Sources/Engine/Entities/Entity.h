@@ -206,6 +206,7 @@ public:
   public: // these must be public for iteration
   CListNode en_lnInParent;      // node in the parent entity
   CListHead en_lhChildren;      // list of child entities
+  CListHead en_lhReferrers;     // [Cecil] tracked property pointers of other entities that point to this one
   public:
   CPlacement3D en_plRelativeToParent;   // placement relative to parent placement
 
@@ -262,6 +263,10 @@ public:
   /* Find and remember all sectors that this entity is in. */
   void FindSectorsAroundEntity(void);
   void FindSectorsAroundEntityNear(void);
+  // [Cecil] Gather all sectors that this entity is in without linking to them (only reads the world)
+  void GetSectorsAroundEntity(CStaticStackArray<CBrushSector *> &apbsc);
+  // [Cecil] Replace links to sectors with new ones
+  void LinkToSectors(const CStaticStackArray<CBrushSector *> &apbsc);
 
   // add entity to collision grid
   void AddToCollisionGrid(void);
@@ -717,22 +722,37 @@ __forceinline BOOL IsDerivedFromClass(CEntity *pen, const CTString &strClassName
 };
 
 // all standard smart pointer functions are here as inlines
-inline CEntityPointer::CEntityPointer(void) : ep_pen(NULL) {};
+inline CEntityPointer::CEntityPointer(void) : ep_pen(NULL), ep_penOwner(NULL) {};
 inline CEntityPointer::~CEntityPointer(void) {
+  // [Cecil] stop referring before the entity can be deleted
+  if (ep_lnInReferrers.IsLinked()) ep_lnInReferrers.Remove();
   if (ep_pen != NULL) ep_pen->RemReference();
 };
-inline CEntityPointer::CEntityPointer(const CEntityPointer &penOther) : ep_pen(penOther.ep_pen) {
+inline CEntityPointer::CEntityPointer(const CEntityPointer &penOther) : ep_pen(penOther.ep_pen), ep_penOwner(NULL) {
   if (ep_pen != NULL) ep_pen->AddReference();
 };
-inline CEntityPointer::CEntityPointer(CEntity *pen) : ep_pen(pen) {
+inline CEntityPointer::CEntityPointer(CEntity *pen) : ep_pen(pen), ep_penOwner(NULL) {
   if (ep_pen != NULL) ep_pen->AddReference();
 };
 inline const CEntityPointer &CEntityPointer::operator=(CEntity *pen) {
   if (pen != NULL) pen->AddReference();    // must first add, then remove!
+
+  // [Cecil] move into referrers of the new entity
+  if (ep_penOwner != NULL) {
+    if (ep_lnInReferrers.IsLinked()) ep_lnInReferrers.Remove();
+    if (pen != NULL) pen->en_lhReferrers.AddTail(ep_lnInReferrers);
+  }
+
   if (ep_pen != NULL) ep_pen->RemReference();
   ep_pen = pen;
   return *this;
 };
+// [Cecil] track this pointer as a property of some entity
+inline void CEntityPointer::SetOwner(CEntity *penOwner) {
+  ep_penOwner = penOwner;
+  if (ep_lnInReferrers.IsLinked()) ep_lnInReferrers.Remove();
+  if (ep_penOwner != NULL && ep_pen != NULL) ep_pen->en_lhReferrers.AddTail(ep_lnInReferrers);
+};
 
 /////////////////////////////////////////////////////////////////////
 // Reference counting functions
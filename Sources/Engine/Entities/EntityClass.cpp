@@ -22,6 +22,11 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Entities/Precaching.h>
 #include <Engine/Base/Translation.h>
 #include <Engine/Base/CRCTable.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/World/World.h>
+#include <Engine/Templates/DynamicContainer.cpp>
 
 #include <Engine/Templates/Stock_CEntityClass.h>
 
@@ -43,6 +48,9 @@ CEntityClass::CEntityClass(class CDLLEntityClass *pdecDLLClass)
 {
   ec_pdecDLLClass = pdecDLLClass;
   ec_fnmClassDLL.Clear();
+
+  // [Cecil] Make lookup tables for the whole class hierarchy
+  ec_pdecDLLClass->PrepareLookups();
 }
 
 /*
@@ -75,6 +83,9 @@ void CEntityClass::Clear(void)
 
       // Release all components needed by the DLL
       ec_pdecDLLClass->ReleaseComponents();
+
+      // Forget lookup tables
+      ec_pdecDLLClass->ClearLookups();
     }
 
     // [Cecil] The library should never be released from memory because declared
@@ -261,6 +272,9 @@ void CEntityClass::Read_t( CTStream *istr) // throw char *
   // attach the DLL
   ec_pdecDLLClass->dec_OnInitClass();
 
+  // [Cecil] Make lookup tables for the whole class hierarchy
+  ec_pdecDLLClass->PrepareLookups();
+
   // check that the class properties have been properly declared
   CheckClassProperties();
 }
@@ -349,80 +363,311 @@ class CEntityProperty *CDLLEntityClass::PropertyForName(const CTString &strPrope
   }
 }
 
-/*
- * Get pointer to entity property from its packed identifier.
- */
-class CEntityProperty *CDLLEntityClass::PropertyForTypeAndID(
+// [Cecil] Hash tables of properties, components and handlers of a class and all of its base classes
+struct SClassLookup {
+  CStaticArray<CEntityProperty *> cl_apepProperties; // properties by their identifiers
+  CStaticArray<CEntityComponent *> cl_apecComponents; // components by their identifiers
+  CStaticArray<CEntityComponent *> cl_apecPointers; // obtained components by their pointers
+  CStaticArray<CEventHandlerEntry *> cl_aeheHandlers; // handlers by their states
+  ULONG cl_ulPointerChanges; // component pointer changes when the pointer table was filled
+};
+
+// [Cecil] Incremented whenever any component gets a new pointer or loses it
+extern ULONG _ulComponentPointerChanges;
+
+// [Cecil] Get home slot of a key in a lookup table
+static inline INDEX LookupSlot(ULONG ulKey, INDEX ctSlots)
+{
+  // Identifiers of properties and states only differ in a few bits, so mix them up
+  ulKey ^= ulKey >> 16;
+  ulKey *= 0x85EBCA6BUL;
+  ulKey ^= ulKey >> 13;
+  return INDEX(ulKey & (ctSlots - 1));
+}
+
+// [Cecil] Get home slot of a component pointer in a lookup table
+static inline INDEX LookupSlot(const void *pv, INDEX ctSlots)
+{
+  return LookupSlot(ULONG(size_t(pv) >> 4), ctSlots);
+}
+
+// [Cecil] Keys of lookup table entries
+static inline ULONG LookupKey(const CEntityProperty &ep) { return ep.ep_ulID; }
+static inline ULONG LookupKey(const CEntityComponent &ec) { return ec.ec_slID; }
+static inline ULONG LookupKey(const CEventHandlerEntry &ehe) { return ehe.ehe_slState; }
+
+// [Cecil] Create an empty lookup table that stays at most half full
+template<class Type>
+static void NewLookup(CStaticArray<Type *> &apTable, INDEX ctEntries)
+{
+  INDEX ctSlots = 4;
+
+  while (ctSlots < ctEntries * 2) {
+    ctSlots *= 2;
+  }
+
+  apTable.Clear();
+  apTable.New(ctSlots);
+
+  for (INDEX iSlot = 0; iSlot < ctSlots; iSlot++) {
+    apTable[iSlot] = NULL;
+  }
+}
+
+// [Cecil] Add an entry to a lookup table unless there's already one with the same key
+template<class Type>
+static void AddToLookup(CStaticArray<Type *> &apTable, Type &entry)
+{
+  const ULONG ulKey = LookupKey(entry);
+  const INDEX ctSlots = apTable.Count();
+  INDEX iSlot = LookupSlot(ulKey, ctSlots);
+
+  while (apTable[iSlot] != NULL) {
+    // Classes are added from the most derived one, which should take priority like before
+    if (LookupKey(*apTable[iSlot]) == ulKey) return;
+    iSlot = (iSlot + 1) & (ctSlots - 1);
+  }
+
+  apTable[iSlot] = &entry;
+}
+
+// [Cecil] Find an entry in a lookup table by its key
+template<class Type>
+static Type *FindInLookup(const CStaticArray<Type *> &apTable, ULONG ulKey)
+{
+  const INDEX ctSlots = apTable.Count();
+  INDEX iSlot = LookupSlot(ulKey, ctSlots);
+
+  FOREVER {
+    Type *pEntry = apTable[iSlot];
+    if (pEntry == NULL || LookupKey(*pEntry) == ulKey) return pEntry;
+
+    iSlot = (iSlot + 1) & (ctSlots - 1);
+  }
+}
+
+// [Cecil] Fill lookup table of components by their current pointers
+static void FillPointerLookup(CDLLEntityClass *pdecClass, CStaticArray<CEntityComponent *> &apecTable)
+{
+  const INDEX ctSlots = apecTable.Count();
+
+  for (INDEX iSlot = 0; iSlot < ctSlots; iSlot++) {
+    apecTable[iSlot] = NULL;
+  }
+
+  for (CDLLEntityClass *pdec = pdecClass; pdec != NULL; pdec = pdec->dec_pdecBase) {
+    for (INDEX iComponent = 0; iComponent < pdec->dec_ctComponents; iComponent++) {
+      CEntityComponent &ec = pdec->dec_aecComponents[iComponent];
+
+      // Skip components that aren't obtained
+      if (ec.ec_pvPointer == NULL) continue;
+
+      INDEX iSlot = LookupSlot(ec.ec_pvPointer, ctSlots);
+      BOOL bAdded = FALSE;
+
+      while (apecTable[iSlot] != NULL) {
+        // Same resource in a base class
+        if (apecTable[iSlot]->ec_pvPointer == ec.ec_pvPointer) {
+          bAdded = TRUE;
+          break;
+        }
+
+        iSlot = (iSlot + 1) & (ctSlots - 1);
+      }
+
+      if (!bAdded) apecTable[iSlot] = &ec;
+    }
+  }
+}
+
+// [Cecil] Find component by its pointer in the lookup table
+static CEntityComponent *FindPointerInLookup(const CStaticArray<CEntityComponent *> &apecTable, void *pv)
+{
+  const INDEX ctSlots = apecTable.Count();
+  INDEX iSlot = LookupSlot(pv, ctSlots);
+
+  FOREVER {
+    CEntityComponent *pec = apecTable[iSlot];
+    if (pec == NULL || pec->ec_pvPointer == pv) return pec;
+
+    iSlot = (iSlot + 1) & (ctSlots - 1);
+  }
+}
+
+// [Cecil] Make hash tables for lookups through the whole class hierarchy (if not made yet)
+void CDLLEntityClass::PrepareLookups(void)
+{
+  if (dec_pLookup != NULL) return;
+
+  // Count entries of all classes in the hierarchy
+  INDEX ctProperties = 0;
+  INDEX ctComponents = 0;
+  INDEX ctHandlers = 0;
+
+  CDLLEntityClass *pdec;
+
+  for (pdec = this; pdec != NULL; pdec = pdec->dec_pdecBase) {
+    ctProperties += pdec->dec_ctProperties;
+    ctComponents += pdec->dec_ctComponents;
+    ctHandlers += pdec->dec_ctHandlers;
+  }
+
+  SClassLookup *pcl = new SClassLookup;
+  NewLookup(pcl->cl_apepProperties, ctProperties);
+  NewLookup(pcl->cl_apecComponents, ctComponents);
+  NewLookup(pcl->cl_apecPointers, ctComponents);
+  NewLookup(pcl->cl_aeheHandlers, ctHandlers);
+
+  // Add entries from this class down to the base one
+  for (pdec = this; pdec != NULL; pdec = pdec->dec_pdecBase) {
+    INDEX i;
+
+    for (i = 0; i < pdec->dec_ctProperties; i++) {
+      AddToLookup(pcl->cl_apepProperties, pdec->dec_aepProperties[i]);
+    }
+
+    for (i = 0; i < pdec->dec_ctComponents; i++) {
+      AddToLookup(pcl->cl_apecComponents, pdec->dec_aecComponents[i]);
+    }
+
+    for (i = 0; i < pdec->dec_ctHandlers; i++) {
+      AddToLookup(pcl->cl_aeheHandlers, pdec->dec_aeheHandlers[i]);
+    }
+  }
+
+  FillPointerLookup(this, pcl->cl_apecPointers);
+  pcl->cl_ulPointerChanges = _ulComponentPointerChanges;
+
+  dec_pLookup = pcl;
+};
+
+// [Cecil] Free hash tables for lookups
+void CDLLEntityClass::ClearLookups(void)
+{
+  delete dec_pLookup;
+  dec_pLookup = NULL;
+};
+
+// [Cecil] Find property by going through the whole class hierarchy
+static CEntityProperty *LinearPropertyForTypeAndID(CDLLEntityClass *pdecClass,
   CEntityProperty::PropertyType eptType, ULONG ulID)
 {
-  // for each property
-  for (INDEX iProperty=0; iProperty<dec_ctProperties; iProperty++) {
-    // if it has that same identifier
-    if (dec_aepProperties[iProperty].ep_ulID==ulID) {
+  for (CDLLEntityClass *pdec = pdecClass; pdec != NULL; pdec = pdec->dec_pdecBase) {
+    for (INDEX iProperty = 0; iProperty < pdec->dec_ctProperties; iProperty++) {
+      CEntityProperty &ep = pdec->dec_aepProperties[iProperty];
 
-      // if it also has same type
-      if (dec_aepProperties[iProperty].ep_eptType==eptType) {
-        // return it
-        return &dec_aepProperties[iProperty];
+      // Property with the same identifier but a different type is treated as missing
+      if (ep.ep_ulID == ulID) {
+        return (ep.ep_eptType == eptType) ? &ep : NULL;
+      }
+    }
+  }
 
-      // if it has different type
-      } else {
-        // return that it was not found, this makes the whole thing much safer
-        return NULL;
+  return NULL;
+};
+
+// [Cecil] Find component by going through the whole class hierarchy
+static CEntityComponent *LinearComponentForID(CDLLEntityClass *pdecClass, SLONG slID)
+{
+  for (CDLLEntityClass *pdec = pdecClass; pdec != NULL; pdec = pdec->dec_pdecBase) {
+    for (INDEX iComponent = 0; iComponent < pdec->dec_ctComponents; iComponent++) {
+      if (pdec->dec_aecComponents[iComponent].ec_slID == slID) {
+        return &pdec->dec_aecComponents[iComponent];
       }
     }
   }
-  // if base class exists
-  if (dec_pdecBase!=NULL) {
-    // look in the base class
-    return dec_pdecBase->PropertyForTypeAndID(eptType, ulID);
-  // otherwise
-  } else {
-    // none found
-    return NULL;
+
+  return NULL;
+};
+
+// [Cecil] Find component by its pointer by going through the whole class hierarchy
+static CEntityComponent *LinearComponentForPointer(CDLLEntityClass *pdecClass, void *pv)
+{
+  for (CDLLEntityClass *pdec = pdecClass; pdec != NULL; pdec = pdec->dec_pdecBase) {
+    for (INDEX iComponent = 0; iComponent < pdec->dec_ctComponents; iComponent++) {
+      if (pdec->dec_aecComponents[iComponent].ec_pvPointer == pv) {
+        return &pdec->dec_aecComponents[iComponent];
+      }
+    }
   }
+
+  return NULL;
 };
 
-// [Cecil] Get pointer to component from its identifier, ignoring the type (IDs must be unique anyway)
-CEntityComponent *CDLLEntityClass::ComponentForID(SLONG slID)
+// [Cecil] Find event handler by going through the whole class hierarchy
+static CEntity::pEventHandler LinearHandlerForState(CDLLEntityClass *pdecClass, SLONG slState)
 {
-  for (INDEX iComponent = 0; iComponent < dec_ctComponents; iComponent++) {
-    // Obtain and return the component with the same identifier
-    if (dec_aecComponents[iComponent].ec_slID == slID)
-    {
-      dec_aecComponents[iComponent].ObtainWithCheck();
-      return &dec_aecComponents[iComponent];
+  for (CDLLEntityClass *pdec = pdecClass; pdec != NULL; pdec = pdec->dec_pdecBase) {
+    for (INDEX iHandler = 0; iHandler < pdec->dec_ctHandlers; iHandler++) {
+      if (pdec->dec_aeheHandlers[iHandler].ehe_slState == slState) {
+        return pdec->dec_aeheHandlers[iHandler].ehe_pEventHandler;
+      }
     }
   }
 
-  // Try looking for it in the base class
-  if (dec_pdecBase != NULL) {
-    return dec_pdecBase->ComponentForID(slID);
+  return NULL;
+};
+
+/*
+ * Get pointer to entity property from its packed identifier.
+ */
+class CEntityProperty *CDLLEntityClass::PropertyForTypeAndID(
+  CEntityProperty::PropertyType eptType, ULONG ulID)
+{
+  // [Cecil] Look it up in the hash table
+  PrepareLookups();
+  CEntityProperty *pep = FindInLookup(dec_pLookup->cl_apepProperties, ulID);
+
+  // if it has different type, return that it was not found, this makes the whole thing much safer
+  if (pep == NULL || pep->ep_eptType != eptType) {
+    return NULL;
   }
 
+  return pep;
+};
+
+// [Cecil] Get pointer to component from its identifier, ignoring the type (IDs must be unique anyway)
+CEntityComponent *CDLLEntityClass::ComponentForID(SLONG slID)
+{
+  // Look it up in the hash table
+  PrepareLookups();
+  CEntityComponent *pec = FindInLookup(dec_pLookup->cl_apecComponents, ULONG(slID));
+
   // None found
-  return NULL;
+  if (pec == NULL) return NULL;
+
+  // Obtain and return the component with the same identifier
+  pec->ObtainWithCheck();
+  return pec;
 };
 
 // Get pointer to component from the component
 CEntityComponent *CDLLEntityClass::ComponentForPointer(void *pv)
 {
-  for (INDEX iComponent = 0; iComponent < dec_ctComponents; iComponent++) {
-    // Obtain and return the component with the same pointer
-    if (dec_aecComponents[iComponent].ec_pvPointer == pv)
-    {
-      dec_aecComponents[iComponent].ObtainWithCheck();
-      return &dec_aecComponents[iComponent];
+  CEntityComponent *pec;
+
+  // [Cecil] Components that aren't obtained have no pointers to look up
+  if (pv == NULL) {
+    pec = LinearComponentForPointer(this, pv);
+
+  } else {
+    PrepareLookups();
+
+    // Components get new pointers whenever they are obtained or released, so refresh the table
+    if (dec_pLookup->cl_ulPointerChanges != _ulComponentPointerChanges) {
+      FillPointerLookup(this, dec_pLookup->cl_apecPointers);
+      dec_pLookup->cl_ulPointerChanges = _ulComponentPointerChanges;
     }
-  }
 
-  // Try looking for it in the base class
-  if (dec_pdecBase != NULL) {
-    return dec_pdecBase->ComponentForPointer(pv);
+    pec = FindPointerInLookup(dec_pLookup->cl_apecPointers, pv);
   }
 
   // None found
-  return NULL;
+  if (pec == NULL) return NULL;
+
+  // Obtain and return the component with the same pointer
+  pec->ObtainWithCheck();
+  return pec;
 };
 
 // [Cecil] Precache any component by its identifier
@@ -448,23 +693,14 @@ CEntity::pEventHandler CDLLEntityClass::HandlerForStateAndEvent(SLONG slState, S
   // we ignore the event code here
   (void) slEvent;
 
-  // for each handler
-  for (INDEX iHandler=0; iHandler<dec_ctHandlers; iHandler++) {
-    // if it has that same state
-    if (dec_aeheHandlers[iHandler].ehe_slState==slState) {
-      // return it
-      return dec_aeheHandlers[iHandler].ehe_pEventHandler;
-    }
-  }
-  // if base class exists
-  if (dec_pdecBase!=NULL) {
-    // look in the base class
-    return dec_pdecBase->HandlerForStateAndEvent(slState, slEvent);
-  // otherwise
-  } else {
-    // none found
-    return NULL;
-  }
+  // [Cecil] Look it up in the hash table
+  PrepareLookups();
+  CEventHandlerEntry *pehe = FindInLookup(dec_pLookup->cl_aeheHandlers, ULONG(slState));
+
+  // none found
+  if (pehe == NULL) return NULL;
+
+  return pehe->ehe_pEventHandler;
 }
 
 /* Get event handler name for given state. */
@@ -511,3 +747,158 @@ SLONG CDLLEntityClass::GetOverridenState(SLONG slState)
     return slState;
   }
 }
+
+// [Cecil] Same as CRationalEntity::HandleEvent() but finds handlers by going through the whole class hierarchy
+static BOOL LinearHandleEvent(CRationalEntity *pen, const CEntityEvent &ee)
+{
+  CDLLEntityClass *pdec = pen->en_pecClass->ec_pdecDLLClass;
+
+  for (INDEX iState = pen->en_stslStateStack.Count() - 1; iState >= 0; iState--) {
+    CEntity::pEventHandler pehHandler = LinearHandlerForState(pdec, pen->en_stslStateStack[iState]);
+
+    if (pehHandler != NULL && (pen->*pehHandler)(ee)) return TRUE;
+  }
+
+  return FALSE;
+};
+
+// [Cecil] Compare looking up properties and event handlers of entities in some world with and without hash tables
+void BenchmarkClassLookup(void *pArgs) {
+  const CTFileName fnmWorld = *NEXTARGUMENT(CTString *);
+  INDEX ctCalls = NEXTARGUMENT(INDEX);
+  if (ctCalls <= 0) ctCalls = 1000000;
+
+  CWorld wo;
+
+  try {
+    wo.Load_t(fnmWorld);
+
+  } catch (char *strError) {
+    CPrintF(TRANS("Cannot load world '%s':\n%s\n"), fnmWorld.ConstData(), strError);
+    return;
+  }
+
+  // Gather properties of all entities, like when reading them, and rational entities that can receive events
+  CStaticStackArray<CDLLEntityClass *> apdecProperties;
+  CStaticStackArray<CEntityProperty *> apepProperties;
+  CStaticStackArray<CEntity *> apenRational;
+  INDEX ctStates = 0;
+
+  FOREACHINDYNAMICCONTAINER(wo.wo_cenAllEntities, CEntity, iten) {
+    CDLLEntityClass *pdecClass = iten->en_pecClass->ec_pdecDLLClass;
+    BOOL bRational = FALSE;
+
+    for (CDLLEntityClass *pdec = pdecClass; pdec != NULL; pdec = pdec->dec_pdecBase) {
+      for (INDEX iProperty = 0; iProperty < pdec->dec_ctProperties; iProperty++) {
+        apdecProperties.Push() = pdecClass;
+        apepProperties.Push() = &pdec->dec_aepProperties[iProperty];
+      }
+
+      if (pdec == &CRationalEntity_DLLClass) bRational = TRUE;
+    }
+
+    if (bRational) {
+      CRationalEntity *penRational = (CRationalEntity *)&*iten;
+      const INDEX ctStack = penRational->en_stslStateStack.Count();
+
+      if (ctStack > 0) {
+        apenRational.Push() = penRational;
+        ctStates += ctStack;
+      }
+    }
+  }
+
+  const INDEX ctProperties = apepProperties.Count();
+  const INDEX ctRational = apenRational.Count();
+
+  if (ctProperties == 0) {
+    CPrintF(TRANS("No entities in '%s'!\n"), fnmWorld.ConstData());
+    return;
+  }
+
+  INDEX iCall;
+  INDEX ctMismatches = 0;
+
+  // Find properties using hash tables
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+  INDEX ctFoundHashed = 0;
+
+  for (iCall = 0; iCall < ctCalls; iCall++) {
+    const CEntityProperty *pep = apepProperties[iCall % ctProperties];
+    if (apdecProperties[iCall % ctProperties]->PropertyForTypeAndID(pep->ep_eptType, pep->ep_ulID) != NULL) ctFoundHashed++;
+  }
+
+  const DOUBLE dPropertiesHashed = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+  // Find properties by going through all classes
+  tvStart = _pTimer->GetHighPrecisionTimer();
+  INDEX ctFoundLinear = 0;
+
+  for (iCall = 0; iCall < ctCalls; iCall++) {
+    const CEntityProperty *pep = apepProperties[iCall % ctProperties];
+    if (LinearPropertyForTypeAndID(apdecProperties[iCall % ctProperties], pep->ep_eptType, pep->ep_ulID) != NULL) ctFoundLinear++;
+  }
+
+  const DOUBLE dPropertiesLinear = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+  if (ctFoundHashed != ctFoundLinear) ctMismatches++;
+
+  // Make sure that both methods agree
+  for (INDEX iProperty = 0; iProperty < ctProperties; iProperty++) {
+    CDLLEntityClass *pdec = apdecProperties[iProperty];
+    const CEntityProperty *pep = apepProperties[iProperty];
+
+    if (pdec->PropertyForTypeAndID(pep->ep_eptType, pep->ep_ulID)
+     != LinearPropertyForTypeAndID(pdec, pep->ep_eptType, pep->ep_ulID)) ctMismatches++;
+  }
+
+  CPrintF(TRANS("Looked up %d properties of %d entities %d times:\n"), ctProperties, wo.wo_cenAllEntities.Count(), ctCalls);
+  CPrintF(TRANS("  Hashed: %.2f ms\n"), dPropertiesHashed * 1000.0);
+  CPrintF(TRANS("  Linear: %.2f ms\n"), dPropertiesLinear * 1000.0);
+
+  // Dispatch an event that no handler expects, so it goes through all states on the stack
+  // and only reaches the default branches of the handlers
+  if (ctRational > 0) {
+    // Make sure that both methods agree before handlers get a chance to change any states
+    for (INDEX iRational = 0; iRational < ctRational; iRational++) {
+      CRationalEntity *pen = (CRationalEntity *)apenRational[iRational];
+      CDLLEntityClass *pdec = pen->en_pecClass->ec_pdecDLLClass;
+
+      for (INDEX iState = pen->en_stslStateStack.Count() - 1; iState >= 0; iState--) {
+        const SLONG slState = pen->en_stslStateStack[iState];
+        if (pdec->HandlerForStateAndEvent(slState, 0) != LinearHandlerForState(pdec, slState)) ctMismatches++;
+      }
+    }
+
+    const CEntityEvent eeBenchmark(-1);
+
+    tvStart = _pTimer->GetHighPrecisionTimer();
+    ctFoundHashed = 0;
+
+    for (iCall = 0; iCall < ctCalls; iCall++) {
+      CRationalEntity *pen = (CRationalEntity *)apenRational[iCall % ctRational];
+      if (pen->HandleEvent(eeBenchmark)) ctFoundHashed++;
+    }
+
+    const DOUBLE dEventsHashed = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+    tvStart = _pTimer->GetHighPrecisionTimer();
+    ctFoundLinear = 0;
+
+    for (iCall = 0; iCall < ctCalls; iCall++) {
+      CRationalEntity *pen = (CRationalEntity *)apenRational[iCall % ctRational];
+      if (LinearHandleEvent(pen, eeBenchmark)) ctFoundLinear++;
+    }
+
+    const DOUBLE dEventsLinear = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+    CPrintF(TRANS("Dispatched %d events to %d entities with %d states (%d and %d handled):\n"),
+      ctCalls, ctRational, ctStates, ctFoundHashed, ctFoundLinear);
+    CPrintF(TRANS("  Hashed: %.2f ms\n"), dEventsHashed * 1000.0);
+    CPrintF(TRANS("  Linear: %.2f ms\n"), dEventsLinear * 1000.0);
+  }
+
+  if (ctMismatches > 0) {
+    CPrintF(TRANS("  %d lookups have failed!\n"), ctMismatches);
+  }
+};
@@ -19,6 +19,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
   #pragma once
 #endif
 
+#include <Engine/Base/Lists.h>
+
 // [Cecil] Reverted inline definitions of all methods to remove dependency on the entity class
 class CEntity;
 
@@ -28,6 +30,8 @@ class CEntity;
 class CEntityPointer {
 public:
   CEntity *ep_pen;  // the pointer itself
+  CEntity *ep_penOwner; // [Cecil] entity that has this pointer as a property (NULL if not tracked)
+  CListNode ep_lnInReferrers; // [Cecil] node in the list of referrers of the pointed entity
 
 public:
   // all standard smart pointer functions are defined as inlines in Entity.h
@@ -44,6 +48,9 @@ public:
     return operator=(penOther.ep_pen);
   };
 
+  // [Cecil] Track this pointer as a property of some entity (NULL to stop tracking)
+  inline void SetOwner(CEntity *penOwner);
+
   // Casting operators
   inline CEntity *operator->(void) const { return ep_pen; };
   inline operator CEntity *(void) const { return ep_pen; };
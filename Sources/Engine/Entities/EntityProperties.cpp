@@ -598,6 +598,9 @@ void CEntity::WriteProperties_t(CTStream &ostrm) // throw char *
 /////////////////////////////////////////////////////////////////////
 // Component management functions
 
+// [Cecil] Incremented whenever any component gets a new pointer or loses it
+ULONG _ulComponentPointerChanges = 0;
+
 /*
  * Obtain the component.
  */
@@ -659,6 +662,9 @@ void CEntityComponent::Obtain_t(void)  // throw char *
     // report warning
     CPrintF(TRANS("Not precached: (0x%08X)'%s'\n"), ec_slID, ec_fnmComponent.ConstData());
   }
+
+  // [Cecil] Lookup tables of components by their pointers are outdated now
+  _ulComponentPointerChanges++;
   //CPrintF(TRANS("Precaching NOW: (0x%08X)'%s'\n"), ec_slID, ec_fnmComponent.ConstData());
 
   // add to CRC
@@ -741,6 +747,7 @@ void CEntityComponent::Release(void)
 
   // released
   ec_pvPointer=NULL;
+  _ulComponentPointerChanges++; // [Cecil]
 }
 
 // these entity classes are bases, here stop all recursive searches
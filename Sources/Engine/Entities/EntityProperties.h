@@ -214,6 +214,10 @@ public:
   void (*dec_OnWorldRender)(CWorld *pwoWorld);  // function called for each rendering
   void (*dec_OnWorldEnd)(CWorld *pwoWorld);     // function called on world cleanup
 
+  // [Cecil] Hash tables of properties, components and handlers of this class and all of its base classes
+  // (NULL in class definitions and made when the class is loaded)
+  struct SClassLookup *dec_pLookup;
+
   /* Get pointer to entity property from its name. */
   class CEntityProperty *PropertyForName(const CTString &strPropertyName);
   /* Get pointer to entity property from its packed identifier. */
@@ -231,6 +235,12 @@ public:
   // Get pointer to component from the component
   CEntityComponent *ComponentForPointer(void *pv);
 
+  // [Cecil] Make hash tables for lookups through the whole class hierarchy (if not made yet)
+  void PrepareLookups(void);
+
+  // [Cecil] Free hash tables for lookups
+  void ClearLookups(void);
+
   // [Cecil] Precache any component by its identifier
   void PrecacheResource(SLONG slID, INDEX iUser = -1);
 
@@ -278,7 +288,8 @@ public:
     &classname##_OnWorldInit,                                         \
     &classname##_OnWorldTick,                                         \
     &classname##_OnWorldRender,                                       \
-    &classname##_OnWorldEnd                                           \
+    &classname##_OnWorldEnd,                                          \
+    NULL /* [Cecil] dec_pLookup */                                    \
   };\
   ClassRegistrar classname##_AddToRegistry(#classname, &classname##_DLLClass)
 
@@ -286,7 +297,8 @@ public:
   extern "C" SE1_API_EXPORT CDLLEntityClass classname##_DLLClass; \
   CDLLEntityClass classname##_DLLClass = {                            \
     NULL,0, NULL,0, NULL,0, "", "", id,                               \
-    NULL, NULL,NULL,NULL,NULL, NULL,NULL,NULL,NULL                    \
+    NULL, NULL,NULL,NULL,NULL, NULL,NULL,NULL,NULL,                   \
+    NULL /* [Cecil] dec_pLookup */                                    \
   }
 
 inline ENGINE_API void ClearToDefault(FLOAT &f) { f = 0.0f; };
@@ -22,7 +22,11 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Graphics/Vertex.h>
 #include <Engine/Graphics/Texture.h>
 #include <Engine/Graphics/Fog_internal.h>
+#include <Engine/Graphics/ImageInfo.h> // [Cecil]
 #include <Engine/Base/Statistics_internal.h>
+#include <Engine/Base/Console.h> // [Cecil]
+#include <Engine/Base/Shell.h> // [Cecil]
+#include <Engine/Base/Timer.h> // [Cecil]
 
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Templates/StaticStackArray.cpp>
@@ -52,6 +56,20 @@ static CStaticStackArray<GFXTexCoord> _atexFogHaze;
 static CTextureData *_ptd = NULL;
 static INDEX _iFrame = 0;
 
+// [Cecil] Merge consecutive particle flushes with the same rendering state into one
+extern INDEX gfx_bBatchParticles;
+
+// [Cecil] Rendering state of the current particles
+static enum ParticleBlendType _pbtCurrent = PBT_BLEND;
+static BOOL _bCurrentFog  = FALSE;
+static BOOL _bCurrentHaze = FALSE;
+
+static BOOL _bFlushPending = FALSE; // [Cecil] current particles haven't been rendered yet
+static INDEX _ctPendingVertices = 0; // [Cecil] amount of vertices when the flush was postponed
+static INDEX _iFirstUnsorted = 0; // [Cecil] first particle that has been added since the last postponed flush
+
+static void FlushParticles(void);
+
 
 
 // prepare particles for rendering
@@ -75,10 +93,17 @@ void Particle_PrepareSystem( CDrawPort *pdpDrawPort, CAnyProjection3D &prProject
   _pGfx->GetInterface()->SetTextureWrapping(GFX_REPEAT, GFX_REPEAT);
   // prepare arrays to draw from begining
   _pGfx->GetInterface()->ResetArrays();
+
+  // [Cecil] Nothing is pending in new arrays
+  _bFlushPending = FALSE;
+  _iFirstUnsorted = 0;
 }
 
 void Particle_EndSystem( BOOL bRestoreOrtho/*=TRUE*/)
 {
+  // [Cecil] Render the last batch
+  if (_bFlushPending) FlushParticles();
+
   // reset projection and re-enable clipping
   if( bRestoreOrtho) _pDP->SetOrtho();
   _pGfx->GetInterface()->EnableClipping();
@@ -108,6 +133,26 @@ INDEX Particle_GetDrawPortID(void)
 
 void Particle_PrepareTexture( CTextureObject *pto, enum ParticleBlendType pbt)
 {
+  // [Cecil] If previous particles are waiting to be rendered
+  if (_bFlushPending) {
+    // keep adding to them if the state is the same and nothing else has used the arrays
+    if (pto->GetData() == _ptd && pto->GetFrame() == _iFrame && pbt == _pbtCurrent
+     && _Particle_bHasFog == _bCurrentFog && _Particle_bHasHaze == _bCurrentHaze
+     && _avtxCommon.Count() == _ctPendingVertices) {
+      _bFlushPending = FALSE;
+      _iFirstUnsorted = _ctPendingVertices / 4;
+      return;
+    }
+
+    // render them with their own state
+    FlushParticles();
+  }
+
+  _pbtCurrent = pbt;
+  _bCurrentFog = _Particle_bHasFog;
+  _bCurrentHaze = _Particle_bHasHaze;
+  _iFirstUnsorted = 0;
+
   // determine blend type
   switch( pbt) {
   case PBT_BLEND:
@@ -503,9 +548,12 @@ void Particle_RenderQuad3D( const FLOAT3D &vPos0, const FLOAT3D &vPos1, const FL
 }
 
 
-// flushes particle rendering queue (i.e. renders particle on screen)
-void Particle_Flush(void)
+// [Cecil] Render all queued particles on screen
+static void FlushParticles(void)
 {
+  _bFlushPending = FALSE;
+  _iFirstUnsorted = 0;
+
   // update stats
   const INDEX ctParticles = _avtxCommon.Count()/4;
   _sfStats.IncrementCounter( CStatForm::SCI_PARTICLES, ctParticles);
@@ -559,10 +607,159 @@ void Particle_Flush(void)
   _bNeedsClipping = FALSE;
 }
 
+// flushes particle rendering queue (i.e. renders particle on screen)
+void Particle_Flush(void)
+{
+  // [Cecil] Postpone rendering in case the next particles use the same state
+  if (gfx_bBatchParticles) {
+    _bFlushPending = TRUE;
+    _ctPendingVertices = _avtxCommon.Count();
+    return;
+  }
+
+  FlushParticles();
+}
+
 
 
 // SORTING ROUTINES
 
+// [Cecil] Convert particle depth into a key that sorts unsigned integers in the order of descending depth
+static inline ULONG DepthToSortKey(FLOAT fDepth)
+{
+  ULONG ulBits;
+  memcpy(&ulBits, &fDepth, sizeof(ulBits));
+
+  // flip negative numbers completely and positive numbers by the sign to make them ascending
+  ulBits = (ulBits & 0x80000000) ? ~ulBits : (ulBits | 0x80000000);
+  return ~ulBits;
+}
+
+// [Cecil] Temporary arrays for sorting particles
+static CStaticStackArray<ULONG> _aulSortKeys;
+static CStaticStackArray<ULONG> _aulSortKeysTmp;
+static CStaticStackArray<INDEX> _aiSortOrder;
+static CStaticStackArray<INDEX> _aiSortOrderTmp;
+static CStaticStackArray<GFXVertex>   _avtxSorted;
+static CStaticStackArray<GFXTexCoord> _atexSorted;
+static CStaticStackArray<GFXColor>    _acolSorted;
+
+// [Cecil] Stable LSD radix sort of particle indices by their keys in 11-bit digits
+static void RadixSortParticles(INDEX ctParticles)
+{
+  #define RADIX_BITS 11
+  #define RADIX_SIZE (1 << RADIX_BITS)
+
+  ULONG *pulKeys = &_aulSortKeys[0];
+  ULONG *pulKeysTmp = &_aulSortKeysTmp[0];
+  INDEX *piOrder = &_aiSortOrder[0];
+  INDEX *piOrderTmp = &_aiSortOrderTmp[0];
+
+  INDEX actBuckets[RADIX_SIZE];
+
+  for (INDEX iShift = 0; iShift < 32; iShift += RADIX_BITS) {
+    memset(actBuckets, 0, sizeof(actBuckets));
+
+    INDEX i;
+    for (i = 0; i < ctParticles; i++) {
+      actBuckets[(pulKeys[i] >> iShift) & (RADIX_SIZE - 1)]++;
+    }
+
+    // skip digits that are the same in all keys (e.g. exponents of similar depths)
+    if (actBuckets[(pulKeys[0] >> iShift) & (RADIX_SIZE - 1)] == ctParticles) continue;
+
+    // turn counts into starting positions
+    INDEX iPos = 0;
+    for (i = 0; i < RADIX_SIZE; i++) {
+      const INDEX ct = actBuckets[i];
+      actBuckets[i] = iPos;
+      iPos += ct;
+    }
+
+    // scatter while keeping the order of equal digits
+    for (i = 0; i < ctParticles; i++) {
+      const INDEX iDst = actBuckets[(pulKeys[i] >> iShift) & (RADIX_SIZE - 1)]++;
+      pulKeysTmp[iDst] = pulKeys[i];
+      piOrderTmp[iDst] = piOrder[i];
+    }
+
+    Swap(pulKeys, pulKeysTmp);
+    Swap(piOrder, piOrderTmp);
+  }
+
+  // make sure that the result ends up in the main array
+  if (piOrder != &_aiSortOrder[0]) {
+    memcpy(&_aiSortOrder[0], piOrder, ctParticles * sizeof(INDEX));
+  }
+
+  #undef RADIX_BITS
+  #undef RADIX_SIZE
+}
+
+// [Cecil] Reorder four elements of each particle in some array
+template<class Type>
+static void ReorderParticleElements(Type *pSrc, CStaticStackArray<Type> &aTmp, INDEX ctParticles)
+{
+  aTmp.PopAll();
+  Type *pDst = aTmp.Push(ctParticles * 4);
+
+  for (INDEX i = 0; i < ctParticles; i++) {
+    memcpy(pDst + i * 4, pSrc + _aiSortOrder[i] * 4, 4 * sizeof(Type));
+  }
+
+  memcpy(pSrc, pDst, ctParticles * 4 * sizeof(Type));
+}
+
+
+// sorts particles by distance
+void Particle_Sort( BOOL b3D/*=FALSE*/)
+{
+  INDEX i;
+  // [Cecil] Only sort particles that have been added after the previous flush
+  const INDEX iFirst = _iFirstUnsorted;
+  const INDEX ctParticles = _avtxCommon.Count()/4 - iFirst;
+  if( ctParticles<=1) return; // nothing to do!
+
+  GFXVertex *pvtx = &_avtxCommon[iFirst*4];
+
+  // [Cecil] Make sort keys from depth and sort particles in the order of descending depth
+  _aulSortKeys.PopAll();
+  _aulSortKeysTmp.PopAll();
+  _aiSortOrder.PopAll();
+  _aiSortOrderTmp.PopAll();
+  ULONG *pulKeys = _aulSortKeys.Push(ctParticles);
+  INDEX *piOrder = _aiSortOrder.Push(ctParticles);
+  _aulSortKeysTmp.Push(ctParticles);
+  _aiSortOrderTmp.Push(ctParticles);
+
+  for( i=0; i<ctParticles; i++) {
+    const FLOAT fZ = b3D ? (pvtx[i*4].z + pvtx[i*4+1].z + pvtx[i*4+2].z + pvtx[i*4+3].z) / 4.0f : pvtx[i*4].z;
+    pulKeys[i] = DepthToSortKey(fZ);
+    piOrder[i] = i;
+  }
+
+  RadixSortParticles(ctParticles);
+
+  // [Cecil] Gather vertices, texture coords and colors in the sorted order
+  ReorderParticleElements(pvtx, _avtxSorted, ctParticles);
+  ReorderParticleElements(&_atexCommon[iFirst*4], _atexSorted, ctParticles);
+  ReorderParticleElements(&_acolCommon[iFirst*4], _acolSorted, ctParticles);
+
+  // [Cecil] Fog and haze coords belong to the same particles
+  if (_bTransFogHaze) {
+    ASSERT(_atexFogHaze.Count() == _avtxCommon.Count()+4);
+    ReorderParticleElements(&_atexFogHaze[iFirst*4], _atexSorted, ctParticles);
+  }
+
+#ifndef NDEBUG
+  // test to see whether the array is sorted
+  for( i=0; i<ctParticles-1; i++) {
+    ASSERT( DepthToSortKey(pvtx[i*4].z) <= DepthToSortKey(pvtx[(i+1)*4].z) || b3D);
+  }
+#endif
+}
+
+// [Cecil] Sort particles the original way, with a comparison callback (for benchmarking)
 static int qsort_CompareZ( const void *pI0, const void *pI1) {
   const INDEX i0 = (*(INDEX*)pI0) *4;
   const INDEX i1 = (*(INDEX*)pI1) *4;
@@ -573,74 +770,182 @@ static int qsort_CompareZ( const void *pI0, const void *pI1) {
   else              return  0;
 }
 
-static int qsort_CompareZ3D( const void *pI0, const void *pI1) {
-  const INDEX i0 = (*(INDEX*)pI0) *4;
-  const INDEX i1 = (*(INDEX*)pI1) *4;
-  const FLOAT fZ0 = (_avtxCommon[i0].z + _avtxCommon[i0+1].z + _avtxCommon[i0+2].z + _avtxCommon[i0+3].z) / 4.0f;
-  const FLOAT fZ1 = (_avtxCommon[i1].z + _avtxCommon[i1+1].z + _avtxCommon[i1+2].z + _avtxCommon[i1+3].z) / 4.0f;
-       if( fZ0<fZ1) return +1;
-  else if( fZ0>fZ1) return -1;
-  else              return  0;
+static void SortParticlesWithCallback(void)
+{
+  const INDEX ctParticles = _avtxCommon.Count()/4;
+  if( ctParticles<=1) return;
+
+  CStaticArray<INDEX> aiIndices;
+  aiIndices.New(ctParticles);
+  for (INDEX i = 0; i < ctParticles; i++) aiIndices[i] = i;
+
+  qsort( &aiIndices[0], ctParticles, sizeof(INDEX), qsort_CompareZ);
+
+  _aiSortOrder.PopAll();
+  memcpy(_aiSortOrder.Push(ctParticles), &aiIndices[0], ctParticles * sizeof(INDEX));
+
+  ReorderParticleElements(&_avtxCommon[0], _avtxSorted, ctParticles);
+  ReorderParticleElements(&_atexCommon[0], _atexSorted, ctParticles);
+  ReorderParticleElements(&_acolCommon[0], _acolSorted, ctParticles);
 }
 
+// [Cecil] Add synthetic particles with random depth into the common arrays
+static void AddSyntheticParticles(INDEX ctParticles, ULONG &ulSeed)
+{
+  GFXVertex   *pvtx = _avtxCommon.Push(ctParticles * 4);
+  GFXTexCoord *ptex = _atexCommon.Push(ctParticles * 4);
+  GFXColor    *pcol = _acolCommon.Push(ctParticles * 4);
+
+  for (INDEX i = 0; i < ctParticles * 4; i += 4) {
+    ulSeed = ulSeed * 1664525UL + 1013904223UL;
+    const FLOAT fZ = -1.0f - (ulSeed >> 8) * (1000.0f / 16777216.0f);
+    const FLOAT fX = FLOAT(ulSeed & 1023);
+    const FLOAT fY = FLOAT((ulSeed >> 10) & 767);
+
+    for (INDEX iVtx = 0; iVtx < 4; iVtx++) {
+      pvtx[i + iVtx].x = fX + (iVtx >> 1) * 4.0f;
+      pvtx[i + iVtx].y = fY + ((iVtx + 1) & 2) * 2.0f;
+      pvtx[i + iVtx].z = fZ;
+      ptex[i + iVtx].s = FLOAT(iVtx >> 1);
+      ptex[i + iVtx].t = FLOAT(((iVtx + 1) >> 1) & 1);
+      pcol[i + iVtx].abgr = ulSeed | 0xFF000000;
+    }
+  }
+}
 
-// sorts particles by distance
-void Particle_Sort( BOOL b3D/*=FALSE*/)
+// [Cecil] Submit synthetic particle batches the way particle effects do
+// Batches come in runs of 8 with the same texture, like particles of similar effects
+static void SubmitParticleBatches(CTextureObject *ato, INDEX ctTextures, INDEX ctParticles, INDEX ctPerBatch, ULONG ulSeed)
 {
-  INDEX i;
-  const INDEX ctParticles = _avtxCommon.Count()/4; 
-  if( ctParticles<=0) return; // nothing to do!
+  const INDEX ctBatches = (ctParticles + ctPerBatch - 1) / ctPerBatch;
 
-  // generate sort array
-  CStaticArray<INDEX> aiIndices;
-  aiIndices.New(ctParticles);
-  for( i=0; i<ctParticles; i++) aiIndices[i] = i;
+  _pGfx->GetInterface()->ResetArrays();
+  _atexFogHaze.PopAll();
+  _bFlushPending = FALSE;
+  _iFirstUnsorted = 0;
 
-  // bubble sort indices by vertex Z coord
-  if(b3D) qsort( &aiIndices[0], ctParticles, sizeof(INDEX), qsort_CompareZ3D);
-  else    qsort( &aiIndices[0], ctParticles, sizeof(INDEX), qsort_CompareZ);
+  for (INDEX iBatch = 0; iBatch < ctBatches; iBatch++) {
+    Particle_PrepareTexture(&ato[(iBatch / 8) % ctTextures], PBT_BLEND);
+    AddSyntheticParticles(Min(ctPerBatch, ctParticles - iBatch * ctPerBatch), ulSeed);
+    Particle_Flush();
+  }
 
-  // generate inverse table
-  CStaticArray<INDEX> aiInverse;
-  aiInverse.New(ctParticles);
-  for( i=0; i<ctParticles; i++) {
-    const INDEX iOrig = aiIndices[i];
-    aiInverse[iOrig] = i;
+  // Render the last batch
+  if (_bFlushPending) FlushParticles();
+}
+
+// [Cecil] Benchmark particle sorting and submission of particle batches
+void BenchmarkParticles(void *pArgs)
+{
+  INDEX ctParticles = NEXTARGUMENT(INDEX);
+  INDEX ctPerBatch = NEXTARGUMENT(INDEX);
+  if (ctParticles <= 0) ctParticles = 50000;
+  if (ctPerBatch <= 0) ctPerBatch = 64;
+
+  const INDEX ctPasses = 10;
+  IGfxInterface *pInterface = _pGfx->GetInterface();
+  pInterface->ResetArrays();
+
+  // Sort the same particles both ways
+  DOUBLE dCallback = 0.0, dRadix = 0.0;
+
+  for (INDEX iPass = 0; iPass < ctPasses; iPass++) {
+    ULONG ulSeed = iPass;
+    AddSyntheticParticles(ctParticles, ulSeed);
+
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+    SortParticlesWithCallback();
+    dCallback += (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+    pInterface->ResetArrays();
+    ulSeed = iPass;
+    AddSyntheticParticles(ctParticles, ulSeed);
+
+    _iFirstUnsorted = 0;
+    _bTransFogHaze = FALSE;
+
+    tvStart = _pTimer->GetHighPrecisionTimer();
+    Particle_Sort(FALSE);
+    dRadix += (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+    pInterface->ResetArrays();
   }
 
-  // sort vertices by indices
-  for( i=0; i<ctParticles;) // i is incremented in loop
-  { // fetch destination
-    INDEX &iWhere = aiInverse[i];
-    ASSERT( iWhere<ctParticles);
-    // if current is already in place, advance to next index
-    if( iWhere==i) { i++; continue; }
-    // swap vertices
-    Swap( _avtxCommon[iWhere*4+0], _avtxCommon[i*4+0]);
-    Swap( _avtxCommon[iWhere*4+1], _avtxCommon[i*4+1]);
-    Swap( _avtxCommon[iWhere*4+2], _avtxCommon[i*4+2]);
-    Swap( _avtxCommon[iWhere*4+3], _avtxCommon[i*4+3]);
-    // swap texture coords
-    Swap( _atexCommon[iWhere*4+0], _atexCommon[i*4+0]);
-    Swap( _atexCommon[iWhere*4+1], _atexCommon[i*4+1]);
-    Swap( _atexCommon[iWhere*4+2], _atexCommon[i*4+2]);
-    Swap( _atexCommon[iWhere*4+3], _atexCommon[i*4+3]);
-    // swap colors
-    Swap( _acolCommon[iWhere*4+0], _acolCommon[i*4+0]);
-    Swap( _acolCommon[iWhere*4+1], _acolCommon[i*4+1]);
-    Swap( _acolCommon[iWhere*4+2], _acolCommon[i*4+2]);
-    Swap( _acolCommon[iWhere*4+3], _acolCommon[i*4+3]);
-    // swap indices
-    Swap( aiInverse[iWhere], aiInverse[i]);
+  CPrintF(TRANS("Sorting %d particles: %.3f ms with a comparison callback, %.3f ms with radix sort\n"),
+    ctParticles, dCallback * 1000.0 / ctPasses, dRadix * 1000.0 / ctPasses);
+
+  // Submitting through a real API would draw over the screen outside of rendering
+  if (pInterface->GetType() != GAT_NONE) {
+    CPutString(TRANS("Submission is only timed with the null graphics API.\n"));
+    return;
   }
 
-#ifndef NDEBUG
-  // test to see whether the array is sorted
-  INDEX      *pidx = &aiInverse[0];
-  GFXVertex4 *pvtx = &_avtxCommon[0];
-  for( i=0; i<ctParticles-1; i++) {
-    ASSERT( pidx[i] < pidx[i+1]);
-    ASSERT( pvtx[i*4].z >= pvtx[(i+1)*4].z);
+  // Particles of a few different small textures
+  const INDEX ctTextures = 4;
+  CTextureData atd[ctTextures];
+  CTextureObject ato[ctTextures];
+  ULONG aulPicture[16 * 16];
+
+  INDEX iTex;
+
+  for (iTex = 0; iTex < ctTextures; iTex++) {
+    for (INDEX iPixel = 0; iPixel < 16 * 16; iPixel++) {
+      aulPicture[iPixel] = ((iPixel + iTex * 64) * 0x010101UL) | 0xFF000000UL;
+    }
+
+    CImageInfo ii;
+    ii.Attach((UBYTE *)aulPicture, 16, 16, 32);
+
+    try {
+      atd[iTex].Create_t(&ii, 16, 1, TRUE);
+
+    } catch (char *strError) {
+      ii.Detach();
+      CPrintF(TRANS("Cannot create particle textures: %s\n"), strError);
+      return;
+    }
+
+    ii.Detach();
+
+    // Keep an extra reference so that the textures are never released into the stock
+    atd[iTex].MarkUsed();
+    ato[iTex].SetData(&atd[iTex]);
   }
-#endif
+
+  const BOOL bOldBatch = gfx_bBatchParticles;
+  const BOOL bOldFog = _Particle_bHasFog;
+  const BOOL bOldHaze = _Particle_bHasHaze;
+  _Particle_bHasFog = FALSE;
+  _Particle_bHasHaze = FALSE;
+
+  const INDEX ctBatches = (ctParticles + ctPerBatch - 1) / ctPerBatch;
+  DOUBLE dSeparate = 0.0, dMerged = 0.0;
+
+  for (INDEX iPass = 0; iPass < ctPasses; iPass++) {
+    // Flush each batch
+    gfx_bBatchParticles = FALSE;
+
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+    SubmitParticleBatches(ato, ctTextures, ctParticles, ctPerBatch, iPass);
+    dSeparate += (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+    // Flush batches together until the texture changes
+    gfx_bBatchParticles = TRUE;
+
+    tvStart = _pTimer->GetHighPrecisionTimer();
+    SubmitParticleBatches(ato, ctTextures, ctParticles, ctPerBatch, iPass);
+    dMerged += (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+  }
+
+  gfx_bBatchParticles = bOldBatch;
+  _Particle_bHasFog = bOldFog;
+  _Particle_bHasHaze = bOldHaze;
+
+  for (iTex = 0; iTex < ctTextures; iTex++) {
+    ato[iTex].SetData(NULL);
+    atd[iTex].MarkUnused();
+  }
+
+  CPrintF(TRANS("Submitting %d batches: %.3f ms one by one, %.3f ms in %d texture runs\n"),
+    ctBatches, dSeparate * 1000.0 / ctPasses, dMerged * 1000.0 / ctPasses, (ctBatches + 7) / 8);
 }
@@ -157,6 +157,13 @@ class IGfxInterface
      */
     void UploadTexture(ULONG *pulTexture, PIX pixWidth, PIX pixHeight, ULONG ulFormat, BOOL bNoDiscard);
 
+    // [Cecil] Upload precompressed texture
+    /*
+      - pubBlocks = all mipmaps down to 1x1 as 4x4 blocks of the format (see TextureCompression.h)
+      - ulFormat  = one of the precompressed formats from the texture settings (ts_tfBC1, ts_tfBC3 or ts_tfBC7)
+     */
+    void UploadCompressedTexture(const UBYTE *pubBlocks, PIX pixWidth, PIX pixHeight, ULONG ulFormat);
+
     // Returns size of uploaded texture
     SLONG GetTextureSize(ULONG ulTexObject, BOOL bHasMipmaps = TRUE);
 
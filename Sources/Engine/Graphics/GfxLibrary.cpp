@@ -129,6 +129,9 @@ INDEX tex_bFineFog = TRUE;             // should fog be 8/32bit? (or just plain
 INDEX tex_iFogSize = 7;                // limit fog texture size 
 INDEX tex_iFiltering = 0;              // -6 - +6; negative = sharpen, positive = blur, 0 = none
 INDEX tex_iEffectFiltering = +4;       // filtering of fire effect textures
+INDEX tex_bParallelEffects = TRUE;     // [Cecil] animate effect textures on worker threads
+INDEX tex_bParallelProcessing = TRUE;  // [Cecil] process bitmaps in row bands on worker threads
+INDEX tex_iWriteCompression = 0;       // [Cecil] encode frames of written textures into blocks (0=none, 1=BC1/BC3, 2=BC7)
 INDEX tex_bProgressiveFilter = FALSE;  // filter mipmaps in creation time (not afterwards)
 INDEX tex_bColorizeMipmaps   = FALSE;  // DEBUG: colorize texture's mipmap levels in various colors
 INDEX tex_bCompressAlphaChannel = FALSE;  // for compressed textures, compress alpha channel too   
@@ -222,6 +225,7 @@ INDEX ter_bNoRegeneration   = FALSE;
 
 // rendering control
 INDEX wld_bAlwaysAddAll         = FALSE;
+INDEX wld_iUsePVS               = 0; // [Cecil] 0 = off, 1 = cull sectors with the world PVS, 2 = verify the PVS without culling
 INDEX wld_bRenderMirrors        = TRUE;
 INDEX wld_bRenderEmptyBrushes   = TRUE;
 INDEX wld_bRenderShadowMaps     = TRUE;
@@ -236,6 +240,7 @@ FLOAT wld_fEdgeAdjustK          = 1.0f; //1.0001f;
                                      
 INDEX gfx_bRenderWorld      = TRUE;
 INDEX gfx_bRenderParticles  = TRUE;
+INDEX gfx_bBatchParticles   = TRUE; // [Cecil] merge consecutive particle flushes with the same state
 INDEX gfx_bRenderModels     = TRUE;
 INDEX gfx_bRenderPredicted  = FALSE;
 INDEX gfx_bRenderFog        = TRUE;
@@ -348,9 +353,15 @@ static void TexturesInfo(void)
   PIX   pixK04A=0, pixK64A=0, pixKMXA=0;
   SLONG slKB04A=0, slKB64A=0, slKBMXA=0;
 
+  // [Cecil] Textures may be loaded on other threads
+  CTSingleLock slStock(&_pTextureStock->st_csLock, TRUE);
+
   // walk thru all textures on stock
   {FOREACHINDYNAMICCONTAINER( _pTextureStock->st_ctObjects, CTextureData, ittd)
-  { // get texture info
+  { // [Cecil] Skip textures that are still loading
+    if (CStock_CTextureData::IsLoading(ittd)) continue;
+
+    // get texture info
     CTextureData &td = *ittd;
     BOOL  bAlpha   = td.td_ulFlags&TEX_ALPHACHANNEL;
     INDEX ctFrames = td.td_ctFrames;
@@ -735,6 +746,11 @@ extern BOOL ProbeMode( CTimerValue tvLast)
    
 
 
+// [Cecil] Compare quantized keyframes of an animset against regular ones
+extern void BenchmarkAnimSet(void *pArgs);
+// [Cecil] Encode and decode a generated bitmap in each block format
+extern void BenchmarkTextureCompression(void *pArgs);
+
 // uncache all cached shadow maps
 extern void UncacheShadows(void)
 {
@@ -789,7 +805,9 @@ extern void ReloadTextures(void)
   // update texture settings
   UpdateTextureSettings();
   // loop thru texture stock
-  {FOREACHINDYNAMICCONTAINER( _pTextureStock->st_ctObjects, CTextureData, ittd) {
+  {CTSingleLock slStock(&_pTextureStock->st_csLock, TRUE); // [Cecil]
+   FOREACHINDYNAMICCONTAINER( _pTextureStock->st_ctObjects, CTextureData, ittd) {
+    if (CStock_CTextureData::IsLoading(ittd)) continue; // [Cecil]
     CTextureData &td = *ittd;
     td.Reload();
     td.td_tpLocal.Clear();
@@ -847,7 +865,9 @@ static void ReloadModels(void)
   // mute all sounds
   _pSound->Mute();
   // loop thru model stock
-  {FOREACHINDYNAMICCONTAINER( _pModelStock->st_ctObjects, CModelData, itmd) {
+  {CTSingleLock slStock(&_pModelStock->st_csLock, TRUE); // [Cecil]
+   FOREACHINDYNAMICCONTAINER( _pModelStock->st_ctObjects, CModelData, itmd) {
+    if (CStock_CModelData::IsLoading(itmd)) continue; // [Cecil]
     CModelData &md = *itmd;
     md.Reload();
   }}
@@ -1190,6 +1210,8 @@ void CGfxLibrary::Init(void)
   _pShell->DeclareSymbol("           user INDEX ska_bShowColision;",   &ska_bShowColision);
   _pShell->DeclareSymbol("persistent user FLOAT ska_fLODMul;",         &ska_fLODMul);
   _pShell->DeclareSymbol("persistent user FLOAT ska_fLODAdd;",         &ska_fLODAdd);
+  _pShell->DeclareSymbol("user void BenchmarkAnimSet(CTString);",      &BenchmarkAnimSet); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkTextureCompression(INDEX);", &BenchmarkTextureCompression); // [Cecil]
   
   _pShell->DeclareSymbol("           user INDEX ter_bShowQuadTree;",   &ter_bShowQuadTree);
   _pShell->DeclareSymbol("           user INDEX ter_bShowWireframe;",  &ter_bShowWireframe);
@@ -1218,6 +1240,9 @@ void CGfxLibrary::Init(void)
   _pShell->DeclareSymbol("persistent user INDEX tex_iNormalQuality;",    &tex_iNormalQuality);
   _pShell->DeclareSymbol("persistent user INDEX tex_iAnimationQuality;", &tex_iAnimationQuality);
   _pShell->DeclareSymbol("persistent user INDEX tex_bFineEffect;",       &tex_bFineEffect);
+  _pShell->DeclareSymbol("persistent user INDEX tex_bParallelEffects;",  &tex_bParallelEffects); // [Cecil]
+  _pShell->DeclareSymbol("persistent user INDEX tex_bParallelProcessing;", &tex_bParallelProcessing); // [Cecil]
+  _pShell->DeclareSymbol("user INDEX tex_iWriteCompression;", &tex_iWriteCompression); // [Cecil]
   _pShell->DeclareSymbol("persistent user INDEX tex_bFineFog;",          &tex_bFineFog);
   _pShell->DeclareSymbol("persistent user INDEX tex_iNormalSize;",    &tex_iNormalSize);
   _pShell->DeclareSymbol("persistent user INDEX tex_iAnimationSize;", &tex_iAnimationSize);
@@ -1249,11 +1274,13 @@ void CGfxLibrary::Init(void)
   _pShell->DeclareSymbol("           user INDEX shd_bColorize;",   &shd_bColorize);
   
   _pShell->DeclareSymbol("           user INDEX gfx_bRenderParticles;", &gfx_bRenderParticles);
+  _pShell->DeclareSymbol("           user INDEX gfx_bBatchParticles;",  &gfx_bBatchParticles); // [Cecil]
   _pShell->DeclareSymbol("           user INDEX gfx_bRenderFog;",       &gfx_bRenderFog);
   _pShell->DeclareSymbol("           user INDEX gfx_bRenderWorld;",     &gfx_bRenderWorld);
   _pShell->DeclareSymbol("persistent user INDEX gfx_iLensFlareQuality;", &gfx_iLensFlareQuality);
   _pShell->DeclareSymbol("persistent user INDEX wld_bTextureLayers;", &wld_bTextureLayers);
   _pShell->DeclareSymbol("persistent user INDEX wld_bRenderMirrors;", &wld_bRenderMirrors);
+  _pShell->DeclareSymbol("           user INDEX wld_iUsePVS;", &wld_iUsePVS); // [Cecil]
   _pShell->DeclareSymbol("persistent user FLOAT wld_fEdgeOffsetI;",   &wld_fEdgeOffsetI);
   _pShell->DeclareSymbol("persistent user FLOAT wld_fEdgeAdjustK;",   &wld_fEdgeAdjustK);
   _pShell->DeclareSymbol("persistent user INDEX wld_iDetailRemovingBias;", &wld_iDetailRemovingBias);
@@ -2017,7 +2044,8 @@ BOOL CGfxLibrary::LockRaster( CRaster *praToLock)
 {
   // don't do this! it can break sync consistency in entities!
   // SetFPUPrecision(FPT_24BIT); 
-  ASSERT( praToLock->ra_pvpViewPort!=NULL);
+  // [Cecil] Null API can draw into rasters without windows
+  ASSERT( praToLock->ra_pvpViewPort!=NULL || GetCurrentAPI()==GAT_NONE);
   BOOL bRes = SetCurrentViewport( praToLock->ra_pvpViewPort);
   if( bRes) {
     // must signal to picky Direct3D
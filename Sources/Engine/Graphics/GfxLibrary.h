@@ -109,6 +109,7 @@ enum VtxType
 #define GLF_EXT_OCCLUSIONTEST       (1UL<<23)   // GL_HP_occlusion_test
 #define GLF_EXT_OCCLUSIONQUERY      (1UL<<24)   // GL_NV_occlusion_query
 	
+#define GLF_EXTC_BPTC   (1UL<<26)   // [Cecil] GL_ARB_texture_compression_bptc
 #define GLF_EXTC_ARB    (1UL<<27)   // GL_ARB_texture_compression
 #define GLF_EXTC_S3TC   (1UL<<28)   // GL_EXT_texture_compression_s3tc
 #define GLF_EXTC_FXT1   (1UL<<29)   // GL_3DFX_texture_compression_FXT1
@@ -410,7 +410,9 @@ void CGfxLibrary::EndDriver_D3D(void)
 {
   // unbind textures
   if( _pTextureStock!=NULL) {
-    {FOREACHINDYNAMICCONTAINER( _pTextureStock->st_ctObjects, CTextureData, ittd) {
+    {CTSingleLock slStock(&_pTextureStock->st_csLock, TRUE); // [Cecil]
+     FOREACHINDYNAMICCONTAINER( _pTextureStock->st_ctObjects, CTextureData, ittd) {
+      if (CStock_CTextureData::IsLoading(ittd)) continue; // [Cecil]
       CTextureData &td = *ittd;
       td.td_tpLocal.Clear();
       td.Unbind();
@@ -97,6 +97,10 @@ GLint     (__stdcall *pwglGetSwapIntervalEXT)(void) = NULL;
 void (__stdcall *pglActiveTextureARB)(GLenum texunit) = NULL;
 void (__stdcall *pglClientActiveTextureARB)(GLenum texunit) = NULL;
 
+// [Cecil] GL_ARB_texture_compression
+void (__stdcall *pglCompressedTexImage2DARB)(GLenum target, GLint level, GLenum internalformat,
+  GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid *data) = NULL;
+
 #if !SE1_PREFER_SDL
 char *(__stdcall *pwglGetExtensionsStringARB)(HDC hdc);
 BOOL  (__stdcall *pwglChoosePixelFormatARB)(HDC hdc, const int *piAttribIList, const FLOAT *pfAttribFList, UINT nMaxFormats, int *piFormats, UINT *nNumFormats);
@@ -709,6 +713,15 @@ void CGfxLibrary::InitContext_OGL(void)
   TestExtension_OGL( GLF_EXTC_S3TC,   "GL_EXT_texture_compression_s3tc");
   TestExtension_OGL( GLF_EXTC_FXT1,   "GL_3DFX_texture_compression_FXT1");
   TestExtension_OGL( GLF_EXTC_LEGACY, "GL_S3_s3tc");
+  TestExtension_OGL( GLF_EXTC_BPTC,   "GL_ARB_texture_compression_bptc"); // [Cecil]
+
+  // [Cecil] Precompressed textures are uploaded through the ARB extension
+  pglCompressedTexImage2DARB = NULL;
+  if( gl_ulFlags&GLF_EXTC_ARB) {
+    pglCompressedTexImage2DARB = (void (__stdcall*)(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei, const GLvoid*))
+      OGL_GetProcAddress( "glCompressedTexImage2DARB");
+    ASSERT( pglCompressedTexImage2DARB!=NULL);
+  }
   // mark if there is at least one extension present
   gl_ulFlags &= ~GLF_TEXTURECOMPRESSION;
   if( (gl_ulFlags&GLF_EXTC_ARB)  || (gl_ulFlags&GLF_EXTC_FXT1)
@@ -1005,7 +1018,9 @@ void CGfxLibrary::EndDriver_OGL(void)
 {
   // unbind all textures
   if( _pTextureStock!=NULL) {
-    {FOREACHINDYNAMICCONTAINER( _pTextureStock->st_ctObjects, CTextureData, ittd) {
+    {CTSingleLock slStock(&_pTextureStock->st_csLock, TRUE); // [Cecil]
+     FOREACHINDYNAMICCONTAINER( _pTextureStock->st_ctObjects, CTextureData, ittd) {
+      if (CStock_CTextureData::IsLoading(ittd)) continue; // [Cecil]
       CTextureData &td = *ittd;
       td.td_tpLocal.Clear();
       td.Unbind();
@@ -235,6 +235,48 @@ extern void UploadTexture_OGL( ULONG *pulTexture, PIX pixSizeU, PIX pixSizeV,
 }
 
 
+// [Cecil] Upload precompressed mipmaps of the current texture (chain of 4x4 blocks that goes down to 1x1)
+extern void UploadCompressedTexture_OGL( const UBYTE *pubBlocks, PIX pixSizeU, PIX pixSizeV, GLenum eInternalFormat)
+{
+  // safeties
+  ASSERT( pubBlocks!=NULL);
+  ASSERT( pixSizeU>0 && pixSizeV>0);
+  ASSERT( pglCompressedTexImage2DARB!=NULL);
+  _sfStats.StartTimer( CStatForm::STI_BINDTEXTURE);
+  _pfGfxProfile.StartTimer( CGfxProfile::PTI_TEXTUREUPLOADING);
+
+  // DXT1 blocks are half the size
+  const SLONG slBlockSize = (eInternalFormat==GL_COMPRESSED_RGB_S3TC_DXT1_EXT) ? 8 : 16;
+
+  INDEX iMip=0;
+  SLONG slOffset=0;
+  FOREVER {
+    // upload mipmap blocks as they are
+    const SLONG slMipSize = ((pixSizeU+3)/4) * ((pixSizeV+3)/4) * slBlockSize;
+    pglCompressedTexImage2DARB( GL_TEXTURE_2D, iMip, eInternalFormat, pixSizeU, pixSizeV, 0,
+                                slMipSize, pubBlocks+slOffset);
+    OGL_CHECKERROR;
+    slOffset += slMipSize;
+
+    // end here if there is only one mip-map to upload or it was the last one
+    if( _tpCurrent->tp_bSingleMipmap || (pixSizeU==1 && pixSizeV==1)) break;
+
+    // advance to next mip-map
+    pixSizeU = ClampDn( pixSizeU>>1, 1);
+    pixSizeV = ClampDn( pixSizeV>>1, 1);
+    iMip++;
+  }
+
+  // all done
+  _pfGfxProfile.IncrementCounter( CGfxProfile::PCI_TEXTUREUPLOADS, 1);
+  _pfGfxProfile.IncrementCounter( CGfxProfile::PCI_TEXTUREUPLOADBYTES, slOffset);
+  _sfStats.IncrementCounter( CStatForm::SCI_TEXTUREUPLOADS, 1);
+  _sfStats.IncrementCounter( CStatForm::SCI_TEXTUREUPLOADBYTES, slOffset);
+  _pfGfxProfile.StopTimer( CGfxProfile::PTI_TEXTUREUPLOADING);
+  _sfStats.StopTimer( CStatForm::STI_BINDTEXTURE);
+}
+
+
 
 // returns bytes/pixels ratio for uploaded texture
 extern INDEX GetFormatPixRatio_OGL( GLenum eFormat)
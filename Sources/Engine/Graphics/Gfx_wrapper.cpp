@@ -118,6 +118,7 @@ extern INDEX GetFormatPixRatio_OGL( GLenum eFormat);
 extern void  MimicTexParams_OGL( CTexParams &tpLocal);
 extern void  UploadTexture_OGL( ULONG *pulTexture, PIX pixSizeU, PIX pixSizeV,
                                 GLenum eInternalFormat, BOOL bUseSubImage);
+extern void  UploadCompressedTexture_OGL( const UBYTE *pubBlocks, PIX pixSizeU, PIX pixSizeV, GLenum eInternalFormat); // [Cecil]
 
 #if SE1_DIRECT3D
 extern INDEX GetTexturePixRatio_D3D( LPDIRECT3DTEXTURE8 pd3dTexture);
@@ -346,6 +347,24 @@ void IGfxInterface::UploadTexture( ULONG *pulTexture, PIX pixWidth, PIX pixHeigh
 }
 
 
+// [Cecil] Upload precompressed texture
+void IGfxInterface::UploadCompressedTexture(const UBYTE *pubBlocks, PIX pixWidth, PIX pixHeight, ULONG ulFormat)
+{
+  // determine API
+  const GfxAPIType eAPI = _pGfx->GetCurrentAPI();
+  _pGfx->CheckAPI();
+
+  _sfStats.StartTimer(CStatForm::STI_GFXAPI);
+
+  // Only OpenGL has formats for precompressed textures (see UpdateTextureSettings())
+  if (eAPI == GAT_OGL) {
+    UploadCompressedTexture_OGL(pubBlocks, pixWidth, pixHeight, (GLenum)ulFormat);
+  }
+
+  _sfStats.StopTimer(CStatForm::STI_GFXAPI);
+}
+
+
 
 
 // returns size of uploaded texture
@@ -102,6 +102,7 @@ public:
   ULONG ts_tfRGB5, ts_tfRGBA4, ts_tfRGB5A1;  // high color
   ULONG ts_tfLA8,  ts_tfL8;                  // grayscale
   ULONG ts_tfCRGB, ts_tfCRGBA;               // compressed formats
+  ULONG ts_tfBC1, ts_tfBC3, ts_tfBC7;        // [Cecil] formats for precompressed blocks (NONE if unsupported)
   // maximum texel-byte ratio for largest texture size
   INDEX ts_iMaxBytesPerTexel;
 };
@@ -24,6 +24,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Graphics/Color.h>
 #include <Engine/Graphics/Texture.h>
 #include <Engine/Graphics/GfxProfile.h>
+#include <Engine/Base/SIMDKernels.h> // [Cecil]
+#include <Engine/Base/WorkerThreads.h> // [Cecil]
 
 // asm shortcuts
 #define O offset
@@ -33,6 +35,43 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #define B  byte ptr
 
 extern INDEX tex_bProgressiveFilter; // filter mipmaps in creation time (not afterwards)
+extern INDEX tex_bParallelProcessing; // [Cecil] process bitmaps in row bands on worker threads
+
+// [Cecil] Inline assembly cannot access thread-local variables, so dithering stays on one thread with it
+#define SE1_PARALLEL_BITMAPS (SE1_WORKER_THREADS && !SE1_USE_ASM)
+
+#if SE1_PARALLEL_BITMAPS
+  #define BITMAP_TLS thread_local
+#else
+  #define BITMAP_TLS
+#endif
+
+// [Cecil] Rows in one band of a bitmap and the smallest bitmap area that is worth splitting into bands
+static const PIX _pixRowsPerBand = 32;
+static const PIX _pixMinBandedArea = 128 * 128;
+
+// [Cecil] Determine how many row bands should a bitmap be processed in
+static INDEX GetRowBands(PIX pixWidth, PIX pixHeight)
+{
+  if (!tex_bParallelProcessing || pixWidth * pixHeight < _pixMinBandedArea || GetWorkerThreadCount() == 0) {
+    return 1;
+  }
+
+  return (pixHeight + _pixRowsPerBand - 1) / _pixRowsPerBand;
+}
+
+// [Cecil] Determine rows of some band
+static inline void GetBandRows(INDEX iBand, INDEX ctBands, PIX pixHeight, PIX &pixFirst, PIX &pixRows)
+{
+  if (ctBands == 1) {
+    pixFirst = 0;
+    pixRows = pixHeight;
+    return;
+  }
+
+  pixFirst = iBand * _pixRowsPerBand;
+  pixRows = Min(_pixRowsPerBand, pixHeight - pixFirst);
+}
 
 
 // returns number of mip-maps to skip from original texture
@@ -189,8 +228,27 @@ void FlipBitmap( UBYTE *pubSrc, UBYTE *pubDst, PIX pixWidth, PIX pixHeight, INDE
 
 
 
+// [Cecil] Bilinear downsampling of some bitmap
+struct DownsampleJob {
+  const ULONG *dj_pulSrc;
+  ULONG *dj_pulDst;
+  PIX dj_pixWidth, dj_pixHeight; // Destination size
+  INDEX dj_ctBands;
+};
+
+// [Cecil] Downsample one row band of a bitmap
+static void DownsampleBandJob(void *pData, INDEX iBand)
+{
+  const DownsampleJob &job = *(const DownsampleJob *)pData;
+  PIX pixFirst, pixRows;
+  GetBandRows(iBand, job.dj_ctBands, job.dj_pixHeight, pixFirst, pixRows);
+
+  // Two source rows of double width per destination row
+  Kernel_DownsampleBilinear(job.dj_pulSrc + pixFirst * job.dj_pixWidth * 4, job.dj_pulDst + pixFirst * job.dj_pixWidth,
+                            job.dj_pixWidth, pixRows);
+}
+
 // makes one level lower mipmap (bilinear or nearest-neighbour with border preservance)
-static SQUAD mmRounder = 0x0002000200020002;
 static void MakeOneMipmap( ULONG *pulSrcMipmap, ULONG *pulDstMipmap, PIX pixWidth, PIX pixHeight, BOOL bBilinear)
 {
   // some safety checks
@@ -202,98 +260,14 @@ static void MakeOneMipmap( ULONG *pulSrcMipmap, ULONG *pulDstMipmap, PIX pixWidt
 
   if( bBilinear) // type of filtering?
   { // BILINEAR
-  #if SE1_USE_ASM
-    __asm {
-      pxor    mm0,mm0
-      mov     ebx,D [pixWidth]
-      mov     esi,D [pulSrcMipmap]
-      mov     edi,D [pulDstMipmap]
-      mov     edx,D [pixHeight]
-rowLoop:
-      mov     ecx,D [pixWidth]
-pixLoopN:           
-      movd    mm1,D [esi+ 0]        // up-left
-      movd    mm2,D [esi+ 4]        // up-right
-      movd    mm3,D [esi+ ebx*8 +0] // down-left
-      movd    mm4,D [esi+ ebx*8 +4] // down-right
-      punpcklbw mm1,mm0
-      punpcklbw mm2,mm0
-      punpcklbw mm3,mm0
-      punpcklbw mm4,mm0
-      paddw   mm1,mm2
-      paddw   mm1,mm3
-      paddw   mm1,mm4
-      paddw   mm1,Q [mmRounder]
-      psrlw   mm1,2
-      packuswb mm1,mm0
-      movd    D [edi],mm1
-      // advance to next pixel
-      add     esi,4*2
-      add     edi,4
-      dec     ecx
-      jnz     pixLoopN
-      // advance to next row
-      lea     esi,[esi+ ebx*8] // skip one row in source mip-map
-      dec     edx
-      jnz     rowLoop
-      emms
-    }
-
-  #else
-    UBYTE *src = (UBYTE *)pulSrcMipmap;
-    UBYTE *dest = (UBYTE *)pulDstMipmap;
-
-    // Cycle trough rows
-    for (INDEX i = 0; i < pixHeight; i++)
-    {
-      // For each pixel in a row.
-      for (INDEX j = 0; j < pixWidth; j++)
-      {
-        // Grab pixels from image
-        UWORD upleft[4];
-        UWORD upright[4];
-        UWORD downleft[4];
-        UWORD downright[4];
-        upleft[0] = *(src + 0);
-        upleft[1] = *(src + 1);
-        upleft[2] = *(src + 2);
-        upleft[3] = *(src + 3);
-        upright[0] = *(src + 4);
-        upright[1] = *(src + 5);
-        upright[2] = *(src + 6);
-        upright[3] = *(src + 7);
-
-        downleft[0] = *(src + pixWidth * 8 + 0);
-        downleft[1] = *(src + pixWidth * 8 + 1);
-        downleft[2] = *(src + pixWidth * 8 + 2);
-        downleft[3] = *(src + pixWidth * 8 + 3);
-        downright[0] = *(src + pixWidth * 8 + 4);
-        downright[1] = *(src + pixWidth * 8 + 5);
-        downright[2] = *(src + pixWidth * 8 + 6);
-        downright[3] = *(src + pixWidth * 8 + 7);
-
-        UWORD answer[4];
-        answer[0] = upleft[0] + upright[0] + downleft[0] + downright[0] + 2;
-        answer[1] = upleft[1] + upright[1] + downleft[1] + downright[1] + 2;
-        answer[2] = upleft[2] + upright[2] + downleft[2] + downright[2] + 2;
-        answer[3] = upleft[3] + upright[3] + downleft[3] + downright[3] + 2;
-        answer[0] /= 4;
-        answer[1] /= 4;
-        answer[2] /= 4;
-        answer[3] /= 4;
-
-        *(dest + 0) = answer[0];
-        *(dest + 1) = answer[1];
-        *(dest + 2) = answer[2];
-        *(dest + 3) = answer[3];
-
-        src += 8;
-        dest += 4;
-      }
-
-      src += 8 * pixWidth;
-    }
-  #endif
+    // [Cecil] Use dispatched kernel on row bands
+    DownsampleJob job;
+    job.dj_pulSrc = pulSrcMipmap;
+    job.dj_pulDst = pulDstMipmap;
+    job.dj_pixWidth = pixWidth;
+    job.dj_pixHeight = pixHeight;
+    job.dj_ctBands = GetRowBands(pixWidth, pixHeight);
+    ParallelFor(job.dj_ctBands, &DownsampleBandJob, &job);
   }
   else
   { // NEAREST-NEIGHBOUR but with border preserving
@@ -513,20 +487,19 @@ static ULONG ulDither2[4][4] = {
 };
 
 
-static SQUAD mmErrDiffMask=0;
+// [Cecil] Per thread for dithering several bitmaps at once
+BITMAP_TLS static SQUAD mmErrDiffMask=0;
 static SQUAD mmW3 = 0x0003000300030003;
 static SQUAD mmW5 = 0x0005000500050005;
 static SQUAD mmW7 = 0x0007000700070007;
-static SQUAD mmShifter = 0;
-static SQUAD mmMask  = 0;
-static ULONG *pulDitherTable;
+BITMAP_TLS static SQUAD mmShifter = 0;
+BITMAP_TLS static SQUAD mmMask  = 0;
+BITMAP_TLS static ULONG *pulDitherTable;
 
-// performs dithering of a 32-bit bipmap (can be in-place)
-void DitherBitmap( INDEX iDitherType, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight,
-                   PIX pixCanvasWidth, PIX pixCanvasHeight)
+// [Cecil] Dither one bitmap without profiling
+static void DitherOneBitmap( INDEX iDitherType, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight,
+                             PIX pixCanvasWidth, PIX pixCanvasHeight)
 {
-  _pfGfxProfile.StartTimer( CGfxProfile::PTI_DITHERBITMAP);
-
 #if !SE1_DITHERBITMAP
   // Don't dither it at all, rather copy only (if needed)
   if (pulDst != pulSrc) {
@@ -715,42 +688,17 @@ void DitherBitmap( INDEX iDitherType, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth
       }
 
       int tablePos = 0;
-      UQUAD *itSrc = (UQUAD *)pulSrc;
-      UQUAD *itDst = (UQUAD *)pulDst;
+      UBYTE *itSrc = (UBYTE *)pulSrc;
+      UBYTE *itDst = (UBYTE *)pulDst;
       for (int row = pixHeight; row; row--)
       {
-        // So even and odd quads.. 2 texel each
-        uConv dither1 = table[tablePos], dither2 = table[tablePos + 1];
+        // [Cecil] So even and odd quads.. 2 texel each (added to the whole row by groups of 4 texels)
+        Kernel_DitherRow((ULONG *)itSrc, (ULONG *)itDst, pixWidth, (ULONG *)&table[tablePos]);
         tablePos = (tablePos + 2) & 0x7;
 
-        int width = pixWidth;
-        for (; width > 0; width -= 4)
-        {
-          // using both quads
-          uConv data1, data2;
-          data1.val = *itSrc++;
-          data2.val = *itSrc++;
-
-          // Add ubytes - paddusb
-          for (int j = 0; j < 8; j++)
-          {
-            data1.byte[j] = Clamp(data1.byte[j] + dither1.byte[j], 0, 255);
-            data2.byte[j] = Clamp(data2.byte[j] + dither2.byte[j], 0, 255);
-          }
-
-          *itDst++ = data1.val;
-          *itDst++ = data2.val;
-        }
-        if (width < 0)
-        {
-          // if width less than mul 4, move pointer back by width*4 bytes
-          itSrc = (UQUAD *)((char*)itSrc + width * 4);
-          itDst = (UQUAD *)((char*)itDst + width * 4);
-        }
-
-        // move pointer by slModulo bytes
-        itSrc = (UQUAD *)((char*)itSrc + slModulo);
-        itDst = (UQUAD *)((char*)itDst + slModulo);
+        // move pointer by the row and slModulo bytes
+        itSrc += slWidthModulo;
+        itDst += slWidthModulo;
       }
     #endif
 
@@ -759,6 +707,7 @@ void DitherBitmap( INDEX iDitherType, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth
   if(ditherMethod == 2)
   {
     // ------------------------------- error diffusion dithering routine
+    // [Cecil] NOTE: Not vectorized because each texel needs errors that have been spread from the previous one
 
     // Since error diffusion algorithm requires in-place dithering, original bitmap must be copied if needed
     if (pulDst != pulSrc) {
@@ -946,18 +895,64 @@ void DitherBitmap( INDEX iDitherType, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth
   #endif
   }
 #endif // SE1_DITHERBITMAP
+}
+
+// performs dithering of a 32-bit bipmap (can be in-place)
+void DitherBitmap( INDEX iDitherType, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight,
+                   PIX pixCanvasWidth, PIX pixCanvasHeight)
+{
+  _pfGfxProfile.StartTimer( CGfxProfile::PTI_DITHERBITMAP);
+
+  // [Cecil] Moved into its own function
+  DitherOneBitmap(iDitherType, pulSrc, pulDst, pixWidth, pixHeight, pixCanvasWidth, pixCanvasHeight);
 
   // All done
   _pfGfxProfile.StopTimer(CGfxProfile::PTI_DITHERBITMAP);
 }
 
 
+// [Cecil] Dithering of all mipmaps of some bitmap
+struct DitherMipmapsJob {
+  INDEX dmj_iDitherType;
+  ULONG *dmj_pulSrc;
+  ULONG *dmj_pulDst;
+  PIX dmj_pixWidth, dmj_pixHeight;
+};
+
+// [Cecil] Dither one mipmap level
+static void DitherMipmapJob(void *pData, INDEX iMipLevel)
+{
+  const DitherMipmapsJob &job = *(const DitherMipmapsJob *)pData;
+  const PIX pixOffset = GetMipmapOffset(iMipLevel, job.dmj_pixWidth, job.dmj_pixHeight);
+
+  DitherOneBitmap(job.dmj_iDitherType, job.dmj_pulSrc + pixOffset, job.dmj_pulDst + pixOffset,
+                  job.dmj_pixWidth >> iMipLevel, job.dmj_pixHeight >> iMipLevel, 0, 0);
+}
 
 // performs dithering of a 32-bit mipmaps (can be in-place)
 void DitherMipmaps( INDEX iDitherType, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight)
 {
   // safety check
   ASSERT( pixWidth>0 && pixHeight>0);
+
+#if SE1_PARALLEL_BITMAPS
+  // [Cecil] Mipmaps don't overlap, so each one can be dithered on its own thread
+  if (GetRowBands(pixWidth, pixHeight) > 1) {
+    _pfGfxProfile.StartTimer(CGfxProfile::PTI_DITHERBITMAP);
+
+    DitherMipmapsJob job;
+    job.dmj_iDitherType = iDitherType;
+    job.dmj_pulSrc = pulSrc;
+    job.dmj_pulDst = pulDst;
+    job.dmj_pixWidth = pixWidth;
+    job.dmj_pixHeight = pixHeight;
+    ParallelFor(GetNoOfMipmaps(pixWidth, pixHeight), &DitherMipmapJob, &job);
+
+    _pfGfxProfile.StopTimer(CGfxProfile::PTI_DITHERBITMAP);
+    return;
+  }
+#endif
+
   // loop thru mipmaps
   PIX pixMipSize;
   while( pixWidth>0 && pixHeight>0)
@@ -998,6 +993,23 @@ static SQUAD mmAdd = 0x0007000700070007;
 static ULONG aulRows[2048];
 
 
+// [Cecil] FilterBitmap() INTERNAL: determines weights of the middle convolution matrix and its inverted divider
+static void GetConvolutionWeights( INDEX iFilter, INDEX &iMc, INDEX &iMe, INDEX &iMm, INDEX &iInvDiv)
+{
+  INDEX iFilterAbs = Abs(iFilter) -1;
+  iMc = aiFilters[iFilterAbs][0];  // corner
+  iMe = aiFilters[iFilterAbs][1];  // edge
+  iMm = aiFilters[iFilterAbs][2];  // middle
+  // negate values for sharpen filter case
+  if( iFilter<0) {
+    iMm += (iMe+iMc) *8;  // (4*Edge + 4*Corner) *2
+    iMe  = -iMe;
+    iMc  = -iMc;
+  }
+  // prepare divider
+  iInvDiv = ((SQUAD)ceil(65536.0f/(iMc*4+iMe*4+iMm))) & 0xFFFF;
+}
+
 // FilterBitmap() INTERNAL: generates convolution filter matrix if needed
 static INDEX iLastFilter;
 static void GenerateConvolutionMatrix( INDEX iFilter)
@@ -1006,23 +1018,15 @@ static void GenerateConvolutionMatrix( INDEX iFilter)
   if( iLastFilter==iFilter) return;
   // update filter
   iLastFilter = iFilter;
-  INDEX iFilterAbs = Abs(iFilter) -1;
   // convert convolution values to MMX format
-  INDEX iMc = aiFilters[iFilterAbs][0];  // corner
-  INDEX iMe = aiFilters[iFilterAbs][1];  // edge
-  INDEX iMm = aiFilters[iFilterAbs][2];  // middle
-  // negate values for sharpen filter case
-  if( iFilter<0) {
-    iMm += (iMe+iMc) *8;  // (4*Edge + 4*Corner) *2
-    iMe  = -iMe;
-    iMc  = -iMc;
-  }
+  INDEX iMc, iMe, iMm, iInvDiv;
+  GetConvolutionWeights( iFilter, iMc, iMe, iMm, iInvDiv); // [Cecil]
   // find values for edge and corner cases
   INDEX iEch = iMc  + iMe;
   INDEX iEm  = iMm  + iMe;
   INDEX iCm  = iEch + iEm;
   // prepare divider
-  SQUAD mm = ((SQUAD)ceil(65536.0f/(iMc*4+iMe*4+iMm))) & 0xFFFF;
+  SQUAD mm = iInvDiv;
   mmInvDiv   = (mm<<48) | (mm<<32) | (mm<<16) | mm;
   // prepare filter values
   mm = iMc  & 0xFFFF;  mmMc = (mm<<48) | (mm<<32) | (mm<<16) | mm;
@@ -1102,6 +1106,64 @@ static inline void extpix_mulhi(ExtPix &p1, const ExtPix &p2)
 }
 
 #endif // !SE1_USE_ASM
+
+// [Cecil] Filtering of some bitmap in row bands
+struct FilterJob {
+  const ULONG *fj_pulSrc;
+  ULONG *fj_pulDst;
+  PIX fj_pixWidth, fj_pixHeight, fj_pixCanvasWidth;
+  SWORD fj_swCorner, fj_swEdge, fj_swMiddle, fj_swInvDiv;
+  INDEX fj_ctBands;
+};
+
+// [Cecil] Filter one row band of a bitmap (rows beyond bitmap edges are clamped)
+static void FilterBandJob(void *pData, INDEX iBand)
+{
+  const FilterJob &job = *(const FilterJob *)pData;
+  PIX pixFirst, pixRows;
+  GetBandRows(iBand, job.fj_ctBands, job.fj_pixHeight, pixFirst, pixRows);
+
+  for (PIX pixY = pixFirst; pixY < pixFirst + pixRows; pixY++) {
+    const ULONG *pulRow   = job.fj_pulSrc + pixY * job.fj_pixCanvasWidth;
+    const ULONG *pulAbove = job.fj_pulSrc + ClampDn(pixY - 1, (PIX)0) * job.fj_pixCanvasWidth;
+    const ULONG *pulBelow = job.fj_pulSrc + Min(pixY + 1, job.fj_pixHeight - 1) * job.fj_pixCanvasWidth;
+
+    Kernel_FilterRow(pulAbove, pulRow, pulBelow, job.fj_pulDst + pixY * job.fj_pixCanvasWidth, job.fj_pixWidth,
+                     job.fj_swCorner, job.fj_swEdge, job.fj_swMiddle, job.fj_swInvDiv);
+  }
+}
+
+// [Cecil] Filter bitmap rows with a vector kernel (same results as the edge and corner matrices below)
+static void FilterBitmapRows( INDEX iFilter, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight, PIX pixCanvasWidth)
+{
+  INDEX iMc, iMe, iMm, iInvDiv;
+  GetConvolutionWeights( iFilter, iMc, iMe, iMm, iInvDiv);
+
+  // Filter from a copy of the source if done in-place
+  ULONG *pulCopy = NULL;
+
+  if (pulSrc == pulDst) {
+    const SLONG slSize = pixCanvasWidth * pixHeight * BYTES_PER_TEXEL;
+    pulCopy = (ULONG *)AllocMemory(slSize);
+    memcpy(pulCopy, pulSrc, slSize);
+    pulSrc = pulCopy;
+  }
+
+  FilterJob job;
+  job.fj_pulSrc = pulSrc;
+  job.fj_pulDst = pulDst;
+  job.fj_pixWidth = pixWidth;
+  job.fj_pixHeight = pixHeight;
+  job.fj_pixCanvasWidth = pixCanvasWidth;
+  job.fj_swCorner = (SWORD)iMc;
+  job.fj_swEdge   = (SWORD)iMe;
+  job.fj_swMiddle = (SWORD)iMm;
+  job.fj_swInvDiv = (SWORD)iInvDiv;
+  job.fj_ctBands = GetRowBands(pixWidth, pixHeight);
+  ParallelFor(job.fj_ctBands, &FilterBandJob, &job);
+
+  if (pulCopy != NULL) FreeMemory(pulCopy);
+}
  
 // applies filter to bitmap
 void FilterBitmap( INDEX iFilter, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight,
@@ -1123,8 +1185,16 @@ void FilterBitmap( INDEX iFilter, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PI
     return;
   }
 
-  // prepare convolution matrix and row modulo
   iFilter = Clamp( iFilter, -6L, +6L);
+
+  // [Cecil] Filter in row bands only if they can actually be processed in parallel
+  if( GetRowBands( pixWidth, pixHeight) > 1) {
+    FilterBitmapRows( iFilter, pulSrc, pulDst, pixWidth, pixHeight, pixCanvasWidth);
+    _pfGfxProfile.StopTimer( CGfxProfile::PTI_FILTERBITMAP);
+    return;
+  }
+
+  // prepare convolution matrix and row modulo
   GenerateConvolutionMatrix( iFilter);
   SLONG slModulo1 = (pixCanvasWidth-pixWidth+1) *BYTES_PER_TEXEL;
   SLONG slCanvasWidth = pixCanvasWidth *BYTES_PER_TEXEL;
@@ -1710,13 +1780,49 @@ lowerLoop:
  
 
 
+// [Cecil] Color adjustment of some bitmap in row bands
+struct AdjustColorJob {
+  const ULONG *acj_pulSrc;
+  ULONG *acj_pulDst;
+  PIX acj_pixWidth, acj_pixHeight;
+  SLONG acj_slHueShift, acj_slSaturation;
+  INDEX acj_ctBands;
+};
+
+// [Cecil] Adjust color of one row band of a bitmap
+static void AdjustColorBandJob(void *pData, INDEX iBand)
+{
+  const AdjustColorJob &job = *(const AdjustColorJob *)pData;
+  PIX pixFirst, pixRows;
+  GetBandRows(iBand, job.acj_ctBands, job.acj_pixHeight, pixFirst, pixRows);
+
+  const PIX pixEnd = (pixFirst + pixRows) * job.acj_pixWidth;
+
+  for( PIX i = pixFirst * job.acj_pixWidth; i < pixEnd; i++) {
+    job.acj_pulDst[i] = ByteSwap32( AdjustColor( ByteSwap32(job.acj_pulSrc[i]), job.acj_slHueShift, job.acj_slSaturation));
+  }
+}
+
 // saturate color of bitmap
 void AdjustBitmapColor( ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight, 
                         SLONG const slHueShift, SLONG const slSaturation)
 {
-  for( INDEX i=0; i<(pixWidth*pixHeight); i++) {
-    pulDst[i] = ByteSwap32( AdjustColor( ByteSwap32(pulSrc[i]), slHueShift, slSaturation));
+  // [Cecil] Nothing to adjust
+  if( slHueShift==0 && slSaturation==256) {
+    if( pulDst!=pulSrc) memcpy( pulDst, pulSrc, pixWidth*pixHeight *BYTES_PER_TEXEL);
+    return;
   }
+
+  // [Cecil] Adjust in row bands
+  AdjustColorJob job;
+  job.acj_pulSrc = pulSrc;
+  job.acj_pulDst = pulDst;
+  job.acj_pixWidth = pixWidth;
+  job.acj_pixHeight = pixHeight;
+  job.acj_slHueShift = slHueShift;
+  job.acj_slSaturation = slSaturation;
+  job.acj_ctBands = GetRowBands(pixWidth, pixHeight);
+  ParallelFor(job.acj_ctBands, &AdjustColorBandJob, &job);
 }
 
 
@@ -53,6 +53,10 @@ extern GLint     (__stdcall *pwglGetSwapIntervalEXT)(void);
 extern void (__stdcall *pglActiveTextureARB)(GLenum texunit);
 extern void (__stdcall *pglClientActiveTextureARB)(GLenum texunit);
 
+// [Cecil] GL_ARB_texture_compression
+extern void (__stdcall *pglCompressedTexImage2DARB)(GLenum target, GLint level, GLenum internalformat,
+  GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid *data);
+
 #if !SE1_PREFER_SDL /* !!! FIXME: Move to abstraction layer. --rcg. */
 extern char *(__stdcall *pwglGetExtensionsStringARB)(HDC hdc);
 extern BOOL  (__stdcall *pwglChoosePixelFormatARB)(HDC hdc, const int *piAttribIList, const FLOAT *pfAttribFList, UINT nMaxFormats, int *piFormats, UINT *nNumFormats);
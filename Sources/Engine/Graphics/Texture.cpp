@@ -24,6 +24,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Graphics/GfxLibrary.h>
 #include <Engine/Graphics/ImageInfo.h>
 #include <Engine/Graphics/TextureEffects.h>
+#include <Engine/Graphics/TextureCompression.h>
 
 #include <Engine/Templates/DynamicArray.h>
 #include <Engine/Templates/DynamicArray.cpp>
@@ -41,6 +42,7 @@ extern INDEX tex_iEffectSize;
 
 extern INDEX tex_iDithering;
 extern INDEX tex_iFiltering;       
+extern INDEX tex_iWriteCompression; // [Cecil]
 
 extern INDEX gap_bAllowSingleMipmap;
 extern FLOAT gfx_tmProbeDecay;
@@ -150,6 +152,16 @@ extern void UpdateTextureSettings(void)
     TS.ts_tfCRGB  = NONE;
     break;
   }
+  // [Cecil] formats in which precompressed texture blocks can be uploaded as they are
+  TS.ts_tfBC1 = TS.ts_tfBC3 = TS.ts_tfBC7 = NONE;
+  if( eAPI==GAT_OGL && (ulGfxFlags&GLF_EXTC_ARB)) {
+    if( ulGfxFlags&GLF_EXTC_S3TC) {
+      TS.ts_tfBC1 = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      TS.ts_tfBC3 = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+    if( ulGfxFlags&GLF_EXTC_BPTC) TS.ts_tfBC7 = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
+  }
+
   // adjust if need to compress opaque textures as transparent
   extern INDEX tex_bAlternateCompression; 
   if( tex_bAlternateCompression) {
@@ -203,6 +215,9 @@ CTextureData::CTextureData()
   td_pulObjects = NULL;
   td_ulObject = NONE;
   td_pulFrames = NULL;
+  td_pubBlocks = NULL; // [Cecil]
+  td_ulBlockFormat = TBF_NONE;
+  td_slBlockFrameSize = 0;
 
   td_pubBuffer1      = NULL; // reset effect buffers
   td_pubBuffer2      = NULL;
@@ -560,13 +575,9 @@ static void Convert( CTextureData *pTD)
 }
 
 
-// remove mipmaps from texture that are not needed (exceeds maximum supported dimension)
-static void RemoveOversizedMipmaps( CTextureData *pTD)
+// [Cecil] determine how many of the largest mipmaps exceed maximum supported dimension
+static INDEX CountOversizedMipmaps( CTextureData *pTD)
 {
-  // if this is an effect texture, leave as it is
-  if( pTD->td_ptegEffect != NULL) return;
-  pTD->td_ulFlags &= ~TEX_DISPOSED;
-
   // determine and clamp to max allowed texture dimension and size
   PIX pixClampAreaSize = (pTD->td_ctFrames>1) ? TS.ts_pixAnimSize : TS.ts_pixNormSize;
   // constant textures doesn't need clamping to area, but still must be clamped to max HW dimension!
@@ -578,11 +589,28 @@ static void RemoveOversizedMipmaps( CTextureData *pTD)
   // determine number of mip-maps to skip
   INDEX ctSkipMips = ClampTextureSize( pixClampAreaSize, _pGfx->gl_pixMaxTextureDimension,
                                        pixSizeU, pixSizeV);
-  // return if no need to remove mip-maps
-  if( ctSkipMips==0) return;
   // check for mip overhead
   INDEX ctMips = GetNoOfMipmaps( pixSizeU, pixSizeV);
   while( ctMips<=ctSkipMips) ctSkipMips--;
+  return ctSkipMips;
+}
+
+
+// remove mipmaps from texture that are not needed (exceeds maximum supported dimension)
+static void RemoveOversizedMipmaps( CTextureData *pTD)
+{
+  // if this is an effect texture, leave as it is
+  if( pTD->td_ptegEffect != NULL) return;
+  pTD->td_ulFlags &= ~TEX_DISPOSED;
+
+  // determine number of mip-maps to skip
+  const INDEX ctSkipMips = CountOversizedMipmaps(pTD);
+  // return if no need to remove mip-maps
+  if( ctSkipMips==0) return;
+
+  // determine dimensions of finest mip-map
+  PIX pixSizeU = pTD->GetPixWidth();
+  PIX pixSizeV = pTD->GetPixHeight();
 
   // determine memory size and allocate memory for rest mip-maps
   SLONG slRemovedMipsSize = GetMipmapOffset( ctSkipMips, pixSizeU, pixSizeV) *BYTES_PER_TEXEL;
@@ -611,6 +639,68 @@ static void RemoveOversizedMipmaps( CTextureData *pTD)
 }
 
 
+// [Cecil] remove compressed mipmaps from texture that are not needed (exceeds maximum supported dimension)
+static void RemoveOversizedBlocks( CTextureData *pTD)
+{
+  pTD->td_ulFlags &= ~TEX_DISPOSED;
+
+  // return if no need to remove mip-maps
+  const INDEX ctSkipMips = CountOversizedMipmaps(pTD);
+  if( ctSkipMips==0) return;
+
+  // determine memory size and allocate memory for rest mip-maps
+  const ULONG ulFormat = pTD->td_ulBlockFormat;
+  SLONG slRemovedMipsSize = GetCompressedMipmapOffset( ulFormat, ctSkipMips, pTD->GetPixWidth(), pTD->GetPixHeight());
+  SLONG slNewFrameSize    = pTD->td_slBlockFrameSize-slRemovedMipsSize;
+  UBYTE *pubNewBlocks = (UBYTE*)AllocMemory( slNewFrameSize * pTD->td_ctFrames);
+
+  // copy only needed mip-maps from each frame
+  for( INDEX iFr=0; iFr<pTD->td_ctFrames; iFr++) {
+    memcpy( pubNewBlocks + iFr*slNewFrameSize, pTD->td_pubBlocks + iFr*pTD->td_slBlockFrameSize + slRemovedMipsSize, slNewFrameSize);
+  }
+
+  // free old blocks memory
+  FreeMemory( pTD->td_pubBlocks);
+  // adjust texture parameters
+  pTD->td_pubBlocks        = pubNewBlocks;
+  pTD->td_slBlockFrameSize = slNewFrameSize;
+  pTD->td_iFirstMipLevel  += ctSkipMips;
+  pTD->td_ctFineMipLevels  = ClampDn( (INDEX)(pTD->td_ctFineMipLevels-ctSkipMips), (INDEX)1);
+  pTD->td_slFrameSize      = GetMipmapOffset( 15, pTD->GetPixWidth(), pTD->GetPixHeight()) *BYTES_PER_TEXEL;
+
+  // mark that this texture had some mip maps disposed
+  pTD->td_ulFlags |= TEX_DISPOSED;
+}
+
+
+// [Cecil] get format in which compressed blocks can be uploaded as they are (NONE if they can't)
+static ULONG GetPrecompressedFormat( ULONG ulBlockFormat)
+{
+  switch( ulBlockFormat) {
+  case TBF_BC1: return TS.ts_tfBC1;
+  case TBF_BC3: return TS.ts_tfBC3;
+  case TBF_BC7: return TS.ts_tfBC7;
+  }
+  return NONE;
+}
+
+
+// [Cecil] check if compressed blocks of a texture can be kept instead of being decoded into frames
+static BOOL KeepCompressedBlocks( CTextureData *pTD, ULONG ulBlockFormat)
+{
+  // exporting and static textures need frames
+  if( _bExport || (pTD->td_ulFlags&TEX_STATIC)) return FALSE;
+
+  // so does adjusting of colors
+  extern INDEX tex_bColorizeMipmaps;
+  if( tex_bColorizeMipmaps && !(pTD->td_ulFlags&TEX_CONSTANT)) return FALSE;
+  if( !(pTD->td_ulFlags&TEX_KEEPCOLOR) && (_slTexSaturation!=256 || _slTexHueShift!=0)) return FALSE;
+
+  // must be supported by the driver
+  return GetPrecompressedFormat(ulBlockFormat)!=NONE;
+}
+
+
 
 // internal routines for texture::read routine
 
@@ -772,6 +862,49 @@ void CTextureData::Read_t( CTStream *inFile)
       }
       bFramesLoaded = TRUE;
     }
+    // [Cecil] if this is chunk containing frames as compressed blocks
+    else if( idChunk == CChunkID("FRMC"))
+    {
+      ULONG ulBlockFormat;
+      *inFile >> ulBlockFormat;
+      if( !IsValidBlockFormat(ulBlockFormat)) {
+        ThrowF_t(TRANS("Unknown block format (%u) found while reading texture \"%s\"."),
+                 ulBlockFormat, inFile->GetDescription().ConstData());
+      }
+      // all mip-maps are kept in file
+      const PIX pixWidth  = GetPixWidth();
+      const PIX pixHeight = GetPixHeight();
+      const SLONG slBlockFrameSize = GetCompressedMipmapOffset( ulBlockFormat, GetCompressedMipmapCount( pixWidth, pixHeight),
+                                                                pixWidth, pixHeight);
+      // if no driver is present and texture is not static
+      if( !(bHasContext || td_ulFlags&TEX_STATIC)) {
+        // just seek over frames (skip it)
+        inFile->Seek_t( slBlockFrameSize*td_ctFrames, CTStream::SD_CUR);
+        continue;
+      }
+      // keep blocks as they are if they can be uploaded like that
+      if( bHasContext && KeepCompressedBlocks( this, ulBlockFormat)) {
+        td_ulBlockFormat = ulBlockFormat;
+        td_slBlockFrameSize = slBlockFrameSize;
+        td_pubBlocks = (UBYTE*)AllocMemory( slBlockFrameSize*td_ctFrames);
+        inFile->Read_t( td_pubBlocks, slBlockFrameSize*td_ctFrames);
+        continue;
+      }
+      // otherwise decode the largest mip-map of each frame and treat it as raw frames
+      td_pulFrames = (ULONG*)AllocMemory( td_slFrameSize * td_ctFrames);
+      const SLONG slFirstMipSize = GetCompressedMipmapSize( ulBlockFormat, pixWidth, pixHeight);
+      UBYTE *pubBlocks = (UBYTE*)AllocMemory( slFirstMipSize);
+
+      for( INDEX iFr=0; iFr<td_ctFrames; iFr++)
+      { // loop thru frames
+        ULONG *pulCurrentFrame = td_pulFrames + (iFr * td_slFrameSize/BYTES_PER_TEXEL);
+        inFile->Read_t( pubBlocks, slFirstMipSize);
+        inFile->Seek_t( slBlockFrameSize-slFirstMipSize, CTStream::SD_CUR);
+        DecompressBitmap( ulBlockFormat, pubBlocks, pulCurrentFrame, pixWidth, pixHeight);
+      }
+      FreeMemory( pubBlocks);
+      bFramesLoaded = TRUE;
+    }
     // if this is chunk containing texture animation data
     else if( idChunk == CChunkID("ANIM"))
     {
@@ -886,6 +1019,14 @@ void CTextureData::Read_t( CTStream *inFile)
     AllocEffectBuffers(this);
   }
 
+  // [Cecil] compressed blocks only need to be reduced in size and uploaded
+  if( td_pubBlocks!=NULL) {
+    RemoveOversizedBlocks(this);
+    td_ulInternalFormat = GetPrecompressedFormat(td_ulBlockFormat);
+    SetAsCurrent();
+    return;
+  }
+
   // were done if frames weren't loaded or effect texture has been read
   if( !bFramesLoaded || td_ptegEffect!=NULL) return;
 
@@ -1028,8 +1169,34 @@ void CTextureData::Write_t( CTStream *outFile)   // throw char *
   *outFile << td_iFirstMipLevel;
   *outFile << td_ctFrames;
 
+  // [Cecil] determine whether frames should be encoded into compressed blocks
+  ULONG ulBlockFormat = TBF_NONE;
+  if( tex_iWriteCompression==1) ulBlockFormat = bAlphaChannel ? TBF_BC3 : TBF_BC1;
+  else if( tex_iWriteCompression==2) ulBlockFormat = TBF_BC7;
+
+  // [Cecil] if frames should be compressed
+  if( td_ptegEffect==NULL && ulBlockFormat!=TBF_NONE)
+  { // write chunk containing frames as compressed blocks
+    ASSERT( td_ctFrames>0);
+    ASSERT( td_pulFrames!=NULL);
+    outFile->WriteID_t( CChunkID("FRMC"));
+    *outFile << ulBlockFormat;
+    const PIX pixWidth  = GetPixWidth();
+    const PIX pixHeight = GetPixHeight();
+    const SLONG slBlockFrameSize = GetCompressedMipmapOffset( ulBlockFormat, GetCompressedMipmapCount( pixWidth, pixHeight),
+                                                              pixWidth, pixHeight);
+    UBYTE *pubBlocks = (UBYTE*)AllocMemory( slBlockFrameSize);
+    // write all mip-maps of each frame
+    for( INDEX iFr=0; iFr<td_ctFrames; iFr++ )
+    {
+      ULONG *pulCurrentFrame = td_pulFrames + (iFr * td_slFrameSize/BYTES_PER_TEXEL);
+      CompressMipmaps( ulBlockFormat, pulCurrentFrame, pubBlocks, pixWidth, pixHeight);
+      outFile->Write_t( pubBlocks, slBlockFrameSize);
+    }
+    FreeMemory( pubBlocks);
+  }
   // if global effect struct exists in texture, don't save frames
-  if( td_ptegEffect==NULL)
+  else if( td_ptegEffect==NULL)
   { // write chunk containing raw frames
     ASSERT( td_ctFrames>0);
     ASSERT( td_pulFrames!=NULL);
@@ -1236,7 +1403,12 @@ void CTextureData::SetAsCurrent( INDEX iFrameNo/*=0*/, BOOL bForceUpload/*=FALSE
     if (td_ptegEffect->teg_updTexture.LastUpdateTick() != _pTimer->GetGameTick()) {
       // discard eventual cached frame and calculate new frame
       MarkChanged();
-      td_ptegEffect->Animate();
+
+      // [Cecil] Unless it has already been animated in advance
+      if (td_ptegEffect->teg_updAnimation.LastUpdateTick() != _pTimer->GetGameTick()) {
+        td_ptegEffect->Animate();
+      }
+
       bNeedUpload = TRUE;
       // make sure that effect and base textures are static
       Force(TEX_STATIC);
@@ -1303,7 +1475,7 @@ void CTextureData::SetAsCurrent( INDEX iFrameNo/*=0*/, BOOL bForceUpload/*=FALSE
   if ((td_ctFrames > 1 && td_pulObjects == NULL) || (td_ctFrames <= 1 && td_ulObject == NONE))
   {
     // check whether frames are present
-    ASSERT( td_pulFrames!=NULL && td_pulFrames[0]!=0xDEADBEEF); 
+    ASSERT( (td_pulFrames!=NULL && td_pulFrames[0]!=0xDEADBEEF) || td_pubBlocks!=NULL); 
 
     if( td_ctFrames>1) {
       // animation textures
@@ -1316,8 +1488,9 @@ void CTextureData::SetAsCurrent( INDEX iFrameNo/*=0*/, BOOL bForceUpload/*=FALSE
       _pGfx->GetInterface()->GenerateTexture(td_ulObject);
     }
     // generate probe texture (if needed)
+    // [Cecil] compressed blocks don't have frames that probes are made from
     ASSERT( td_ulProbeObject==NONE);
-    if (td_ptegEffect == NULL && pixTextureSize > 16*16) {
+    if (td_ptegEffect == NULL && td_pubBlocks == NULL && pixTextureSize > 16*16) {
       _pGfx->GetInterface()->GenerateTexture(td_ulProbeObject);
     }
     // must do initial uploading
@@ -1343,7 +1516,7 @@ void CTextureData::SetAsCurrent( INDEX iFrameNo/*=0*/, BOOL bForceUpload/*=FALSE
   if( bNeedUpload)
   { 
     // check whether frames are present
-    ASSERT( td_pulFrames!=NULL && td_pulFrames[0]!=0xDEADBEEF);
+    ASSERT( (td_pulFrames!=NULL && td_pulFrames[0]!=0xDEADBEEF) || td_pubBlocks!=NULL);
 
     // must discard uploaded texture if single mipmap flag has been changed
     const BOOL bLastSingleMipmap = td_ulFlags & TEX_SINGLEMIPMAP;
@@ -1354,7 +1527,15 @@ void CTextureData::SetAsCurrent( INDEX iFrameNo/*=0*/, BOOL bForceUpload/*=FALSE
 
     // upload all texture frames
     ASSERT( td_ulInternalFormat!=TEXFMT_NONE);
-    if( td_ctFrames>1) {
+    if( td_pubBlocks!=NULL) {
+      // [Cecil] compressed blocks are uploaded as they are
+      for( INDEX iFr=0; iFr<td_ctFrames; iFr++)
+      {
+        ULONG &ulObject = (td_ctFrames>1) ? td_pulObjects[iFr] : td_ulObject;
+        _pGfx->GetInterface()->SetTexture(ulObject, td_tpLocal);
+        _pGfx->GetInterface()->UploadCompressedTexture(td_pubBlocks + iFr*td_slBlockFrameSize, pixWidth, pixHeight, td_ulInternalFormat);
+      }
+    } else if( td_ctFrames>1) {
       // animation textures
       for( INDEX iFr=0; iFr<td_ctFrames; iFr++)
       { // determine frame offset and upload texture frame
@@ -1380,9 +1561,14 @@ void CTextureData::SetAsCurrent( INDEX iFrameNo/*=0*/, BOOL bForceUpload/*=FALSE
     td_tpLocal.Clear();
     // free frames' memory if allowed
     if( !(td_ulFlags&TEX_STATIC)) {
-      FreeMemory( td_pulFrames);
+      if( td_pulFrames!=NULL) FreeMemory( td_pulFrames); // [Cecil] might be in compressed blocks
       td_pulFrames = NULL;
     }
+    // [Cecil] compressed blocks are never static
+    if( td_pubBlocks!=NULL) {
+      FreeMemory( td_pubBlocks);
+      td_pubBlocks = NULL;
+    }
     // done uploading
     ASSERT((td_ctFrames > 1 && td_pulObjects != NULL) || (td_ctFrames == 1 && td_ulObject != NONE));
     return;
@@ -1463,6 +1649,14 @@ void CTextureData::Clear(void)
     td_slFrameSize = 0;
   }
 
+  // [Cecil] free compressed blocks
+  if( td_pubBlocks!=NULL) {
+    FreeMemory( td_pubBlocks);
+    td_pubBlocks = NULL;
+  }
+  td_ulBlockFormat = TBF_NONE;
+  td_slBlockFrameSize = 0;
+
   // free memory allocated for texture effect buffers
   FreeEffectBuffers(this);
 
@@ -70,6 +70,9 @@ public:
     ULONG *td_pulObjects;
   };
   ULONG *td_pulFrames;          // all frames with their mip-maps and private palettes
+  UBYTE *td_pubBlocks;          // [Cecil] all frames as compressed blocks that are uploaded as they are (instead of frames)
+  ULONG td_ulBlockFormat;       // [Cecil] format of compressed blocks (see TexBlockFormat)
+  SLONG td_slBlockFrameSize;    // [Cecil] size of compressed mip-maps of one frame
   UBYTE *td_pubBuffer1, *td_pubBuffer2;       // buffers for effect textures
   PIX td_pixBufferWidth, td_pixBufferHeight;  // effect buffer dimensions
   class CTextureData *td_ptdBaseTexture;      // base texure for effects (if any)
@@ -0,0 +1,783 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "StdH.h"
+
+#include <Engine/Graphics/TextureCompression.h>
+#include <Engine/Graphics/GfxLibrary.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Base/WorkerThreads.h>
+#include <Engine/Math/Functions.h>
+
+extern INDEX tex_bParallelProcessing;
+
+// 4x4 block of texels in R,G,B,A byte order
+typedef UBYTE BlockTexels[16][4];
+
+// Weights of the second endpoint in BC1 palettes (in order of the indices)
+static const FLOAT _afWeightsBC1[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+// Weights of the second endpoint in BC7 palettes with 4-bit indices (out of 64)
+static const INDEX _aiWeightsBC7[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Get name of a block format
+const char *GetBlockFormatName(ULONG ulFormat) {
+  switch (ulFormat) {
+    case TBF_BC1: return "BC1";
+    case TBF_BC3: return "BC3";
+    case TBF_BC7: return "BC7";
+  }
+  return "none";
+};
+
+// Get size of one 4x4 block in bytes
+SLONG GetBlockSize(ULONG ulFormat) {
+  return (ulFormat == TBF_BC1) ? 8 : 16;
+};
+
+// Get size of one compressed mipmap in bytes (partial blocks are padded)
+SLONG GetCompressedMipmapSize(ULONG ulFormat, PIX pixWidth, PIX pixHeight) {
+  return ((pixWidth + 3) / 4) * ((pixHeight + 3) / 4) * GetBlockSize(ulFormat);
+};
+
+// Get number of mipmaps in a compressed chain, which goes down to 1x1 unlike the engine mipmaps
+INDEX GetCompressedMipmapCount(PIX pixWidth, PIX pixHeight) {
+  return FastLog2(Max(pixWidth, pixHeight)) + 1;
+};
+
+// Get offset of some mipmap in a compressed chain in bytes
+SLONG GetCompressedMipmapOffset(ULONG ulFormat, INDEX iMipLevel, PIX pixWidth, PIX pixHeight) {
+  SLONG slOffset = 0;
+
+  for (INDEX iMip = 0; iMip < iMipLevel; iMip++) {
+    slOffset += GetCompressedMipmapSize(ulFormat, pixWidth, pixHeight);
+    pixWidth  = ClampDn(pixWidth  >> 1, 1);
+    pixHeight = ClampDn(pixHeight >> 1, 1);
+  }
+
+  return slOffset;
+};
+
+// Bits of a 128-bit block that are accessed from the lowest one
+struct BlockBits {
+  UBYTE *bb_pubBlock;
+  INDEX bb_iBit;
+
+  BlockBits(UBYTE *pubBlock) : bb_pubBlock(pubBlock), bb_iBit(0) {};
+
+  void Write(ULONG ulValue, INDEX ctBits) {
+    for (INDEX i = 0; i < ctBits; i++, bb_iBit++) {
+      if ((ulValue >> i) & 1) bb_pubBlock[bb_iBit >> 3] |= UBYTE(1 << (bb_iBit & 7));
+    }
+  };
+
+  ULONG Read(INDEX ctBits) {
+    ULONG ulValue = 0;
+
+    for (INDEX i = 0; i < ctBits; i++, bb_iBit++) {
+      ulValue |= ULONG((bb_pubBlock[bb_iBit >> 3] >> (bb_iBit & 7)) & 1) << i;
+    }
+
+    return ulValue;
+  };
+};
+
+// Copy one block of texels from a bitmap (coordinates beyond the edges are clamped for partial blocks)
+static void FetchBlock(const ULONG *pulSrc, PIX pixWidth, PIX pixHeight, PIX pixX, PIX pixY, BlockTexels &aubBlock) {
+  for (INDEX i = 0; i < 16; i++) {
+    const PIX pixU = ClampUp(pixX + (i & 3), pixWidth - 1);
+    const PIX pixV = ClampUp(pixY + (i >> 2), pixHeight - 1);
+    memcpy(aubBlock[i], pulSrc + pixV * pixWidth + pixU, 4);
+  }
+};
+
+// Copy one block of texels into a bitmap (texels beyond the edges are left out)
+static void StoreBlock(const BlockTexels &aubBlock, ULONG *pulDst, PIX pixWidth, PIX pixHeight, PIX pixX, PIX pixY) {
+  for (INDEX i = 0; i < 16; i++) {
+    const PIX pixU = pixX + (i & 3);
+    const PIX pixV = pixY + (i >> 2);
+    if (pixU < pixWidth && pixV < pixHeight) memcpy(pulDst + pixV * pixWidth + pixU, aubBlock[i], 4);
+  }
+};
+
+// Find a line along the principal axis of texel colors and the two points on it that enclose all texels
+static void FitEndpoints(const FLOAT afTexels[16][4], INDEX ctChannels, FLOAT afEnd0[4], FLOAT afEnd1[4]) {
+  FLOAT afMean[4] = { 0, 0, 0, 0 };
+  INDEX i, iCh;
+
+  for (i = 0; i < 16; i++) {
+    for (iCh = 0; iCh < ctChannels; iCh++) afMean[iCh] += afTexels[i][iCh] / 16.0f;
+  }
+
+  // Covariance of channels
+  FLOAT aafCov[4][4] = { { 0 } };
+
+  for (i = 0; i < 16; i++) {
+    for (INDEX iA = 0; iA < ctChannels; iA++) {
+      for (INDEX iB = 0; iB < ctChannels; iB++) {
+        aafCov[iA][iB] += (afTexels[i][iA] - afMean[iA]) * (afTexels[i][iB] - afMean[iB]);
+      }
+    }
+  }
+
+  // Start from the channel that varies the most and find the axis by power iteration
+  INDEX iMaxCh = 0;
+
+  for (iCh = 1; iCh < ctChannels; iCh++) {
+    if (aafCov[iCh][iCh] > aafCov[iMaxCh][iMaxCh]) iMaxCh = iCh;
+  }
+
+  FLOAT afAxis[4] = { 0, 0, 0, 0 };
+  for (iCh = 0; iCh < ctChannels; iCh++) afAxis[iCh] = aafCov[iMaxCh][iCh];
+
+  for (INDEX iIter = 0; iIter < 8; iIter++) {
+    FLOAT afNext[4] = { 0, 0, 0, 0 };
+    FLOAT fLength = 0.0f;
+
+    for (INDEX iA = 0; iA < ctChannels; iA++) {
+      for (INDEX iB = 0; iB < ctChannels; iB++) afNext[iA] += aafCov[iA][iB] * afAxis[iB];
+      fLength = Max(fLength, Abs(afNext[iA]));
+    }
+
+    if (fLength < 1e-6f) break;
+    for (iCh = 0; iCh < ctChannels; iCh++) afAxis[iCh] = afNext[iCh] / fLength;
+  }
+
+  FLOAT fAxisLength = 0.0f;
+  for (iCh = 0; iCh < ctChannels; iCh++) fAxisLength += afAxis[iCh] * afAxis[iCh];
+
+  // All texels are the same
+  if (fAxisLength < 1e-6f) {
+    for (iCh = 0; iCh < ctChannels; iCh++) afEnd0[iCh] = afEnd1[iCh] = afMean[iCh];
+    return;
+  }
+
+  fAxisLength = Sqrt(fAxisLength);
+  for (iCh = 0; iCh < ctChannels; iCh++) afAxis[iCh] /= fAxisLength;
+
+  // Project texels onto the axis
+  FLOAT fMin = 1e30f, fMax = -1e30f;
+
+  for (i = 0; i < 16; i++) {
+    FLOAT fProj = 0.0f;
+    for (iCh = 0; iCh < ctChannels; iCh++) fProj += (afTexels[i][iCh] - afMean[iCh]) * afAxis[iCh];
+
+    fMin = Min(fMin, fProj);
+    fMax = Max(fMax, fProj);
+  }
+
+  for (iCh = 0; iCh < ctChannels; iCh++) {
+    afEnd0[iCh] = Clamp(afMean[iCh] + afAxis[iCh] * fMin, 0.0f, 255.0f);
+    afEnd1[iCh] = Clamp(afMean[iCh] + afAxis[iCh] * fMax, 0.0f, 255.0f);
+  }
+};
+
+// Fit endpoints to texels with the least squares for weights of the second endpoint that have been chosen for each texel
+static BOOL RefitEndpoints(const FLOAT afTexels[16][4], const FLOAT afWeights[16], INDEX ctChannels, FLOAT afEnd0[4], FLOAT afEnd1[4]) {
+  FLOAT fAA = 0.0f, fAB = 0.0f, fBB = 0.0f;
+  FLOAT afA[4] = { 0, 0, 0, 0 };
+  FLOAT afB[4] = { 0, 0, 0, 0 };
+  INDEX iCh;
+
+  for (INDEX i = 0; i < 16; i++) {
+    const FLOAT fB = afWeights[i];
+    const FLOAT fA = 1.0f - fB;
+
+    fAA += fA * fA;
+    fAB += fA * fB;
+    fBB += fB * fB;
+
+    for (iCh = 0; iCh < ctChannels; iCh++) {
+      afA[iCh] += fA * afTexels[i][iCh];
+      afB[iCh] += fB * afTexels[i][iCh];
+    }
+  }
+
+  // All texels use the same palette entry
+  const FLOAT fDet = fAA * fBB - fAB * fAB;
+  if (Abs(fDet) < 1e-6f) return FALSE;
+
+  for (iCh = 0; iCh < ctChannels; iCh++) {
+    afEnd0[iCh] = Clamp((fBB * afA[iCh] - fAB * afB[iCh]) / fDet, 0.0f, 255.0f);
+    afEnd1[iCh] = Clamp((fAA * afB[iCh] - fAB * afA[iCh]) / fDet, 0.0f, 255.0f);
+  }
+
+  return TRUE;
+};
+
+// Choose the closest palette entry for each texel and return the total squared error
+static INDEX ChooseIndices(const BlockTexels &aubTexels, const UBYTE aubPalette[][4], INDEX ctEntries, INDEX ctChannels, INDEX aiIndices[16]) {
+  INDEX iTotalError = 0;
+
+  for (INDEX i = 0; i < 16; i++) {
+    INDEX iBestError = MAX_SLONG;
+
+    for (INDEX iEntry = 0; iEntry < ctEntries; iEntry++) {
+      INDEX iError = 0;
+
+      for (INDEX iCh = 0; iCh < ctChannels; iCh++) {
+        const INDEX iDiff = INDEX(aubTexels[i][iCh]) - INDEX(aubPalette[iEntry][iCh]);
+        iError += iDiff * iDiff;
+      }
+
+      if (iError < iBestError) {
+        iBestError = iError;
+        aiIndices[i] = iEntry;
+      }
+    }
+
+    iTotalError += iBestError;
+  }
+
+  return iTotalError;
+};
+
+static void BlockToFloats(const BlockTexels &aubTexels, FLOAT afTexels[16][4]) {
+  for (INDEX i = 0; i < 16; i++) {
+    for (INDEX iCh = 0; iCh < 4; iCh++) afTexels[i][iCh] = aubTexels[i][iCh];
+  }
+};
+
+// Pack color into 5:6:5 bits
+static UWORD PackColor565(const FLOAT afColor[3]) {
+  const ULONG ulR = Clamp(INDEX(afColor[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+  const ULONG ulG = Clamp(INDEX(afColor[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+  const ULONG ulB = Clamp(INDEX(afColor[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+  return UWORD((ulR << 11) | (ulG << 5) | ulB);
+};
+
+// Make palette of a BC1 color block (BC3 color blocks always have four colors)
+static void MakeColorPalette(UWORD uw0, UWORD uw1, BOOL bAlwaysFour, UBYTE aubPalette[4][4]) {
+  const INDEX ai0[3] = { (uw0 >> 11) & 31, (uw0 >> 5) & 63, uw0 & 31 };
+  const INDEX ai1[3] = { (uw1 >> 11) & 31, (uw1 >> 5) & 63, uw1 & 31 };
+  const BOOL bFour = bAlwaysFour || uw0 > uw1;
+
+  for (INDEX iCh = 0; iCh < 3; iCh++) {
+    // Expand to 8 bits
+    const INDEX iBits = (iCh == 1) ? 6 : 5;
+    const INDEX iC0 = (ai0[iCh] << (8 - iBits)) | (ai0[iCh] >> (iBits * 2 - 8));
+    const INDEX iC1 = (ai1[iCh] << (8 - iBits)) | (ai1[iCh] >> (iBits * 2 - 8));
+
+    aubPalette[0][iCh] = UBYTE(iC0);
+    aubPalette[1][iCh] = UBYTE(iC1);
+
+    if (bFour) {
+      aubPalette[2][iCh] = UBYTE((iC0 * 2 + iC1) / 3);
+      aubPalette[3][iCh] = UBYTE((iC0 + iC1 * 2) / 3);
+    } else {
+      aubPalette[2][iCh] = UBYTE((iC0 + iC1) / 2);
+      aubPalette[3][iCh] = 0;
+    }
+  }
+
+  aubPalette[0][3] = aubPalette[1][3] = aubPalette[2][3] = 255;
+  aubPalette[3][3] = bFour ? 255 : 0;
+};
+
+// Encode colors of a block into 8 bytes (always in four color mode)
+static void EncodeColorBlock(const BlockTexels &aubTexels, UBYTE *pubDst) {
+  FLOAT afTexels[16][4];
+  BlockToFloats(aubTexels, afTexels);
+
+  FLOAT afEnd0[4], afEnd1[4];
+  FitEndpoints(afTexels, 3, afEnd0, afEnd1);
+
+  UWORD uwBest0 = 0, uwBest1 = 0;
+  ULONG ulBestIndices = 0;
+  INDEX iBestError = MAX_SLONG;
+
+  // Second pass refits endpoints to the indices chosen in the first one
+  for (INDEX iPass = 0; iPass < 2; iPass++) {
+    UWORD uw0 = PackColor565(afEnd0);
+    UWORD uw1 = PackColor565(afEnd1);
+
+    // First color must be larger for four color mode
+    if (uw0 < uw1) Swap(uw0, uw1);
+
+    UBYTE aubPalette[4][4];
+    MakeColorPalette(uw0, uw1, TRUE, aubPalette);
+
+    // Only the first color may be used if they are the same
+    INDEX aiIndices[16];
+    const INDEX iError = ChooseIndices(aubTexels, aubPalette, (uw0 == uw1) ? 1 : 4, 3, aiIndices);
+
+    if (iError < iBestError) {
+      iBestError = iError;
+      uwBest0 = uw0;
+      uwBest1 = uw1;
+      ulBestIndices = 0;
+
+      for (INDEX i = 0; i < 16; i++) ulBestIndices |= ULONG(aiIndices[i]) << (i * 2);
+    }
+
+    if (iError == 0) break;
+
+    FLOAT afWeights[16];
+    for (INDEX i = 0; i < 16; i++) afWeights[i] = _afWeightsBC1[aiIndices[i]];
+
+    if (!RefitEndpoints(afTexels, afWeights, 3, afEnd0, afEnd1)) break;
+  }
+
+  pubDst[0] = UBYTE(uwBest0);
+  pubDst[1] = UBYTE(uwBest0 >> 8);
+  pubDst[2] = UBYTE(uwBest1);
+  pubDst[3] = UBYTE(uwBest1 >> 8);
+  pubDst[4] = UBYTE(ulBestIndices);
+  pubDst[5] = UBYTE(ulBestIndices >> 8);
+  pubDst[6] = UBYTE(ulBestIndices >> 16);
+  pubDst[7] = UBYTE(ulBestIndices >> 24);
+};
+
+// Decode colors of a block from 8 bytes
+static void DecodeColorBlock(const UBYTE *pubSrc, BOOL bAlwaysFour, BlockTexels &aubTexels) {
+  const UWORD uw0 = UWORD(pubSrc[0] | (pubSrc[1] << 8));
+  const UWORD uw1 = UWORD(pubSrc[2] | (pubSrc[3] << 8));
+  const ULONG ulIndices = pubSrc[4] | (pubSrc[5] << 8) | (pubSrc[6] << 16) | (ULONG(pubSrc[7]) << 24);
+
+  UBYTE aubPalette[4][4];
+  MakeColorPalette(uw0, uw1, bAlwaysFour, aubPalette);
+
+  for (INDEX i = 0; i < 16; i++) {
+    memcpy(aubTexels[i], aubPalette[(ulIndices >> (i * 2)) & 3], 4);
+  }
+};
+
+// Make palette of an alpha block
+static void MakeAlphaPalette(INDEX iA0, INDEX iA1, UBYTE aubPalette[8]) {
+  aubPalette[0] = UBYTE(iA0);
+  aubPalette[1] = UBYTE(iA1);
+
+  if (iA0 > iA1) {
+    for (INDEX i = 2; i < 8; i++) aubPalette[i] = UBYTE(((8 - i) * iA0 + (i - 1) * iA1) / 7);
+
+  } else {
+    for (INDEX i = 2; i < 6; i++) aubPalette[i] = UBYTE(((6 - i) * iA0 + (i - 1) * iA1) / 5);
+    aubPalette[6] = 0;
+    aubPalette[7] = 255;
+  }
+};
+
+// Encode alpha of a block into 8 bytes (always in eight value mode)
+static void EncodeAlphaBlock(const BlockTexels &aubTexels, UBYTE *pubDst) {
+  INDEX iMin = 255, iMax = 0;
+
+  for (INDEX i = 0; i < 16; i++) {
+    iMin = Min(iMin, INDEX(aubTexels[i][3]));
+    iMax = Max(iMax, INDEX(aubTexels[i][3]));
+  }
+
+  UBYTE aubPalette[8];
+  MakeAlphaPalette(iMax, iMin, aubPalette);
+
+  // Only the first value may be used if they are the same
+  const INDEX ctEntries = (iMax == iMin) ? 1 : 8;
+
+  // 48 bits of 3-bit indices
+  SQUAD llIndices = 0;
+
+  for (INDEX i = 0; i < 16; i++) {
+    INDEX iBest = 0, iBestError = MAX_SLONG;
+
+    for (INDEX iEntry = 0; iEntry < ctEntries; iEntry++) {
+      const INDEX iError = Abs(INDEX(aubTexels[i][3]) - INDEX(aubPalette[iEntry]));
+
+      if (iError < iBestError) {
+        iBestError = iError;
+        iBest = iEntry;
+      }
+    }
+
+    llIndices |= SQUAD(iBest) << (i * 3);
+  }
+
+  pubDst[0] = UBYTE(iMax);
+  pubDst[1] = UBYTE(iMin);
+  for (INDEX iByte = 0; iByte < 6; iByte++) pubDst[2 + iByte] = UBYTE(llIndices >> (iByte * 8));
+};
+
+// Decode alpha of a block from 8 bytes
+static void DecodeAlphaBlock(const UBYTE *pubSrc, BlockTexels &aubTexels) {
+  UBYTE aubPalette[8];
+  MakeAlphaPalette(pubSrc[0], pubSrc[1], aubPalette);
+
+  SQUAD llIndices = 0;
+  for (INDEX iByte = 0; iByte < 6; iByte++) llIndices |= SQUAD(pubSrc[2 + iByte]) << (iByte * 8);
+
+  for (INDEX i = 0; i < 16; i++) {
+    aubTexels[i][3] = aubPalette[(llIndices >> (i * 3)) & 7];
+  }
+};
+
+// Quantize BC7 mode 6 endpoint to 7 bits per channel and one shared lowest bit
+// (opaque endpoints need the lowest bit to keep the full alpha)
+static void QuantizeEndpointBC7(const FLOAT afEnd[4], BOOL bOpaque, INDEX aiColor[4]) {
+  FLOAT fBestError = 1e30f;
+
+  for (INDEX iP = (bOpaque ? 1 : 0); iP < 2; iP++) {
+    INDEX aiTry[4];
+    FLOAT fError = 0.0f;
+
+    for (INDEX iCh = 0; iCh < 4; iCh++) {
+      aiTry[iCh] = (Clamp(INDEX((afEnd[iCh] - iP) * 0.5f + 0.5f), 0, 127) << 1) | iP;
+
+      const FLOAT fDiff = aiTry[iCh] - afEnd[iCh];
+      fError += fDiff * fDiff;
+    }
+
+    if (fError < fBestError) {
+      fBestError = fError;
+      memcpy(aiColor, aiTry, sizeof(aiTry));
+    }
+  }
+};
+
+// Make palette of a BC7 block from 8-bit endpoints
+static void MakePaletteBC7(const INDEX ai0[4], const INDEX ai1[4], UBYTE aubPalette[16][4]) {
+  for (INDEX i = 0; i < 16; i++) {
+    const INDEX iW = _aiWeightsBC7[i];
+
+    for (INDEX iCh = 0; iCh < 4; iCh++) {
+      aubPalette[i][iCh] = UBYTE(((64 - iW) * ai0[iCh] + iW * ai1[iCh] + 32) >> 6);
+    }
+  }
+};
+
+// Encode a block into 16 bytes using BC7 mode 6 (one RGBA subset with 4-bit indices)
+static void EncodeBlockBC7(const BlockTexels &aubTexels, UBYTE *pubDst) {
+  FLOAT afTexels[16][4];
+  BlockToFloats(aubTexels, afTexels);
+
+  FLOAT afEnd0[4], afEnd1[4];
+  FitEndpoints(afTexels, 4, afEnd0, afEnd1);
+
+  INDEX aiBest0[4], aiBest1[4], aiBestIndices[16];
+  INDEX iBestError = MAX_SLONG;
+  INDEX i, iCh;
+
+  BOOL bOpaque = TRUE;
+  for (i = 0; i < 16; i++) bOpaque &= (aubTexels[i][3] == 255);
+
+  // Second pass refits endpoints to the indices chosen in the first one
+  for (INDEX iPass = 0; iPass < 2; iPass++) {
+    INDEX ai0[4], ai1[4];
+    QuantizeEndpointBC7(afEnd0, bOpaque, ai0);
+    QuantizeEndpointBC7(afEnd1, bOpaque, ai1);
+
+    UBYTE aubPalette[16][4];
+    MakePaletteBC7(ai0, ai1, aubPalette);
+
+    INDEX aiIndices[16];
+    const INDEX iError = ChooseIndices(aubTexels, aubPalette, 16, 4, aiIndices);
+
+    if (iError < iBestError) {
+      iBestError = iError;
+      memcpy(aiBest0, ai0, sizeof(ai0));
+      memcpy(aiBest1, ai1, sizeof(ai1));
+      memcpy(aiBestIndices, aiIndices, sizeof(aiIndices));
+    }
+
+    if (iError == 0) break;
+
+    FLOAT afWeights[16];
+    for (i = 0; i < 16; i++) afWeights[i] = _aiWeightsBC7[aiIndices[i]] / 64.0f;
+
+    if (!RefitEndpoints(afTexels, afWeights, 4, afEnd0, afEnd1)) break;
+  }
+
+  // Index of the first texel is stored without its highest bit, so swap endpoints if it's set
+  if (aiBestIndices[0] & 8) {
+    for (iCh = 0; iCh < 4; iCh++) Swap(aiBest0[iCh], aiBest1[iCh]);
+    for (i = 0; i < 16; i++) aiBestIndices[i] = 15 - aiBestIndices[i];
+  }
+
+  memset(pubDst, 0, 16);
+  BlockBits bits(pubDst);
+
+  // Mode 6
+  bits.Write(1 << 6, 7);
+
+  // 7-bit endpoints channel by channel
+  for (iCh = 0; iCh < 4; iCh++) {
+    bits.Write(aiBest0[iCh] >> 1, 7);
+    bits.Write(aiBest1[iCh] >> 1, 7);
+  }
+
+  // Lowest bits of endpoints
+  bits.Write(aiBest0[0] & 1, 1);
+  bits.Write(aiBest1[0] & 1, 1);
+
+  bits.Write(aiBestIndices[0], 3);
+  for (i = 1; i < 16; i++) bits.Write(aiBestIndices[i], 4);
+};
+
+// Decode a BC7 block from 16 bytes (only mode 6 is supported, other blocks are decoded as transparent black)
+static void DecodeBlockBC7(const UBYTE *pubSrc, BlockTexels &aubTexels) {
+  if ((pubSrc[0] & 0x7F) != 0x40) {
+    memset(aubTexels, 0, sizeof(BlockTexels));
+    return;
+  }
+
+  BlockBits bits(const_cast<UBYTE *>(pubSrc));
+  bits.Read(7);
+
+  INDEX ai0[4], ai1[4];
+  INDEX iCh;
+
+  for (iCh = 0; iCh < 4; iCh++) {
+    ai0[iCh] = bits.Read(7) << 1;
+    ai1[iCh] = bits.Read(7) << 1;
+  }
+
+  const INDEX iP0 = bits.Read(1);
+  const INDEX iP1 = bits.Read(1);
+
+  for (iCh = 0; iCh < 4; iCh++) {
+    ai0[iCh] |= iP0;
+    ai1[iCh] |= iP1;
+  }
+
+  UBYTE aubPalette[16][4];
+  MakePaletteBC7(ai0, ai1, aubPalette);
+
+  for (INDEX i = 0; i < 16; i++) {
+    memcpy(aubTexels[i], aubPalette[bits.Read(i == 0 ? 3 : 4)], 4);
+  }
+};
+
+// Encode one block of texels
+static void EncodeBlock(ULONG ulFormat, const BlockTexels &aubTexels, UBYTE *pubDst) {
+  switch (ulFormat) {
+    case TBF_BC1:
+      EncodeColorBlock(aubTexels, pubDst);
+      break;
+
+    case TBF_BC3:
+      EncodeAlphaBlock(aubTexels, pubDst);
+      EncodeColorBlock(aubTexels, pubDst + 8);
+      break;
+
+    case TBF_BC7:
+      EncodeBlockBC7(aubTexels, pubDst);
+      break;
+
+    default: ASSERTALWAYS("Unknown block format!");
+  }
+};
+
+// Decode one block of texels
+static void DecodeBlock(ULONG ulFormat, const UBYTE *pubSrc, BlockTexels &aubTexels) {
+  switch (ulFormat) {
+    case TBF_BC1:
+      DecodeColorBlock(pubSrc, FALSE, aubTexels);
+      break;
+
+    case TBF_BC3:
+      DecodeColorBlock(pubSrc + 8, TRUE, aubTexels);
+      DecodeAlphaBlock(pubSrc, aubTexels);
+      break;
+
+    case TBF_BC7:
+      DecodeBlockBC7(pubSrc, aubTexels);
+      break;
+
+    default: ASSERTALWAYS("Unknown block format!");
+  }
+};
+
+// Bitmap encoding that's split into rows of blocks
+struct CompressJob {
+  ULONG cj_ulFormat;
+  const ULONG *cj_pulSrc;
+  UBYTE *cj_pubDst;
+  PIX cj_pixWidth, cj_pixHeight;
+};
+
+// Encode one row of blocks
+static void CompressRowJob(void *pData, INDEX iRow) {
+  const CompressJob &job = *(const CompressJob *)pData;
+  const SLONG slBlockSize = GetBlockSize(job.cj_ulFormat);
+  const INDEX ctBlocksU = (job.cj_pixWidth + 3) / 4;
+
+  UBYTE *pubDst = job.cj_pubDst + iRow * ctBlocksU * slBlockSize;
+  BlockTexels aubBlock;
+
+  for (INDEX iBlock = 0; iBlock < ctBlocksU; iBlock++) {
+    FetchBlock(job.cj_pulSrc, job.cj_pixWidth, job.cj_pixHeight, iBlock * 4, iRow * 4, aubBlock);
+    EncodeBlock(job.cj_ulFormat, aubBlock, pubDst);
+    pubDst += slBlockSize;
+  }
+};
+
+// Encode one bitmap of 32-bit texels in R,G,B,A byte order into blocks
+void CompressBitmap(ULONG ulFormat, const ULONG *pulSrc, UBYTE *pubDst, PIX pixWidth, PIX pixHeight) {
+  ASSERT(IsValidBlockFormat(ulFormat));
+  ASSERT(pixWidth > 0 && pixHeight > 0);
+
+  CompressJob job;
+  job.cj_ulFormat = ulFormat;
+  job.cj_pulSrc = pulSrc;
+  job.cj_pubDst = pubDst;
+  job.cj_pixWidth = pixWidth;
+  job.cj_pixHeight = pixHeight;
+
+  const INDEX ctRows = (pixHeight + 3) / 4;
+
+  // Each row of blocks is independent
+  if (tex_bParallelProcessing && ctRows > 1) {
+    ParallelFor(ctRows, &CompressRowJob, &job);
+    return;
+  }
+
+  for (INDEX iRow = 0; iRow < ctRows; iRow++) {
+    CompressRowJob(&job, iRow);
+  }
+};
+
+// Decode blocks of one bitmap into 32-bit texels in R,G,B,A byte order
+void DecompressBitmap(ULONG ulFormat, const UBYTE *pubSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight) {
+  ASSERT(IsValidBlockFormat(ulFormat));
+  ASSERT(pixWidth > 0 && pixHeight > 0);
+
+  const SLONG slBlockSize = GetBlockSize(ulFormat);
+  BlockTexels aubBlock;
+
+  for (PIX pixY = 0; pixY < pixHeight; pixY += 4) {
+    for (PIX pixX = 0; pixX < pixWidth; pixX += 4) {
+      // Opaque BC1 texels
+      if (ulFormat == TBF_BC1) memset(aubBlock, 255, sizeof(aubBlock));
+
+      DecodeBlock(ulFormat, pubSrc, aubBlock);
+      StoreBlock(aubBlock, pulDst, pixWidth, pixHeight, pixX, pixY);
+      pubSrc += slBlockSize;
+    }
+  }
+};
+
+// Encode all mipmaps of one texture frame into a compressed chain
+void CompressMipmaps(ULONG ulFormat, const ULONG *pulMipmaps, UBYTE *pubDst, PIX pixWidth, PIX pixHeight) {
+  const INDEX ctMips = GetNoOfMipmaps(pixWidth, pixHeight);
+  const ULONG *pulLastMip = pulMipmaps;
+
+  for (INDEX iMip = 0; iMip < ctMips; iMip++) {
+    CompressBitmap(ulFormat, pulMipmaps, pubDst, pixWidth, pixHeight);
+    pubDst += GetCompressedMipmapSize(ulFormat, pixWidth, pixHeight);
+
+    pulLastMip = pulMipmaps;
+    pulMipmaps += pixWidth * pixHeight;
+
+    // Stop at the last one
+    if (iMip == ctMips - 1) break;
+
+    pixWidth  >>= 1;
+    pixHeight >>= 1;
+  }
+
+  // Square textures end with 1x1
+  PIX pixTexels = pixWidth * pixHeight;
+  if (pixTexels == 1) return;
+
+  // Keep averaging pairs of texels from the last mipmap in place
+  UBYTE *pubTail = (UBYTE *)AllocMemory(pixTexels * 4);
+  memcpy(pubTail, pulLastMip, pixTexels * 4);
+
+  while (pixTexels > 1) {
+    pixWidth  = ClampDn(pixWidth  >> 1, 1);
+    pixHeight = ClampDn(pixHeight >> 1, 1);
+    pixTexels = pixWidth * pixHeight;
+
+    for (INDEX iByte = 0; iByte < pixTexels * 4; iByte++) {
+      const INDEX iSrc = (iByte & ~3) * 2 + (iByte & 3);
+      pubTail[iByte] = UBYTE((UWORD(pubTail[iSrc]) + UWORD(pubTail[iSrc + 4])) >> 1);
+    }
+
+    CompressBitmap(ulFormat, (const ULONG *)pubTail, pubDst, pixWidth, pixHeight);
+    pubDst += GetCompressedMipmapSize(ulFormat, pixWidth, pixHeight);
+  }
+
+  FreeMemory(pubTail);
+};
+
+// Encode and decode a generated bitmap in each block format and report speed and quality
+void BenchmarkTextureCompression(void *pArgs) {
+  INDEX iSize = NEXTARGUMENT(INDEX);
+  if (iSize < 4) iSize = 512;
+
+  // Power of two like texture dimensions
+  const PIX pixSize = 1 << FastLog2(iSize);
+  const PIX pixTexels = pixSize * pixSize;
+
+  ULONG *pulSrc = (ULONG *)AllocMemory(pixTexels * sizeof(ULONG));
+  ULONG *pulDecoded = (ULONG *)AllocMemory(pixTexels * sizeof(ULONG));
+  UBYTE *pubBlocks = (UBYTE *)AllocMemory(GetCompressedMipmapSize(TBF_BC7, pixSize, pixSize));
+
+  // Gradients with some noise and sharp edges
+  ULONG ulSeed = 0x1234567;
+  UBYTE *pubSrc = (UBYTE *)pulSrc;
+
+  for (PIX pixY = 0; pixY < pixSize; pixY++) {
+    for (PIX pixX = 0; pixX < pixSize; pixX++) {
+      ulSeed = ulSeed * 1103515245 + 12345;
+      const INDEX iNoise = (ulSeed >> 16) & 15;
+      const BOOL bStripe = ((pixX / 16) & 1) != 0;
+
+      *pubSrc++ = UBYTE(pixX * 255 / pixSize);
+      *pubSrc++ = UBYTE(pixY * 255 / pixSize);
+      *pubSrc++ = UBYTE((bStripe ? 192 : 32) + iNoise);
+      *pubSrc++ = UBYTE(255 - ((pixX + pixY) * 127 / pixSize));
+    }
+  }
+
+  CPrintF(TRANS("Texture compression benchmark (%dx%d):\n"), pixSize, pixSize);
+
+  static const ULONG aulFormats[3] = { TBF_BC1, TBF_BC3, TBF_BC7 };
+
+  for (INDEX iFormat = 0; iFormat < 3; iFormat++) {
+    const ULONG ulFormat = aulFormats[iFormat];
+
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+    CompressBitmap(ulFormat, pulSrc, pubBlocks, pixSize, pixSize);
+    const DOUBLE dEncode = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+    tvStart = _pTimer->GetHighPrecisionTimer();
+    DecompressBitmap(ulFormat, pubBlocks, pulDecoded, pixSize, pixSize);
+    const DOUBLE dDecode = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+    // Alpha isn't stored in BC1
+    const INDEX ctChannels = (ulFormat == TBF_BC1) ? 3 : 4;
+    const UBYTE *pubA = (const UBYTE *)pulSrc;
+    const UBYTE *pubB = (const UBYTE *)pulDecoded;
+    DOUBLE dSquaredError = 0.0;
+
+    for (PIX pix = 0; pix < pixTexels; pix++) {
+      for (INDEX iCh = 0; iCh < ctChannels; iCh++) {
+        const DOUBLE dDiff = DOUBLE(pubA[pix * 4 + iCh]) - DOUBLE(pubB[pix * 4 + iCh]);
+        dSquaredError += dDiff * dDiff;
+      }
+    }
+
+    const DOUBLE dMSE = dSquaredError / DOUBLE(pixTexels * ctChannels);
+    const DOUBLE dPSNR = (dMSE > 0.0) ? 10.0 * log10(255.0 * 255.0 / dMSE) : 99.0;
+
+    CPrintF("  %s: %8.2f ms encode, %6.2f ms decode, %.2f dB PSNR, %d -> %d bytes\n",
+      GetBlockFormatName(ulFormat), dEncode * 1000.0, dDecode * 1000.0, dPSNR,
+      pixTexels * 4, GetCompressedMipmapSize(ulFormat, pixSize, pixSize));
+  }
+
+  FreeMemory(pulSrc);
+  FreeMemory(pulDecoded);
+  FreeMemory(pubBlocks);
+};
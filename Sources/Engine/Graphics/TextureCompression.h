@@ -0,0 +1,60 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_TEXTURECOMPRESSION_H
+#define SE_INCL_TEXTURECOMPRESSION_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+// Formats of compressed texture blocks (values are saved in texture files)
+enum TexBlockFormat {
+  TBF_NONE = 0,
+  TBF_BC1  = 1, // 4x4 opaque RGB texels in 8 bytes (DXT1)
+  TBF_BC3  = 2, // 4x4 RGBA texels in 16 bytes (DXT5)
+  TBF_BC7  = 3, // 4x4 RGBA texels in 16 bytes (BPTC, encoded only in mode 6)
+};
+
+// Check if the block format is known
+inline BOOL IsValidBlockFormat(ULONG ulFormat) {
+  return ulFormat == TBF_BC1 || ulFormat == TBF_BC3 || ulFormat == TBF_BC7;
+};
+
+// Get name of a block format
+ENGINE_API const char *GetBlockFormatName(ULONG ulFormat);
+
+// Get size of one 4x4 block in bytes
+ENGINE_API SLONG GetBlockSize(ULONG ulFormat);
+
+// Get size of one compressed mipmap in bytes (partial blocks are padded)
+ENGINE_API SLONG GetCompressedMipmapSize(ULONG ulFormat, PIX pixWidth, PIX pixHeight);
+
+// Get number of mipmaps in a compressed chain, which goes down to 1x1 unlike the engine mipmaps
+ENGINE_API INDEX GetCompressedMipmapCount(PIX pixWidth, PIX pixHeight);
+
+// Get offset of some mipmap in a compressed chain in bytes (or size of the whole chain for the level past the last one)
+ENGINE_API SLONG GetCompressedMipmapOffset(ULONG ulFormat, INDEX iMipLevel, PIX pixWidth, PIX pixHeight);
+
+// Encode one bitmap of 32-bit texels in R,G,B,A byte order into blocks (spread over worker threads)
+ENGINE_API void CompressBitmap(ULONG ulFormat, const ULONG *pulSrc, UBYTE *pubDst, PIX pixWidth, PIX pixHeight);
+
+// Decode blocks of one bitmap into 32-bit texels in R,G,B,A byte order
+ENGINE_API void DecompressBitmap(ULONG ulFormat, const UBYTE *pubSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight);
+
+// Encode all mipmaps of one texture frame (as made by MakeMipmaps()) into a compressed chain;
+// mipmaps under 1xN and Nx1 are averaged from the last one the same way as when uploading raw frames
+ENGINE_API void CompressMipmaps(ULONG ulFormat, const ULONG *pulMipmaps, UBYTE *pubDst, PIX pixWidth, PIX pixHeight);
+
+#endif  /* include-once check. */
@@ -21,6 +21,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Math/Functions.h>
 #include <Engine/Base/Timer.h>
 #include <Engine/Base/Statistics_internal.h>
+#include <Engine/Base/SIMDKernels.h>
+#include <Engine/Base/WorkerThreads.h>
 #include <Engine/Templates/DynamicArray.cpp>
 #include <Engine/Templates/Stock_CTextureData.h>
 #include <Engine/Templates/StaticArray.cpp>
@@ -39,24 +41,35 @@ static const SQUAD mm1HILO = 0x0000000100000001;
 static const SQUAD mm0001  = 0x0000000000000001;
 static const SQUAD mm0010  = 0x0000000000010000;
 static const SQUAD mm00M0  = 0x00000000FFFF0000;
-static SQUAD mmBaseWidthShift=0, mmBaseWidth=0, mmBaseWidthMask=0, mmBaseHeightMask=0, mmBaseMasks=0, mmShift=0;
+
+// [Cecil] Effect textures can only be animated on worker threads if the effect state is kept per thread
+// (inline assembly cannot access thread-local variables)
+#define SE1_PARALLEL_EFFECTS (SE1_WORKER_THREADS && !SE1_USE_ASM)
+
+#if SE1_PARALLEL_EFFECTS
+  #define EFFECT_TLS thread_local
+#else
+  #define EFFECT_TLS
+#endif
+
+EFFECT_TLS static SQUAD mmBaseWidthShift=0, mmBaseWidth=0, mmBaseWidthMask=0, mmBaseHeightMask=0, mmBaseMasks=0, mmShift=0;
 
 
 // speed table
 static SBYTE asbMod3Sub1Table[256];
 static BOOL  bTableSet = FALSE;
 
-static CTextureData *_ptdEffect, *_ptdBase;
-static PIX _pixTexWidth,    _pixTexHeight;
-static PIX _pixBufferWidth, _pixBufferHeight;
-static ULONG _ulBufferMask;
-static INDEX _iWantedMipLevel;
-static UBYTE *_pubDrawBuffer;
-static SWORD *_pswDrawBuffer;
+EFFECT_TLS static CTextureData *_ptdEffect, *_ptdBase;
+EFFECT_TLS static PIX _pixTexWidth,    _pixTexHeight;
+EFFECT_TLS static PIX _pixBufferWidth, _pixBufferHeight;
+EFFECT_TLS static ULONG _ulBufferMask;
+EFFECT_TLS static INDEX _iWantedMipLevel;
+EFFECT_TLS static UBYTE *_pubDrawBuffer;
+EFFECT_TLS static SWORD *_pswDrawBuffer;
 
 
 // randomizer
-static ULONG ulRNDSeed;
+EFFECT_TLS static ULONG ulRNDSeed;
 
 inline void Randomize( ULONG ulSeed)
 {
@@ -1094,31 +1107,19 @@ void InitializeWater(void)
 ********************************/
 static void AnimateWater( SLONG slDensity)
 {
-  _sfStats.StartTimer(CStatForm::STI_EFFECTRENDER);
-
 /////////////////////////////////// move water
 
   SWORD *pNew = (SWORD*)_ptdEffect->td_pubBuffer1;
   SWORD *pOld = (SWORD*)_ptdEffect->td_pubBuffer2;
 
-  PIX pixV, pixU;
+  PIX pixU;
   PIX pixOffset, iNew;
   SLONG slLineAbove, slLineBelow, slLineLeft, slLineRight;
 
   // inner rectangle (without 1 pixel top and bottom line)
+  // [Cecil] Vectorized
   pixOffset = _pixBufferWidth + 1;
-  for( pixV=_pixBufferHeight-2; pixV>0; pixV--) {
-    for( pixU=_pixBufferWidth; pixU>0; pixU--) {
-      iNew = (( (SLONG)pOld[pixOffset - _pixBufferWidth]
-              + (SLONG)pOld[pixOffset + _pixBufferWidth]
-              + (SLONG)pOld[pixOffset - 1]
-              + (SLONG)pOld[pixOffset + 1]
-             ) >> 1)
-              - (SLONG)pNew[pixOffset];
-      pNew[pixOffset] =  iNew - (iNew >> slDensity);
-      pixOffset++;
-    }
-  }
+  Kernel_AnimateWater( pOld+pixOffset, pNew+pixOffset, _pixBufferWidth, (_pixBufferHeight-2)*_pixBufferWidth, slDensity);
 
   // upper horizontal border (without corners)
   slLineAbove = ((_pixBufferHeight-1)*_pixBufferWidth) + 1;
@@ -1195,8 +1196,6 @@ static void AnimateWater( SLONG slDensity)
 
   // swap buffers
   Swap( _ptdEffect->td_pubBuffer1, _ptdEffect->td_pubBuffer2);
-
-  _sfStats.StopTimer(CStatForm::STI_EFFECTRENDER);
 }
 
 
@@ -1210,8 +1209,6 @@ static void AnimateWater( SLONG slDensity)
 #pragma warning(disable: 4731)
 static void RenderWater(void)
 {
-  _sfStats.StartTimer(CStatForm::STI_EFFECTRENDER);
-
   // get textures' parameters
   ULONG *pulTexture     = _ptdEffect->td_pulFrames;
   PIX pixBaseWidth      = _ptdBase->GetPixWidth();
@@ -1882,8 +1879,6 @@ pixLoop4:
   { // DO NOTHING
     ASSERTALWAYS( "Effect textures larger than 256 pixels aren't supported");
   }
-
-  _sfStats.StopTimer(CStatForm::STI_EFFECTRENDER);
 }
 #pragma warning(default: 4731)
 
@@ -1910,14 +1905,12 @@ enum PlasmaType {
 ********************************/
 static void AnimatePlasma( SLONG slDensity, PlasmaType eType)
 {
-  _sfStats.StartTimer(CStatForm::STI_EFFECTRENDER);
-
 /////////////////////////////////// move plasma
 
   UBYTE *pNew = (UBYTE*)_ptdEffect->td_pubBuffer1;
   UBYTE *pOld = (UBYTE*)_ptdEffect->td_pubBuffer2;
 
-  PIX pixV, pixU;
+  PIX pixU;
   PIX pixOffset;
   SLONG slLineAbove, slLineBelow, slLineLeft, slLineRight;
   ULONG ulNew;
@@ -1927,20 +1920,9 @@ static void AnimatePlasma( SLONG slDensity, PlasmaType eType)
   // --------------------------
   if (eType == ptNormal) {
     // inner rectangle (without 1 pixel border)
+    // [Cecil] Vectorized
     pixOffset = _pixBufferWidth;
-    for( pixV=1; pixV<_pixBufferHeight-1; pixV++) {
-      for( pixU=0; pixU<_pixBufferWidth; pixU++) {
-        ulNew = ((((ULONG)pOld[pixOffset - _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset + _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset - 1] +
-                   (ULONG)pOld[pixOffset + 1]
-                  )>>2) +
-                   (ULONG)pOld[pixOffset]
-                )>>1;
-        pNew[pixOffset] = ulNew - (ulNew >> slDensity);
-        pixOffset++;
-      }
-    }
+    Kernel_AnimatePlasma( pOld+pixOffset, pNew+pixOffset, _pixBufferWidth, (_pixBufferHeight-2)*_pixBufferWidth, slDensity);
     // upper horizontal border (without corners)
     slLineAbove = ((_pixBufferHeight-1)*_pixBufferWidth) + 1;
     slLineBelow = _pixBufferWidth + 1;
@@ -2026,20 +2008,9 @@ static void AnimatePlasma( SLONG slDensity, PlasmaType eType)
   // --------------------------
   } else if (eType==ptUp || eType==ptUpTile) {
     // inner rectangle (without 1 pixel border)
+    // [Cecil] Vectorized
     pixOffset = _pixBufferWidth;
-    for( pixV=1; pixV<_pixBufferHeight-1; pixV++) {
-      for( pixU=0; pixU<_pixBufferWidth; pixU++) {
-        ulNew = ((((ULONG)pOld[pixOffset - _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset + _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset - 1] +
-                   (ULONG)pOld[pixOffset + 1]
-                  )>>2) +
-                   (ULONG)pOld[pixOffset]
-                )>>1;
-        pNew[pixOffset-_pixBufferWidth] = ulNew - (ulNew >> slDensity);
-        pixOffset++;
-      }
-    }
+    Kernel_AnimatePlasma( pOld+pixOffset, pNew+pixOffset-_pixBufferWidth, _pixBufferWidth, (_pixBufferHeight-2)*_pixBufferWidth, slDensity);
     // tile
     if (eType==ptUpTile) {
       // upper horizontal border (without corners)
@@ -2128,20 +2099,9 @@ static void AnimatePlasma( SLONG slDensity, PlasmaType eType)
   // --------------------------
   } else if (eType==ptDown || eType==ptDownTile) {
     // inner rectangle (without 1 pixel border)
+    // [Cecil] Vectorized
     pixOffset = _pixBufferWidth;
-    for( pixV=1; pixV<_pixBufferHeight-1; pixV++) {
-      for( pixU=0; pixU<_pixBufferWidth; pixU++) {
-        ulNew = ((((ULONG)pOld[pixOffset - _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset + _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset - 1] +
-                   (ULONG)pOld[pixOffset + 1]
-                  )>>2) +
-                   (ULONG)pOld[pixOffset]
-                )>>1;
-        pNew[pixOffset+_pixBufferWidth] = ulNew - (ulNew >> slDensity);
-        pixOffset++;
-      }
-    }
+    Kernel_AnimatePlasma( pOld+pixOffset, pNew+pixOffset+_pixBufferWidth, _pixBufferWidth, (_pixBufferHeight-2)*_pixBufferWidth, slDensity);
     // tile
     if (eType==ptDownTile) {
       // upper horizontal border (without corners)
@@ -2227,8 +2187,6 @@ static void AnimatePlasma( SLONG slDensity, PlasmaType eType)
 
   // swap buffers
   Swap( _ptdEffect->td_pubBuffer1, _ptdEffect->td_pubBuffer2);
-
-  _sfStats.StopTimer(CStatForm::STI_EFFECTRENDER);
 }
 
 
@@ -2584,6 +2542,9 @@ INDEX _ctTextureEffectGlobalPresets = sizeof(_ategtTextureEffectGlobalPresets)
                                     / sizeof(_ategtTextureEffectGlobalPresets[0]);
 
 
+// [Cecil] All existing effect textures
+static CListHead _lhAllEffects;
+
 // get effect type (TRUE if water type effect, FALSE if plasma or fire effect)
 BOOL CTextureEffectGlobal::IsWater(void)
 {
@@ -2598,8 +2559,13 @@ CTextureEffectGlobal::CTextureEffectGlobal(CTextureData *ptdTexture, ULONG ulGlo
   teg_ulEffectType = ulGlobalEffect;
   // init for animating
   _ategtTextureEffectGlobalPresets[teg_ulEffectType].tegt_Initialize();
+  // [Cecil] Each effect continues its own random sequence
+  teg_ulRandomSeed = ulRNDSeed;
   // make sure the texture will be updated next time when used
   teg_updTexture.Invalidate();
+  teg_updAnimation.Invalidate();
+  // [Cecil] Register the effect for animating in advance
+  _lhAllEffects.AddTail(teg_lnInEffects);
 }
 
 // add new effect source.
@@ -2610,8 +2576,8 @@ void CTextureEffectGlobal::AddEffectSource( ULONG ulEffectSourceType, PIX pixU0,
   ptesNew->Initialize(this, ulEffectSourceType, pixU0, pixV0, pixU1, pixV1);
 }
 
-// animate effect texture
-void CTextureEffectGlobal::Animate(void)
+// [Cecil] Set up tables shared by all effects
+static void InitEffectTables(void)
 {
   // if not set yet (funny word construction:)
   if( !bTableSet) {
@@ -2619,7 +2585,19 @@ void CTextureEffectGlobal::Animate(void)
     for( INDEX i=0; i<256; i++) asbMod3Sub1Table[i]=(SBYTE)((i%3)-1);
     bTableSet = TRUE;
   }
+}
 
+// [Cecil] Get profiling timer for this effect type
+INDEX CTextureEffectGlobal::GetStatTimer(void)
+{
+  if( IsWater()) return CStatForm::STI_EFFECTWATER;
+  if( _ategtTextureEffectGlobalPresets[teg_ulEffectType].tegt_Animate==AFire) return CStatForm::STI_EFFECTFIRE;
+  return CStatForm::STI_EFFECTPLASMA;
+}
+
+// [Cecil] Animate effect texture without touching any shared state (may run on a worker thread)
+void CTextureEffectGlobal::AnimateEffect(void)
+{
   // setup some internal vars
   _ptdEffect       = teg_ptdTexture;
   _pixBufferWidth  = _ptdEffect->td_pixBufferWidth;
@@ -2629,7 +2607,10 @@ void CTextureEffectGlobal::Animate(void)
   // remember buffer pointers
   _pubDrawBuffer=(UBYTE*)_ptdEffect->td_pubBuffer2;
   _pswDrawBuffer=(SWORD*)_ptdEffect->td_pubBuffer2;
-  
+
+  // [Cecil] Continue with randomizer state of this effect
+  ulRNDSeed = teg_ulRandomSeed;
+
   // for each effect source
   FOREACHINDYNAMICARRAY( teg_atesEffectSources, CTextureEffectSource, itEffectSource) {
     // let it animate itself
@@ -2637,14 +2618,39 @@ void CTextureEffectGlobal::Animate(void)
   }
   // use animation function for this global effect type
   _ategtTextureEffectGlobalPresets[teg_ulEffectType].tegt_Animate();
+
+  // [Cecil] Remember randomizer state of this effect
+  teg_ulRandomSeed = ulRNDSeed;
+}
+
+// animate effect texture
+void CTextureEffectGlobal::Animate(void)
+{
+  InitEffectTables();
+
+  // [Cecil] Profile per effect type
+  const INDEX iTimer = GetStatTimer();
+  _sfStats.StartTimer(CStatForm::STI_EFFECTRENDER);
+  _sfStats.StartTimer(iTimer);
+
+  AnimateEffect();
+
+  _sfStats.StopTimer(iTimer);
+  _sfStats.StopTimer(CStatForm::STI_EFFECTRENDER);
+
   // remember that it was calculated
-  teg_updTexture.MarkUpdated();
+  teg_updAnimation.MarkUpdated();
 }
 
 #pragma warning(disable: 4731)
 // render effect texture
 void CTextureEffectGlobal::Render( INDEX iWantedMipLevel, PIX pixTexWidth, PIX pixTexHeight)
 {
+  // [Cecil] Profile per effect type
+  const INDEX iTimer = GetStatTimer();
+  _sfStats.StartTimer(CStatForm::STI_EFFECTRENDER);
+  _sfStats.StartTimer(iTimer);
+
   // setup some internal vars
   _ptdEffect = teg_ptdTexture;
   _ptdBase   = teg_ptdTexture->td_ptdBaseTexture;
@@ -2663,6 +2669,12 @@ void CTextureEffectGlobal::Render( INDEX iWantedMipLevel, PIX pixTexWidth, PIX p
     _pixTexHeight = _ptdEffect->GetHeight() >>iWantedMipLevel;
     RenderPlasmaFire();
   }
+
+  _sfStats.StopTimer(iTimer);
+  _sfStats.StopTimer(CStatForm::STI_EFFECTRENDER);
+
+  // remember that it was calculated
+  teg_updTexture.MarkUpdated();
 }
 #pragma warning(default: 4731)
 
@@ -2672,4 +2684,161 @@ SECOND CTextureEffectGlobal::GetRenderingTime(void)
   return( _sfStats.sf_astTimers[CStatForm::STI_EFFECTRENDER].st_tvElapsed.GetSeconds());
 }
 
+// [Cecil] Animated effect texture
+struct EffectAnimationJob {
+  CTextureEffectGlobal *eaj_pteg;
+  CTimerValue eaj_tvElapsed;
+};
+
+// [Cecil] Effects that are being animated
+static CStaticStackArray<EffectAnimationJob> _aEffectJobs;
+
+// [Cecil] Animate one effect texture on a worker thread
+static void AnimateEffectJob(void *pData, INDEX iItem)
+{
+  EffectAnimationJob &job = ((EffectAnimationJob *)pData)[iItem];
+  const CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  job.eaj_pteg->AnimateEffect();
+
+  job.eaj_tvElapsed = _pTimer->GetHighPrecisionTimer() - tvStart;
+}
+
+// [Cecil] Animate all recently drawn effect textures that are due for this tick on worker threads
+void AnimateEffectTextures(void)
+{
+#if SE1_PARALLEL_EFFECTS
+  extern INDEX tex_bParallelEffects;
+  if (!tex_bParallelEffects || GetWorkerThreadCount() == 0) return;
+
+  const TICK llTick = _pTimer->GetGameTick();
+  const CTimerValue tvNow = _pTimer->GetHighPrecisionTimer();
+
+  // Gather effects that have been drawn during the last second but haven't been animated for this tick yet
+  FOREACHINLIST(CTextureEffectGlobal, teg_lnInEffects, _lhAllEffects, itteg) {
+    CTextureEffectGlobal &teg = *itteg;
+    if (teg.teg_updAnimation.LastUpdateTick() == llTick) continue;
+
+    CTextureData *ptd = teg.teg_ptdTexture;
+    if (ptd->td_pubBuffer1 == NULL || ptd->td_pubBuffer2 == NULL) continue;
+    if ((tvNow - ptd->td_tvLastDrawn).GetSeconds() > 1.0) continue;
+
+    _aEffectJobs.Push().eaj_pteg = &teg;
+  }
+
+  const INDEX ctJobs = _aEffectJobs.Count();
+  if (ctJobs == 0) return;
+
+  InitEffectTables();
+
+  _sfStats.StartTimer(CStatForm::STI_EFFECTRENDER);
+  ParallelFor(ctJobs, &AnimateEffectJob, &_aEffectJobs[0]);
+  _sfStats.StopTimer(CStatForm::STI_EFFECTRENDER);
+
+  // Add time spent on each effect to its type
+  for (INDEX iJob = 0; iJob < ctJobs; iJob++) {
+    EffectAnimationJob &job = _aEffectJobs[iJob];
+    _sfStats.sf_astTimers[job.eaj_pteg->GetStatTimer()].st_tvElapsed += job.eaj_tvElapsed;
+    job.eaj_pteg->teg_updAnimation.MarkUpdated();
+  }
+
+  _aEffectJobs.PopAll();
+#endif
+}
+
+// [Cecil] Fill effect buffer with random data
+static void FillEffectBuffer(UBYTE *pubBuffer, SLONG slSize, ULONG ulSeed)
+{
+  for (SLONG i = 0; i < slSize; i++) {
+    ulSeed = ulSeed * 1103515245 + 12345;
+    pubBuffer[i] = UBYTE(ulSeed >> 16);
+  }
+}
+
+// [Cecil] Time one effect routine
+static void BenchmarkEffect(const char *strName, void (*pRoutine)(void), INDEX ctIterations)
+{
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX iIter = 0; iIter < ctIterations; iIter++) {
+    pRoutine();
+  }
+
+  const DOUBLE dTime = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+  CPrintF("  %-16s %8.3f ms\n", strName, dTime * 1000.0);
+}
+
+static void BenchmarkAnimateFire(void) { AnimateFire(15); };
+static void BenchmarkAnimatePlasma(void) { AnimatePlasma(4, ptNormal); };
+static void BenchmarkAnimateWater(void) { AnimateWater(3); };
+
+// [Cecil] Time animation and rendering of effect textures on synthetic buffers
+void BenchmarkEffectTextures(INDEX ctIterations)
+{
+  InitEffectTables();
+  Randomize(0x1234567);
+
+  // Base texture without mipmaps
+  CTextureData tdBase;
+  tdBase.td_mexWidth = 256;
+  tdBase.td_mexHeight = 256;
+  tdBase.td_slFrameSize = GetMipmapOffset(15, 256, 256) * BYTES_PER_TEXEL;
+  tdBase.td_pulFrames = (ULONG *)AllocMemory(tdBase.td_slFrameSize);
+  FillEffectBuffer((UBYTE *)tdBase.td_pulFrames, tdBase.td_slFrameSize, 0x89ABCDE);
+
+  // Effect texture with enough space for water buffers
+  CTextureData tdEffect;
+  tdEffect.td_mexWidth = 128;
+  tdEffect.td_mexHeight = 128;
+  tdEffect.td_slFrameSize = GetMipmapOffset(15, 256, 256) * BYTES_PER_TEXEL;
+  tdEffect.td_pulFrames = (ULONG *)AllocMemory(tdEffect.td_slFrameSize);
+
+  const SLONG slBufferSize = 128 * (128 + 2) * sizeof(SWORD);
+  tdEffect.td_pubBuffer1 = (UBYTE *)AllocMemory(slBufferSize);
+  tdEffect.td_pubBuffer2 = (UBYTE *)AllocMemory(slBufferSize);
+
+  _ptdEffect = &tdEffect;
+  _ptdBase = &tdBase;
+
+  CPrintF(TRANS("Effect texture benchmark (%d iterations):\n"), ctIterations);
+
+  // Plasma and fire use 128x128 buffers of the same size as the texture
+  _pixBufferWidth = _pixTexWidth = 128;
+  _pixBufferHeight = _pixTexHeight = 128;
+  _ulBufferMask = _pixBufferWidth * _pixBufferHeight - 1;
+  FillEffectBuffer(tdEffect.td_pubBuffer1, slBufferSize, 0x1234567);
+  FillEffectBuffer(tdEffect.td_pubBuffer2, slBufferSize, 0x7654321);
+
+  BenchmarkEffect("AnimatePlasma", &BenchmarkAnimatePlasma, ctIterations);
+  BenchmarkEffect("AnimateFire", &BenchmarkAnimateFire, ctIterations);
+  BenchmarkEffect("RenderPlasmaFire", &RenderPlasmaFire, ctIterations);
+
+  // Water uses 64x64 height maps rendered into textures of different sizes
+  _pixBufferWidth = 64;
+  _pixBufferHeight = 64;
+  _ulBufferMask = _pixBufferWidth * _pixBufferHeight - 1;
+  memset(tdEffect.td_pubBuffer1, 0, slBufferSize);
+  memset(tdEffect.td_pubBuffer2, 0, slBufferSize);
+
+  // Drop some waves into the height map
+  for (INDEX iDrop = 0; iDrop < 64; iDrop++) {
+    ((SWORD *)tdEffect.td_pubBuffer1)[Rnd() & _ulBufferMask] = SWORD(Rnd() & 0x3FFF);
+  }
+
+  BenchmarkEffect("AnimateWater", &BenchmarkAnimateWater, ctIterations);
+
+  for (PIX pixSize = 64; pixSize <= 256; pixSize *= 2) {
+    _pixTexWidth = pixSize;
+    _pixTexHeight = pixSize;
+
+    // Same base texture mipmap as the one selected when drawing
+    _iWantedMipLevel = FastLog2(256) - FastLog2(pixSize);
 
+    CTString strName;
+    strName.PrintF("RenderWater %d", pixSize);
+    BenchmarkEffect(strName.ConstData(), &RenderWater, ctIterations);
+  }
+
+  _ptdEffect = NULL;
+  _ptdBase = NULL;
+}
@@ -22,6 +22,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/StaticArray.h>
 #include <Engine/Templates/DynamicArray.h>
 #include <Engine/Base/Updateable.h>
+#include <Engine/Base/Lists.h>
 
 struct TextureEffectPixel {
   char tepp_achDummy[8];
@@ -50,6 +51,9 @@ public:
   CTextureData *teg_ptdTexture;  // texture of this global effect
   ULONG teg_ulEffectType;
   TUpdateable<false> teg_updTexture; // when the texture was last updated
+  TUpdateable<false> teg_updAnimation; // [Cecil] When the effect was last animated
+  ULONG teg_ulRandomSeed; // [Cecil] Randomizer state of this effect
+  CListNode teg_lnInEffects; // [Cecil] For the list of all effects
   CDynamicArray<CTextureEffectSource> teg_atesEffectSources;
 
   // Constructor.
@@ -60,11 +64,15 @@ public:
                                                              PIX pixU1, PIX pixV1);
   // animate effect texture
   void Animate(void);
+  // [Cecil] Animate effect texture without profiling it (may run on a worker thread)
+  void AnimateEffect(void);
   // render effect texture in required mip level
   void Render( INDEX iWantedMipLevel, PIX pixTexWidth, PIX pixTexHeight);
 
   // get effect type (true if water type effect, false if plasma or fire effect)
   BOOL IsWater(void);
+  // [Cecil] Get profiling timer for this effect type
+  INDEX GetStatTimer(void);
   // returns number of second it took to render effect texture
   ENGINE_API SECOND GetRenderingTime(void);
 };
@@ -94,6 +102,11 @@ struct TextureEffectGlobalProperties_Fire {
   UBYTE tegpw_ubRising;    // 0 for no rising
 };
 
+// [Cecil] Animate all recently drawn effect textures that are due for this tick on worker threads
+void AnimateEffectTextures(void);
+// [Cecil] Time animation and rendering of effect textures on synthetic buffers
+void BenchmarkEffectTextures(INDEX ctIterations);
+
 ENGINE_API extern INDEX _ctTextureEffectGlobalPresets;
 ENGINE_API extern struct TextureEffectGlobalType _ategtTextureEffectGlobalPresets[];
 
@@ -624,6 +624,9 @@ typedef enum {
   GL_COMPRESSED_RGBA_S3TC_DXT3_EXT = 0x83F2,
   GL_COMPRESSED_RGBA_S3TC_DXT5_EXT = 0x83F3,
 
+  // [Cecil] GL_ARB_texture_compression_bptc
+  GL_COMPRESSED_RGBA_BPTC_UNORM_ARB = 0x8E8C,
+
   // GL_3DFX_texture_compression_FXT1
   GL_COMPRESSED_RGB_FXT1_3DFX	 = 0x86B0,
 	GL_COMPRESSED_RGBA_FXT1_3DFX = 0x86B1,
@@ -37,10 +37,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Templates/DynamicArray.cpp>
 
-// [Cecil] For no ASM in CLayerMixer::AddAmbientPoint()
-#if !SE1_OLD_COMPILER
-  #include <xmmintrin.h>
-#endif
+// [Cecil] Mixing of point light layers by rows
+#include <Engine/Templates/StaticStackArray.cpp>
+#include <Engine/Base/SIMDKernels.h>
 
 // asm shortcuts
 #define O offset
@@ -158,13 +157,6 @@ inline void CLayerMixer::AddToCluster(UBYTE *pub, SLONG slIntensity)
   IncrementByteWithClip(pub[2], (SLONG)(((UBYTE *)&lm_colLight)[1] * slIntensity) >> 16);
 }
 
-inline UBYTE LimitWordToByte(SLONG sl) {
-  if (sl <= -1) {
-    return 0;
-  }
-
-  return sl >= 256 ? 255 : sl;
-};
   
 // remember general data
 void CLayerMixer::CalculateData( CBrushShadowMap *pbsm, INDEX iMipmap)
@@ -263,94 +255,12 @@ static ULONG *_pulLayer;
 
 #if !SE1_USE_ASM
 
-// [Cecil] Separate methods to avoid code duplication
-static __forceinline void PrepareColorMMX(__m64 &mm7, const ULONG ulLightRGB) {
-  #if SE1_USE_MMXINT
-    __m64 tmp_mm0;
-
-    memset(&mm7, 0, sizeof(mm7));           //mm7.m64_u64 = 0;
-    memcpy(&mm7, &ulLightRGB, sizeof(mm7)); //mm7.m64_i64 = ulLightRGB;
-    memset(&tmp_mm0, 0, sizeof(tmp_mm0));   //tmp_mm0.m64_u64 = 0;
-    mm7 = _m_punpcklbw(mm7, tmp_mm0); // punpcklbw
-    mm7 = _m_psllwi(mm7, 1);          // psllw
-    _mm_empty(); // emms
-
-  #else
-    // punpcklbw
-    mm7.m64_u16[0] = (ulLightRGB & 0x000000FF);
-    mm7.m64_u16[1] = (ulLightRGB & 0x0000FF00) >> 8;
-    mm7.m64_u16[2] = (ulLightRGB & 0x00FF0000) >> 16;
-    mm7.m64_u16[3] = (ulLightRGB & 0xFF000000) >> 24;
-
-    // psllw
-    mm7.m64_u16[0] <<= 1;
-    mm7.m64_u16[1] <<= 1;
-    mm7.m64_u16[2] <<= 1;
-    mm7.m64_u16[3] <<= 1;
-  #endif
-};
+// [Cecil] Light intensities of one row of pixels
+static CStaticStackArray<SWORD> _aswRowIntensities;
 
-static __forceinline void MixPixelMMX(ULONG &ulPixel, const SLONG slIntensity, const __m64 &mm7) {
-  // Mix underlaying pixels with the calculated one
-  __m64 tmp_mm6;
-
-  #if SE1_USE_MMXINT
-    memset(&tmp_mm6, 0, sizeof(tmp_mm6)); //tmp_mm6.m64_u64 = 0;
-    tmp_mm6 = _mm_cvtsi32_si64(slIntensity);
-    tmp_mm6 = _mm_unpacklo_pi16(tmp_mm6, tmp_mm6); // punpcklwd
-    tmp_mm6 = _mm_unpacklo_pi32(tmp_mm6, tmp_mm6); // punpckldq
-    tmp_mm6 = _mm_mulhi_pi16(tmp_mm6, mm7);        // _m_pmulhw
-    _mm_empty(); // emms
-
-  #else
-    // punpcklwd & punpckldq
-    tmp_mm6.m64_u16[0] = slIntensity;
-    tmp_mm6.m64_u16[1] = slIntensity;
-    tmp_mm6.m64_u16[2] = slIntensity;
-    tmp_mm6.m64_u16[3] = slIntensity;
-
-    // pmulhw   mm7, mm6
-    tmp_mm6.m64_u16[0] = (tmp_mm6.m64_i16[0] * mm7.m64_i16[0]) >> 16;
-    tmp_mm6.m64_u16[1] = (tmp_mm6.m64_i16[1] * mm7.m64_i16[1]) >> 16;
-    tmp_mm6.m64_u16[2] = (tmp_mm6.m64_i16[2] * mm7.m64_i16[2]) >> 16;
-    tmp_mm6.m64_u16[3] = (tmp_mm6.m64_i16[3] * mm7.m64_i16[3]) >> 16;
-  #endif
-
-  // Add light pixel to underlying pixel
-  __m64 tmp_mm5;
-
-  #if SE1_USE_MMXINT
-    // [Cecil] Old compilers don't like inline braces
-    const __m64 mmZero = { 0L };
-
-    tmp_mm5 = _mm_cvtsi32_si64(ulPixel);
-    tmp_mm5 = _mm_unpacklo_pi8(tmp_mm5, mmZero); // punpcklbw
-    tmp_mm5 = _mm_add_pi16(tmp_mm5, tmp_mm6);    // paddw
-    tmp_mm5 = _mm_packs_pu16(tmp_mm5, mmZero);   // packuswb
-    ulPixel = _mm_cvtsi64_si32(tmp_mm5);
-    _mm_empty(); // emms
-
-  #else
-    // punpcklbw
-    tmp_mm5.m64_u16[0] = (ulPixel & 0x000000FF);
-    tmp_mm5.m64_u16[1] = (ulPixel & 0x0000FF00) >> 8;
-    tmp_mm5.m64_u16[2] = (ulPixel & 0x00FF0000) >> 16;
-    tmp_mm5.m64_u16[3] = (ulPixel & 0xFF000000) >> 24;
-
-    // paddw
-    tmp_mm5.m64_i16[0] += tmp_mm6.m64_i16[0];
-    tmp_mm5.m64_i16[1] += tmp_mm6.m64_i16[1];
-    tmp_mm5.m64_i16[2] += tmp_mm6.m64_i16[2];
-    tmp_mm5.m64_i16[3] += tmp_mm6.m64_i16[3];
-
-    // packuswb
-    tmp_mm5.m64_u8[0] = LimitWordToByte(tmp_mm5.m64_i16[0]);
-    tmp_mm5.m64_u8[1] = LimitWordToByte(tmp_mm5.m64_i16[1]);
-    tmp_mm5.m64_u8[2] = LimitWordToByte(tmp_mm5.m64_i16[2]);
-    tmp_mm5.m64_u8[3] = LimitWordToByte(tmp_mm5.m64_i16[3]);
-
-    ulPixel = tmp_mm5.m64_u32[0];
-  #endif
+static SWORD *GetRowIntensities(void) {
+  _aswRowIntensities.PopAll();
+  return _aswRowIntensities.Push(_iPixCt);
 };
 
 #endif // !SE1_USE_ASM
@@ -446,66 +356,46 @@ skipPixel:
   }
 
 #else
-  // prepare color
-  __m64 tmp_mm7;
-  PrepareColorMMX(tmp_mm7, ulLightRGB);
-
-  PIX pixV = _iRowCt;
-  UBYTE *pubLayer = (UBYTE *)_pulLayer; // temp carret
+  // [Cecil] Calculate intensities of a whole row and then add light to it at once
+  SWORD *pswRow = GetRowIntensities();
+  ULONG *pulLayer = _pulLayer;
 
   // row loop
-  do {
-    PIX pixU = _iPixCt;
-
+  for (PIX pixV = 0; pixV < _iRowCt; pixV++) {
     SLONG slL2Point = _slL2Row;
     SLONG slDL2oDU = _slDL2oDURow;
 
     // pixel loop
-    do {
+    for (PIX pixU = 0; pixU < _iPixCt; pixU++) {
+      // masked pixels stay the same with zero intensity
+      SLONG slIntensity = 0;
+
       // if the point is not masked
-      if (slL2Point < FTOX)
-      {
+      if (slL2Point < FTOX) {
         SLONG slL = (slL2Point >> SHIFTX) & (SQRTTABLESIZE - 1);  // and is just for degenerate cases
-        SLONG slIntensity = _slLightMax;
         slL = aubSqrt[slL];
+        slIntensity = _slLightMax;
+
         if (slL > _slHotSpot) {
           slIntensity = ((255 - slL) * _slLightStep);
         }
-
-        ULONG *pulPixel = (ULONG *)pubLayer;
-        ULONG ulPixel = *pulPixel;
-
-        MixPixelMMX(ulPixel, slIntensity, tmp_mm7);
-        *pulPixel = ulPixel;
       }
 
-      // advance to next pixel
-      // add     edi, 4
-      pubLayer += 4;
+      pswRow[pixU] = (SWORD)slIntensity;
 
-      // movd    eax, mm3
-      // add     ebx, eax
+      // advance to next pixel
       slL2Point += slDL2oDU;
-
-      // paddd   mm3, Q [mmDDL2oDU]
       slDL2oDU += _slDDL2oDU;
-      pixU--;
-    } while (pixU > 0);
+    }
 
-    // advance to the next row
-    pubLayer += _slModulo; // add     edi, D [_slModulo]
+    Kernel_AddLightRow(pulLayer, pswRow, _iPixCt, ulLightRGB);
 
-    // paddd   mm1, mm2
-    // MM1 = _slDL2oDURow | _slL2Row
-    // MM2 = _slDDL2oDUoDV | _slDL2oDV
+    // advance to the next row
+    pulLayer += _iPixCt + _slModulo / BYTES_PER_TEXEL;
     _slL2Row += _slDL2oDV;
     _slDL2oDURow += _slDDL2oDUoDV;
-
-    // paddd   mm2, Q [mmDDL2oDV]
-    _slDL2oDV += _slDDL2oDV; 
-
-    pixV--;
-  } while (pixV > 0);
+    _slDL2oDV += _slDDL2oDV;
+  }
 #endif
 }
 
@@ -599,76 +489,52 @@ skipPixel:
   }
 
 #else
-  // prepare color
-  __m64 tmp_mm7;
-  PrepareColorMMX(tmp_mm7, ulLightRGB);
-
-  PIX pixV = _iRowCt;
-  UBYTE *pubLayer = (UBYTE *)_pulLayer; // temp carret
+  // [Cecil] Calculate intensities of a whole row and then add light to it at once
+  SWORD *pswRow = GetRowIntensities();
+  ULONG *pulLayer = _pulLayer;
 
   // row loop
-  do {
-    PIX pixU = _iPixCt;
-
+  for (PIX pixV = 0; pixV < _iRowCt; pixV++) {
     SLONG slL2Point = _slL2Row;
     SLONG slDL2oDU = _slDL2oDURow;
 
     // pixel loop
-    do {
+    for (PIX pixU = 0; pixU < _iPixCt; pixU++) {
+      // masked pixels stay the same with zero intensity
+      SLONG slIntensity = 0;
+
       // if the point is not masked
-      if ((*pubMask & ubMask) && (slL2Point < FTOX))
-      {
-        // calculate intensities and do actual drawing of shadow pixel ARGB
-        SLONG slL = (slL2Point >> SHIFTX)&(SQRTTABLESIZE-1);  // and is just for degenerate cases
-        SLONG slIntensity = _slLightMax;
+      if ((*pubMask & ubMask) && (slL2Point < FTOX)) {
+        SLONG slL = (slL2Point >> SHIFTX) & (SQRTTABLESIZE - 1);  // and is just for degenerate cases
         slL = aubSqrt[slL];
+        slIntensity = _slLightMax;
 
         if (slL > _slHotSpot) {
           slIntensity = ((255 - slL) * _slLightStep);
         }
-
-        ULONG *pulPixel = (ULONG *)pubLayer;
-        ULONG ulPixel = *pulPixel;
-
-        MixPixelMMX(ulPixel, slIntensity, tmp_mm7);
-        *pulPixel = ulPixel;
       }
 
-      // advance to next pixel
-      // add     edi, 4
-      pubLayer += 4;
+      pswRow[pixU] = (SWORD)slIntensity;
 
-      // movd    eax, mm3
-      // add     ebx, eax
+      // advance to next pixel
       slL2Point += slDL2oDU;
-
-      // paddd   mm3, Q [mmDDL2oDU]
       slDL2oDU += _slDDL2oDU;
 
       ubMask <<= 1;
-      if (ubMask == 0)
-      {
+      if (ubMask == 0) {
         pubMask++;
         ubMask = 1;
       }
+    }
 
-      pixU--;
-    } while (pixU > 0);
+    Kernel_AddLightRow(pulLayer, pswRow, _iPixCt, ulLightRGB);
 
     // advance to the next row
-    pubLayer += _slModulo; // add     edi, D [_slModulo]
-
-    // paddd   mm1, mm2
-    // MM1 = _slDL2oDURow | _slL2Row
-    // MM2 = _slDDL2oDUoDV | _slDL2oDV
+    pulLayer += _iPixCt + _slModulo / BYTES_PER_TEXEL;
     _slL2Row += _slDL2oDV;
     _slDL2oDURow += _slDDL2oDUoDV;
-
-    // paddd   mm2, Q [mmDDL2oDV]
-    _slDL2oDV += _slDDL2oDV; 
-
-    pixV--;
-  } while (pixV > 0);
+    _slDL2oDV += _slDDL2oDV;
+  }
 #endif
 }
 
@@ -765,73 +631,46 @@ skipPixel:
   }
 
 #else
-  // prepare color
-  __m64 tmp_mm7;
-  PrepareColorMMX(tmp_mm7, ulLightRGB);
-
-  PIX pixV = _iRowCt;
-  UBYTE *pubLayer = (UBYTE *)_pulLayer; // temp carret
+  // [Cecil] Calculate intensities of a whole row and then add light to it at once
+  SWORD *pswRow = GetRowIntensities();
+  ULONG *pulLayer = _pulLayer;
 
   // row loop
-  do {
-    PIX pixU = _iPixCt;
-
+  for (PIX pixV = 0; pixV < _iRowCt; pixV++) {
     SLONG slL2Point = _slL2Row;
     SLONG slDL2oDU = _slDL2oDURow;
 
     // pixel loop
-    do {
+    for (PIX pixU = 0; pixU < _iPixCt; pixU++) {
+      // masked pixels stay the same with zero intensity
+      SLONG slIntensity = 0;
+
       // if the point is not masked
-      if (slL2Point < FTOX)
-      {
+      if (slL2Point < FTOX) {
         SLONG sl1oL = (slL2Point >> SHIFTX) & (SQRTTABLESIZE - 1);  // and is just for degenerate cases
         sl1oL = auw1oSqrt[sl1oL];
+        slIntensity = _slLightMax;
 
-        SLONG slIntensity = _slLightMax; // ecx, D [_slLightMax]
-
-        // calculate intensities and do actual drawing of shadow pixel ARGB
         if (sl1oL < slMax1oL) {
-          // mov     eax, D [sl1oL]
-          // mov     ecx, D [slIntensity]
-          // lea     ecx, [eax-256]
-          // imul    ecx, D [_slLightStep]
           slIntensity = ((sl1oL - 256) * _slLightStep);
         }
-
-        ULONG *pulPixel = (ULONG *)pubLayer;
-        ULONG ulPixel = *pulPixel;
-
-        MixPixelMMX(ulPixel, slIntensity, tmp_mm7);
-        *pulPixel = ulPixel;
       }
 
-      // advance to next pixel
-      // add     edi, 4
-      pubLayer += 4;
+      pswRow[pixU] = (SWORD)slIntensity;
 
-      // movd    eax, mm3
-      // add     ebx, eax
+      // advance to next pixel
       slL2Point += slDL2oDU;
-
-      // paddd   mm3, Q [mmDDL2oDU]
       slDL2oDU += _slDDL2oDU;
-      pixU--;
-    } while (pixU > 0);
+    }
 
-    // advance to the next row
-    pubLayer += _slModulo; // add     edi, D [_slModulo]
+    Kernel_AddLightRow(pulLayer, pswRow, _iPixCt, ulLightRGB);
 
-    // paddd   mm1, mm2
-    // MM1 = _slDL2oDURow | _slL2Row
-    // MM2 = _slDDL2oDUoDV | _slDL2oDV
+    // advance to the next row
+    pulLayer += _iPixCt + _slModulo / BYTES_PER_TEXEL;
     _slL2Row += _slDL2oDV;
     _slDL2oDURow += _slDDL2oDUoDV;
-
-    // paddd   mm2, Q [mmDDL2oDV]
-    _slDL2oDV += _slDDL2oDV; 
-
-    pixV--;
-  } while (pixV > 0);
+    _slDL2oDV += _slDDL2oDV;
+  }
 #endif
 }
 
@@ -935,81 +774,52 @@ skipPixel:
   }
 
 #else
-  // prepare color
-  __m64 tmp_mm7;
-  PrepareColorMMX(tmp_mm7, ulLightRGB);
-
-  PIX pixV = _iRowCt;
-  UBYTE *pubLayer = (UBYTE *)_pulLayer; // temp carret
+  // [Cecil] Calculate intensities of a whole row and then add light to it at once
+  SWORD *pswRow = GetRowIntensities();
+  ULONG *pulLayer = _pulLayer;
 
   // row loop
-  do {
-    PIX pixU = _iPixCt;
-
+  for (PIX pixV = 0; pixV < _iRowCt; pixV++) {
     SLONG slL2Point = _slL2Row;
     SLONG slDL2oDU = _slDL2oDURow;
 
     // pixel loop
-    do {
+    for (PIX pixU = 0; pixU < _iPixCt; pixU++) {
+      // masked pixels stay the same with zero intensity
+      SLONG slIntensity = 0;
+
       // if the point is not masked
-      if ((*pubMask & ubMask) && (slL2Point < FTOX))
-      {
+      if ((*pubMask & ubMask) && (slL2Point < FTOX)) {
         SLONG sl1oL = (slL2Point >> SHIFTX) & (SQRTTABLESIZE - 1);  // and is just for degenerate cases
         sl1oL = auw1oSqrt[sl1oL];
+        slIntensity = _slLightMax;
 
-        SLONG slIntensity = _slLightMax; // ecx, D [_slLightMax]
-
-        // calculate intensities and do actual drawing of shadow pixel ARGB
         if (sl1oL < slMax1oL) {
-          // mov     eax, D [sl1oL]
-          // mov     ecx, D [slIntensity]
-          // lea     ecx, [eax-256]
-          // imul    ecx, D [_slLightStep]
           slIntensity = ((sl1oL - 256) * _slLightStep);
         }
-
-        ULONG *pulPixel = (ULONG *)pubLayer;
-        ULONG ulPixel = *pulPixel;
-
-        MixPixelMMX(ulPixel, slIntensity, tmp_mm7);
-        *pulPixel = ulPixel;
       }
 
-      // advance to next pixel
-      // add     edi, 4
-      pubLayer += 4;
+      pswRow[pixU] = (SWORD)slIntensity;
 
-      // movd    eax, mm3
-      // add     ebx, eax
+      // advance to next pixel
       slL2Point += slDL2oDU;
-
-      // paddd   mm3, Q [mmDDL2oDU]
       slDL2oDU += _slDDL2oDU;
 
       ubMask <<= 1;
-      if (ubMask == 0)
-      {
+      if (ubMask == 0) {
         pubMask++;
         ubMask = 1;
       }
+    }
 
-      pixU--;
-    } while (pixU > 0);
+    Kernel_AddLightRow(pulLayer, pswRow, _iPixCt, ulLightRGB);
 
     // advance to the next row
-    pubLayer += _slModulo; // add     edi, D [_slModulo]
-
-    // paddd   mm1, mm2
-    // MM1 = _slDL2oDURow | _slL2Row
-    // MM2 = _slDDL2oDUoDV | _slDL2oDV
+    pulLayer += _iPixCt + _slModulo / BYTES_PER_TEXEL;
     _slL2Row += _slDL2oDV;
     _slDL2oDURow += _slDDL2oDUoDV;
-
-    // paddd   mm2, Q [mmDDL2oDV]
-    _slDL2oDV += _slDDL2oDV; 
-
-    pixV--;
-  } while (pixV > 0);
+    _slDL2oDV += _slDDL2oDV;
+  }
 #endif
 }
 
@@ -259,16 +259,30 @@ void CModelPatch::Read_t(CTStream *strFile)
   *strFile >> mp_strName;
   CTFileName fnPatchTexture;
   strFile->ReadFileName(fnPatchTexture);
+  SetTexture(fnPatchTexture); // [Cecil]
+  *strFile >> mp_mexPosition;
+  *strFile >> mp_fStretch;
+}
+
+// [Cecil] Set or defer patch texture (doesn't throw)
+void CModelPatch::SetTexture(const CTFileName &fnmTexture)
+{
+  // Textures touch the graphics API, so they cannot be loaded on worker threads
+  if (IsObtainingInBackground()) {
+    mp_fnmDeferred = fnmTexture;
+    return;
+  }
+
+  mp_fnmDeferred = CTString("");
+
   try
   {
-    mp_toTexture.SetData_t( fnPatchTexture);
+    mp_toTexture.SetData_t( fnmTexture);
   }
   catch( char *strError)
   {
     (void) strError;
   }
-  *strFile >> mp_mexPosition;
-  *strFile >> mp_fStretch;
 }
 
 void CModelPatch::Write_t(CTStream *strFile)
@@ -331,7 +345,10 @@ void CModelData::Clear(void)
 
   for( i=0; i<md_MipCt;           i++) md_MipInfos[i].Clear();
   for( i=0; i<MAX_COLOR_NAMES;    i++) md_ColorNames[i].Clear();
-  for( i=0; i<MAX_TEXTUREPATCHES; i++) md_mpPatches[i].mp_toTexture.SetData_t( CTString(""));
+  for( i=0; i<MAX_TEXTUREPATCHES; i++) {
+    md_mpPatches[i].mp_toTexture.SetData_t( CTString(""));
+    md_mpPatches[i].mp_fnmDeferred = CTString(""); // [Cecil]
+  }
 
   md_VerticesCt = 0;
   md_FramesCt = 0;
@@ -1459,14 +1476,7 @@ void CModelData::Read_t( CTStream *pFile) // throw char *
       {
         CTFileName fnPatchName;
         pFile->ReadFileName(fnPatchName);
-        try
-        {
-          md_mpPatches[ iPatch].mp_toTexture.SetData_t( fnPatchName);
-        }
-        catch(char *strError)
-        {
-          (void) strError;
-        }
+        md_mpPatches[ iPatch].SetTexture( fnPatchName); // [Cecil]
       }
     }
   }
@@ -1706,6 +1716,20 @@ void CModelData::RemReference_internal(void)
   }
 }
 
+// [Cecil] Obtain patch textures that have been deferred while loading in the background
+void CModelData::ObtainDeferredPatches(void)
+{
+  ASSERT(!IsObtainingInBackground());
+
+  for (INDEX iPatch = 0; iPatch < MAX_TEXTUREPATCHES; iPatch++) {
+    CModelPatch &mp = md_mpPatches[iPatch];
+    if (mp.mp_fnmDeferred == "") continue;
+
+    const CTFileName fnmTexture = mp.mp_fnmDeferred;
+    mp.SetTexture(fnmTexture);
+  }
+}
+
 
 /* Get the description of this object. */
 CTString CModelData::GetDescription(void)
@@ -40,8 +40,10 @@ public:
   CTextureObject mp_toTexture;
   MEX2D mp_mexPosition;
   FLOAT mp_fStretch;
+  CTFileName mp_fnmDeferred; // [Cecil] Texture to obtain on the main thread after loading in the background
 
   CModelPatch(void);
+  void SetTexture(const CTFileName &fnmTexture); // [Cecil] Set or defer patch texture (doesn't throw)
   void Read_t( CTStream *strFile); // throw char *
   void Write_t( CTStream *strFile); // throw char *
 };
@@ -116,6 +118,9 @@ public:
   // reference counting (override from CAnimData)
   void RemReference_internal(void);
 
+  // [Cecil] Obtain patch textures that have been deferred while loading in the background
+  void ObtainDeferredPatches(void);
+
   void PtrsToIndices();
 	void IndicesToPtrs();
   void SpreadMipSwitchFactors( INDEX iFirst, float fStartingFactor); // spreads mip switch factors
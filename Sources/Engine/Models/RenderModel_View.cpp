@@ -1095,6 +1095,9 @@ static void AttenuateColor( const UBYTE *pshdMip, const INDEX ctVertices)
 
 
 // unpack vertices (and eventually normals) of one frame
+// [Cecil] NOTE: C versions aren't vectorized because each vertex is fetched through the mip-to-model table and
+// its normal through the sine table, which SSE2 and NEON cannot gather; the compiler already uses scalar
+// SSE math for them on x64 instead of x87 from the assembly versions
 static void UnpackFrame( CRenderModel &rm, BOOL bKeepNormals)
 {
   _pfModelProfile.StartTimer( CModelProfile::PTI_VIEW_INIT_UNPACK);
@@ -23,6 +23,10 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Network/CPacket.h>
 
 #include <Engine/Base/ListIterator.inl>
+#include <Engine/Base/Synchronization.h> // [Cecil]
+#include <Engine/Base/Translation.h> // [Cecil]
+
+#include <Engine/Templates/StaticStackArray.cpp> // [Cecil]
 
 // should the packet transfers in/out of the buffer be reported to the console
 extern INDEX net_bReportPackets;
@@ -32,6 +36,147 @@ extern FLOAT net_fSendRetryWait;
 #define MAX_RETRIES 10
 #define RETRY_INTERVAL 3.0f
 
+// [Cecil] Maximum amount of free packet blocks that are kept for reuse
+#define PACKET_POOL_SIZE 4096
+
+// [Cecil] Free packet blocks (thread-safe)
+struct PacketPool {
+  CTCriticalSection pp_cs;
+  CStaticStackArray<void *> pp_apvFree;
+  PacketPoolStats pp_stats;
+
+  PacketPool() {
+    memset(&pp_stats, 0, sizeof(pp_stats));
+    pp_apvFree.SetAllocationStep(256);
+  };
+};
+
+// [Cecil] Packets can be freed during global destruction, so the pool is never destroyed
+static PacketPool &GetPacketPool(void) {
+  static PacketPool *ppp = new PacketPool;
+  return *ppp;
+};
+
+void *CPacket::operator new(size_t size) {
+  ASSERT(size == sizeof(CPacket));
+  PacketPool &pp = GetPacketPool();
+
+  {
+    CTSingleLock slPool(&pp.pp_cs, TRUE);
+    pp.pp_stats.pps_ctLive++;
+
+    if (pp.pp_apvFree.Count() > 0) {
+      pp.pp_stats.pps_llHits++;
+      return pp.pp_apvFree.Pop();
+    }
+
+    pp.pp_stats.pps_llMisses++;
+  }
+
+  return AllocMemory(sizeof(CPacket));
+};
+
+void CPacket::operator delete(void *pv) {
+  if (pv == NULL) return;
+  PacketPool &pp = GetPacketPool();
+
+  {
+    CTSingleLock slPool(&pp.pp_cs, TRUE);
+    pp.pp_stats.pps_ctLive--;
+
+    if (pp.pp_apvFree.Count() < PACKET_POOL_SIZE) {
+      pp.pp_apvFree.Push() = pv;
+      return;
+    }
+
+    pp.pp_stats.pps_llReleased++;
+  }
+
+  FreeMemory(pv);
+};
+
+void GetPacketPoolStats(PacketPoolStats &stats) {
+  PacketPool &pp = GetPacketPool();
+  CTSingleLock slPool(&pp.pp_cs, TRUE);
+
+  stats = pp.pp_stats;
+  stats.pps_ctPooled = pp.pp_apvFree.Count();
+};
+
+// [Cecil] Expected size of a loopback test packet with some index
+static inline SLONG LoopbackPacketSize(INDEX iPacket) {
+  return sizeof(INDEX) + (iPacket * 97) % (MAX_UDP_BLOCK_SIZE - sizeof(INDEX) - 1);
+};
+
+CPacketLoopbackTest::CPacketLoopbackTest(INDEX ctPackets) {
+  plt_ctPackets = ctPackets;
+  plt_iSent = 0;
+  plt_ctReceived = 0;
+  plt_ctCorrupt = 0;
+
+  // Fill the payload with a pattern that can be verified on the other side
+  for (INDEX iByte = 0; iByte < MAX_UDP_BLOCK_SIZE; iByte++) {
+    plt_aubSend[iByte] = UBYTE(iByte * 31 + 7);
+  }
+
+  GetPacketPoolStats(plt_statsBefore);
+
+  plt_tvStart = _pTimer->GetHighPrecisionTimer();
+  plt_tvLastReceived = plt_tvStart;
+};
+
+INDEX CPacketLoopbackTest::GetBatchEnd(void) const {
+  return Min(plt_iSent + 64, plt_ctPackets);
+};
+
+SLONG CPacketLoopbackTest::PrepareNext(void) {
+  // Packets vary in size and have their index at the start
+  *(INDEX *)plt_aubSend = plt_iSent;
+  return LoopbackPacketSize(plt_iSent);
+};
+
+void CPacketLoopbackTest::Verify(const UBYTE *pubData, SLONG slSize) {
+  plt_tvLastReceived = _pTimer->GetHighPrecisionTimer();
+
+  if (slSize < (SLONG)sizeof(INDEX)) {
+    plt_ctCorrupt++;
+    return;
+  }
+
+  const INDEX iPacket = *(const INDEX *)pubData;
+
+  if (slSize != LoopbackPacketSize(iPacket)
+   || memcmp(pubData + sizeof(INDEX), plt_aubSend + sizeof(INDEX), slSize - sizeof(INDEX)) != 0) {
+    plt_ctCorrupt++;
+  } else {
+    plt_ctReceived++;
+  }
+};
+
+BOOL CPacketLoopbackTest::IsStalled(void) {
+  // Give up if nothing arrives for a while
+  if ((_pTimer->GetHighPrecisionTimer() - plt_tvLastReceived).GetSeconds() > 5.0) {
+    CPrintF(TRANS("No packets received for 5 seconds, stopping\n"));
+    return TRUE;
+  }
+  return FALSE;
+};
+
+void CPacketLoopbackTest::Report(INDEX ctUnsent) {
+  const DOUBLE dTime = (_pTimer->GetHighPrecisionTimer() - plt_tvStart).GetSeconds();
+
+  PacketPoolStats statsAfter;
+  GetPacketPoolStats(statsAfter);
+
+  CPrintF(TRANS("%d packets queued, %d unsent, %d received, %d corrupt, %d lost in %.3f s (%.0f packets/s)\n"),
+    plt_iSent, ctUnsent, plt_ctReceived, plt_ctCorrupt, plt_iSent - ctUnsent - plt_ctReceived - plt_ctCorrupt,
+    dTime, (plt_ctReceived + plt_ctCorrupt) / ClampDn(dTime, 1e-6));
+
+  CPrintF(TRANS("Pool: %.0f hits, %.0f misses, %.0f released, %d live packets left over\n"),
+    DOUBLE(statsAfter.pps_llHits - plt_statsBefore.pps_llHits), DOUBLE(statsAfter.pps_llMisses - plt_statsBefore.pps_llMisses),
+    DOUBLE(statsAfter.pps_llReleased - plt_statsBefore.pps_llReleased), statsAfter.pps_ctLive - plt_statsBefore.pps_ctLive);
+};
+
 // make the address broadcast
 void CAddress::MakeBroadcast(void)
 {
@@ -65,11 +210,27 @@ CPacket::CPacket(CPacket &paOriginal)
 	pa_adrAddress.adr_ulAddress = paOriginal.pa_adrAddress.adr_ulAddress;
 	pa_adrAddress.adr_uwPort = paOriginal.pa_adrAddress.adr_uwPort;
 	pa_adrAddress.adr_uwID = paOriginal.pa_adrAddress.adr_uwID;
+  pa_ctReferences = 1; // [Cecil]
 
 	memcpy(pa_pubPacketData,paOriginal.pa_pubPacketData,pa_slSize);
 
 };
 
+// [Cecil] Add one more owner of the packet
+void CPacket::AddReference(void) {
+  ASSERT(pa_ctReferences > 0);
+  pa_ctReferences++;
+};
+
+// [Cecil] Remove one owner of the packet and delete it after the last one
+void CPacket::RemReference(void) {
+  ASSERT(pa_ctReferences > 0);
+
+  if (--pa_ctReferences == 0) {
+    delete this;
+  }
+};
+
 // initialization of the packet - clear all data and remove the packet from any list (buffer) it is in
 void CPacket::Clear() 
 {
@@ -78,6 +239,7 @@ void CPacket::Clear()
   pa_slTransferSize = 0;
 	pa_ubReliable = UDP_PACKET_UNRELIABLE;
 	pa_ubRetryNumber = 0;
+  pa_ctReferences = 1; // [Cecil]
 
 	pa_tvSendWhen = CTimerValue(0.0f);
 	if(pa_lnListNode.IsLinked()) pa_lnListNode.Remove();
@@ -172,6 +334,23 @@ BOOL CPacket::WriteToPacketRaw(void* pv,SLONG slSize)
 
 };
 
+// [Cecil] Reads the packet header from the data that is already in the packet
+void CPacket::ReadRawHeader(SLONG slSize)
+{
+	ASSERT(slSize <= MAX_PACKET_SIZE && slSize > MAX_HEADER_SIZE);
+
+	UBYTE *pubData = pa_pubPacketData;
+	pa_ubReliable = *pubData;
+	pubData++;
+	pa_ulSequence = *(ULONG*)pubData;
+	pubData+=sizeof(pa_ulSequence);
+  pa_adrAddress.adr_uwID = *(UWORD*)pubData;
+	pubData+=sizeof(pa_adrAddress.adr_uwID);
+  pa_slTransferSize = *(SLONG*)pubData;
+
+	pa_slSize = slSize;
+};
+
 
 // Copies the data from the packet to the location specified by the *pv. 
 // packet header data is skipped
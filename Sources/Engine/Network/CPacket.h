@@ -77,6 +77,7 @@ public:
 	CListNode pa_lnListNode;					// used to create a linked list of packets - buffer
 
   CAddress pa_adrAddress;				// packet address, port and client ID
+  INDEX pa_ctReferences; // [Cecil] Owners of the packet (network messages reading straight from its payload)
   																
 	// Constructors/destructors
 	CPacket() { Clear(); }					// Default Constructor
@@ -86,10 +87,21 @@ public:
 	// Reset all packet data and free allocated memory
 	void Clear();
 
+  // [Cecil] Packets are allocated from a pool of reusable memory blocks
+  static void *operator new(size_t size);
+  static void operator delete(void *pv);
+
+  // [Cecil] Add one more owner of the packet
+  void AddReference(void);
+  // [Cecil] Remove one owner of the packet and delete it after the last one
+  void RemReference(void);
+
 	// Write data to the packet and add header data
 	BOOL WriteToPacket(void* pv,SLONG slSize,UBYTE ubReliable,ULONG ulSequence,UWORD uwClientID,SLONG slTransferSize);
 	// Write raw data to the packet and extract header data from the data
 	BOOL WriteToPacketRaw(void* pv,SLONG slSize);
+	// [Cecil] Extract header data from raw data that has been received directly into the packet
+	void ReadRawHeader(SLONG slSize);
 	// Read data from the packet (no header data)
 	BOOL ReadFromPacket(void* pv,SLONG &slExpectedSize);
 
@@ -118,6 +130,46 @@ public:
 };
 
 
+// [Cecil] Usage statistics of the packet pool
+struct PacketPoolStats {
+  SQUAD pps_llHits;     // packets allocated from pooled blocks
+  SQUAD pps_llMisses;   // packets allocated from the heap
+  SQUAD pps_llReleased; // packets freed into the heap because the pool was full
+  INDEX pps_ctPooled;   // free blocks in the pool
+  INDEX pps_ctLive;     // packets that currently exist
+};
+
+// [Cecil] Get current statistics of the packet pool
+ENGINE_API void GetPacketPoolStats(PacketPoolStats &stats);
+
+// [Cecil] Common part of the packet loopback soak tests
+class CPacketLoopbackTest {
+public:
+  INDEX plt_ctPackets;  // how many packets to pump through
+  INDEX plt_iSent;      // packets sent so far
+  INDEX plt_ctReceived; // packets received intact
+  INDEX plt_ctCorrupt;  // packets received with wrong size or contents
+  UBYTE plt_aubSend[MAX_UDP_BLOCK_SIZE]; // verifiable payload pattern
+  PacketPoolStats plt_statsBefore;
+  CTimerValue plt_tvStart;
+  CTimerValue plt_tvLastReceived;
+
+  CPacketLoopbackTest(INDEX ctPackets);
+
+  // Check if all packets have arrived
+  BOOL IsDone(void) const { return plt_ctReceived + plt_ctCorrupt >= plt_ctPackets; };
+  // Get index of the last packet in the next batch to send
+  INDEX GetBatchEnd(void) const;
+  // Prepare payload of the next packet to send and return its size
+  SLONG PrepareNext(void);
+  // Verify payload of a received packet
+  void Verify(const UBYTE *pubData, SLONG slSize);
+  // Check if nothing has arrived for too long
+  BOOL IsStalled(void);
+  // Print results of the test
+  void Report(INDEX ctUnsent);
+};
+
 // data used to limit bandwidth/lantency and calculate statistics in packet-buffers
 class CPacketBufferStats {
 public:
@@ -298,6 +298,25 @@ BOOL CClientInterface::ReceiveFrom(void *pvReceive, SLONG &slSize, CAddress *pad
 	return FALSE;
 };
 
+// [Cecil] Take the next unreliable packet out of the input buffer without copying its data
+BOOL CClientInterface::ReceivePacket(CPacket *&ppaPacket, SLONG slMaxSize)
+{
+  // Same conditions as for receiving an unreliable message
+  if (ci_pbInputBuffer.pb_ulNumOfPackets == 0 || ci_pbReliableInputBuffer.pb_ulNumOfPackets != 0) {
+    return FALSE;
+  }
+
+  CPacket *ppaFirst = ci_pbInputBuffer.PeekFirstPacket();
+
+  if (ppaFirst->pa_ubReliable != UDP_PACKET_UNRELIABLE || ppaFirst->pa_slTransferSize > slMaxSize) {
+    return FALSE;
+  }
+
+  // The caller becomes the owner of the packet
+  ppaPacket = ci_pbInputBuffer.GetFirstPacket();
+  return TRUE;
+};
+
 
 // receive a message through the interface, discard originating address
 BOOL CClientInterface::Receive(CTStream &strmReceive,UBYTE bReliable)
@@ -702,3 +721,51 @@ SLONG CClientInterface::GetCurrentReliableSize(void)
   ci_pbReliableInputBuffer.CheckSequence(slSize);
 	return slSize;
 };
+
+// [Cecil] Print packet pool counters
+void PacketPoolInfo(void) {
+  PacketPoolStats stats;
+  GetPacketPoolStats(stats);
+
+  CPrintF(TRANS("Packet pool: %d live, %d pooled\n"), stats.pps_ctLive, stats.pps_ctPooled);
+  CPrintF(TRANS("  %.0f hits, %.0f misses, %.0f released\n"), (DOUBLE)stats.pps_llHits, (DOUBLE)stats.pps_llMisses, (DOUBLE)stats.pps_llReleased);
+};
+
+// [Cecil] Soak test that pumps unreliable packets through a pair of local interfaces
+void BenchmarkPacketLoopback(void *pArgs) {
+  INDEX ctPackets = NEXTARGUMENT(INDEX);
+  if (ctPackets <= 0) ctPackets = 1000000;
+
+  CClientInterface ciA, ciB;
+  ciA.SetLocal(&ciB);
+  ciB.SetLocal(&ciA);
+
+  CPacketLoopbackTest plt(ctPackets);
+  UBYTE aubReceive[MAX_UDP_BLOCK_SIZE];
+
+  while (!plt.IsDone()) {
+    // Send a batch of packets
+    const INDEX iBatchEnd = plt.GetBatchEnd();
+
+    for (; plt.plt_iSent < iBatchEnd; plt.plt_iSent++) {
+      const SLONG slSize = plt.PrepareNext();
+      ciA.Send(plt.plt_aubSend, slSize, FALSE);
+    }
+
+    ciA.ExchangeBuffers();
+
+    // Drain and verify everything that has arrived
+    SLONG slReceived = MAX_UDP_BLOCK_SIZE;
+
+    while (ciB.Receive(aubReceive, slReceived, FALSE)) {
+      plt.Verify(aubReceive, slReceived);
+      slReceived = MAX_UDP_BLOCK_SIZE;
+    }
+
+    if (plt.IsStalled()) break;
+  }
+
+  ciA.Clear();
+  ciB.Clear();
+  plt.Report(0);
+};
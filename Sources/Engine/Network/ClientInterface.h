@@ -52,6 +52,8 @@ public:
   BOOL Receive(void *pvReceive, SLONG &slSize,BOOL bReliable);
   BOOL ReceiveFrom(void *pvReceive, SLONG &slSize, CAddress *adrAdress,BOOL bReliable);
   BOOL Receive(CTStream &strmReceive,UBYTE bReliable);
+  // [Cecil] Take the next unreliable packet out of the input buffer without copying its data
+  BOOL ReceivePacket(CPacket *&ppaPacket, SLONG slMaxSize);
 
 	// exchanges packets beetween this socket and it's local partner
 	// from output of this buffet to the input of the other and vice versa
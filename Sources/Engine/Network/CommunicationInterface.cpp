@@ -20,6 +20,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/ErrorReporting.h>
 #include <Engine/Base/ErrorTable.h>
 #include <Engine/Base/ProgressHook.h>
+#include <Engine/Base/Shell.h> // [Cecil]
 #include <Engine/Base/Synchronization.h>
 #include <Engine/Base/Translation.h>
 
@@ -30,6 +31,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Network/Server.h>
 
 #include <Engine/Query/MasterServer.h> // [Cecil]
+#include <Engine/Network/TickTrace.h> // [Cecil]
 
 #if SE1_WIN
   #pragma comment(lib, "wsock32.lib")
@@ -809,6 +811,14 @@ BOOL CCommunicationInterface::Server_Receive_Unreliable(INDEX iClient, void *pvR
   return cm_aciClients[iClient].Receive(pvReceive, slReceiveSize,FALSE);
 };
 
+// [Cecil] Take the packet itself instead of copying its data
+BOOL CCommunicationInterface::Server_Receive_Unreliable(INDEX iClient, CPacket *&ppaPacket, SLONG slMaxSize)
+{
+  CTSingleLock slComm(&cm_csComm, TRUE);
+  ASSERT(iClient>=0 && iClient<SERVER_CLIENTS);
+  return cm_aciClients[iClient].ReceivePacket(ppaPacket, slMaxSize);
+};
+
 
 BOOL CCommunicationInterface::Server_Update()
 {
@@ -1168,6 +1178,13 @@ BOOL CCommunicationInterface::Client_Receive_Unreliable(void *pvReceive, SLONG &
   return cm_ciLocalClient.Receive(pvReceive, slReceiveSize,FALSE);
 };
 
+// [Cecil] Take the packet itself instead of copying its data
+BOOL CCommunicationInterface::Client_Receive_Unreliable(CPacket *&ppaPacket, SLONG slMaxSize)
+{
+  CTSingleLock slComm(&cm_csComm, TRUE);
+  return cm_ciLocalClient.ReceivePacket(ppaPacket, slMaxSize);
+};
+
 
 
 BOOL CCommunicationInterface::Client_Update(void)
@@ -1263,8 +1280,9 @@ BOOL CCommunicationInterface::Client_Update(void)
 // update master UDP socket and route its messages
 void CCommunicationInterface::UpdateMasterBuffers() 
 {
+  // [Cecil] Trace socket I/O
+  CTickTraceScope ttsPacketIO(TTE_PACKETIO);
 
-	UBYTE aub[MAX_PACKET_SIZE];
 	CAddress adrIncomingAddress;
 	SOCKADDR_IN sa;
 	socklen_t size = sizeof(sa);
@@ -1275,12 +1293,17 @@ void CCommunicationInterface::UpdateMasterBuffers()
 	CTimerValue tvNow;
 
 	if (cci_bBound) {
+		// [Cecil] Receive datagrams directly into a packet that is reused until it gets some data
+		ppaNewPacket = NULL;
+
 		// read from the socket while there is incoming data
 		do {
 
 			// initially, nothing is done
 			bSomethingDone = FALSE;
-			slSizeReceived = recvfrom(cci_hSocket,(char*)aub,MAX_PACKET_SIZE,0,(SOCKADDR *)&sa,&size);
+
+			if (ppaNewPacket == NULL) ppaNewPacket = new CPacket; // [Cecil]
+			slSizeReceived = recvfrom(cci_hSocket,(char*)ppaNewPacket->pa_pubPacketData,MAX_PACKET_SIZE,0,(SOCKADDR *)&sa,&size);
 			tvNow = _pTimer->GetHighPrecisionTimer();
 
 			adrIncomingAddress.adr_ulAddress = ntohl(sa.sin_addr.s_addr);
@@ -1294,6 +1317,7 @@ void CCommunicationInterface::UpdateMasterBuffers()
 					if (iResult!=WSAECONNRESET || net_bReportICMPErrors) {
 						CPrintF(TRANS("Socket error during UDP receive. %s\n"), 
 							GetSocketError(iResult).ConstData());
+						delete ppaNewPacket; // [Cecil]
 						return;
 					}
 				}
@@ -1313,8 +1337,7 @@ void CCommunicationInterface::UpdateMasterBuffers()
 				} else if (net_fDropPackets <= 0  || (FLOAT(rand())/RAND_MAX) > net_fDropPackets) {
 					// if no packet drop emulation (or the packet is not dropped), form the packet 
 					// and add it to the end of the UDP Master's input buffer
-					ppaNewPacket = new CPacket;
-					ppaNewPacket->WriteToPacketRaw(aub,slSizeReceived);
+					ppaNewPacket->ReadRawHeader(slSizeReceived); // [Cecil] Data is already there
 					ppaNewPacket->pa_adrAddress.adr_ulAddress = adrIncomingAddress.adr_ulAddress;
 					ppaNewPacket->pa_adrAddress.adr_uwPort = adrIncomingAddress.adr_uwPort;						
 
@@ -1324,6 +1347,7 @@ void CCommunicationInterface::UpdateMasterBuffers()
 					}
 
 					cci_pbMasterInput.AppendPacket(*ppaNewPacket,FALSE);
+					ppaNewPacket = NULL; // [Cecil] Now owned by the buffer
 					// there might be more to do
 					bSomethingDone = TRUE;
 				
@@ -1331,6 +1355,9 @@ void CCommunicationInterface::UpdateMasterBuffers()
 			}	
 
 		} while (bSomethingDone);
+
+		// [Cecil] Return the unused packet
+		delete ppaNewPacket;
 	}
 
 	// write from the output buffer to the socket
@@ -1382,3 +1409,83 @@ void CCommunicationInterface::UpdateMasterBuffers()
 };
 
 
+// [Cecil] Close a socket opened by the UDP loopback test
+static void CloseLoopbackSocket(CCommunicationInterface &cci) {
+  if (cci.cci_hSocket != INVALID_SOCKET) {
+    closesocket(cci.cci_hSocket);
+    cci.cci_hSocket = INVALID_SOCKET;
+  }
+
+  cci.cci_pbMasterInput.Clear();
+  cci.cci_pbMasterOutput.Clear();
+  cci.cci_bSocketOpen = FALSE;
+  cci.cci_bBound = FALSE;
+  cci.EndWinsock();
+};
+
+// [Cecil] Soak test that sends real datagrams between two UDP sockets on the loopback address
+void BenchmarkPacketLoopbackUDP(void *pArgs) {
+  INDEX ctPackets = NEXTARGUMENT(INDEX);
+  if (ctPackets <= 0) ctPackets = 100000;
+
+  CCommunicationInterface cciSender, cciReceiver;
+  ULONG ulReceiverHost, ulReceiverPort;
+
+  try {
+    cciSender.InitWinsock();
+    cciReceiver.InitWinsock();
+
+    // Bind the receiver to any free port so it can read datagrams right away
+    cciReceiver.CreateSocket_t();
+    cciReceiver.Bind_t(INADDR_LOOPBACK, 0);
+    cciReceiver.SetNonBlocking_t();
+    cciReceiver.cci_bSocketOpen = TRUE;
+    cciReceiver.GetLocalAddress_t(ulReceiverHost, ulReceiverPort);
+
+    // Sender gets bound implicitly on its first send
+    cciSender.OpenSocket_t(INADDR_LOOPBACK, 0);
+
+  } catch (char *strError) {
+    CPrintF(TRANS("Cannot open loopback sockets: %s\n"), strError);
+    CloseLoopbackSocket(cciSender);
+    CloseLoopbackSocket(cciReceiver);
+    return;
+  }
+
+  CPacketLoopbackTest plt(ctPackets);
+
+  while (!plt.IsDone()) {
+    // Queue a batch of packets
+    const INDEX iBatchEnd = plt.GetBatchEnd();
+
+    for (; plt.plt_iSent < iBatchEnd; plt.plt_iSent++) {
+      const SLONG slSize = plt.PrepareNext();
+
+      CPacket *ppa = new CPacket;
+      ppa->WriteToPacket(plt.plt_aubSend, slSize, UDP_PACKET_UNRELIABLE, plt.plt_iSent, 0, slSize);
+      ppa->pa_adrAddress.adr_ulAddress = ulReceiverHost;
+      ppa->pa_adrAddress.adr_uwPort = UWORD(ulReceiverPort);
+      cciSender.cci_pbMasterOutput.AppendPacket(*ppa, FALSE);
+    }
+
+    // Send everything through the socket and read whatever has arrived on the other one
+    cciSender.UpdateMasterBuffers();
+    cciReceiver.UpdateMasterBuffers();
+
+    // Verify payloads of everything that has arrived right inside the packets
+    while (cciReceiver.cci_pbMasterInput.pb_ulNumOfPackets > 0) {
+      CPacket *ppa = cciReceiver.cci_pbMasterInput.GetFirstPacket();
+      plt.Verify(ppa->pa_pubPacketData + MAX_HEADER_SIZE, ppa->pa_slSize - MAX_HEADER_SIZE);
+      ppa->RemReference();
+    }
+
+    if (plt.IsStalled()) break;
+  }
+
+  // Packets that couldn't be sent are still in the output buffer
+  const INDEX ctUnsent = cciSender.cci_pbMasterOutput.pb_ulNumOfPackets;
+
+  CloseLoopbackSocket(cciSender);
+  CloseLoopbackSocket(cciReceiver);
+  plt.Report(ctUnsent);
+};
@@ -98,6 +98,7 @@ public:
   BOOL Server_Receive_Reliable(INDEX iClient, void *pvReceive, SLONG &slReceiveSize);
   void Server_Send_Unreliable(INDEX iClient, const void *pvSend, SLONG slSendSize);
   BOOL Server_Receive_Unreliable(INDEX iClient, void *pvReceive, SLONG &slReceiveSize);
+  BOOL Server_Receive_Unreliable(INDEX iClient, CPacket *&ppaPacket, SLONG slMaxSize); // [Cecil]
 
   BOOL Server_Update(void);
 
@@ -115,6 +116,7 @@ public:
   void Client_PeekSize_Reliable(SLONG &slExpectedSize,SLONG &slReceivedSize);
   void Client_Send_Unreliable(const void *pvSend, SLONG slSendSize);
   BOOL Client_Receive_Unreliable(void *pvReceive, SLONG &slReceiveSize);
+  BOOL Client_Receive_Unreliable(CPacket *&ppaPacket, SLONG slMaxSize); // [Cecil]
 
   BOOL Client_Update(void);
 };
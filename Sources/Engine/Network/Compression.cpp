@@ -22,8 +22,6 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <zlib/zlib.h>
 #pragma comment(lib, "zlib.lib")
 
-// Critical section for accessing zlib functions
-extern CTCriticalSection zip_csLock;
 
 /* Unpack from stream to stream. */
 void CCompressor::UnpackStream_t(CTMemoryStream &strmSrc, CTStream &strmDst) // throw char *
@@ -297,6 +295,8 @@ void lzrw1_compress(const UBYTE *p_src_first, ULONG src_len,UBYTE *p_dst_first,
  UBYTE *p_dst_post=p_dst_first+src_len;
  const UBYTE *p_src_max1=p_src_post-ITEMMAX,*p_src_max16=p_src_post-16*ITEMMAX;
  const UBYTE *hash[4096];
+ // [Cecil] Clear the hash table, otherwise matches against leftover stack data make the output differ between calls
+ memset(hash, 0, sizeof(hash));
  UBYTE *p_control; UWORD control=0,control_bits=0;
  *p_dst=FLAG_COMPRESS; p_dst+=FLAG_BYTES; p_control=p_dst; p_dst+=2;
  while (TRUE)
@@ -431,7 +431,8 @@ int ZEXPORT compress (dest, destLen, source, sourceLen)
     uLong sourceLen;
     */
 
-  CTSingleLock slZip(&zip_csLock, TRUE);
+  // [Cecil] compress() and uncompress() don't share any state between calls, so they don't need zip_csLock,
+  // which would otherwise stall reading of archives while a saved game is being compressed
   uLongf ulDstSize = static_cast<uLongf>(slDstSize);
 
   int iResult = compress(
@@ -455,7 +456,6 @@ int ZEXPORT uncompress (dest, destLen, source, sourceLen)
     uLong sourceLen;
     */
 
-  CTSingleLock slZip(&zip_csLock, TRUE);
   uLongf ulDstSize = static_cast<uLongf>(slDstSize);
 
   int iResult = uncompress(
@@ -0,0 +1,279 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#include "StdH.h"
+
+#include <Engine/Network/DemoBenchmark.h>
+#include <Engine/Network/Network.h>
+#include <Engine/Network/SessionState.h>
+#include <Engine/Network/PlayerTarget.h>
+#include <Engine/Base/Statistics_internal.h>
+#include <Engine/Entities/Entity.h>
+#include <Engine/Graphics/Raster.h>
+#include <Engine/Graphics/DrawPort.h>
+#include <Engine/Graphics/GfxLibrary.h>
+#include <Engine/Math/Projection.h>
+#include <Engine/Rendering/Render.h>
+#include <Engine/Sound/SoundLibrary.h>
+
+#include <Engine/Templates/StaticStackArray.cpp>
+
+#include <algorithm>
+
+static const char *_astrColumnNames[CDemoBenchmark::E_MAX_COLUMNS] = {
+  "total", "network", "physics", "render", "sound",
+};
+
+// Get elapsed time of a stat timer in seconds
+static inline DOUBLE GetStatTime(INDEX iTimer) {
+  return _sfStats.sf_astTimers[iTimer].st_tvElapsed.GetSeconds();
+};
+
+// Find the first active player to view the demo from
+static CEntity *GetDemoViewer(void) {
+  CStaticArray<CPlayerTarget> &aplt = _pNetwork->ga_sesSessionState.ses_apltPlayers;
+
+  for (INDEX i = 0; i < aplt.Count(); i++) {
+    if (aplt[i].IsActive() && aplt[i].plt_penPlayerEntity != NULL) {
+      return (CEntity *)aplt[i].plt_penPlayerEntity;
+    }
+  }
+
+  return NULL;
+};
+
+CDemoBenchmark::CDemoBenchmark(void) {
+  db_fFPS = (FLOAT)CTimer::TickRate;
+  db_pixWidth = 1280;
+  db_pixHeight = 720;
+  db_ctMaxFrames = 0;
+};
+
+void CDemoBenchmark::Run_t(const CTFileName &fnmDemo) {
+  db_fnmDemo = fnmDemo;
+  db_aFrames.PopAll();
+
+  if (_pGfx->GetCurrentAPI() != GAT_NONE) {
+    CPrintF(TRANS("Warning: Benchmarking demo playback with a graphics API also measures the driver\n"));
+  }
+
+  // Advance demo time by the same step each frame
+  const FLOAT fOldSyncRate = _pNetwork->ga_fDemoSyncRate;
+  _pNetwork->ga_fDemoSyncRate = ClampDn(db_fFPS, 1.0f);
+
+  try {
+    _pNetwork->StartDemoPlay_t(fnmDemo);
+  } catch (char *) {
+    _pNetwork->ga_fDemoSyncRate = fOldSyncRate;
+    throw;
+  }
+
+  // Render into a raster without a window
+  CRaster ra(db_pixWidth, db_pixHeight, 0);
+  CDrawPort *pdp = &ra.ra_MainDrawPort;
+
+  CSessionState &ses = _pNetwork->ga_sesSessionState;
+
+  while (!_pNetwork->IsDemoPlayFinished() && (db_ctMaxFrames <= 0 || db_aFrames.Count() < db_ctMaxFrames)) {
+    _sfStats.Reset();
+
+    const TICK tckBefore = ses.ses_tckLastProcessedTick;
+    const CTimerValue tvFrame = _pTimer->GetHighPrecisionTimer();
+
+    // Play the demo up to the next frame
+    _pNetwork->MainLoop();
+
+    // Ray casting pauses the main loop timer, so its time has to be added back
+    const DOUBLE dMainLoopRayCasts = GetStatTime(CStatForm::STI_RAYCAST);
+
+    // Render the view of the first player
+    const CTimerValue tvRender = _pTimer->GetHighPrecisionTimer();
+    CEntity *penViewer = GetDemoViewer();
+
+    if (penViewer != NULL && pdp->Lock()) {
+      CPerspectiveProjection3D prPerspective;
+      prPerspective.FOVL() = AngleDeg(90.0f);
+      prPerspective.ScreenBBoxL() = FLOATaabbox2D(FLOAT2D(0.0f, 0.0f), FLOAT2D((FLOAT)pdp->GetWidth(), (FLOAT)pdp->GetHeight()));
+      prPerspective.AspectRatioL() = 1.0f;
+      prPerspective.FrontClipDistanceL() = 0.3f;
+      prPerspective.ViewerPlacementL() = penViewer->GetLerpedPlacement();
+
+      CAnyProjection3D prProjection;
+      prProjection = prPerspective;
+
+      pdp->Fill(C_BLACK | CT_OPAQUE);
+      pdp->FillZBuffer(ZBUF_BACK);
+      RenderView(*_pNetwork->ga_pWorld, *penViewer, prProjection, *pdp);
+      pdp->Unlock();
+    }
+
+    const CTimerValue tvSound = _pTimer->GetHighPrecisionTimer();
+
+    // Update sounds of the frame even though they are muted
+    _pSound->UpdateSounds();
+
+    const CTimerValue tvEnd = _pTimer->GetHighPrecisionTimer();
+
+    DemoBenchmarkFrame &frame = db_aFrames.Push();
+    frame.dTotal = (tvEnd - tvFrame).GetSeconds();
+    frame.dPhysics = GetStatTime(CStatForm::STI_GAMETICK);
+    frame.dNetwork = ClampDn(GetStatTime(CStatForm::STI_MAINLOOP) + dMainLoopRayCasts - frame.dPhysics, 0.0);
+    frame.dRender = (tvSound - tvRender).GetSeconds();
+    frame.dSound = GetStatTime(CStatForm::STI_SOUNDUPDATE);
+    frame.ctTicks = INDEX(ses.ses_tckLastProcessedTick - tckBefore);
+  }
+
+  _pNetwork->StopGame();
+  _pNetwork->ga_fDemoSyncRate = fOldSyncRate;
+};
+
+const char *CDemoBenchmark::GetColumnName(INDEX iColumn) {
+  ASSERT(iColumn >= 0 && iColumn < E_MAX_COLUMNS);
+  return _astrColumnNames[iColumn];
+};
+
+DOUBLE CDemoBenchmark::GetFrameTime(INDEX iFrame, INDEX iColumn) const {
+  const DemoBenchmarkFrame &frame = db_aFrames[iFrame];
+
+  switch (iColumn) {
+    case E_TOTAL:   return frame.dTotal;
+    case E_NETWORK: return frame.dNetwork;
+    case E_PHYSICS: return frame.dPhysics;
+    case E_RENDER:  return frame.dRender;
+    case E_SOUND:   return frame.dSound;
+  }
+
+  ASSERTALWAYS("Invalid demo benchmark column!");
+  return 0.0;
+};
+
+DemoBenchmarkStats CDemoBenchmark::GetStats(INDEX iColumn) const {
+  DemoBenchmarkStats stats;
+  stats.dMin = stats.dAvg = stats.dP99 = stats.dMax = 0.0;
+
+  const INDEX ctFrames = db_aFrames.Count();
+  if (ctFrames == 0) return stats;
+
+  CStaticArray<DOUBLE> adTimes;
+  adTimes.New(ctFrames);
+
+  DOUBLE dSum = 0.0;
+
+  for (INDEX i = 0; i < ctFrames; i++) {
+    adTimes[i] = GetFrameTime(i, iColumn);
+    dSum += adTimes[i];
+  }
+
+  std::sort(&adTimes[0], &adTimes[0] + ctFrames);
+
+  // Nearest-rank percentile
+  const INDEX iP99 = Clamp(INDEX(ceil(ctFrames * 0.99)) - 1, (INDEX)0, ctFrames - 1);
+
+  stats.dMin = adTimes[0];
+  stats.dAvg = dSum / ctFrames;
+  stats.dP99 = adTimes[iP99];
+  stats.dMax = adTimes[ctFrames - 1];
+  return stats;
+};
+
+CTString CDemoBenchmark::GetSummary(void) const {
+  CTString strSummary(0, "%d frames of '%s' at %.1f FPS\n", db_aFrames.Count(), db_fnmDemo.ConstData(), db_fFPS);
+  strSummary += "           min      avg      p99      max (ms)\n";
+
+  for (INDEX iColumn = 0; iColumn < E_MAX_COLUMNS; iColumn++) {
+    const DemoBenchmarkStats stats = GetStats(iColumn);
+
+    strSummary += CTString(0, "%-8s %8.3f %8.3f %8.3f %8.3f\n", GetColumnName(iColumn),
+      stats.dMin * 1000.0, stats.dAvg * 1000.0, stats.dP99 * 1000.0, stats.dMax * 1000.0);
+  }
+
+  return strSummary;
+};
+
+void CDemoBenchmark::WriteJSON_t(const CTFileName &fnmFile) const {
+  CTFileStream strm;
+  strm.Create_t(fnmFile);
+
+  // Use forward slashes to avoid escaping them
+  CTString strDemo = db_fnmDemo;
+  strDemo.ReplaceSubstr("\\", "/");
+
+  strm.FPrintF_t("{\n  \"demo\": \"%s\",\n  \"fps\": %g,\n  \"width\": %d,\n  \"height\": %d,\n  \"frames\": %d,\n",
+    strDemo.ConstData(), db_fFPS, db_pixWidth, db_pixHeight, db_aFrames.Count());
+
+  // Summary of each column in milliseconds
+  strm.FPrintF_t("  \"summary_ms\": {\n");
+
+  INDEX iColumn;
+
+  for (iColumn = 0; iColumn < E_MAX_COLUMNS; iColumn++) {
+    const DemoBenchmarkStats stats = GetStats(iColumn);
+
+    strm.FPrintF_t("    \"%s\": { \"min\": %.4f, \"avg\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n", GetColumnName(iColumn),
+      stats.dMin * 1000.0, stats.dAvg * 1000.0, stats.dP99 * 1000.0, stats.dMax * 1000.0,
+      iColumn < E_MAX_COLUMNS - 1 ? "," : "");
+  }
+
+  strm.FPrintF_t("  },\n");
+
+  // Each frame as an array of column values in milliseconds
+  strm.FPrintF_t("  \"columns\": [");
+
+  for (iColumn = 0; iColumn < E_MAX_COLUMNS; iColumn++) {
+    strm.FPrintF_t("\"%s\", ", GetColumnName(iColumn));
+  }
+
+  strm.FPrintF_t("\"ticks\"],\n  \"frames_ms\": [\n");
+
+  const INDEX ctFrames = db_aFrames.Count();
+
+  for (INDEX iFrame = 0; iFrame < ctFrames; iFrame++) {
+    strm.FPrintF_t("    [");
+
+    for (iColumn = 0; iColumn < E_MAX_COLUMNS; iColumn++) {
+      strm.FPrintF_t("%.4f, ", GetFrameTime(iFrame, iColumn) * 1000.0);
+    }
+
+    strm.FPrintF_t("%d]%s\n", db_aFrames[iFrame].ctTicks, iFrame < ctFrames - 1 ? "," : "");
+  }
+
+  strm.FPrintF_t("  ]\n}\n");
+};
+
+void CDemoBenchmark::WriteCSV_t(const CTFileName &fnmFile) const {
+  CTFileStream strm;
+  strm.Create_t(fnmFile);
+
+  strm.FPrintF_t("frame");
+
+  INDEX iColumn;
+
+  for (iColumn = 0; iColumn < E_MAX_COLUMNS; iColumn++) {
+    strm.FPrintF_t(",%s_ms", GetColumnName(iColumn));
+  }
+
+  strm.FPrintF_t(",ticks\n");
+
+  for (INDEX iFrame = 0; iFrame < db_aFrames.Count(); iFrame++) {
+    strm.FPrintF_t("%d", iFrame);
+
+    for (iColumn = 0; iColumn < E_MAX_COLUMNS; iColumn++) {
+      strm.FPrintF_t(",%.4f", GetFrameTime(iFrame, iColumn) * 1000.0);
+    }
+
+    strm.FPrintF_t(",%d\n", db_aFrames[iFrame].ctTicks);
+  }
+};
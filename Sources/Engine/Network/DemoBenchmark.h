@@ -0,0 +1,89 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#ifndef SE_INCL_DEMOBENCHMARK_H
+#define SE_INCL_DEMOBENCHMARK_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+// Time spent on one played demo frame in seconds
+struct DemoBenchmarkFrame {
+  DOUBLE dTotal;   // whole frame
+  DOUBLE dNetwork; // main network loop without game ticks
+  DOUBLE dPhysics; // processing of game ticks (entity thinking and movement)
+  DOUBLE dRender;  // rendering of the view
+  DOUBLE dSound;   // sound updates
+  INDEX ctTicks;   // game ticks processed during this frame
+};
+
+// Summary of one frame time column
+struct DemoBenchmarkStats {
+  DOUBLE dMin;
+  DOUBLE dAvg;
+  DOUBLE dP99;
+  DOUBLE dMax;
+};
+
+// Plays a recorded demo at a fixed step and renders each frame to measure engine performance
+class ENGINE_API CDemoBenchmark {
+  public:
+    // Frame time columns
+    enum Column {
+      E_TOTAL = 0,
+      E_NETWORK,
+      E_PHYSICS,
+      E_RENDER,
+      E_SOUND,
+
+      E_MAX_COLUMNS,
+    };
+
+  public:
+    CTFileName db_fnmDemo;
+    FLOAT db_fFPS; // frames per one second of demo time
+    PIX db_pixWidth;
+    PIX db_pixHeight;
+    INDEX db_ctMaxFrames; // frame limit (0 - until the demo ends)
+
+    CStaticStackArray<DemoBenchmarkFrame> db_aFrames;
+
+  public:
+    CDemoBenchmark(void);
+
+    // Play the whole demo (the graphics API should be the null one to avoid measuring the GPU)
+    void Run_t(const CTFileName &fnmDemo); // throw char *
+
+    // Get name of a column
+    static const char *GetColumnName(INDEX iColumn);
+
+    // Get one column of some frame
+    DOUBLE GetFrameTime(INDEX iFrame, INDEX iColumn) const;
+
+    // Calculate min/avg/p99/max of some column over all frames
+    DemoBenchmarkStats GetStats(INDEX iColumn) const;
+
+    // Get human-readable summary of all columns
+    CTString GetSummary(void) const;
+
+    // Write summary and all frames in JSON format
+    void WriteJSON_t(const CTFileName &fnmFile) const; // throw char *
+
+    // Write all frames in CSV format
+    void WriteCSV_t(const CTFileName &fnmFile) const; // throw char *
+};
+
+#endif  /* include-once check. */
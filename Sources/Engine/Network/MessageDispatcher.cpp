@@ -319,16 +319,14 @@ void CMessageDispatcher::SendToServerReliable(const CNetworkMessage &nmMessage)
 BOOL CMessageDispatcher::ReceiveFromServer(CNetworkMessage &nmMessage)
 {
   _pfNetworkProfile.StartTimer(CNetworkProfile::PTI_RECEIVEMESSAGE);
-  // receive message in static buffer
-  nmMessage.nm_slSize = nmMessage.nm_slMaxSize;
-  BOOL bReceived = _cmiComm.Client_Receive_Unreliable(
-    (void*)nmMessage.nm_pubMessage, nmMessage.nm_slSize);
+  // [Cecil] Read the message right from the received packet
+  CPacket *ppaReceived = NULL;
+  BOOL bReceived = _cmiComm.Client_Receive_Unreliable(ppaReceived, nmMessage.nm_slMaxSize);
 
   // if there is message
   if (bReceived) {
     // init the message structure
-    nmMessage.nm_pubPointer = nmMessage.nm_pubMessage;
-    nmMessage.nm_iBit = 0;
+    nmMessage.SetPayload(ppaReceived);
     UBYTE ubType;
     nmMessage.Read(&ubType, sizeof(ubType));
     nmMessage.nm_mtType = (MESSAGETYPE)ubType;
@@ -342,6 +340,9 @@ BOOL CMessageDispatcher::ReceiveFromServer(CNetworkMessage &nmMessage)
 BOOL CMessageDispatcher::ReceiveFromServerReliable(CNetworkMessage &nmMessage)
 {
   _pfNetworkProfile.StartTimer(CNetworkProfile::PTI_RECEIVEMESSAGE);
+  // [Cecil] Receive into own buffer
+  nmMessage.ReleasePayload();
+
   // receive message in static buffer
   nmMessage.nm_slSize = nmMessage.nm_slMaxSize;
   BOOL bReceived = _cmiComm.Client_Receive_Reliable(
@@ -383,16 +384,14 @@ BOOL CMessageDispatcher::ReceiveFromServerReliable(CTMemoryStream &strmMessage)
 BOOL CMessageDispatcher::ReceiveFromClient(INDEX iClient, CNetworkMessage &nmMessage)
 {
   _pfNetworkProfile.StartTimer(CNetworkProfile::PTI_RECEIVEMESSAGE);
-  // receive message in static buffer
-  nmMessage.nm_slSize = nmMessage.nm_slMaxSize;
-  BOOL bReceived = _cmiComm.Server_Receive_Unreliable(iClient,
-    (void*)nmMessage.nm_pubMessage, nmMessage.nm_slSize);
+  // [Cecil] Read the message right from the received packet
+  CPacket *ppaReceived = NULL;
+  BOOL bReceived = _cmiComm.Server_Receive_Unreliable(iClient, ppaReceived, nmMessage.nm_slMaxSize);
 
   // if there is message
   if (bReceived) {
     // init the message structure
-    nmMessage.nm_pubPointer = nmMessage.nm_pubMessage;
-    nmMessage.nm_iBit = 0;
+    nmMessage.SetPayload(ppaReceived);
     UBYTE ubType;
     nmMessage.Read(&ubType, sizeof(ubType));
     nmMessage.nm_mtType = (MESSAGETYPE)ubType;
@@ -406,6 +405,9 @@ BOOL CMessageDispatcher::ReceiveFromClient(INDEX iClient, CNetworkMessage &nmMes
 BOOL CMessageDispatcher::ReceiveFromClientReliable(INDEX iClient, CNetworkMessage &nmMessage)
 {
 //  _pfNetworkProfile.StartTimer(CNetworkProfile::PTI_RECEIVEMESSAGE);  // profile this!!!!
+  // [Cecil] Receive into own buffer
+  nmMessage.ReleasePayload();
+
   // receive message in static buffer
   nmMessage.nm_slSize = nmMessage.nm_slMaxSize;
   BOOL bReceived = _cmiComm.Server_Receive_Reliable(iClient,
@@ -442,6 +444,9 @@ void CMessageDispatcher::SendBroadcast(const CNetworkMessage &nmMessage, ULONG u
 BOOL CMessageDispatcher::ReceiveBroadcast(CNetworkMessage &nmMessage, ULONG &ulAddr, UWORD &uwPort)
 {
   CAddress adrSource = {0,0,0};
+  // [Cecil] Receive into own buffer
+  nmMessage.ReleasePayload();
+
   // receive message in static buffer
   nmMessage.nm_slSize = nmMessage.nm_slMaxSize;
   BOOL bReceived = _cmiComm.Broadcast_Receive(
@@ -28,6 +28,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Entities/InternalClasses.h>
 #include <Engine/Entities/Precaching.h>
 #include <Engine/Network/CommunicationInterface.h>
+#include <Engine/Network/Compression.h> // [Cecil]
+#include <Engine/Base/WorkerThreads.h> // [Cecil]
 
 #include <Engine/Base/Statistics_internal.h>
 #include <Engine/Graphics/DrawPort.h>
@@ -66,6 +68,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/Stock_CModelConfig.h> // [Cecil]
 
 #include <Engine/Query/MasterServer.h> // [Cecil]
+#include <Engine/Network/TickTrace.h> // [Cecil]
 
 // pointer to global instance of the only game object in the application
 CNetworkLibrary *_pNetwork= NULL;
@@ -79,6 +82,18 @@ BOOL _bTempNetwork = FALSE;  // set while using temporary second network object
 extern BOOL con_bCapture;
 extern CTString con_strCapture;
 
+// [Cecil] Packet pool
+extern void PacketPoolInfo(void);
+extern void BenchmarkPacketLoopback(void *pArgs);
+extern void BenchmarkPacketLoopbackUDP(void *pArgs);
+
+// [Cecil] Tick tracing
+extern FLOAT net_fTraceSpikeMS;
+extern void DumpTickTrace(void);
+
+// [Cecil] Game stream packing
+extern void BenchmarkStreamPacking(void *pArgs);
+
 CWorld *_pwoCurrentWorld = NULL;
 
 static FLOAT _bStartDemoRecordingNextTime = FALSE;
@@ -92,6 +107,7 @@ INDEX ser_bReportSyncLate = FALSE;
 INDEX ser_bReportSyncEarly = FALSE;
 INDEX ser_bPauseOnSyncBad = FALSE;
 INDEX ser_bRequestSyncDump = TRUE; // [Cecil]
+INDEX ser_bParallelStreams = FALSE; // [Cecil] Pack game stream batches for all clients on worker threads
 INDEX ser_iKickOnSyncBad = 10;
 INDEX ser_bKickOnSyncLate = 1;
 INDEX ser_iRememberBehind = 3000;
@@ -109,6 +125,12 @@ CTString ser_strNameMask = "";
 INDEX ser_bInverseBanning = FALSE;
 CTString ser_strMOTD = "";
 
+// [Cecil] Saved games
+INDEX gam_bCompressSaves = TRUE; // Compress saved games with zlib (only when they are written in the background)
+INDEX gam_bAsyncSaves = FALSE; // Write saved games on a worker thread
+static CJobGroup *_pjgSaves = NULL; // Jobs for writing saved games
+static CTString _strSaveError = ""; // Error from the last game saved in the background
+
 INDEX cli_bEmulateDesync  = FALSE;
 INDEX cli_bDumpSync       = FALSE;
 INDEX cli_bDumpSyncEachTick = FALSE;
@@ -714,6 +736,21 @@ CNetworkLibrary::CNetworkLibrary(void) :
  */
 CNetworkLibrary::~CNetworkLibrary(void)
 {
+  // [Cecil] Finish writing saved games
+  try {
+    FinishSaving_t();
+  } catch (char *strError) {
+    CPrintF("%s\n", strError);
+  }
+
+  if (_pjgSaves != NULL) {
+    delete _pjgSaves;
+    _pjgSaves = NULL;
+  }
+
+  // [Cecil] Finish writing tick traces
+  TickTrace_FinishDumps();
+
   // clear the global world
   ga_pWorld->DeletePredictors();
   ga_pWorld->Clear();
@@ -749,6 +786,8 @@ void CNetworkLibrary::Init(void)
   // add shell symbols
   _pShell->DeclareSymbol("user INDEX dbg_bBreak;", &dbg_bBreak);
   _pShell->DeclareSymbol("persistent user INDEX gam_bPretouch;", &gam_bPretouch);
+  _pShell->DeclareSymbol("persistent user INDEX gam_bCompressSaves;", &gam_bCompressSaves); // [Cecil]
+  _pShell->DeclareSymbol("persistent user INDEX gam_bAsyncSaves;", &gam_bAsyncSaves); // [Cecil]
 
   // [Cecil] Check if some symbol can be changed during the game
   _pShell->DeclareSymbol("INDEX UpdateServerSymbolValue(INDEX);", &UpdateServerSymbolValue);
@@ -767,6 +806,11 @@ void CNetworkLibrary::Init(void)
   _pShell->DeclareSymbol("user void KickByName(CTString, CTString);", &KickByNameCfunc);
   _pShell->DeclareSymbol("user void ListPlayers(void);", &ListPlayers);
   _pShell->DeclareSymbol("user void Admin(CTString);", &Admin);
+  _pShell->DeclareSymbol("user void DumpTickTrace(void);", &DumpTickTrace); // [Cecil]
+  _pShell->DeclareSymbol("user void PacketPoolInfo(void);", &PacketPoolInfo); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkPacketLoopback(INDEX);", &BenchmarkPacketLoopback); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkPacketLoopbackUDP(INDEX);", &BenchmarkPacketLoopbackUDP); // [Cecil]
+  _pShell->DeclareSymbol("user void BenchmarkStreamPacking(INDEX, INDEX);", &BenchmarkStreamPacking); // [Cecil]
 
   _pShell->DeclareSymbol("user void AddIPMask(CTString);", &AddIPMask);
   _pShell->DeclareSymbol("user void RemIPMask(CTString);", &RemIPMask);
@@ -796,6 +840,7 @@ void CNetworkLibrary::Init(void)
   _pShell->DeclareSymbol("user INDEX ser_bReportSyncEarly;", &ser_bReportSyncEarly);
   _pShell->DeclareSymbol("user INDEX ser_bPauseOnSyncBad;",  &ser_bPauseOnSyncBad);
   _pShell->DeclareSymbol("persistent user INDEX ser_bRequestSyncDump;", &ser_bRequestSyncDump); // [Cecil]
+  _pShell->DeclareSymbol("persistent user INDEX ser_bParallelStreams;", &ser_bParallelStreams); // [Cecil]
   _pShell->DeclareSymbol("user INDEX ser_iKickOnSyncBad;",   &ser_iKickOnSyncBad);
   _pShell->DeclareSymbol("user INDEX ser_bKickOnSyncLate;",  &ser_bKickOnSyncLate);
   _pShell->DeclareSymbol("persistent user FLOAT ser_tmSyncCheckFrequency;", &ser_tmSyncCheckFrequency);
@@ -832,6 +877,8 @@ void CNetworkLibrary::Init(void)
   _pShell->DeclareSymbol("persistent user INDEX net_bReportTraffic;", &net_bReportTraffic);
   _pShell->DeclareSymbol("persistent user INDEX net_bReportICMPErrors;", &net_bReportICMPErrors);
   _pShell->DeclareSymbol("persistent user INDEX net_bReportMiscErrors;", &net_bReportMiscErrors);
+  _pShell->DeclareSymbol("persistent user INDEX net_bTraceTicks;",   &net_bTraceTicks);   // [Cecil]
+  _pShell->DeclareSymbol("persistent user FLOAT net_fTraceSpikeMS;", &net_fTraceSpikeMS); // [Cecil]
   _pShell->DeclareSymbol("persistent user INDEX net_bLerping;",       &net_bLerping);
   _pShell->DeclareSymbol("persistent user INDEX ser_bClientsMayPause;", &ser_bClientsMayPause);
   _pShell->DeclareSymbol("persistent user INDEX ser_bEnumeration pre:UpdateServerSymbolValue;", &ser_bEnumeration);
@@ -1102,29 +1149,149 @@ void CNetworkLibrary::StartPeerToPeer_t(const CTString &strSessionName,
   CPrintF( TRANS("  started.\n"));
 }
 
+// [Cecil] Game state that has been saved into memory and needs to be written into a file
+struct SPendingSave {
+  CTFileName ps_fnmGame;
+  CTMemoryStream ps_strmGame;
+  BOOL ps_bCompress;
+};
+
+// [Cecil] Write game state from memory into a file
+static void WritePendingSave_t(SPendingSave &ps) {
+  SLONG slSize = ps.ps_strmGame.GetStreamSize();
+  ps.ps_strmGame.SetPos_t(0);
+
+  // create the file
+  CTFileStream strmFile;
+  strmFile.Create_t(ps.ps_fnmGame);
+
+  // write compressed game state with the uncompressed and compressed sizes
+  if (ps.ps_bCompress) {
+    strmFile.WriteID_t("GAMZ");
+    CzlibCompressor comp;
+    comp.PackStream_t(ps.ps_strmGame, strmFile);
+
+  // or write it as it is
+  } else {
+    strmFile.Write_t(ps.ps_strmGame.mstrm_pubBuffer, slSize);
+  }
+};
+
+// [Cecil] Write saved game on a worker thread
+static void WritePendingSaveJob(void *pData, INDEX iItem) {
+  SPendingSave *pps = (SPendingSave *)pData;
+
+  // Remember the error until it's reported by FinishSaving_t()
+  // NOTE: It's only read after waiting for the job, so it doesn't need its own lock
+  try {
+    WritePendingSave_t(*pps);
+
+  } catch (char *strError) {
+    _strSaveError.PrintF(TRANS("Cannot save game '%s':\n%s"), pps->ps_fnmGame.ConstData(), strError);
+  }
+
+  delete pps;
+};
+
 /*
  * Save the game.
  */
 void CNetworkLibrary::Save_t(const CTFileName &fnmGame) // throw char *
 {
-  // synchronize access to network
-  CTSingleLock slNetwork(&ga_csNetwork, TRUE);
+  // [Cecil] Game state is saved into memory first
+  SPendingSave *pps = new SPendingSave;
+  pps->ps_fnmGame = fnmGame;
+  // [Cecil] Don't stall the game by compressing it on this thread
+  pps->ps_bCompress = (gam_bCompressSaves && gam_bAsyncSaves);
 
-  // must be server
-  if (!ga_IsServer) {
-    throw TRANS("Cannot save game - not a server!\n");
+  try {
+    // synchronize access to network
+    CTSingleLock slNetwork(&ga_csNetwork, TRUE);
+
+    // must be server
+    if (!ga_IsServer) {
+      throw TRANS("Cannot save game - not a server!\n");
+    }
+
+    // write game to stream
+    pps->ps_strmGame.WriteID_t("GAME");
+    ga_sesSessionState.Write_t(&pps->ps_strmGame);
+    pps->ps_strmGame.WriteID_t("GEND");   // game end
+
+  } catch (char *) {
+    delete pps;
+    throw;
   }
 
-  // create the file
-  CTFileStream strmFile;
-  strmFile.Create_t(fnmGame);
+  // [Cecil] Don't write the same file from multiple threads
+  try {
+    FinishSaving_t();
+  } catch (char *strError) {
+    CPrintF("%s\n", strError);
+  }
+
+  // [Cecil] Compress and write the file in the background
+  if (gam_bAsyncSaves) {
+    if (_pjgSaves == NULL) _pjgSaves = new CJobGroup;
+    _pjgSaves->Add(&WritePendingSaveJob, pps, 0);
+    return;
+  }
+
+  // [Cecil] Or write it right away
+  try {
+    WritePendingSave_t(*pps);
+
+  } catch (char *) {
+    delete pps;
+    throw;
+  }
 
-  // write game to stream
-  strmFile.WriteID_t("GAME");
-  ga_sesSessionState.Write_t(&strmFile);
-  strmFile.WriteID_t("GEND");   // game end
+  delete pps;
 }
 
+// [Cecil] Wait until all games that are being saved in the background are written
+// and report the error if the last one couldn't be
+void CNetworkLibrary::FinishSaving_t(void)
+{
+  if (_pjgSaves == NULL) return;
+
+  _pjgSaves->Wait();
+
+  // Report it only once
+  if (_strSaveError != "") {
+    const CTString strError = _strSaveError;
+    _strSaveError = "";
+
+    ThrowF_t("%s", strError.ConstData());
+  }
+}
+
+// [Cecil] Unpack game state that has been saved in a compressed file
+static void UnpackSavedGame_t(CTStream &strmFile, CTMemoryStream &strmGame) {
+  strmFile.ExpectID_t("GAMZ");
+
+  // read compressed data into memory
+  const SLONG slPacked = strmFile.GetStreamSize() - strmFile.GetPos_t();
+
+  if (slPacked <= 0) {
+    ThrowF_t(TRANS("Saved game is empty"));
+  }
+
+  CTMemoryStream strmPacked;
+
+  if (slPacked > strmPacked.mstrm_pubBufferEnd - strmPacked.mstrm_pubBuffer) {
+    ThrowF_t(TRANS("Saved game is too big"));
+  }
+
+  // read it straight into the stream buffer
+  strmFile.Read_t(strmPacked.mstrm_pubBuffer, slPacked);
+  strmPacked.mstrm_pubBufferMax = strmPacked.mstrm_pubBuffer + slPacked;
+
+  // unpack it
+  CzlibCompressor comp;
+  comp.UnpackStream_t(strmPacked, strmGame);
+};
+
 /*
  * Load the game.
  *
@@ -1144,10 +1311,26 @@ void CNetworkLibrary::Load_t(const CTFileName &fnmGame) // throw char *
 
   ga_bLocalPause = FALSE;
 
+  // [Cecil] Make sure the file is completely written
+  try {
+    FinishSaving_t();
+  } catch (char *strError) {
+    CPrintF("%s\n", strError);
+  }
+
   // open the file
   CTFileStream strmFile;
   strmFile.Open_t(fnmGame);
 
+  // [Cecil] Unpack compressed game state into memory
+  CTMemoryStream strmUnpacked;
+  CTStream *pstrmGame = &strmFile;
+
+  if (strmFile.PeekID_t() == CChunkID("GAMZ")) {
+    UnpackSavedGame_t(strmFile, strmUnpacked);
+    pstrmGame = &strmUnpacked;
+  }
+
   // if starting in network
   if (_cmiComm.IsNetworkEnabled()) {
     // start gathering CRCs
@@ -1164,11 +1347,11 @@ void CNetworkLibrary::Load_t(const CTFileName &fnmGame) // throw char *
   // start the timer loop
   AddTimerHandler();
 
-  strmFile.ExpectID_t("GAME");
+  pstrmGame->ExpectID_t("GAME");
   // read session state
   try {
     ga_sesSessionState.Start_t(-1);
-    ga_sesSessionState.Read_t(&strmFile);
+    ga_sesSessionState.Read_t(pstrmGame);
     // if starting in network
     if (_cmiComm.IsNetworkEnabled()) {
       // make default state data for creating deltas
@@ -1178,7 +1361,7 @@ void CNetworkLibrary::Load_t(const CTFileName &fnmGame) // throw char *
     // players will be connected later
     ga_sesSessionState.ses_apltPlayers.Clear();
     ga_sesSessionState.ses_apltPlayers.New(NET_MAXGAMEPLAYERS);
-    strmFile.ExpectID_t("GEND");   // game end
+    pstrmGame->ExpectID_t("GEND");   // game end
   } catch(char *) {
     RemoveTimerHandler();
     ga_srvServer.Stop();
@@ -1730,6 +1913,9 @@ void CNetworkLibrary::ChangeLevel_internal(void)
     ga_sesSessionState.ses_bWaitingForServer = TRUE;
   // if server
   } else {
+    // [Cecil] Recompose status responses for the new level
+    IMasterServer::InvalidateStatus();
+
     // flush sync check buffer
     ga_srvServer.srv_ascChecks.Clear();
 
@@ -1837,9 +2023,21 @@ void CNetworkLibrary::MainLoop(void)
   // synchronize access to network
   CTSingleLock slNetwork(&ga_csNetwork, TRUE);
 
+  // [Cecil] Trace the whole loop
+  CTickTraceScope ttsMainLoop(TTE_MAINLOOP);
+
   // update network state variable (to control usage of some cvars that cannot be altered in mulit-player mode)
   _bMultiPlayer = (ga_sesSessionState.GetPlayersCount() > 1);
 
+  // [Cecil] Report a game that couldn't be saved in the background as soon as it's done
+  if (_pjgSaves != NULL && _pjgSaves->IsDone()) {
+    try {
+      FinishSaving_t();
+    } catch (char *strError) {
+      CPrintF("%s\n", strError);
+    }
+  }
+
   // if should change world
   if (_lphCurrent==LCP_SIGNALLED) {
     // really do the level change here
@@ -266,6 +266,8 @@ public:
   void Save_t(const CTFileName &fnmGame); // throw char *
   /* Load the game. */
   void Load_t(const CTFileName &fnmGame); // throw char *
+  // [Cecil] Wait until all games that are being saved in the background are written
+  void FinishSaving_t(void); // throw char *
 
   /* Save a debugging game. */
   void DebugSave(void);   // this doesn't throw anything
@@ -17,6 +17,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Network/NetworkMessage.h>
 #include <Engine/Network/Compression.h>
+#include <Engine/Network/CPacket.h> // [Cecil]
 
 #include <Engine/Math/Functions.h>
 #include <Engine/Base/CRC.h>
@@ -67,11 +68,18 @@ CNetworkMessage::CNetworkMessage(void)
   nm_pubPointer = NULL;
   nm_iBit = -1;
   nm_slSize = -1;
+
+  // [Cecil] Not reading from any packet
+  nm_ppaPayload = NULL;
+  nm_pubOwnMessage = NULL;
 }
 
 // reinit a message that is to be sent (to write different contents)
 void CNetworkMessage::Reinit(void)
 {
+  // [Cecil] Write into own buffer
+  ReleasePayload();
+
   // init read/write pointer and size
   nm_slMaxSize = MAX_NETWORKMESSAGE_SIZE;
   nm_pubPointer = nm_pubMessage;
@@ -96,6 +104,10 @@ CNetworkMessage::CNetworkMessage(MESSAGETYPE mtType)
   nm_iBit = 0;
   nm_slSize = 0;
 
+  // [Cecil] Not reading from any packet
+  nm_ppaPayload = NULL;
+  nm_pubOwnMessage = NULL;
+
   // remember the type
   nm_mtType = mtType;
   // write the type
@@ -109,13 +121,24 @@ CNetworkMessage::CNetworkMessage(const CNetworkMessage &nmOriginal)
   nm_slMaxSize = nmOriginal.nm_slMaxSize;
   nm_pubMessage = (UBYTE*) AllocMemory(nm_slMaxSize);
 
+  // [Cecil] Share the packet with the original
+  nm_ppaPayload = NULL;
+  nm_pubOwnMessage = NULL;
+
+  if (nmOriginal.nm_ppaPayload != NULL) {
+    nmOriginal.nm_ppaPayload->AddReference();
+    SetPayload(nmOriginal.nm_ppaPayload);
+  }
+
   // init read/write pointer and size
   nm_pubPointer = nm_pubMessage + (nmOriginal.nm_pubPointer-nmOriginal.nm_pubMessage);
   nm_iBit = nmOriginal.nm_iBit;
   nm_slSize = nmOriginal.nm_slSize;
 
   // copy from original
-  memcpy(nm_pubMessage, nmOriginal.nm_pubMessage, nm_slSize);
+  if (nm_ppaPayload == NULL) { // [Cecil]
+    memcpy(nm_pubMessage, nmOriginal.nm_pubMessage, nm_slSize);
+  }
 
   // remember the type
   nm_mtType = nmOriginal.nm_mtType;
@@ -123,6 +146,19 @@ CNetworkMessage::CNetworkMessage(const CNetworkMessage &nmOriginal)
 
 void CNetworkMessage::operator=(const CNetworkMessage &nmOriginal)
 {
+  // [Cecil] Stop reading from the previous packet
+  ReleasePayload();
+
+  // [Cecil] Share the packet with the original
+  if (nmOriginal.nm_ppaPayload != NULL) {
+    nmOriginal.nm_ppaPayload->AddReference();
+    SetPayload(nmOriginal.nm_ppaPayload);
+
+    nm_pubPointer = nm_pubMessage+sizeof(UBYTE);
+    nm_mtType = nmOriginal.nm_mtType;
+    return;
+  }
+
   if (nm_slMaxSize != nmOriginal.nm_slMaxSize) {
     if (nm_pubMessage!=NULL) {
       FreeMemory(nm_pubMessage);
@@ -150,12 +186,47 @@ void CNetworkMessage::operator=(const CNetworkMessage &nmOriginal)
  */
 CNetworkMessage::~CNetworkMessage(void)
 {
+  // [Cecil] Free own buffer
+  ReleasePayload();
+
   ASSERT(nm_pubMessage!=NULL);
   if (nm_pubMessage!=NULL) {
     FreeMemory(nm_pubMessage);
   }
 }
 
+// [Cecil] Read the message straight from a received packet (takes over one reference of it)
+void CNetworkMessage::SetPayload(CPacket *ppa)
+{
+  ReleasePayload();
+
+  nm_ppaPayload = ppa;
+  nm_pubOwnMessage = nm_pubMessage;
+
+  // Payload goes right after the packet header
+  nm_pubMessage = ppa->pa_pubPacketData + MAX_HEADER_SIZE;
+  nm_slSize = ppa->pa_slSize - MAX_HEADER_SIZE;
+  nm_pubPointer = nm_pubMessage;
+  nm_iBit = 0;
+}
+
+// [Cecil] Stop reading from the packet and switch back to own message buffer
+void CNetworkMessage::ReleasePayload(void)
+{
+  if (nm_ppaPayload == NULL) return;
+
+  nm_ppaPayload->RemReference();
+  nm_ppaPayload = NULL;
+
+  nm_pubMessage = nm_pubOwnMessage;
+  nm_pubOwnMessage = NULL;
+
+  // Contents of the packet are gone
+  nm_pubPointer = nm_pubMessage;
+  nm_iBit = 0;
+  nm_slSize = 0;
+}
+
 /*
  * Ignore the contents of this message.
  */
@@ -273,6 +344,9 @@ void CNetworkMessage::InsertSubMessage(const CNetworkMessage &nmSubMessage)
  */
 void CNetworkMessage::ExtractSubMessage(CNetworkMessage &nmSubMessage)
 {
+  // [Cecil] Read into own buffer
+  nmSubMessage.ReleasePayload();
+
   // read sub-message size
   operator>>(nmSubMessage.nm_slSize);
   // read the contents of the sub-message
@@ -421,6 +495,9 @@ void CNetworkMessage::Dump(void)
 // shrink message buffer to exactly fit contents
 void CNetworkMessage::Shrink(void)
 {
+  // [Cecil] Packet payload cannot be reallocated
+  ASSERT(nm_ppaPayload == NULL);
+
   // remember original pointer offset
   SLONG slOffset = nm_pubPointer-nm_pubMessage;
   // allocate message buffer
@@ -575,6 +652,9 @@ void CNetworkStreamBlock::Write_t(CTStream &strm) // throw char *
 }
 void CNetworkStreamBlock::Read_t(CTStream &strm) // throw char *
 {
+  // [Cecil] Read into own buffer
+  ReleasePayload();
+
   // read sequence number
   strm>>nsb_iSequenceNumber;
   // read block size
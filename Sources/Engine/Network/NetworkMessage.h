@@ -124,6 +124,10 @@ public:
   UBYTE *nm_pubPointer;       // pointer for reading/writing message
   SLONG nm_slSize;            // size of message
   INDEX nm_iBit;              // next bit index to read/write (0 if not reading/writing bits)
+
+  // [Cecil] Received packet whose payload is being read in place of the message buffer
+  class CPacket *nm_ppaPayload;
+  UBYTE *nm_pubOwnMessage; // own message buffer while reading from the packet
 public:
   /* Constructor for empty message (for receiving). */
   CNetworkMessage(void);
@@ -137,6 +141,11 @@ public:
   // reinit a message that is to be sent (to write different contents)
   void Reinit(void);
 
+  // [Cecil] Read the message straight from a received packet (takes over one reference of it)
+  void SetPayload(class CPacket *ppa);
+  // [Cecil] Stop reading from the packet and switch back to own message buffer
+  void ReleasePayload(void);
+
   /* Ignore the contents of this message. */
   void IgnoreContents(void);
   // dump message to console
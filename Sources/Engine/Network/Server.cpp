@@ -35,6 +35,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/CRC.h>
 #include <Engine/Base/ErrorTable.h>
 #include <Engine/Query/MasterServer.h> // [Cecil]
+#include <Engine/Network/TickTrace.h> // [Cecil]
+#include <Engine/Base/WorkerThreads.h> // [Cecil]
 
 #include <Engine/Templates/StaticArray.cpp>
 
@@ -372,33 +374,11 @@ INDEX CServer::FindSyncCheck(TICK tckTick, CSyncCheck &sc)
   }
 }
 
-/* Send one regular batch of sequences to a client. */
-void CServer::SendGameStreamBlocks(INDEX iClient)
+// [Cecil] Pack as many stream blocks after the last sent sequence as the byte limits allow
+// (only reads the stream, so it can be done for multiple clients at once)
+static INDEX PackStreamBlocks(CNetworkStream &ns, INDEX iLastSent, INDEX ctMinBytes, INDEX ctMaxBytes,
+  CNetworkMessage &nmPackedBlocks, INDEX &iMaxSent)
 {
-  // get corresponding session socket
-  CSessionSocket &sso = srv_assoSessions[iClient];
-
-  // gather needed data to decide what to send
-  INDEX iLastSent = sso.sso_iLastSentSequence;
-  INDEX ctMinBytes = sso.sso_sspParams.ssp_iMinBPS/20;
-  INDEX ctMaxBytes = sso.sso_sspParams.ssp_iMaxBPS/20;
-  // make sure outgoing message doesn't overflow UDP size
-  ctMinBytes = Clamp(ctMinBytes, 0L, 1000L);
-  ctMaxBytes = Clamp(ctMaxBytes, 0L, 1000L);
-  // limit the clients BPS by server's local settings
-  extern INDEX ser_iMaxAllowedBPS;
-  ctMinBytes = ClampUp(ctMinBytes, (INDEX) ( ser_iMaxAllowedBPS/20L - MAX_HEADER_SIZE));
-  ctMaxBytes = ClampUp(ctMaxBytes, (INDEX) (ser_iMaxAllowedBPS/20L - MAX_HEADER_SIZE));
-
-  // prevent server/singleplayer from flooding itself
-  extern INDEX cli_bPredictIfServer;
-  if (iClient==0 && !cli_bPredictIfServer) {
-    ctMinBytes = 0;
-    ctMaxBytes = 1E6;
-  }
-
-//  CPrintF("Send%d(%d, %d, %d): ", iClient, iLastSent, ctMinBytes, ctMaxBytes);
-
   // start after last sequence that was sent and go upwards
   INDEX iSequence = iLastSent+1;
   INDEX iStep = +1;
@@ -406,13 +386,11 @@ void CServer::SendGameStreamBlocks(INDEX iClient)
 
   // initialize the message that is to be sent
   CNetworkMessage nmGameStreamBlocks(MSG_GAMESTREAMBLOCKS);
-  // get one message for last compressed message of valid size
-  CNetworkMessage nmPackedBlocks(MSG_GAMESTREAMBLOCKS);
   CNetworkMessage nmPackedBlocksNew(MSG_GAMESTREAMBLOCKS);
 
   // repeat for max 100 sequences
   INDEX iBlocksOk = 0;
-  INDEX iMaxSent = -1;
+  iMaxSent = -1;
   for(INDEX i=0; i<100; i++) {
     if (iStep<0 && iBlocksOk>=3) {
 //      break;
@@ -420,7 +398,7 @@ void CServer::SendGameStreamBlocks(INDEX iClient)
     // get the stream block with current sequence
 //    CPrintF("%d: ", iSequence);
     CNetworkStreamBlock *pnsbBlock;
-    CNetworkStream::Result res = sso.sso_nsBuffer.GetBlockBySequence(iSequence, pnsbBlock);
+    CNetworkStream::Result res = ns.GetBlockBySequence(iSequence, pnsbBlock);
     // if it is not found
     if (res!=CNetworkStream::E_NSR_OK) {
       // if going upward
@@ -476,6 +454,61 @@ void CServer::SendGameStreamBlocks(INDEX iClient)
     iBlocksOk++;
   }
 
+  return iBlocksOk;
+};
+
+// [Cecil] Get byte limits of one batch of sequences for a client
+void CServer::GetGameStreamLimits(INDEX iClient, INDEX &ctMinBytes, INDEX &ctMaxBytes)
+{
+  // get corresponding session socket
+  CSessionSocket &sso = srv_assoSessions[iClient];
+
+  // gather needed data to decide what to send
+  ctMinBytes = sso.sso_sspParams.ssp_iMinBPS/20;
+  ctMaxBytes = sso.sso_sspParams.ssp_iMaxBPS/20;
+  // make sure outgoing message doesn't overflow UDP size
+  ctMinBytes = Clamp(ctMinBytes, 0L, 1000L);
+  ctMaxBytes = Clamp(ctMaxBytes, 0L, 1000L);
+  // limit the clients BPS by server's local settings
+  extern INDEX ser_iMaxAllowedBPS;
+  ctMinBytes = ClampUp(ctMinBytes, (INDEX) ( ser_iMaxAllowedBPS/20L - MAX_HEADER_SIZE));
+  ctMaxBytes = ClampUp(ctMaxBytes, (INDEX) (ser_iMaxAllowedBPS/20L - MAX_HEADER_SIZE));
+
+  // prevent server/singleplayer from flooding itself
+  extern INDEX cli_bPredictIfServer;
+  if (iClient==0 && !cli_bPredictIfServer) {
+    ctMinBytes = 0;
+    ctMaxBytes = 1E6;
+  }
+};
+
+// [Cecil] Pack one regular batch of sequences for a client
+INDEX CServer::PackGameStreamBlocks(INDEX iClient, CNetworkMessage &nmPacked, INDEX &iMaxSent)
+{
+  INDEX ctMinBytes, ctMaxBytes;
+  GetGameStreamLimits(iClient, ctMinBytes, ctMaxBytes);
+
+  CSessionSocket &sso = srv_assoSessions[iClient];
+  return PackStreamBlocks(sso.sso_nsBuffer, sso.sso_iLastSentSequence, ctMinBytes, ctMaxBytes, nmPacked, iMaxSent);
+};
+
+/* Send one regular batch of sequences to a client. */
+void CServer::SendGameStreamBlocks(INDEX iClient)
+{
+  // [Cecil] Pack and send right away
+  CNetworkMessage nmPackedBlocks(MSG_GAMESTREAMBLOCKS);
+  INDEX iMaxSent = -1;
+  const INDEX iBlocksOk = PackGameStreamBlocks(iClient, nmPackedBlocks, iMaxSent);
+
+  SendPackedGameStreamBlocks(iClient, nmPackedBlocks, iBlocksOk, iMaxSent);
+};
+
+// [Cecil] Send a batch of sequences that has been packed for a client
+void CServer::SendPackedGameStreamBlocks(INDEX iClient, CNetworkMessage &nmPackedBlocks, INDEX iBlocksOk, INDEX iMaxSent)
+{
+  // get corresponding session socket
+  CSessionSocket &sso = srv_assoSessions[iClient];
+
   // if no blocks to write
   if (iBlocksOk<=0) {
     // if not sent anything for some time
@@ -524,6 +557,46 @@ void CServer::SendGameStreamBlocks(INDEX iClient)
   }
 }
 
+// [Cecil] Batch of sequences packed for one client on a worker thread
+struct StreamPackJob {
+  CServer *spj_pServer;
+  INDEX spj_iClient;
+  CNetworkMessage spj_nmPacked;
+  INDEX spj_iBlocksOk;
+  INDEX spj_iMaxSent;
+
+  StreamPackJob() : spj_pServer(NULL), spj_iClient(-1), spj_nmPacked(MSG_GAMESTREAMBLOCKS), spj_iBlocksOk(0), spj_iMaxSent(-1) {};
+};
+
+static void PackStreamJob(void *pData, INDEX iItem) {
+  StreamPackJob &spj = ((StreamPackJob *)pData)[iItem];
+
+  const CTimerValue tvTrace = TickTrace_Begin();
+  spj.spj_iBlocksOk = spj.spj_pServer->PackGameStreamBlocks(spj.spj_iClient, spj.spj_nmPacked, spj.spj_iMaxSent);
+  TickTrace_End(TTE_SENDCLIENT, tvTrace, spj.spj_iClient);
+};
+
+// [Cecil] Pack batches for all given clients on worker threads and send them in the same order
+void CServer::SendGameStreamBlocksParallel(const INDEX *aiClients, INDEX ctClients)
+{
+  // Packing only reads the session streams, so each client can be packed independently
+  CStaticArray<StreamPackJob> aJobs;
+  aJobs.New(ctClients);
+
+  for (INDEX i = 0; i < ctClients; i++) {
+    aJobs[i].spj_pServer = this;
+    aJobs[i].spj_iClient = aiClients[i];
+  }
+
+  ParallelFor(ctClients, &PackStreamJob, &aJobs[0]);
+
+  // Sending and updating the sessions is done on this thread, so the result is identical to sending one by one
+  for (INDEX i = 0; i < ctClients; i++) {
+    StreamPackJob &spj = aJobs[i];
+    SendPackedGameStreamBlocks(spj.spj_iClient, spj.spj_nmPacked, spj.spj_iBlocksOk, spj.spj_iMaxSent);
+  }
+};
+
 /* Resend a batch of game stream blocks to a client. */
 void CServer::ResendGameStreamBlocks(INDEX iClient, INDEX iSequence0, INDEX ctSequences)
 {
@@ -721,6 +794,7 @@ void CServer::ServerLoop(void)
   }
 
   _pfNetworkProfile.StartTimer(CNetworkProfile::PTI_SERVER_LOOP);
+  CTickTraceScope ttsServerLoop(TTE_SERVERLOOP); // [Cecil]
 
 //  try {
 //    _cmiComm.Server_Accept_t();
@@ -751,19 +825,39 @@ void CServer::ServerLoop(void)
       // for each tick
       for( INDEX i=0; i<iSpeed; i++) {
         // make allaction messages for one tick
+        const CTimerValue tvTrace = TickTrace_Begin(); // [Cecil]
         MakeAllActions();
+        TickTrace_End(TTE_MAKEACTIONS, tvTrace, (INDEX)srv_tckLastProcessedTick); // [Cecil]
       }
     }
   }
 
+  // [Cecil] Gather active sessions
+  INDEX aiSessions[NET_MAXGAMECOMPUTERS];
+  INDEX ctSessions = 0;
+
   // for each active session
   for(INDEX iSession=0; iSession<srv_assoSessions.Count(); iSession++) {
     CSessionSocket &sso = srv_assoSessions[iSession];
     if (iSession>0 && (!sso.IsActive() || !sso.sso_bSendStream)) {
       continue;
     }
-    // send one regular batch of sequences to the client
-    SendGameStreamBlocks(iSession);
+    aiSessions[ctSessions++] = iSession;
+  }
+
+  // [Cecil] Pack batches for multiple clients at once
+  extern INDEX ser_bParallelStreams;
+
+  if (ser_bParallelStreams && ctSessions > 1 && GetWorkerThreadCount() > 0) {
+    SendGameStreamBlocksParallel(aiSessions, ctSessions);
+
+  } else {
+    for (INDEX i = 0; i < ctSessions; i++) {
+      // send one regular batch of sequences to the client
+      const CTimerValue tvTrace = TickTrace_Begin(); // [Cecil]
+      SendGameStreamBlocks(aiSessions[i]);
+      TickTrace_End(TTE_SENDCLIENT, tvTrace, aiSessions[i]); // [Cecil]
+    }
   }
 
   _pfNetworkProfile.StopTimer(CNetworkProfile::PTI_SERVER_LOOP);
@@ -1207,6 +1301,9 @@ void CServer::HandleClientDisconected(INDEX iClient)
     }
     iPlayer++;
   }
+
+  // [Cecil] Recompose status responses without these players
+  IMasterServer::InvalidateStatus();
 }
 
 // split the rcon response string into lines and send one by one to the client
@@ -1621,3 +1718,131 @@ void CServer::Handle(INDEX iClient, CNetworkMessage &nmMessage)
     ASSERT(FALSE);
   }
 }
+
+// [Cecil] Fake client for the stream packing benchmark
+struct FakeStreamClient {
+  CNetworkStream fsc_ns;      // stream of blocks for this client
+  INDEX fsc_iLastSent;        // last sent sequence
+  CClientInterface fsc_ciServer; // server side of the loopback
+  CClientInterface fsc_ciClient; // client side of the loopback
+
+  CNetworkMessage fsc_nmSerial;   // batch packed on the main thread
+  CNetworkMessage fsc_nmParallel; // batch packed on a worker thread
+  INDEX fsc_iBlocksOk;
+  INDEX fsc_iMaxSent;
+
+  FakeStreamClient() : fsc_iLastSent(0), fsc_nmSerial(MSG_GAMESTREAMBLOCKS), fsc_nmParallel(MSG_GAMESTREAMBLOCKS),
+    fsc_iBlocksOk(0), fsc_iMaxSent(-1) {};
+};
+
+static INDEX _ctFakeMinBytes = 0;
+static INDEX _ctFakeMaxBytes = 0;
+
+static void PackFakeStreamJob(void *pData, INDEX iItem) {
+  FakeStreamClient &fsc = ((FakeStreamClient *)pData)[iItem];
+  fsc.fsc_nmParallel.Reinit();
+  fsc.fsc_iBlocksOk = PackStreamBlocks(fsc.fsc_ns, fsc.fsc_iLastSent, _ctFakeMinBytes, _ctFakeMaxBytes, fsc.fsc_nmParallel, fsc.fsc_iMaxSent);
+};
+
+// [Cecil] Compare packing of game stream batches for fake clients one by one and on worker threads
+// and deliver the batches over loopback interfaces
+void BenchmarkStreamPacking(void *pArgs) {
+  INDEX ctClients = NEXTARGUMENT(INDEX);
+  INDEX ctTicks = NEXTARGUMENT(INDEX);
+  if (ctClients <= 0) ctClients = NET_MAXGAMECOMPUTERS;
+  if (ctTicks <= 0) ctTicks = 1000;
+
+  // Use the same limits as regular remote clients
+  extern INDEX ser_iMaxAllowedBPS;
+  _ctFakeMaxBytes = ClampUp(1000L, (INDEX)(ser_iMaxAllowedBPS / 20L - MAX_HEADER_SIZE));
+  _ctFakeMinBytes = _ctFakeMaxBytes / 2;
+
+  CStaticArray<FakeStreamClient> aClients;
+  aClients.New(ctClients);
+
+  for (INDEX iClient = 0; iClient < ctClients; iClient++) {
+    aClients[iClient].fsc_ciServer.SetLocal(&aClients[iClient].fsc_ciClient);
+    aClients[iClient].fsc_ciClient.SetLocal(&aClients[iClient].fsc_ciServer);
+  }
+
+  CTimerValue tvSerial((SQUAD)0), tvParallel((SQUAD)0);
+  INDEX ctMismatches = 0, ctSent = 0, ctDelivered = 0;
+  SQUAD llBytes = 0;
+  ULONG ulRandom = 0x12345678;
+
+  UBYTE aubReceived[MAX_UDP_BLOCK_SIZE];
+
+  for (INDEX iTick = 1; iTick <= ctTicks; iTick++) {
+    // Add one all-actions block with a few players to each client stream
+    for (INDEX iClient = 0; iClient < ctClients; iClient++) {
+      CNetworkStreamBlock nsb(MSG_SEQ_ALLACTIONS, iTick);
+      nsb << (ULONG)iTick;
+
+      for (INDEX iPlayer = 0; iPlayer < 4; iPlayer++) {
+        // Mostly repeating button states with some changing movement
+        ulRandom = ulRandom * 1103515245UL + 12345UL;
+        nsb << (ULONG)iPlayer << (ULONG)(ulRandom & 0xFF) << (ULONG)(ulRandom >> 16);
+      }
+
+      aClients[iClient].fsc_ns.AddBlock(nsb);
+    }
+
+    // Pack batches one by one
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+    for (INDEX iClient = 0; iClient < ctClients; iClient++) {
+      FakeStreamClient &fsc = aClients[iClient];
+      INDEX iMaxSent;
+      fsc.fsc_nmSerial.Reinit();
+      PackStreamBlocks(fsc.fsc_ns, fsc.fsc_iLastSent, _ctFakeMinBytes, _ctFakeMaxBytes, fsc.fsc_nmSerial, iMaxSent);
+    }
+
+    tvSerial += _pTimer->GetHighPrecisionTimer() - tvStart;
+
+    // Pack the same batches on worker threads
+    tvStart = _pTimer->GetHighPrecisionTimer();
+    ParallelFor(ctClients, &PackFakeStreamJob, &aClients[0]);
+    tvParallel += _pTimer->GetHighPrecisionTimer() - tvStart;
+
+    // Send parallel batches over loopback and compare them with serial ones
+    for (INDEX iClient = 0; iClient < ctClients; iClient++) {
+      FakeStreamClient &fsc = aClients[iClient];
+      if (fsc.fsc_iBlocksOk <= 0) continue;
+
+      const CNetworkMessage &nmSerial = fsc.fsc_nmSerial;
+      const CNetworkMessage &nmParallel = fsc.fsc_nmParallel;
+
+      if (nmSerial.nm_slSize != nmParallel.nm_slSize
+       || memcmp(nmSerial.nm_pubMessage, nmParallel.nm_pubMessage, nmSerial.nm_slSize) != 0) {
+        ctMismatches++;
+      }
+
+      if (nmParallel.nm_slSize < MAX_UDP_BLOCK_SIZE) {
+        fsc.fsc_ciServer.Send(nmParallel.nm_pubMessage, nmParallel.nm_slSize, FALSE);
+        fsc.fsc_ciServer.ExchangeBuffers();
+        ctSent++;
+
+        SLONG slReceived = MAX_UDP_BLOCK_SIZE;
+
+        while (fsc.fsc_ciClient.Receive(aubReceived, slReceived, FALSE)) {
+          if (slReceived == nmParallel.nm_slSize && memcmp(aubReceived, nmParallel.nm_pubMessage, slReceived) == 0) {
+            ctDelivered++;
+            llBytes += slReceived;
+          }
+          slReceived = MAX_UDP_BLOCK_SIZE;
+        }
+      }
+
+      // Acknowledge and forget old blocks
+      fsc.fsc_iLastSent = Max(fsc.fsc_iLastSent, fsc.fsc_iMaxSent);
+      fsc.fsc_ns.RemoveOlderBlocksBySequence(iTick - 32);
+    }
+  }
+
+  const DOUBLE dSerial = tvSerial.GetSeconds() * 1000.0 / ctTicks;
+  const DOUBLE dParallel = tvParallel.GetSeconds() * 1000.0 / ctTicks;
+
+  CPrintF(TRANS("Packed batches for %d clients over %d ticks using %d worker threads\n"), ctClients, ctTicks, GetWorkerThreadCount());
+  CPrintF(TRANS("  serial: %.3f ms/tick, parallel: %.3f ms/tick (%.2fx)\n"), dSerial, dParallel, dSerial / ClampDn(dParallel, 1e-9));
+  CPrintF(TRANS("  %d mismatching batches, %d of %d batches delivered (%.0f bytes)\n"), ctMismatches, ctDelivered, ctSent, (DOUBLE)llBytes);
+};
@@ -70,6 +70,14 @@ public:
 
   /* Send one regular batch of sequences to a client. */
   void SendGameStreamBlocks(INDEX iClient);
+  // [Cecil] Get byte limits of one batch of sequences for a client
+  void GetGameStreamLimits(INDEX iClient, INDEX &ctMinBytes, INDEX &ctMaxBytes);
+  // [Cecil] Pack one regular batch of sequences for a client (returns number of packed blocks)
+  INDEX PackGameStreamBlocks(INDEX iClient, CNetworkMessage &nmPacked, INDEX &iMaxSent);
+  // [Cecil] Send a batch of sequences that has been packed for a client
+  void SendPackedGameStreamBlocks(INDEX iClient, CNetworkMessage &nmPackedBlocks, INDEX iBlocksOk, INDEX iMaxSent);
+  // [Cecil] Pack batches for all given clients on worker threads and send them in the same order
+  void SendGameStreamBlocksParallel(const INDEX *aiClients, INDEX ctClients);
   /* Resend a batch of game stream blocks to a client. */
   void ResendGameStreamBlocks(INDEX iClient, INDEX iSequence0, INDEX ctSequences);
 
@@ -31,6 +31,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Network/PlayerTarget.h>
 #include <Engine/Network/NetworkProfile.h>
 #include <Engine/World/PhysicsProfile.h>
+#include <Engine/Base/Statistics_internal.h> // [Cecil]
+#include <Engine/Network/TickTrace.h> // [Cecil]
 #include <Engine/Network/CommunicationInterface.h>
 #include <Engine/Network/Compression.h>
 #include <Engine/Entities/InternalClasses.h>
@@ -904,6 +906,8 @@ void CSessionState::ProcessGameTick(CNetworkMessage &nmMessage, TICK tckCurrentT
   ses_tckLastPredictionProcessed = -1;
 
   _pfPhysicsProfile.StartTimer(CPhysicsProfile::PTI_PROCESSGAMETICK);
+  _sfStats.StartTimer(CStatForm::STI_GAMETICK); // [Cecil]
+  const CTimerValue tvTraceTick = TickTrace_Begin(); // [Cecil]
 
 #if DEBUG_SYNCSTREAMDUMPING
   try
@@ -930,6 +934,8 @@ void CSessionState::ProcessGameTick(CNetworkMessage &nmMessage, TICK tckCurrentT
   ses_bAllowRandom = TRUE;
 
   _pfPhysicsProfile.StartTimer(CPhysicsProfile::PTI_APPLYACTIONS);
+  CTimerValue tvTrace = TickTrace_Begin(); // [Cecil]
+
   // for all clients
   INDEX iClient = 0;
   FOREACHINSTATICARRAY(ses_apltPlayers, CPlayerTarget, itplt) {
@@ -955,15 +961,28 @@ void CSessionState::ProcessGameTick(CNetworkMessage &nmMessage, TICK tckCurrentT
   }
   cli_bEmulateDesync = FALSE;
 
+  // [Cecil] Trace parts of the tick
+  TickTrace_End(TTE_APPLYACTIONS, tvTrace);
+  tvTrace = TickTrace_Begin();
+
   // handle all the sent events
   CEntity::HandleSentEvents();
   _pfPhysicsProfile.StopTimer(CPhysicsProfile::PTI_APPLYACTIONS);
 
+  TickTrace_End(TTE_SENTEVENTS, tvTrace); // [Cecil]
+  tvTrace = TickTrace_Begin(); // [Cecil]
+
   // do thinking
   HandleTimers(tckCurrentTick);
+
+  TickTrace_End(TTE_TIMERS, tvTrace); // [Cecil]
+  tvTrace = TickTrace_Begin(); // [Cecil]
+
   // do physics
   HandleMovers();
 
+  TickTrace_End(TTE_MOVERS, tvTrace); // [Cecil]
+
   // notify all entities of level change as needed
   if (_lphCurrent==LCP_INITIATED) {
     EPreLevelChange ePreChange;
@@ -981,6 +1000,8 @@ void CSessionState::ProcessGameTick(CNetworkMessage &nmMessage, TICK tckCurrentT
   }
 
   _pfPhysicsProfile.StartTimer(CPhysicsProfile::PTI_WORLDBASETICK);
+  tvTrace = TickTrace_Begin(); // [Cecil]
+
   // let the worldbase execute its tick function
   if (_pNetwork->ga_pWorld->wo_pecWorldBaseClass!=NULL
     &&_pNetwork->ga_pWorld->wo_pecWorldBaseClass->ec_pdecDLLClass!=NULL
@@ -992,6 +1013,8 @@ void CSessionState::ProcessGameTick(CNetworkMessage &nmMessage, TICK tckCurrentT
   CEntity::HandleSentEvents();
   _pfPhysicsProfile.StopTimer(CPhysicsProfile::PTI_WORLDBASETICK);
 
+  TickTrace_End(TTE_WORLDBASETICK, tvTrace); // [Cecil]
+
   // make sync-check and send to server if needed
   MakeSynchronisationCheck();
 
@@ -1006,6 +1029,8 @@ void CSessionState::ProcessGameTick(CNetworkMessage &nmMessage, TICK tckCurrentT
 
   ses_tckPredictionHeadTick = Max(ses_tckPredictionHeadTick, tckCurrentTick);
 
+  TickTrace_End(TTE_GAMETICK, tvTraceTick, (INDEX)tckCurrentTick); // [Cecil]
+  _sfStats.StopTimer(CStatForm::STI_GAMETICK); // [Cecil]
   _pfPhysicsProfile.StopTimer(CPhysicsProfile::PTI_PROCESSGAMETICK);
 
   // assure that FPU precision was low all the rendering time
@@ -0,0 +1,229 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#include "StdH.h"
+
+#include <Engine/Network/TickTrace.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Synchronization.h>
+#include <Engine/Base/WorkerThreads.h>
+
+INDEX net_bTraceTicks = TRUE;
+FLOAT net_fTraceSpikeMS = 100.0f; // Dump the trace if some frame or tick takes this long (0 - never)
+
+// Amount of the last events that are kept (must be a power of two)
+#define TRACE_EVENTS (1 << 14)
+
+// Don't dump spikes more often than this
+#define SPIKE_DUMP_COOLDOWN (10.0)
+
+// One finished event
+struct TickTraceRecord {
+  SQUAD ttr_llStart;
+  SQUAD ttr_llDuration;
+  INDEX ttr_iArg;
+  UBYTE ttr_ubEvent;
+  UBYTE ttr_ubThread;
+};
+
+static TickTraceRecord _attrEvents[TRACE_EVENTS];
+static ULONG _ulNextEvent = 0; // Total amount of recorded events
+static CTCriticalSection _csTrace;
+
+// Threads that have recorded events
+static INDEX _ctThreads = 0;
+static SE1_THREADLOCAL INDEX _iThisThread = -1;
+
+// Spikes waiting to be dumped (guarded by the trace lock)
+static BOOL _bSpikePending = FALSE;
+static CTimerValue _tvLastSpikeDump(SQUAD(-1));
+static INDEX _iSpikeDump = 0;
+
+// Events copied out of the ring buffer to be written into a file
+struct TickTraceDump {
+  CStaticArray<TickTraceRecord> ttd_attr;
+  CTString ttd_strFile;
+};
+
+static CJobGroup *_pjgDumps = NULL; // Jobs for writing traces (guarded by the trace lock)
+
+static const char *_astrEventNames[TTE_MAX] = {
+  "ServerFrame",
+  "MainLoop",
+  "ServerLoop",
+  "GameTick",
+  "ApplyActions",
+  "SentEvents",
+  "Timers",
+  "Movers",
+  "WorldBaseTick",
+  "MakeAllActions",
+  "SendClient",
+  "PacketIO",
+};
+
+// Check if the event can contain spikes worth reporting
+static inline BOOL IsSpikeEvent(TickTraceEvent eEvent) {
+  return eEvent <= TTE_GAMETICK;
+};
+
+// Check if the spike can be dumped and return its number (must be called under the trace lock)
+static INDEX StartSpikeDump(void) {
+  const CTimerValue tvNow = _pTimer->GetHighPrecisionTimer();
+
+  if (_tvLastSpikeDump.tv_llValue >= 0 && (tvNow - _tvLastSpikeDump).GetSeconds() < SPIKE_DUMP_COOLDOWN) {
+    return -1;
+  }
+
+  _tvLastSpikeDump = tvNow;
+  return _iSpikeDump++;
+};
+
+// Dump the trace after a spike once the outermost loop is over
+static void DumpSpike(INDEX iSpikeDump) {
+  const CTString strFile = ExpandPath::ToTemp(CTString(0, "TickSpike%02d.json", iSpikeDump));
+
+  CPrintF(TRANS("Tick took longer than %g ms, saving trace into '%s'\n"), net_fTraceSpikeMS, strFile.ConstData());
+  TickTrace_Dump(strFile);
+};
+
+void TickTrace_Record(TickTraceEvent eEvent, const CTimerValue &tvStart, INDEX iArg) {
+  const CTimerValue tvDuration = _pTimer->GetHighPrecisionTimer() - tvStart;
+  INDEX iSpikeDump = -1;
+
+  {
+    CTSingleLock slTrace(&_csTrace, TRUE);
+
+    if (_iThisThread < 0) {
+      _iThisThread = _ctThreads++;
+    }
+
+    TickTraceRecord &ttr = _attrEvents[_ulNextEvent & (TRACE_EVENTS - 1)];
+    ttr.ttr_llStart = tvStart.tv_llValue;
+    ttr.ttr_llDuration = tvDuration.tv_llValue;
+    ttr.ttr_iArg = iArg;
+    ttr.ttr_ubEvent = (UBYTE)eEvent;
+    ttr.ttr_ubThread = (UBYTE)_iThisThread;
+    _ulNextEvent++;
+
+    if (net_fTraceSpikeMS > 0.0f && IsSpikeEvent(eEvent)
+     && CTimerValue(tvDuration).GetSeconds() * 1000.0 > net_fTraceSpikeMS) {
+      _bSpikePending = TRUE;
+    }
+
+    // Dump once the loop that contains the spike is over
+    if (_bSpikePending && eEvent < TTE_GAMETICK) {
+      _bSpikePending = FALSE;
+      iSpikeDump = StartSpikeDump();
+    }
+  }
+
+  if (iSpikeDump >= 0) DumpSpike(iSpikeDump);
+};
+
+// Write copied events into a file
+static void WriteEvents_t(const CStaticArray<TickTraceRecord> &attr, const CTString &fnmFile) {
+  const INDEX ctEvents = attr.Count();
+
+  // Times are relative to the oldest event
+  const SQUAD llBase = attr[0].ttr_llStart;
+
+  CTFileStream strm;
+  strm.Create_t(fnmFile);
+  strm.FPrintF_t("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+  for (INDEX i = 0; i < ctEvents; i++) {
+    const TickTraceRecord &ttr = attr[i];
+    const DOUBLE dStart = CTimerValue(ttr.ttr_llStart - llBase).GetSeconds() * 1000000.0;
+    const DOUBLE dDuration = CTimerValue(ttr.ttr_llDuration).GetSeconds() * 1000000.0;
+
+    strm.FPrintF_t("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.1f,\"dur\":%.1f",
+      _astrEventNames[ttr.ttr_ubEvent], (INDEX)ttr.ttr_ubThread, dStart, dDuration);
+
+    if (ttr.ttr_iArg >= 0) {
+      const char *strArg = (ttr.ttr_ubEvent == TTE_SENDCLIENT) ? "client" : "tick";
+      strm.FPrintF_t(",\"args\":{\"%s\":%d}", strArg, ttr.ttr_iArg);
+    }
+
+    strm.FPrintF_t("}%s\n", i < ctEvents - 1 ? "," : "");
+  }
+
+  strm.FPrintF_t("]}\n");
+};
+
+static void WriteDumpJob(void *pData, INDEX iItem) {
+  TickTraceDump *pttd = (TickTraceDump *)pData;
+
+  // Console output is synchronized
+  try {
+    WriteEvents_t(pttd->ttd_attr, pttd->ttd_strFile);
+    CPrintF(TRANS("Saved tick trace into '%s'\n"), pttd->ttd_strFile.ConstData());
+
+  } catch (char *strError) {
+    CPrintF(TRANS("Cannot save tick trace: %s\n"), strError);
+  }
+
+  delete pttd;
+};
+
+void TickTrace_Dump(const CTString &fnmFile) {
+  // Copy events to avoid blocking the game while writing them
+  TickTraceDump *pttd = new TickTraceDump;
+  pttd->ttd_strFile = fnmFile;
+  {
+    CTSingleLock slTrace(&_csTrace, TRUE);
+
+    const INDEX ctEvents = Min(_ulNextEvent, (ULONG)TRACE_EVENTS);
+    if (ctEvents > 0) pttd->ttd_attr.New(ctEvents);
+
+    // From the oldest to the newest
+    const ULONG ulFirst = _ulNextEvent - ctEvents;
+
+    for (INDEX i = 0; i < ctEvents; i++) {
+      pttd->ttd_attr[i] = _attrEvents[(ulFirst + i) & (TRACE_EVENTS - 1)];
+    }
+  }
+
+  if (pttd->ttd_attr.Count() == 0) {
+    CPrintF(TRANS("Cannot save tick trace: %s\n"), TRANS("No events have been traced"));
+    delete pttd;
+    return;
+  }
+
+  // Write them in the background
+  CTSingleLock slTrace(&_csTrace, TRUE);
+
+  if (_pjgDumps == NULL) _pjgDumps = new CJobGroup;
+  _pjgDumps->Add(&WriteDumpJob, pttd, 0);
+};
+
+void TickTrace_FinishDumps(void) {
+  CJobGroup *pjgDumps = NULL;
+  {
+    CTSingleLock slTrace(&_csTrace, TRUE);
+    pjgDumps = _pjgDumps;
+    _pjgDumps = NULL;
+  }
+
+  // Wait for the files outside the lock
+  delete pjgDumps;
+};
+
+// Dump the trace on demand
+void DumpTickTrace(void) {
+  static INDEX iDump = 0;
+  TickTrace_Dump(ExpandPath::ToTemp(CTString(0, "TickTrace%02d.json", iDump++)));
+};
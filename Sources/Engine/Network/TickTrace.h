@@ -0,0 +1,85 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#ifndef SE_INCL_TICKTRACE_H
+#define SE_INCL_TICKTRACE_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#include <Engine/Base/Timer.h>
+
+// Traced parts of server frames and game ticks
+enum TickTraceEvent {
+  TTE_SERVERFRAME = 0, // one frame of the dedicated server
+  TTE_MAINLOOP,        // network main loop of the local session
+  TTE_SERVERLOOP,      // server loop that makes and sends game stream
+  TTE_GAMETICK,        // processing of one game tick (argument is the tick)
+  TTE_APPLYACTIONS,    // applying player actions
+  TTE_SENTEVENTS,      // handling events sent during the tick
+  TTE_TIMERS,          // entity thinking
+  TTE_MOVERS,          // entity movement
+  TTE_WORLDBASETICK,   // tick function of the world base class
+  TTE_MAKEACTIONS,     // making all-actions messages for one tick
+  TTE_SENDCLIENT,      // sending game stream to one client (argument is the client)
+  TTE_PACKETIO,        // sending and receiving packets over sockets
+
+  TTE_MAX,
+};
+
+// Keep recording timings of traced events
+ENGINE_API extern INDEX net_bTraceTicks;
+
+// Start timing an event (returns -1 if tracing is disabled)
+inline CTimerValue TickTrace_Begin(void) {
+  if (!net_bTraceTicks) return CTimerValue(SQUAD(-1));
+  return _pTimer->GetHighPrecisionTimer();
+};
+
+// Record a finished event in the ring buffer
+ENGINE_API void TickTrace_Record(TickTraceEvent eEvent, const CTimerValue &tvStart, INDEX iArg);
+
+// Finish timing an event that has been started by TickTrace_Begin()
+inline void TickTrace_End(TickTraceEvent eEvent, const CTimerValue &tvStart, INDEX iArg = -1) {
+  if (tvStart.tv_llValue < 0) return;
+  TickTrace_Record(eEvent, tvStart, iArg);
+};
+
+// Copy all events in the ring buffer and write them into a file in Chrome trace event format on a worker thread
+ENGINE_API void TickTrace_Dump(const CTString &fnmFile);
+
+// Wait until all traces that are being written in the background are saved
+void TickTrace_FinishDumps(void);
+
+// Times an event until the end of the scope
+class CTickTraceScope {
+  private:
+    TickTraceEvent tts_eEvent;
+    INDEX tts_iArg;
+    CTimerValue tts_tvStart;
+
+  public:
+    inline CTickTraceScope(TickTraceEvent eEvent, INDEX iArg = -1) :
+      tts_eEvent(eEvent), tts_iArg(iArg), tts_tvStart(TickTrace_Begin())
+    {
+    };
+
+    inline ~CTickTraceScope() {
+      TickTrace_End(tts_eEvent, tts_tvStart, tts_iArg);
+    };
+};
+
+#endif  /* include-once check. */
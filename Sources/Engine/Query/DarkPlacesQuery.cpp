@@ -228,24 +228,38 @@ static void ClientParsePacket(INDEX iLength) {
   }
 };
 
+// Cached info and status responses without the challenge
+static SCachedResponse _acrStatusResponses[2];
+
 // Compose status response packet
 static void ComposeStatusPacket(CTString &strPacket, const char *strChallenge, BOOL bFullStatus) {
-  const INDEX ctMaxPlayers = _pNetwork->ga_sesSessionState.ses_ctMaxPlayers;
-  const INDEX ctClients = _pNetwork->ga_srvServer.GetClientsCount();
-
-  // Compose the packet
-  strPacket.PrintF("\xFF\xFF\xFF\xFF%s\x0A"
-    "\\gamename\\%s\\modname\\%s\\gameversion\\%s"
-    "\\sv_maxclients\\%d\\clients\\%d\\bots\\%d\\mapname\\%s\\hostname\\%s\\protocol\\%d"
-    "\\qcstatus\\%s:%s:P%d:S%d:F%d:M%s::score!!",
-    // Response header
-    (bFullStatus ? "statusResponse" : "infoResponse"),
-    // Game info
-    sam_strGameName, "", _SE_VER_STRING,
-    // Server info
-    ctMaxPlayers, ctClients, 0, _pNetwork->ga_pWorld->wo_strName.ConstData(), Game_SessionName, _iProtocolVersion,
-    // Server status
-    Query_GetCurrentGameTypeName().ConstData(), "0.8.2", 0, ctMaxPlayers - ctClients, 0, sam_strGameName);
+  SCachedResponse &cr = _acrStatusResponses[bFullStatus ? 1 : 0];
+
+  // Reuse the packet if the server state hasn't changed
+  if (cr.IsValid()) {
+    strPacket = cr.strPacket;
+
+  } else {
+    const INDEX ctMaxPlayers = _pNetwork->ga_sesSessionState.ses_ctMaxPlayers;
+    const INDEX ctClients = _pNetwork->ga_srvServer.GetClientsCount();
+
+    // Compose the packet
+    cr.strPacket.PrintF("\xFF\xFF\xFF\xFF%s\x0A"
+      "\\gamename\\%s\\modname\\%s\\gameversion\\%s"
+      "\\sv_maxclients\\%d\\clients\\%d\\bots\\%d\\mapname\\%s\\hostname\\%s\\protocol\\%d"
+      "\\qcstatus\\%s:%s:P%d:S%d:F%d:M%s::score!!",
+      // Response header
+      (bFullStatus ? "statusResponse" : "infoResponse"),
+      // Game info
+      sam_strGameName, "", _SE_VER_STRING,
+      // Server info
+      ctMaxPlayers, ctClients, 0, _pNetwork->ga_pWorld->wo_strName.ConstData(), Game_SessionName, _iProtocolVersion,
+      // Server status
+      Query_GetCurrentGameTypeName().ConstData(), "0.8.2", 0, ctMaxPlayers - ctClients, 0, sam_strGameName);
+
+    cr.Validate();
+    strPacket = cr.strPacket;
+  }
 
   // Optional challenge
   if (strChallenge != NULL) {
@@ -675,12 +675,8 @@ static BOOL ReceiveServerData(SOCKET &iSocketUDP, BOOL bLocal) {
     }
 
   } else {
-    // Search for a request to clear it
-    SServerRequest *preq = SServerRequest::Find(sinClient);
-
-    if (preq != NULL) {
-      preq->Clear();
-    }
+    // Discard the request for this address
+    SServerRequest::Remove(sinClient);
   }
 
   return FALSE;
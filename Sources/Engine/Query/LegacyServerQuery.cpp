@@ -30,6 +30,11 @@ static const char *_strStatusResponseFormat =
 
 extern INDEX net_iPort;
 
+// Cached responses that only depend on the server state
+static SCachedResponse _crStatusHeader;
+static SCachedResponse _crInfo;
+static SCachedResponse _crBasic;
+
 void ILegacy::BuildHearthbeatPacket(CTString &strPacket, INDEX iChallenge) {
   strPacket.PrintF("\\heartbeat\\%hu\\gamename\\%s", (net_iPort + 1), SAM_MS_NAME);
 };
@@ -58,31 +63,37 @@ void ILegacy::ServerParsePacket(INDEX iLength) {
 
   // Status request
   if (pStatus != NULL) {
-    // Get location
-    extern CTString net_strLocalHost;
-    CTString strLocation = net_strLocalHost;
+    // Compose server part of the status response, if it's outdated
+    if (!_crStatusHeader.IsValid()) {
+      // Get location
+      extern CTString net_strLocalHost;
+      CTString strLocation = net_strLocalHost;
+
+      if (strLocation == "") {
+        strLocation = "Heartland";
+      }
 
-    if (strLocation == "") {
-      strLocation = "Heartland";
+      // Retrieve symbols once
+      const INDEX symptrFF    = _pShell->GetINDEX("gam_bFriendlyFire");
+      const INDEX symptrWeap  = _pShell->GetINDEX("gam_bWeaponsStay");
+      const INDEX symptrAmmo  = _pShell->GetINDEX("gam_bAmmoStays");
+      const INDEX symptrVital = _pShell->GetINDEX("gam_bHealthArmorStays");
+      const INDEX symptrHP    = _pShell->GetINDEX("gam_bAllowHealth");
+      const INDEX symptrAR    = _pShell->GetINDEX("gam_bAllowArmor");
+      const INDEX symptrIA    = _pShell->GetINDEX("gam_bInfiniteAmmo");
+      const INDEX symptrResp  = _pShell->GetINDEX("gam_bRespawnInPlace");
+
+      _crStatusHeader.strPacket.PrintF(_strStatusResponseFormat,
+        sam_strGameName, _SE_VER_STRING, strLocation.ConstData(), Game_SessionName, net_iPort,
+        _pNetwork->ga_pWorld->wo_strName.ConstData(), Query_GetCurrentGameTypeName().ConstData(),
+        ctPlayers, ctMaxPlayers, symptrFF, symptrWeap, symptrAmmo,
+        symptrVital, symptrHP, symptrAR, symptrIA, symptrResp);
+
+      _crStatusHeader.Validate();
     }
 
-    // Retrieve symbols once
-    const INDEX symptrFF    = _pShell->GetINDEX("gam_bFriendlyFire");
-    const INDEX symptrWeap  = _pShell->GetINDEX("gam_bWeaponsStay");
-    const INDEX symptrAmmo  = _pShell->GetINDEX("gam_bAmmoStays");
-    const INDEX symptrVital = _pShell->GetINDEX("gam_bHealthArmorStays");
-    const INDEX symptrHP    = _pShell->GetINDEX("gam_bAllowHealth");
-    const INDEX symptrAR    = _pShell->GetINDEX("gam_bAllowArmor");
-    const INDEX symptrIA    = _pShell->GetINDEX("gam_bInfiniteAmmo");
-    const INDEX symptrResp  = _pShell->GetINDEX("gam_bRespawnInPlace");
-
-    // Compose status response
-    CTString strPacket;
-    strPacket.PrintF(_strStatusResponseFormat,
-      sam_strGameName, _SE_VER_STRING, strLocation.ConstData(), Game_SessionName, net_iPort,
-      _pNetwork->ga_pWorld->wo_strName.ConstData(), Query_GetCurrentGameTypeName().ConstData(),
-      ctPlayers, ctMaxPlayers, symptrFF, symptrWeap, symptrAmmo,
-      symptrVital, symptrHP, symptrAR, symptrIA, symptrResp);
+    // Compose status response (player info changes all the time)
+    CTString strPacket = _crStatusHeader.strPacket;
 
     // Go through server players
     for (INDEX i = 0; i < ctPlayers; i++) {
@@ -116,15 +127,20 @@ void ILegacy::ServerParsePacket(INDEX iLength) {
 
   // Information request
   } else if (pInfo != NULL) {
-    // Send information response
-    CTString strPacket;
-    strPacket.PrintF("\\hostname\\%s\\hostport\\%hu\\mapname\\%s\\gametype\\%s"
-      "\\numplayers\\%d\\maxplayers\\%d\\gamemode\\openplaying\\final\\"
-      "\\queryid\\8.1",
-      Game_SessionName, net_iPort,
-      _pNetwork->ga_pWorld->wo_strName.ConstData(), Query_GetCurrentGameTypeName().ConstData(),
-      ctPlayers, ctMaxPlayers);
+    // Compose information response, if it's outdated
+    if (!_crInfo.IsValid()) {
+      _crInfo.strPacket.PrintF("\\hostname\\%s\\hostport\\%hu\\mapname\\%s\\gametype\\%s"
+        "\\numplayers\\%d\\maxplayers\\%d\\gamemode\\openplaying\\final\\"
+        "\\queryid\\8.1",
+        Game_SessionName, net_iPort,
+        _pNetwork->ga_pWorld->wo_strName.ConstData(), Query_GetCurrentGameTypeName().ConstData(),
+        ctPlayers, ctMaxPlayers);
+
+      _crInfo.Validate();
+    }
 
+    // Send information response
+    const CTString &strPacket = _crInfo.strPacket;
     IQuery::SendReply(strPacket);
 
     if (ms_bDebugOutput) {
@@ -133,20 +149,25 @@ void ILegacy::ServerParsePacket(INDEX iLength) {
 
   // Basic request
   } else if (pBasic != NULL) {
-    // Get location
-    extern CTString net_strLocalHost;
-    CTString strLocation = net_strLocalHost;
+    // Compose basic response, if it's outdated
+    if (!_crBasic.IsValid()) {
+      // Get location
+      extern CTString net_strLocalHost;
+      CTString strLocation = net_strLocalHost;
+
+      if (strLocation == "") {
+        strLocation = "Heartland";
+      }
+
+      // [Cecil] NOTE: The location is set to "EU" instead of printing the last argument
+      _crBasic.strPacket.PrintF("\\gamename\\%s\\gamever\\%s\\location\\EU\\final\\" "\\queryid\\1.1",
+        sam_strGameName, _SE_VER_STRING/*, strLocation.ConstData()*/);
 
-    if (strLocation == "") {
-      strLocation = "Heartland";
+      _crBasic.Validate();
     }
 
     // Send basic response
-    CTString strPacket;
-    // [Cecil] NOTE: The location is set to "EU" instead of printing the last argument
-    strPacket.PrintF("\\gamename\\%s\\gamever\\%s\\location\\EU\\final\\" "\\queryid\\1.1",
-      sam_strGameName, _SE_VER_STRING/*, strLocation.ConstData()*/);
-
+    const CTString &strPacket = _crBasic.strPacket;
     IQuery::SendReply(strPacket);
 
     if (ms_bDebugOutput) {
@@ -22,6 +22,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 // When the last heartbeat has been sent
 static TICK _tckLastHeartbeat = -1;
 
+// Maximum amount of packets to process in one update step
+static const INDEX _ctMaxPacketsPerUpdate = 256;
+
 extern INDEX ms_iProtocol;
 extern INDEX net_iPort;
 
@@ -44,6 +47,8 @@ void OnServerStart(void) {
   IQuery::bServer = TRUE;
   IQuery::bInitialized = TRUE;
 
+  InvalidateStatus();
+
   // Send opening packet to the master server
   switch (GetProtocol()) {
     case E_MS_LEGACY: {
@@ -107,12 +112,18 @@ void OnServerUpdate(void) {
 
   //if (ms_bDebugOutput) CPutString("IMasterServer::OnServerUpdate()\n");
 
-  // Receive new packet
-  memset(&IQuery::pBuffer[0], 0, 2050);
-  INDEX iLength = IQuery::ReceivePacket();
+  // Drain all pending packets instead of handling one per frame
+  for (INDEX iPacket = 0; iPacket < _ctMaxPacketsPerUpdate; iPacket++) {
+    INDEX iLength = IQuery::ReceivePacket();
+
+    // No more data
+    if (iLength <= 0) {
+      break;
+    }
+
+    // End with a null terminator instead of clearing the entire buffer
+    IQuery::pBuffer[iLength] = '\0';
 
-  // If there's any data
-  if (iLength > 0) {
     if (ms_bDebugOutput) {
       CPrintF("Received packet (%d bytes)\n", iLength);
     }
@@ -129,6 +140,9 @@ void OnServerUpdate(void) {
 
 // Server state has changed
 void OnServerStateChanged(void) {
+  // Recompose status for the next query
+  InvalidateStatus();
+
   // Not initialized
   if (!IQuery::bInitialized) {
     return;
@@ -159,6 +173,11 @@ void OnServerStateChanged(void) {
   }
 };
 
+// Invalidate cached status responses
+void InvalidateStatus(void) {
+  IQuery::ulStatusRevision++;
+};
+
 // Send heartbeat to the master server
 void SendHeartbeat(INDEX iChallenge) {
   CTString strPacket;
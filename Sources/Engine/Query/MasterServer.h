@@ -38,6 +38,9 @@ ENGINE_API void OnServerUpdate(void);
 // Server state has changed
 ENGINE_API void OnServerStateChanged(void);
 
+// Invalidate cached status responses
+ENGINE_API void InvalidateStatus(void);
+
 // Send heartbeat to the master server
 ENGINE_API void SendHeartbeat(INDEX iChallenge);
 
@@ -76,6 +76,24 @@ extern void InitQuery(void) {
   _aProtocols[E_MS_GAMEAGENT]  = new IGameAgent;
 };
 
+// Cached responses are recomposed after this long even without state changes (e.g. for changed game settings)
+static const TIME _tmMaxResponseAge = 5.0f;
+
+// Check if the composed packet is still up-to-date
+BOOL SCachedResponse::IsValid(void) const {
+  if (ulRevision != IQuery::ulStatusRevision) {
+    return FALSE;
+  }
+
+  return (_pTimer->GetRealTime() - tckComposed < SecToTicks(_tmMaxResponseAge));
+};
+
+// Mark freshly composed packet as up-to-date
+void SCachedResponse::Validate(void) {
+  ulRevision = IQuery::ulStatusRevision;
+  tckComposed = _pTimer->GetRealTime();
+};
+
 namespace IQuery {
 
 sockaddr_in sinFrom;
@@ -84,7 +102,10 @@ char *pBuffer = NULL;
 BOOL bServer = FALSE;
 BOOL bInitialized = FALSE;
 
-CDynamicStackArray<SServerRequest> aRequests;
+CServerRequestTable aRequests;
+
+// Current revision of the server status for cached responses
+ULONG ulStatusRevision = 1;
 
 // Add new server request from a received address
 void Address::AddServerRequest(const char **ppBuffer, INDEX &iLength, const UWORD uwSetPort, const char *strPacket, SOCKET iSocketUDP) {
@@ -125,6 +125,22 @@ extern IAbstractProtocol *_aProtocols[E_MS_MAX];
 // Debug output for query
 ENGINE_API extern INDEX ms_bDebugOutput;
 
+// Response packet that is composed once and reused until the server state changes
+struct SCachedResponse {
+  CTString strPacket; // Composed packet
+  ULONG ulRevision; // Status revision it has been composed for
+  TICK tckComposed; // When it has been composed
+
+  // Constructor
+  SCachedResponse() : ulRevision(0), tckComposed(-1) {};
+
+  // Check if the composed packet is still up-to-date
+  BOOL IsValid(void) const;
+
+  // Mark freshly composed packet as up-to-date
+  void Validate(void);
+};
+
 // Internal query functionality
 namespace IQuery {
 
@@ -150,7 +166,10 @@ extern char *pBuffer;
 extern BOOL bServer;
 extern BOOL bInitialized;
 
-extern CDynamicStackArray<SServerRequest> aRequests;
+extern CServerRequestTable aRequests;
+
+// Current revision of the server status for cached responses
+extern ULONG ulStatusRevision;
 
 // Initialize the socket
 void InitWinsock(void);
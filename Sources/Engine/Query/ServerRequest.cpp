@@ -18,28 +18,30 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Query/ServerRequest.h>
 #include <Engine/Query/QueryManager.h>
 
+// Initial amount of request slots (must be a power of two)
+static const INDEX _ctInitialRequestSlots = 64;
+
+// How long a request may stay unanswered before being discarded
+static const SECOND _dRequestTimeout = 10.0;
+
 // Add a new server request
 void SServerRequest::AddRequest(const sockaddr_in &addr) {
-  SServerRequest &req = IQuery::aRequests.Push();
-  req.ulAddress = addr.sin_addr.s_addr;
-  req.uwPort = addr.sin_port;
+  SServerRequest &req = IQuery::aRequests.Add(addr.sin_addr.s_addr, addr.sin_port);
   req.tvRequestTime = _pTimer->GetHighPrecisionTimer();
 };
 
 // Find server request with a matching the socket address
 SServerRequest *SServerRequest::Find(const sockaddr_in &addr) {
-  // Search for the status request
-  for (INDEX i = 0; i < IQuery::aRequests.Count(); i++) {
-    SServerRequest &req = IQuery::aRequests[i];
+  return IQuery::aRequests.Find(addr.sin_addr.s_addr, addr.sin_port);
+};
 
-    // Found matching address
-    if (req.ulAddress == addr.sin_addr.s_addr && req.uwPort == addr.sin_port) {
-      return &req;
-    }
-  }
+// Discard server request for this socket address, if there's any
+void SServerRequest::Remove(const sockaddr_in &addr) {
+  SServerRequest *preq = Find(addr);
 
-  // None found
-  return NULL;
+  if (preq != NULL) {
+    IQuery::aRequests.Remove(preq);
+  }
 };
 
 // Get time from a server request and discard it, if found for this socket address
@@ -49,12 +51,162 @@ CTimerValue SServerRequest::PopRequestTime(const sockaddr_in &addr) {
 
   // If found
   if (preq != NULL) {
-    // Get its time and clear it
+    // Get its time and discard it
     CTimerValue tvTime = preq->tvRequestTime;
-    preq->Clear();
+    IQuery::aRequests.Remove(preq);
 
     return tvTime;
   }
 
   return SQUAD(-1);
 };
+
+// Remove all requests
+void CServerRequestTable::Clear(void) {
+  srt_aSlots.Clear();
+  srt_ctUsed = 0;
+};
+
+// Get home slot of an address
+INDEX CServerRequestTable::HomeSlot(ULONG ulAddress, UWORD uwPort) const {
+  // Mix address bits together with the port
+  ULONG ulHash = ulAddress ^ (ULONG(uwPort) << 16) ^ uwPort;
+  ulHash ^= ulHash >> 16;
+  ulHash *= 0x45D9F3B;
+  ulHash ^= ulHash >> 16;
+
+  return INDEX(ulHash & ULONG(srt_aSlots.Count() - 1));
+};
+
+// Add new request or renew an existing one for the address
+SServerRequest &CServerRequestTable::Add(ULONG ulAddress, UWORD uwPort) {
+  // Request for this address is already pending
+  SServerRequest *preqOld = Find(ulAddress, uwPort);
+
+  if (preqOld != NULL) {
+    return *preqOld;
+  }
+
+  // Keep the table at most three quarters full
+  const INDEX ctSlots = srt_aSlots.Count();
+
+  if (ctSlots == 0) {
+    Rehash(_ctInitialRequestSlots);
+
+  } else if ((srt_ctUsed + 1) * 4 > ctSlots * 3) {
+    // Try to make space by discarding stale requests first
+    Expire();
+
+    if ((srt_ctUsed + 1) * 4 > ctSlots * 3) {
+      Rehash(ctSlots * 2);
+    }
+  }
+
+  // Take the first free slot after the home slot
+  const INDEX iMask = srt_aSlots.Count() - 1;
+  INDEX iSlot = HomeSlot(ulAddress, uwPort);
+
+  while (srt_aSlots[iSlot].IsUsed()) {
+    iSlot = (iSlot + 1) & iMask;
+  }
+
+  SServerRequest &req = srt_aSlots[iSlot];
+  req.ulAddress = ulAddress;
+  req.uwPort = uwPort;
+  srt_ctUsed++;
+
+  return req;
+};
+
+// Find request for the address
+SServerRequest *CServerRequestTable::Find(ULONG ulAddress, UWORD uwPort) {
+  // Nothing to search
+  if (srt_ctUsed == 0) {
+    return NULL;
+  }
+
+  const INDEX iMask = srt_aSlots.Count() - 1;
+  INDEX iSlot = HomeSlot(ulAddress, uwPort);
+
+  // Go through the chain until an empty slot
+  while (srt_aSlots[iSlot].IsUsed()) {
+    SServerRequest &req = srt_aSlots[iSlot];
+
+    // Found matching address
+    if (req.ulAddress == ulAddress && req.uwPort == uwPort) {
+      return &req;
+    }
+
+    iSlot = (iSlot + 1) & iMask;
+  }
+
+  // None found
+  return NULL;
+};
+
+// Remove a request from the table
+void CServerRequestTable::Remove(SServerRequest *preq) {
+  ASSERT(preq != NULL && preq->IsUsed());
+
+  const INDEX iMask = srt_aSlots.Count() - 1;
+  INDEX iHole = srt_aSlots.Index(preq);
+  INDEX iSlot = (iHole + 1) & iMask;
+
+  // Shift following requests of the chain back, so the lookups don't stop at the hole
+  while (srt_aSlots[iSlot].IsUsed()) {
+    SServerRequest &req = srt_aSlots[iSlot];
+    const INDEX iHome = HomeSlot(req.ulAddress, req.uwPort);
+
+    // Move it into the hole if it's not past its home slot
+    if (((iSlot - iHome) & iMask) >= ((iSlot - iHole) & iMask)) {
+      srt_aSlots[iHole] = req;
+      iHole = iSlot;
+    }
+
+    iSlot = (iSlot + 1) & iMask;
+  }
+
+  srt_aSlots[iHole].Clear();
+  srt_ctUsed--;
+};
+
+// Remove requests that have been pending for too long
+void CServerRequestTable::Expire(void) {
+  if (srt_ctUsed == 0) {
+    return;
+  }
+
+  Rehash(srt_aSlots.Count());
+};
+
+// Reallocate slots and reinsert all remaining requests
+void CServerRequestTable::Rehash(INDEX ctSlots) {
+  ASSERT(ctSlots > 0 && (ctSlots & (ctSlots - 1)) == 0);
+
+  CStaticArray<SServerRequest> aOld;
+  aOld.MoveArray(srt_aSlots);
+
+  srt_aSlots.New(ctSlots);
+  srt_ctUsed = 0;
+
+  const INDEX iMask = ctSlots - 1;
+  const CTimerValue tvNow = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX iOld = 0; iOld < aOld.Count(); iOld++) {
+    const SServerRequest &reqOld = aOld[iOld];
+
+    // Skip empty slots and stale requests
+    if (!reqOld.IsUsed() || (tvNow - reqOld.tvRequestTime).GetSeconds() > _dRequestTimeout) {
+      continue;
+    }
+
+    INDEX iSlot = HomeSlot(reqOld.ulAddress, reqOld.uwPort);
+
+    while (srt_aSlots[iSlot].IsUsed()) {
+      iSlot = (iSlot + 1) & iMask;
+    }
+
+    srt_aSlots[iSlot] = reqOld;
+    srt_ctUsed++;
+  }
+};
@@ -20,6 +20,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
   #pragma once
 #endif
 
+#include <Engine/Templates/StaticArray.h>
+
 // Server request for receiving server pings
 struct SServerRequest {
   ULONG ulAddress;
@@ -31,21 +33,67 @@ struct SServerRequest {
     Clear();
   };
 
-  // Clear data in the dynamic stack array
+  // Clear data in the slot
   void Clear(void) {
     ulAddress = 0;
     uwPort = 0;
     tvRequestTime.Clear();
   };
 
+  // Check if the slot is occupied by some request
+  inline BOOL IsUsed(void) const {
+    return (ulAddress != 0 || uwPort != 0);
+  };
+
   // Add a new server request
   static void AddRequest(const sockaddr_in &addr);
 
   // Find server request with a matching the socket address
   static SServerRequest *Find(const sockaddr_in &addr);
 
+  // Discard server request for this socket address, if there's any
+  static void Remove(const sockaddr_in &addr);
+
   // Get time from a server request and discard it, if found for this socket address
   static CTimerValue PopRequestTime(const sockaddr_in &addr);
 };
 
+// Hash table of pending server requests with open addressing
+class CServerRequestTable {
+  public:
+    CStaticArray<SServerRequest> srt_aSlots; // Request slots (power of two)
+    INDEX srt_ctUsed; // Amount of occupied slots
+
+  public:
+    // Constructor
+    CServerRequestTable(void) : srt_ctUsed(0) {};
+
+    // Remove all requests
+    void Clear(void);
+
+    // Amount of pending requests
+    inline INDEX Count(void) const {
+      return srt_ctUsed;
+    };
+
+    // Add new request or renew an existing one for the address
+    SServerRequest &Add(ULONG ulAddress, UWORD uwPort);
+
+    // Find request for the address
+    SServerRequest *Find(ULONG ulAddress, UWORD uwPort);
+
+    // Remove a request from the table
+    void Remove(SServerRequest *preq);
+
+    // Remove requests that have been pending for too long
+    void Expire(void);
+
+  private:
+    // Get home slot of an address
+    INDEX HomeSlot(ULONG ulAddress, UWORD uwPort) const;
+
+    // Reallocate slots and reinsert all remaining requests
+    void Rehash(INDEX ctSlots);
+};
+
 #endif
@@ -295,6 +295,20 @@ void CRenderer::PassPortal(CScreenPolygon &spo)
       // skip it
       continue;
     }
+
+    // [Cecil] If the sector cannot be seen according to the PVS
+    if (re_bUsePVS && IsSectorCulledByPVS(*pbsc)) {
+      // skip it unless verifying the PVS
+      if (wld_iUsePVS != 2) continue;
+
+      // detail portals are passed without checking if they are visible
+      const ULONG ulPortalFlags = spo.spo_pbpoBrushPolygon->bpo_ulFlags;
+
+      if (!(ulPortalFlags & BPOF_DETAILPOLYGON) || (ulPortalFlags & BPOF_RENDERASPORTAL)) {
+        ReportPVSMismatch(*pbsc);
+      }
+    }
+
     // get brush of the sector
     CBrushMip *pbmSectorMip = pbsc->bsc_pbmBrushMip;
     CBrush3D &brBrush = *pbmSectorMip->bm_pbrBrush;
@@ -164,6 +164,9 @@ void CRenderer::MakeNonDetailScreenPolygons(void)
     // no screen polygon by default
     bpo.bpo_pspoScreenPolygon = NULL;
 
+    // [Cecil] skip portals that cannot be seen according to the PVS before their edges are scanned
+    if (re_bUsePVS && wld_iUsePVS != 2 && (bpo.bpo_ulFlags&BPOF_PORTAL) && IsPortalCulledByPVS(bpo)) continue;
+
     // skip if the polygon is not visible
     ASSERT( !IsPolygonCulled(bpo));  // cannot be culled yet!
     const ULONG ulVisible = GetPolygonVisibility(bpo);
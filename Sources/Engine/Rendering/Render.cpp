@@ -27,6 +27,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Light/Gradient.h>
 #include <Engine/Base/ListIterator.inl>
 #include <Engine/World/World.h>
+#include <Engine/World/WorldPVS.h> // [Cecil]
+#include <Engine/World/ShadowBaking.h> // [Cecil]
 #include <Engine/Entities/Entity.h>
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Math/Clipping.inl>
@@ -50,6 +52,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Graphics/DrawPort.h>
 #include <Engine/Graphics/GfxLibrary.h>
 #include <Engine/Graphics/Fog_internal.h>
+#include <Engine/Graphics/TextureEffects.h>
 
 #include <Engine/Base/Statistics_internal.h>
 #include <Engine/Rendering/RenderProfile.h>
@@ -80,6 +83,7 @@ static CRenderer _areRenderers[MAX_RENDERERS];
 static BOOL _bMirrorDrawn = FALSE;
 
 extern INDEX wld_bAlwaysAddAll;
+extern INDEX wld_iUsePVS; // [Cecil]
 extern INDEX wld_bRenderEmptyBrushes;
 extern INDEX wld_bRenderDetailPolygons;
 extern INDEX gfx_bRenderParticles;
@@ -277,6 +281,9 @@ void CRenderer::Initialize(void)
   re_prProjection->DepthBufferFarL()  = 0.9f;
   re_prProjection->Prepare();
 
+  // [Cecil] Sectors aren't culled until the initial ones are known
+  re_bUsePVS = FALSE;
+
   re_asedScreenEdges.PopAll();
   re_aadeAddEdges.PopAll();
   re_aspSpans.PopAll();
@@ -439,6 +446,94 @@ void CRenderer::AddInitialSectors(void)
 
   _pfRenderProfile.StopTimer(CRenderProfile::PTI_ADDINITIAL);
 }
+
+// [Cecil] Gather sectors that may be seen from the initial sectors
+void CRenderer::PreparePVS(void)
+{
+  re_bUsePVS = FALSE;
+
+  CWorldPVS *ppvs = re_pwoWorld->wo_ppvsSectors;
+  if (wld_iUsePVS == 0 || ppvs == NULL || re_bRenderingShadows) return;
+
+  // Warped views are seen from outside of the initial sectors
+  if (re_iIndex > 0 && re_penViewer != NULL) return;
+
+  // World has been edited since the PVS was made
+  if (!ppvs->IsValid(*re_pwoWorld)) return;
+
+  if (re_aulPVS.Count() != ppvs->pvs_ctRowWords) {
+    re_aulPVS.Clear();
+    re_aulPVS.New(ppvs->pvs_ctRowWords);
+  }
+  memset(&re_aulPVS[0], 0, ppvs->pvs_ctRowWords * sizeof(ULONG));
+
+  BOOL bAnySector = FALSE;
+
+  FOREACHINLIST(CBrushSector, bsc_lnInActiveSectors, re_lhActiveSectors, itbsc) {
+    CEntity *penSector = itbsc->bsc_pbmBrushMip->bm_pbrBrush->br_penEntity;
+
+    // Non-zoning brushes are only added together with the sectors they are in
+    if (penSector != NULL && !(penSector->en_ulFlags & ENF_ZONING)) continue;
+
+    // Anything may be seen from sectors without visibility data
+    const INDEX iSector = ppvs->GetSectorIndex(*re_pwoWorld, *itbsc);
+    if (iSector < 0) return;
+
+    const ULONG *pulRow = ppvs->GetRow(iSector);
+
+    for (INDEX iWord = 0; iWord < ppvs->pvs_ctRowWords; iWord++) {
+      re_aulPVS[iWord] |= pulRow[iWord];
+    }
+
+    bAnySector = TRUE;
+  }
+
+  // Viewer is outside of the world
+  re_bUsePVS = bAnySector;
+}
+
+// [Cecil] Check if a sector cannot be seen from the initial sectors
+BOOL CRenderer::IsSectorCulledByPVS(CBrushSector &bsc)
+{
+  ASSERT(re_bUsePVS);
+
+  // Untracked sectors are never culled
+  const INDEX iSector = re_pwoWorld->wo_ppvsSectors->GetSectorIndex(*re_pwoWorld, bsc);
+  if (iSector < 0) return FALSE;
+
+  return !CWorldPVS::IsBitSet(&re_aulPVS[0], iSector);
+}
+
+// [Cecil] Check if a portal only leads to sectors that cannot be seen from the initial sectors
+BOOL CRenderer::IsPortalCulledByPVS(CBrushPolygon &bpo)
+{
+  BOOL bAnySector = FALSE;
+
+  {FOREACHDSTOFSRC(bpo.bpo_rsOtherSideSectors, CBrushSector, bsc_rdOtherSidePortals, pbsc)
+    if (!IsSectorCulledByPVS(*pbsc)) return FALSE;
+    bAnySector = TRUE;
+  ENDFOR}
+
+  // A portal is only visible if something behind it is visible too
+  return bAnySector;
+}
+
+// [Cecil] Report a sector that is visible even though the PVS culls it
+void CRenderer::ReportPVSMismatch(CBrushSector &bsc)
+{
+  CWorldPVS &pvs = *re_pwoWorld->wo_ppvsSectors;
+  const INDEX iSector = bsc.bsc_iInWorld;
+
+  // Report each sector once
+  ULONG &ulReported = pvs.pvs_aulReported[iSector >> 5];
+  const ULONG ulBit = (1UL << (iSector & 31));
+
+  if (ulReported & ulBit) return;
+  ulReported |= ulBit;
+
+  CPrintF(TRANS("PVS mismatch: sector %d ('%s') is visible but would have been culled\n"), iSector, bsc.bsc_strName.ConstData());
+}
+
 // scan through portals for other sectors
 void CRenderer::ScanForOtherSectors(void)
 {
@@ -466,6 +561,11 @@ void CRenderer::CleanupScanning(void)
     // remove it from list
     itbsc->bsc_lnInActiveSectors.Remove();
 
+    // [Cecil] Remember which shadow map has last set sector flags
+    if (re_bRenderingShadows && _psbRendering != NULL) {
+      _psbRendering->SectorRendered(*itbsc);
+    }
+
     // for all polygons in sector
     FOREACHINSTATICARRAY(itbsc->bsc_abpoPolygons, CBrushPolygon, itpo) {
       CBrushPolygon &bpo = *itpo;
@@ -705,6 +805,8 @@ void CRenderer::Render(void)
   if( re_pdpDrawPort!=NULL) InitSelectOnRender( re_pdpDrawPort->GetWidth(), re_pdpDrawPort->GetHeight());
   // add initial sectors to active lists
   AddInitialSectors();
+  // [Cecil] cull sectors that cannot be seen from the initial ones
+  PreparePVS();
   // scan through portals for other sectors
   ScanForOtherSectors();
 
@@ -959,6 +1061,9 @@ void RenderView(CWorld &woWorld, CEntity &enViewer,
     woWorld.CalculateNonDirectionalShadows();
   }
 
+  // [Cecil] Animate visible effect textures for this frame all at once
+  AnimateEffectTextures();
+
   // take first renderer object
   CRenderer &re = _areRenderers[0];
   // set it up for rendering
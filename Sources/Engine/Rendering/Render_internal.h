@@ -361,6 +361,10 @@ public:
   CListHead re_lhActiveSectors;     // list of active sectors
   CListHead re_lhActiveTerrains;    // list of active terrains
 
+  // [Cecil] Sectors that may be seen from the initial sectors according to the world PVS
+  BOOL re_bUsePVS;
+  CStaticArray<ULONG> re_aulPVS;
+
   static CStaticStackArray<CActiveEdge> re_aaceActiveEdges; // active edges for current scan line
   static CStaticStackArray<CActiveEdge> re_aaceActiveEdgesTmp;
 
@@ -555,6 +559,14 @@ public:
   void Initialize(void);
   // add initial sectors to active lists
   void AddInitialSectors(void);
+  // [Cecil] Gather sectors that may be seen from the initial sectors
+  void PreparePVS(void);
+  // [Cecil] Check if a sector cannot be seen from the initial sectors
+  BOOL IsSectorCulledByPVS(CBrushSector &bsc);
+  // [Cecil] Check if a portal only leads to sectors that cannot be seen from the initial sectors
+  BOOL IsPortalCulledByPVS(CBrushPolygon &bpo);
+  // [Cecil] Report a sector that is visible even though the PVS culls it
+  void ReportPVSMismatch(CBrushSector &bsc);
   // scan through portals for other sectors
   void ScanForOtherSectors(void);
   // cleanup after scanning
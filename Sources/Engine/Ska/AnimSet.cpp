@@ -26,9 +26,16 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Math/Geometry.h>
 #include <Engine/Base/Timer.h>
 
-#define ANIMSET_VERSION  14
+#define ANIMSET_VERSION  15
 #define ANIMSET_ID       "ANIM"
 
+// last version without quantized keyframes
+#define ANIMSET_VERSION_NOQUANTIZE 14
+
+// quantization range of the three smallest quaternion components ([-1/sqrt(2), 1/sqrt(2)] -> [0, 32767])
+#define ROTQ_MAXVALUE 32767
+#define ROTQ_INVSQRT2 0.70710678118654752f
+
 // table for removed frames
 static CStaticArray<BOOL> aiRemFrameTable;
 // precalculated angles for rotations
@@ -76,6 +83,81 @@ static void CompressAxis(const FLOAT3D &vNormal, UWORD &ubH, UWORD &ubP)
   ubH = UWORD(h*65535);
   ubP = UWORD(p*65535);
 }
+// destination components for the three smallest ones, depending on the largest one
+static const INDEX _aiSmallestComps[4][3] = {
+  {1, 2, 3}, {0, 2, 3}, {0, 1, 3}, {0, 1, 2},
+};
+
+// quantize rotation into smallest three components
+static void EncodeAnimRot(const FLOATquat3D &qRot, AnimRotQ &arq)
+{
+  const FLOATquat3D q = qRot / qRot.Norm();
+  const FLOAT afComp[4] = { q.q_w, q.q_x, q.q_y, q.q_z };
+
+  // find largest component
+  INDEX iLargest = 0;
+  for(INDEX iComp=1;iComp<4;iComp++) {
+    if(Abs(afComp[iComp]) > Abs(afComp[iLargest])) iLargest = iComp;
+  }
+
+  // quantize other three
+  const INDEX *piComps = _aiSmallestComps[iLargest];
+  for(INDEX i=0;i<3;i++) {
+    FLOAT fNormalized = (afComp[piComps[i]] / ROTQ_INVSQRT2) * 0.5f + 0.5f;
+    INDEX iValue = INDEX(floorf(fNormalized * ROTQ_MAXVALUE + 0.5f));
+    arq.arq_auwComp[i] = (UWORD)Clamp(iValue, (INDEX)0, (INDEX)ROTQ_MAXVALUE);
+  }
+
+  // pack index and sign of the largest component into top bits
+  arq.arq_auwComp[0] |= ((iLargest>>1) & 1) << 15;
+  arq.arq_auwComp[1] |= (iLargest & 1) << 15;
+  arq.arq_auwComp[2] |= (afComp[iLargest] < 0.0f ? 1 : 0) << 15;
+}
+
+// decode quantized rotation
+void DecodeAnimRot(const AnimRotQ &arq, FLOATquat3D &qRot)
+{
+  const UWORD *puwComp = arq.arq_auwComp;
+  const INDEX iLargest = ((puwComp[0]>>14) & 2) | ((puwComp[1]>>15) & 1);
+
+  // dequantize three smallest components (plain scalar code without branches)
+  FLOAT afSmall[3];
+  for(INDEX i=0;i<3;i++) {
+    afSmall[i] = ((puwComp[i] & ROTQ_MAXVALUE) * (2.0f / ROTQ_MAXVALUE) - 1.0f) * ROTQ_INVSQRT2;
+  }
+
+  // restore largest component from the unit length
+  FLOAT fLargest = 1.0f - (afSmall[0]*afSmall[0] + afSmall[1]*afSmall[1] + afSmall[2]*afSmall[2]);
+  fLargest = sqrtf(ClampDn(fLargest, 0.0f));
+  if(puwComp[2] & 0x8000) fLargest = -fLargest;
+
+  FLOAT afComp[4];
+  const INDEX *piComps = _aiSmallestComps[iLargest];
+  afComp[iLargest]   = fLargest;
+  afComp[piComps[0]] = afSmall[0];
+  afComp[piComps[1]] = afSmall[1];
+  afComp[piComps[2]] = afSmall[2];
+
+  qRot = FLOATquat3D(afComp[0], afComp[1], afComp[2], afComp[3]);
+}
+
+// quantize position relative to envelope origin
+static void EncodeAnimPos(const BoneEnvelope &be, const FLOAT3D &vPos, AnimPosQ &apq)
+{
+  for(INDEX i=0;i<3;i++) {
+    INDEX iDelta = INDEX(floorf((vPos(i+1) - be.be_vPosOrigin(i+1)) / be.be_fPosStep + 0.5f));
+    apq.apq_aswDelta[i] = (SWORD)Clamp(iDelta, (INDEX)-32767, (INDEX)32767);
+  }
+}
+
+// decode quantized position
+void DecodeAnimPos(const BoneEnvelope &be, const AnimPosQ &apq, FLOAT3D &vPos)
+{
+  vPos(1) = be.be_vPosOrigin(1) + apq.apq_aswDelta[0] * be.be_fPosStep;
+  vPos(2) = be.be_vPosOrigin(2) + apq.apq_aswDelta[1] * be.be_fPosStep;
+  vPos(3) = be.be_vPosOrigin(3) + apq.apq_aswDelta[2] * be.be_fPosStep;
+}
+
 // try to remove 2. keyframe in rotation
 BOOL RemoveRotFrame(AnimRot &ar1,AnimRot &ar2,AnimRot &ar3,FLOAT fTreshold)
 {
@@ -149,8 +231,65 @@ void CAnimSet::Optimize()
     Animation &an = as_Anims[ian];
     //CalculateExtraSpins(an);
     OptimizeAnimation(an,an.an_fTreshold);
+
+    // quantize remaining keyframes if needed
+    if(an.an_fQuantize>0) {
+      QuantizeAnimation(an,an.an_fQuantize);
+    }
   }
 }
+// quantize keyframes of an animation (uncompresed rotations must be present)
+void CAnimSet::QuantizeAnimation(Animation &an, FLOAT fTolerance)
+{
+  ASSERT(fTolerance>0);
+  INDEX ctbe = an.an_abeBones.Count();
+
+  for(INDEX ibe=0;ibe<ctbe;ibe++)
+  {
+    BoneEnvelope &be = an.an_abeBones[ibe];
+    INDEX ctp = be.be_apPos.Count();
+    INDEX ctr = be.be_arRot.Count();
+    ASSERT(ctr>0 || be.be_arRotOpt.Count()==0);
+
+    // find range of positions
+    FLOAT3D vMin(0,0,0);
+    FLOAT3D vMax(0,0,0);
+    for(INDEX ip=0;ip<ctp;ip++)
+    {
+      const FLOAT3D &vPos = be.be_apPos[ip].ap_vPos;
+      for(INDEX i=1;i<4;i++) {
+        if(ip==0 || vPos(i)<vMin(i)) vMin(i) = vPos(i);
+        if(ip==0 || vPos(i)>vMax(i)) vMax(i) = vPos(i);
+      }
+    }
+
+    // store deltas from the middle with tolerance as the step, unless the range doesn't fit
+    be.be_vPosOrigin = (vMin+vMax) * 0.5f;
+    FLOAT fHalfRange = Max(Max(vMax(1)-vMin(1), vMax(2)-vMin(2)), vMax(3)-vMin(3)) * 0.5f;
+    be.be_fPosStep = Max(fTolerance, fHalfRange/32767.0f);
+
+    be.be_apPosQ.Clear();
+    be.be_apPosQ.New(ctp);
+    for(INDEX ip=0;ip<ctp;ip++)
+    {
+      AnimPosQ &apq = be.be_apPosQ[ip];
+      apq.apq_iFrameNum = be.be_apPos[ip].ap_iFrameNum;
+      EncodeAnimPos(be, be.be_apPos[ip].ap_vPos, apq);
+    }
+
+    be.be_arRotQ.Clear();
+    be.be_arRotQ.New(ctr);
+    for(INDEX ir=0;ir<ctr;ir++)
+    {
+      AnimRotQ &arq = be.be_arRotQ[ir];
+      arq.arq_iFrameNum = be.be_arRot[ir].ar_iFrameNum;
+      EncodeAnimRot(be.be_arRot[ir].ar_qRot, arq);
+    }
+  }
+
+  an.an_fQuantize = fTolerance;
+  an.an_bQuantized = TRUE;
+}
 // optimize animation
 void CAnimSet::OptimizeAnimation(Animation &an, FLOAT fTreshold)
 {
@@ -382,6 +521,9 @@ void CAnimSet::Write_t(CTStream *ostrFile)
     (*ostrFile)<<an.an_bCompresed;
     // write bool if animstion uses custom speed
     (*ostrFile)<<an.an_bCustomSpeed;
+    // write position tolerance if keyframes are quantized
+    FLOAT fQuantize = an.an_bQuantized ? an.an_fQuantize : 0.0f;
+    (*ostrFile)<<fQuantize;
     
     INDEX ctbe = an.an_abeBones.Count();
     INDEX ctme = an.an_ameMorphs.Count();
@@ -397,6 +539,23 @@ void CAnimSet::Write_t(CTStream *ostrFile)
       (*ostrFile)<<pstrNameID;
       // write default pos(matrix12)
       ostrFile->Write_t(&be.be_mDefaultPos[0],sizeof(FLOAT)*12);
+
+      // write quantized keyframes
+      if(an.an_bQuantized)
+      {
+        (*ostrFile)<<be.be_vPosOrigin;
+        (*ostrFile)<<be.be_fPosStep;
+        INDEX ctp = be.be_apPosQ.Count();
+        (*ostrFile)<<ctp;
+        if(ctp>0) ostrFile->Write_t(&be.be_apPosQ[0],sizeof(AnimPosQ)*ctp);
+        INDEX ctr = be.be_arRotQ.Count();
+        (*ostrFile)<<ctr;
+        if(ctr>0) ostrFile->Write_t(&be.be_arRotQ[0],sizeof(AnimRotQ)*ctr);
+        // write offsetlen
+        (*ostrFile)<<be.be_OffSetLen;
+        continue;
+      }
+
       // count positions
       INDEX ctp = be.be_apPos.Count();
       // write position count
@@ -451,7 +610,7 @@ void CAnimSet::Read_t(CTStream *istrFile)
   istrFile->ExpectID_t(CChunkID(ANIMSET_ID));
   // check file version
   (*istrFile)>>iFileVersion;
-  if(iFileVersion != ANIMSET_VERSION)
+  if(iFileVersion != ANIMSET_VERSION && iFileVersion != ANIMSET_VERSION_NOQUANTIZE)
   {
 		ThrowF_t(TRANS("File '%s'.\nInvalid animset file version. Expected Ver \"%d\" but found \"%d\"\n"),
       istrFile->GetDescription().ConstData(), ANIMSET_VERSION, iFileVersion);
@@ -481,6 +640,12 @@ void CAnimSet::Read_t(CTStream *istrFile)
     (*istrFile)>>an.an_bCompresed;
     // read bool if animstion uses custom speed
     (*istrFile)>>an.an_bCustomSpeed;
+    // read position tolerance for quantized keyframes
+    an.an_fQuantize = 0.0f;
+    if(iFileVersion > ANIMSET_VERSION_NOQUANTIZE) {
+      (*istrFile)>>an.an_fQuantize;
+    }
+    an.an_bQuantized = (an.an_fQuantize > 0.0f);
     
     INDEX ctbe;
     INDEX ctme;
@@ -499,6 +664,42 @@ void CAnimSet::Read_t(CTStream *istrFile)
       // read default pos(matrix12)
       istrFile->Read_t(&be.be_mDefaultPos[0],sizeof(FLOAT)*12);
 
+      // read quantized keyframes
+      if(an.an_bQuantized)
+      {
+        (*istrFile)>>be.be_vPosOrigin;
+        (*istrFile)>>be.be_fPosStep;
+        INDEX ctp;
+        (*istrFile)>>ctp;
+        be.be_apPosQ.New(ctp);
+        if(ctp>0) istrFile->Read_t(&be.be_apPosQ[0],sizeof(AnimPosQ)*ctp);
+        INDEX ctr;
+        (*istrFile)>>ctr;
+        be.be_arRotQ.New(ctr);
+        if(ctr>0) istrFile->Read_t(&be.be_arRotQ[0],sizeof(AnimRotQ)*ctr);
+
+        // if flag is set to remember uncompresed rotations
+        if(bAllRotations)
+        {
+          // restore regular keyframes from quantized ones
+          be.be_apPos.New(ctp);
+          for(INDEX ip=0;ip<ctp;ip++)
+          {
+            be.be_apPos[ip].ap_iFrameNum = be.be_apPosQ[ip].apq_iFrameNum;
+            DecodeAnimPos(be, be.be_apPosQ[ip], be.be_apPos[ip].ap_vPos);
+          }
+          be.be_arRot.New(ctr);
+          for(INDEX ir=0;ir<ctr;ir++)
+          {
+            be.be_arRot[ir].ar_iFrameNum = be.be_arRotQ[ir].arq_iFrameNum;
+            DecodeAnimRot(be.be_arRotQ[ir], be.be_arRot[ir].ar_qRot);
+          }
+        }
+        // read offsetlen
+        (*istrFile)>>be.be_OffSetLen;
+        continue;
+      }
+
       INDEX ctp;
       // read pos array
       (*istrFile)>>ctp;
@@ -599,6 +800,9 @@ void CAnimSet::Clear(void)
       //be.be_aqvPlacement.Clear();
       be.be_apPos.Clear();
       be.be_arRot.Clear();
+      be.be_arRotOpt.Clear();
+      be.be_apPosQ.Clear();
+      be.be_arRotQ.Clear();
     }
     for(INDEX iMorphEnv=0;iMorphEnv<ctMorphEnv;iMorphEnv++)
     {
@@ -627,6 +831,8 @@ SLONG CAnimSet::GetUsedMemory(void)
       slMemoryUsed+=be.be_apPos.Count() * sizeof(AnimPos);
       slMemoryUsed+=be.be_arRot.Count() * sizeof(AnimRot);
       slMemoryUsed+=be.be_arRotOpt.Count() * sizeof(AnimRotOpt);
+      slMemoryUsed+=be.be_apPosQ.Count() * sizeof(AnimPosQ);
+      slMemoryUsed+=be.be_arRotQ.Count() * sizeof(AnimRotQ);
     }
     // for each morph envelope
     INDEX ctme = an.an_ameMorphs.Count();
@@ -638,3 +844,131 @@ SLONG CAnimSet::GetUsedMemory(void)
   }
   return slMemoryUsed;
 }
+
+// find frame (binary) index in array of keyframes
+extern INDEX FindFrame(UBYTE *pFirstMember, INDEX iFind, INDEX ctfn, UINT uiSize);
+
+// tolerance used for quantizing animations that aren't quantized yet
+static const FLOAT _fBenchmarkTolerance = 0.001f;
+
+// sample bone envelope at some frame from regular or quantized keyframes
+static void SampleBoneEnvelope(BoneEnvelope &be, INDEX iFrame, BOOL bQuantized, FLOATquat3D &qRot, FLOAT3D &vPos)
+{
+  if(bQuantized) {
+    INDEX ir = FindFrame((UBYTE*)&be.be_arRotQ[0], iFrame, be.be_arRotQ.Count(), sizeof(AnimRotQ));
+    INDEX ip = FindFrame((UBYTE*)&be.be_apPosQ[0], iFrame, be.be_apPosQ.Count(), sizeof(AnimPosQ));
+    DecodeAnimRot(be.be_arRotQ[ir], qRot);
+    DecodeAnimPos(be, be.be_apPosQ[ip], vPos);
+  } else {
+    INDEX ir = FindFrame((UBYTE*)&be.be_arRot[0], iFrame, be.be_arRot.Count(), sizeof(AnimRot));
+    INDEX ip = FindFrame((UBYTE*)&be.be_apPos[0], iFrame, be.be_apPos.Count(), sizeof(AnimPos));
+    qRot = be.be_arRot[ir].ar_qRot;
+    vPos = be.be_apPos[ip].ap_vPos;
+  }
+}
+
+// sample every frame of every animation in the set and return time spent on it
+static DOUBLE SampleAnimSet(CAnimSet &as, BOOL bQuantized, INDEX ctPasses)
+{
+  FLOATquat3D qRot;
+  FLOAT3D vPos;
+  FLOAT fSum = 0.0f;
+
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for(INDEX iPass=0;iPass<ctPasses;iPass++) {
+    for(INDEX ian=0;ian<as.as_Anims.Count();ian++) {
+      Animation &an = as.as_Anims[ian];
+
+      for(INDEX ibe=0;ibe<an.an_abeBones.Count();ibe++) {
+        BoneEnvelope &be = an.an_abeBones[ibe];
+        if(be.be_arRot.Count()==0 || be.be_apPos.Count()==0) continue;
+
+        for(INDEX iFrame=0;iFrame<an.an_iFrames;iFrame++) {
+          SampleBoneEnvelope(be, iFrame, bQuantized, qRot, vPos);
+          fSum += qRot.q_w + vPos(1);
+        }
+      }
+    }
+  }
+
+  DOUBLE dTime = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+  // keep the results alive
+  if(fSum == 12345.678f) CPutString("");
+  return dTime;
+}
+
+// compare memory usage and sampling cost of quantized keyframes against regular ones
+void BenchmarkAnimSet(void *pArgs)
+{
+  CTFileName fnmAnimSet = *NEXTARGUMENT(CTString *);
+  CAnimSet as;
+
+  // load animset with uncompresed keyframes for comparison
+  BOOL bOldAllRotations = bAllRotations;
+  bAllRotations = TRUE;
+
+  try {
+    as.Load_t(fnmAnimSet);
+  } catch (char *strError) {
+    bAllRotations = bOldAllRotations;
+    CPrintF(TRANS("Cannot load animset '%s':\n%s\n"), fnmAnimSet.ConstData(), strError);
+    return;
+  }
+
+  bAllRotations = bOldAllRotations;
+
+  SLONG slRegular = 0;
+  SLONG slQuantized = 0;
+  INDEX ctKeys = 0;
+  FLOAT fMaxPosError = 0.0f;
+  FLOAT fMaxRotError = 0.0f;
+
+  for(INDEX ian=0;ian<as.as_Anims.Count();ian++) {
+    Animation &an = as.as_Anims[ian];
+
+    // quantize with default tolerance, if not yet
+    if(!an.an_bQuantized) {
+      as.QuantizeAnimation(an, _fBenchmarkTolerance);
+    }
+
+    for(INDEX ibe=0;ibe<an.an_abeBones.Count();ibe++) {
+      BoneEnvelope &be = an.an_abeBones[ibe];
+      const INDEX ctp = be.be_apPos.Count();
+      const INDEX ctr = be.be_arRot.Count();
+
+      // memory of keyframes in both formats
+      slRegular += ctp * sizeof(AnimPos) + ctr * (an.an_bCompresed ? sizeof(AnimRotOpt) : sizeof(AnimRot));
+      slQuantized += be.be_apPosQ.Count() * sizeof(AnimPosQ) + be.be_arRotQ.Count() * sizeof(AnimRotQ);
+      ctKeys += ctp + ctr;
+
+      // find largest errors
+      for(INDEX ip=0;ip<ctp;ip++) {
+        FLOAT3D vPos;
+        DecodeAnimPos(be, be.be_apPosQ[ip], vPos);
+        fMaxPosError = Max(fMaxPosError, (vPos - be.be_apPos[ip].ap_vPos).Length());
+      }
+
+      for(INDEX ir=0;ir<ctr;ir++) {
+        FLOATquat3D qRot;
+        DecodeAnimRot(be.be_arRotQ[ir], qRot);
+        const FLOATquat3D qDiff = qRot - be.be_arRot[ir].ar_qRot;
+        fMaxRotError = Max(fMaxRotError, qDiff.Norm());
+      }
+    }
+  }
+
+  // sample both formats
+  const INDEX ctPasses = 16;
+  DOUBLE dRegular = SampleAnimSet(as, FALSE, ctPasses);
+  DOUBLE dQuantized = SampleAnimSet(as, TRUE, ctPasses);
+
+  CPrintF(TRANS("Animset '%s': %d animations, %d keyframes\n"), fnmAnimSet.ConstData(), as.as_Anims.Count(), ctKeys);
+  CPrintF(TRANS("  Keyframe memory: %d KB regular, %d KB quantized (%.1f%%)\n"),
+    slRegular / 1024, slQuantized / 1024, slQuantized * 100.0 / ClampDn(slRegular, (SLONG)1));
+  CPrintF(TRANS("  Sampling time: %.2f ms regular, %.2f ms quantized\n"), dRegular * 1000.0, dQuantized * 1000.0);
+  CPrintF(TRANS("  Largest error: %g position, %g rotation\n"), fMaxPosError, fMaxRotError);
+
+  as.Clear();
+}
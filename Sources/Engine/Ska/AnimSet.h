@@ -54,6 +54,22 @@ struct AnimRot
   FLOATquat3D ar_qRot; //bone rot
 };
 
+// quantized bone rotation (smallest three components)
+struct AnimRotQ
+{
+  UWORD arq_iFrameNum;  //frame number
+  // three smallest quaternion components in lower 15 bits each; top bits of first two words
+  // hold index of the largest component and top bit of the third one holds its sign
+  UWORD arq_auwComp[3];
+};
+
+// quantized bone position (delta from envelope origin in steps of envelope tolerance)
+struct AnimPosQ
+{
+  UWORD apq_iFrameNum;  //frame number
+  SWORD apq_aswDelta[3];
+};
+
 struct Animation
 {
   int an_iID;
@@ -65,6 +81,8 @@ struct Animation
   CStaticArray<struct BoneEnvelope> an_abeBones;
   CTString an_fnSourceFile;// name of ascii aa file, used in Ska studio
   BOOL an_bCustomSpeed; // animation has custom speed set in animset list file, witch override speed from anim file
+  FLOAT an_fQuantize; // position tolerance for quantized keyframes (0 if not quantized)
+  BOOL an_bQuantized; // are quantized keyframes used instead of regular ones
 };
 
 struct MorphEnvelope
@@ -80,9 +98,17 @@ struct BoneEnvelope
   CStaticArray<struct AnimPos> be_apPos;// array of compresed bone positions
   CStaticArray<struct AnimRot> be_arRot;// array if compresed bone rotations
   CStaticArray<struct AnimRotOpt> be_arRotOpt;// array if optimized compresed bone rotations
+  CStaticArray<struct AnimPosQ> be_apPosQ;// array of quantized bone positions
+  CStaticArray<struct AnimRotQ> be_arRotQ;// array of quantized bone rotations
+  FLOAT3D be_vPosOrigin; // origin for quantized positions
+  FLOAT be_fPosStep; // size of one quantization step for positions in this envelope
   FLOAT be_OffSetLen;
 };
 
+// decode quantized keyframes
+ENGINE_API void DecodeAnimRot(const AnimRotQ &arq, FLOATquat3D &qRot);
+ENGINE_API void DecodeAnimPos(const BoneEnvelope &be, const AnimPosQ &apq, FLOAT3D &vPos);
+
 class ENGINE_API CAnimSet : public CSerial
 {
 public:
@@ -90,6 +116,7 @@ public:
   ~CAnimSet();
   void Optimize();
   void OptimizeAnimation(Animation &an, FLOAT fTreshold);
+  void QuantizeAnimation(Animation &an, FLOAT fTolerance);
   void AddAnimation(Animation *pan);
   void RemoveAnimation(Animation *pan);
     
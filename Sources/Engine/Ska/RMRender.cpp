@@ -1183,7 +1183,7 @@ static void FindTextureData(CTextureObject **ptoTextures, INDEX iTextureID, Mesh
 }
 
 //  find frame (binary) index in compresed array of rotations, positions or opt_rotations
-static INDEX FindFrame(UBYTE *pFirstMember, INDEX iFind, INDEX ctfn, UINT uiSize)
+INDEX FindFrame(UBYTE *pFirstMember, INDEX iFind, INDEX ctfn, UINT uiSize)
 {
   INDEX iHigh = ctfn-1;
   INDEX iLow = 0;
@@ -1904,8 +1904,30 @@ static void MatchAnims(RenModel &rm)
             FLOATquat3D *pqRotCurrent;
             FLOATquat3D *pqRotNext;
             
+            // if animation keyframes are quantized
+            if(an.an_bQuantized) {
+              AnimRotQ *arqFirst = &be.be_arRotQ[0];
+              INDEX ctfn = be.be_arRotQ.Count();
+              iRotFrameIndex = FindFrame((UBYTE*)arqFirst,iAnimFrame,ctfn,sizeof(AnimRotQ));
+
+              // get index of next frame
+              if(bAnimLooping) {
+                iNextRotFrameIndex = (iRotFrameIndex+1L) % ctfn;
+              } else {
+                iNextRotFrameIndex = ClampUp(iRotFrameIndex+1L,ctfn - 1L);
+              }
+
+              const AnimRotQ &arqRot = be.be_arRotQ[iRotFrameIndex];
+              const AnimRotQ &arqRotNext = be.be_arRotQ[iNextRotFrameIndex];
+              iRotFrameNum = arqRot.arq_iFrameNum;
+              iNextRotFrameNum = arqRotNext.arq_iFrameNum;
+              DecodeAnimRot(arqRot, qRotCurrent);
+              DecodeAnimRot(arqRotNext, qRotNext);
+              pqRotCurrent = &qRotCurrent;
+              pqRotNext = &qRotNext;
+
             // if animation is not compresed
-            if(!an.an_bCompresed) {
+            } else if(!an.an_bCompresed) {
               AnimRot *arFirst = &be.be_arRot[0];
               INDEX ctfn = be.be_arRot.Count();
               // find index of closest frame
@@ -1967,28 +1989,54 @@ static void MatchAnims(RenModel &rm)
             // and currently playing animation 
             rb.rb_arRot.ar_qRot = Slerp(fFadeFactor * pa.pa_Strength, rb.rb_arRot.ar_qRot, qRot);
 
-            AnimPos *apFirst = &be.be_apPos[0];
-            INDEX ctfn = be.be_apPos.Count();
-            INDEX iPosFrameIndex = FindFrame((UBYTE*)apFirst,iAnimFrame,ctfn,sizeof(AnimPos));
-
+            INDEX iPosFrameIndex;
             INDEX iNextPosFrameIndex;
-            // is animation looping
-            if(bAnimLooping) { 
-              iNextPosFrameIndex = (iPosFrameIndex+1) % be.be_apPos.Count();
+            INDEX iPosFrameNum;
+            INDEX iNextPosFrameNum;
+            FLOAT3D vBonePosCurrent;
+            FLOAT3D vBonePosNext;
+
+            // if animation keyframes are quantized
+            if(an.an_bQuantized) {
+              AnimPosQ *apqFirst = &be.be_apPosQ[0];
+              INDEX ctfn = be.be_apPosQ.Count();
+              iPosFrameIndex = FindFrame((UBYTE*)apqFirst,iAnimFrame,ctfn,sizeof(AnimPosQ));
+
+              // is animation looping
+              if(bAnimLooping) {
+                iNextPosFrameIndex = (iPosFrameIndex+1) % ctfn;
+              } else {
+                iNextPosFrameIndex = ClampUp(iPosFrameIndex+1L,ctfn-1L);
+              }
+
+              iPosFrameNum = be.be_apPosQ[iPosFrameIndex].apq_iFrameNum;
+              iNextPosFrameNum = be.be_apPosQ[iNextPosFrameIndex].apq_iFrameNum;
+              DecodeAnimPos(be, be.be_apPosQ[iPosFrameIndex], vBonePosCurrent);
+              DecodeAnimPos(be, be.be_apPosQ[iNextPosFrameIndex], vBonePosNext);
+
             } else {
-              iNextPosFrameIndex = ClampUp(iPosFrameIndex+1L,be.be_apPos.Count()-1L);
-            }
+              AnimPos *apFirst = &be.be_apPos[0];
+              INDEX ctfn = be.be_apPos.Count();
+              iPosFrameIndex = FindFrame((UBYTE*)apFirst,iAnimFrame,ctfn,sizeof(AnimPos));
 
-            INDEX iPosFrameNum = be.be_apPos[iPosFrameIndex].ap_iFrameNum;
-            INDEX iNextPosFrameNum = be.be_apPos[iNextPosFrameIndex].ap_iFrameNum;
+              // is animation looping
+              if(bAnimLooping) { 
+                iNextPosFrameIndex = (iPosFrameIndex+1) % be.be_apPos.Count();
+              } else {
+                iNextPosFrameIndex = ClampUp(iPosFrameIndex+1L,be.be_apPos.Count()-1L);
+              }
+
+              iPosFrameNum = be.be_apPos[iPosFrameIndex].ap_iFrameNum;
+              iNextPosFrameNum = be.be_apPos[iNextPosFrameIndex].ap_iFrameNum;
+              vBonePosCurrent = be.be_apPos[iPosFrameIndex].ap_vPos;
+              vBonePosNext = be.be_apPos[iNextPosFrameIndex].ap_vPos;
+            }
 
             FLOAT fLerpFactor;
             if(iNextPosFrameNum<=iPosFrameNum) fLerpFactor = (f-iPosFrameNum) / (an.an_iFrames-iPosFrameNum);
             else fLerpFactor = (f-iPosFrameNum) / (iNextPosFrameNum-iPosFrameNum);
             
             FLOAT3D vPos;
-            FLOAT3D vBonePosCurrent = be.be_apPos[iPosFrameIndex].ap_vPos;
-            FLOAT3D vBonePosNext = be.be_apPos[iNextPosFrameIndex].ap_vPos;
 
             // if bone envelope and bone have some length 
             if((be.be_OffSetLen > 0) && (rb.rb_psbBone->sb_fOffSetLen > 0)) {
@@ -23,6 +23,19 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/Unzip.h>
 #include <Engine/Base/Translation.h>
 #include <Engine/Math/Functions.h>
+#include <Engine/Base/WorkerThreads.h> // [Cecil]
+
+// [Cecil] Streaming thread
+#if SE1_WORKER_THREADS
+  #include <thread>
+  #include <mutex>
+  #include <condition_variable>
+  #include <chrono>
+  #include <vector>
+#endif
+
+#include <atomic> // [Cecil]
+#include <unordered_map> // [Cecil]
 
 // generic function called if a dll function is not found
 static void FailFunction_t(const char *strName) {
@@ -203,6 +216,249 @@ static ov_callbacks ovcCallbacks = {
 };
 
 
+// [Cecil] Decoded audio cache
+
+// Keep streaming sounds that are shorter than this fully decoded after their first playback (in seconds; 0 to disable)
+FLOAT snd_tmDecodedCacheLength = 5.0f;
+
+// Memory budget for all fully decoded sounds (in KB)
+INDEX snd_iDecodedCacheSize = 16 * 1024;
+
+// Fully decoded sound that is shared between decoders
+class CDecodeData_PCM {
+public:
+  CTFileName pcm_fnmSound;    // sound that has been decoded
+  UBYTE *pcm_pubData;         // decoded samples
+  SLONG pcm_slSize;           // size of decoded samples in bytes
+  WAVEFORMATEX pcm_wfeFormat; // format of sound
+  INDEX pcm_ctReferences;     // decoders that use it (and the cache itself while it's in there)
+  CListNode pcm_lnInLRU;      // least recently used sounds are at the head
+};
+
+typedef std::unordered_map<CTString, CDecodeData_PCM *> DecodedSounds_t;
+
+static DecodedSounds_t _mapDecodedSounds;
+static CListHead _lhDecodedLRU;
+static SLONG _slDecodedCacheSize = 0;
+static INDEX _ctDecodedCacheHits = 0;
+static INDEX _ctDecodedCacheMisses = 0;
+static CTCriticalSection _csDecodedCache;
+
+// Release one reference to a decoded sound
+static void ReleasePCM(CDecodeData_PCM *ppcm) {
+  CTSingleLock slCache(&_csDecodedCache, TRUE);
+
+  ASSERT(ppcm->pcm_ctReferences > 0);
+  if (--ppcm->pcm_ctReferences > 0) return;
+
+  FreeMemory(ppcm->pcm_pubData);
+  delete ppcm;
+};
+
+// Remove a decoded sound from the cache
+static void UncachePCM(CDecodeData_PCM *ppcm) {
+  _mapDecodedSounds.erase(ppcm->pcm_fnmSound);
+  ppcm->pcm_lnInLRU.Remove();
+  _slDecodedCacheSize -= ppcm->pcm_slSize;
+
+  ReleasePCM(ppcm);
+};
+
+// Find a decoded sound in the cache and reference it
+static CDecodeData_PCM *ObtainCachedPCM(const CTFileName &fnm) {
+  if (snd_tmDecodedCacheLength <= 0.0f) return NULL;
+
+  CTSingleLock slCache(&_csDecodedCache, TRUE);
+  DecodedSounds_t::const_iterator it = _mapDecodedSounds.find(fnm);
+
+  if (it == _mapDecodedSounds.end()) {
+    _ctDecodedCacheMisses++;
+    return NULL;
+  }
+
+  _ctDecodedCacheHits++;
+
+  // Mark as the most recently used one
+  CDecodeData_PCM *ppcm = it->second;
+  ppcm->pcm_lnInLRU.Remove();
+  _lhDecodedLRU.AddTail(ppcm->pcm_lnInLRU);
+
+  ppcm->pcm_ctReferences++;
+  return ppcm;
+};
+
+// Add a decoded sound to the cache and evict least recently used ones that don't fit into the budget
+static void CachePCM(CDecodeData_PCM *ppcm) {
+  CTSingleLock slCache(&_csDecodedCache, TRUE);
+
+  // Another decoder has already cached it
+  if (_mapDecodedSounds.find(ppcm->pcm_fnmSound) != _mapDecodedSounds.end()) return;
+
+  ppcm->pcm_ctReferences++;
+  _mapDecodedSounds[ppcm->pcm_fnmSound] = ppcm;
+  _lhDecodedLRU.AddTail(ppcm->pcm_lnInLRU);
+  _slDecodedCacheSize += ppcm->pcm_slSize;
+
+  const SLONG slBudget = ClampDn(snd_iDecodedCacheSize, (INDEX)0) * 1024;
+
+  while (_slDecodedCacheSize > slBudget) {
+    CDecodeData_PCM *ppcmOldest = LIST_HEAD(_lhDecodedLRU, CDecodeData_PCM, pcm_lnInLRU);
+    UncachePCM(ppcmOldest);
+
+    // Stop after evicting the new sound if it alone exceeds the budget
+    if (ppcmOldest == ppcm) break;
+  }
+};
+
+// Print decoded audio cache statistics
+static void PrintDecodedCache(void) {
+  CTSingleLock slCache(&_csDecodedCache, TRUE);
+
+  const INDEX ctLookups = _ctDecodedCacheHits + _ctDecodedCacheMisses;
+  const FLOAT fHitRate = (ctLookups > 0 ? FLOAT(_ctDecodedCacheHits) / ctLookups * 100.0f : 0.0f);
+
+  CPrintF(TRANS("Decoded audio cache: %d sounds, %d/%d KB\n"), (INDEX)_mapDecodedSounds.size(),
+    _slDecodedCacheSize / 1024, snd_iDecodedCacheSize);
+  CPrintF(TRANS("  hits: %d, misses: %d (%.1f%% hit rate)\n"), _ctDecodedCacheHits, _ctDecodedCacheMisses, fHitRate);
+
+  FOREACHINLIST(CDecodeData_PCM, pcm_lnInLRU, _lhDecodedLRU, itpcm) {
+    CPrintF("  %6d KB  %s\n", itpcm->pcm_slSize / 1024, itpcm->pcm_fnmSound.ConstData());
+  }
+};
+
+// Remove all unused sounds from the decoded audio cache
+static void ClearDecodedCache(void) {
+  CTSingleLock slCache(&_csDecodedCache, TRUE);
+
+  while (!_lhDecodedLRU.IsEmpty()) {
+    UncachePCM(LIST_HEAD(_lhDecodedLRU, CDecodeData_PCM, pcm_lnInLRU));
+  }
+
+  _ctDecodedCacheHits = 0;
+  _ctDecodedCacheMisses = 0;
+};
+
+// Declare decoded audio cache settings
+void CSoundDecoder::InitCache(void)
+{
+  _csDecodedCache.cs_eIndex = EThreadMutexType::E_MTX_IGNORE;
+
+  _pShell->DeclareSymbol("persistent user FLOAT snd_tmDecodedCacheLength;", &snd_tmDecodedCacheLength);
+  _pShell->DeclareSymbol("persistent user INDEX snd_iDecodedCacheSize;", &snd_iDecodedCacheSize);
+  _pShell->DeclareSymbol("user void snd_PrintDecodedCache(void);", &PrintDecodedCache);
+  _pShell->DeclareSymbol("user void snd_ClearDecodedCache(void);", &ClearDecodedCache);
+}
+
+// Decoded audio that is collected while a short sound is being played for the first time
+class CDecodeCapture {
+  public:
+    UBYTE *cap_pubData; // Decoded samples so far
+    SLONG cap_slSize; // Size of decoded samples in bytes
+    SLONG cap_slAllocated; // Size of the buffer
+    SLONG cap_slMaxSize; // Stop collecting if the sound turns out to be longer than this
+};
+
+// Estimate length of a sound in seconds (-1 if it's unknown)
+static FLOAT EstimateSoundLength(CSoundDecoder &sdc) {
+  // Estimate sound length
+  FLOAT fSeconds = -1.0f;
+
+  if (sdc.sdc_pmpeg != NULL) {
+    fSeconds = sdc.sdc_pmpeg->mpeg_fSecondsLen;
+
+  } else if (sdc.sdc_pogg != NULL) {
+    vorbis_info *pvi = pov_info(sdc.sdc_pogg->ogg_vfVorbisFile, -1);
+
+    if (pvi != NULL && pvi->bitrate_nominal > 0) {
+      fSeconds = sdc.sdc_pogg->ogg_slSize * 8.0f / pvi->bitrate_nominal;
+    }
+  }
+
+  return fSeconds;
+};
+
+// Start collecting decoded audio of a short sound for the cache
+static void StartCaching(CSoundDecoder *psdc) {
+  if (snd_tmDecodedCacheLength <= 0.0f || psdc->sdc_pcache != NULL) return;
+
+  const FLOAT fSeconds = EstimateSoundLength(*psdc);
+  if (fSeconds < 0.0f || fSeconds > snd_tmDecodedCacheLength) return;
+
+  WAVEFORMATEX wfe;
+  psdc->GetFormat(wfe);
+
+  // Estimates aren't exact, so allow some leeway but don't let it grow indefinitely
+  CDecodeCapture *pcap = new CDecodeCapture;
+  pcap->cap_slMaxSize = SLONG(wfe.nAvgBytesPerSec * snd_tmDecodedCacheLength * 2.0f) + 64 * 1024;
+  pcap->cap_slAllocated = Min(SLONG(wfe.nAvgBytesPerSec * fSeconds * 1.25f) + 64 * 1024, pcap->cap_slMaxSize);
+  pcap->cap_pubData = (UBYTE *)AllocMemory(pcap->cap_slAllocated);
+  pcap->cap_slSize = 0;
+
+  psdc->sdc_pcache = pcap;
+};
+
+// Stop collecting decoded audio and throw it away
+static void CancelCaching(CSoundDecoder *psdc) {
+  CDecodeCapture *pcap = psdc->sdc_pcache;
+  if (pcap == NULL) return;
+
+  FreeMemory(pcap->cap_pubData);
+  delete pcap;
+  psdc->sdc_pcache = NULL;
+};
+
+// Collect a block of decoded audio and cache the whole sound upon reaching its end
+// NOTE: Called by whichever thread is decoding the sound at the moment
+static void CaptureDecoded(CSoundDecoder *psdc, const void *pvDecoded, INDEX ctDecoded, INDEX ctWanted) {
+  CDecodeCapture *pcap = psdc->sdc_pcache;
+
+  if (ctDecoded > 0) {
+    const SLONG slNeeded = pcap->cap_slSize + ctDecoded;
+
+    // Too long to be cached after all
+    if (slNeeded > pcap->cap_slMaxSize) {
+      CancelCaching(psdc);
+      return;
+    }
+
+    // Grow the buffer
+    if (slNeeded > pcap->cap_slAllocated) {
+      while (pcap->cap_slAllocated < slNeeded) {
+        pcap->cap_slAllocated = Min(pcap->cap_slAllocated * 2, pcap->cap_slMaxSize);
+      }
+
+      GrowMemory((void **)&pcap->cap_pubData, pcap->cap_slAllocated);
+    }
+
+    memcpy(pcap->cap_pubData + pcap->cap_slSize, pvDecoded, ctDecoded);
+    pcap->cap_slSize = slNeeded;
+  }
+
+  // Not the end of the sound yet
+  if (ctDecoded >= ctWanted) return;
+
+  WAVEFORMATEX wfe;
+  psdc->GetFormat(wfe);
+
+  // Keep only whole samples
+  SLONG slSize = pcap->cap_slSize;
+  slSize -= slSize % ClampDn((SLONG)wfe.nBlockAlign, (SLONG)1);
+
+  CDecodeData_PCM *ppcm = new CDecodeData_PCM;
+  ppcm->pcm_fnmSound = psdc->sdc_fnmSound;
+  ppcm->pcm_pubData = pcap->cap_pubData;
+  ppcm->pcm_slSize = slSize;
+  ppcm->pcm_wfeFormat = wfe;
+  ppcm->pcm_ctReferences = 1;
+
+  delete pcap;
+  psdc->sdc_pcache = NULL;
+
+  // Only the cache keeps it from now on
+  CachePCM(ppcm);
+  ReleasePCM(ppcm);
+};
+
 // initialize/end the decoding support engine(s)
 void CSoundDecoder::InitPlugins(void)
 {
@@ -256,6 +512,12 @@ void CSoundDecoder::InitPlugins(void)
 
 void CSoundDecoder::EndPlugins(void)
 {
+  // [Cecil] Stop decoding before unloading the libraries
+  EndStreamingThread();
+
+  // [Cecil] Free unused decoded sounds
+  ClearDecodedCache();
+
   // cleanup amp11lib when not needed anymore
   if (_bAMP11Enabled) {
     palEndLibrary();
@@ -279,15 +541,308 @@ void CSoundDecoder::EndPlugins(void)
 #endif
 }
 
+// [Cecil] Background streaming
+
+// Decode streaming sounds ahead of time on a separate thread
+INDEX snd_bStreamingThread = TRUE;
+
+// How much audio to decode ahead of time (in seconds)
+FLOAT snd_tmStreamAhead = 1.0f;
+
+#if SE1_WORKER_THREADS
+
+// Ring buffer with decoded audio that is filled by the streaming thread and consumed by the mixer
+class CDecodeStream {
+  public:
+    UBYTE *ds_pubBuffer;
+    ULONG ds_ulSize; // Buffer size (power of two)
+    ULONG ds_ulBlockAlign; // Bytes per sample of all channels
+    ULONG ds_ulEmptyPasses; // Passes in a row that haven't decoded anything after restarting
+
+    std::atomic<ULONG> ds_ulWritten; // Total bytes written by the streaming thread
+    std::atomic<ULONG> ds_ulRead; // Total bytes read by the mixer
+    std::atomic<bool> ds_bEnd; // No more data will be written
+};
+
+// Maximum amount of bytes to decode for one stream in one pass
+static const ULONG _ulMaxStreamPass = 32 * 1024;
+
+static std::mutex _mtxStreams; // Guards the list of streams and publishing of decoded data
+static std::condition_variable _cvStreams; // Signaled when there is something new to decode
+static std::condition_variable _cvStreamDecoded; // Signaled when the streaming thread stops using a decoder
+static std::vector<CSoundDecoder *> _apsdcStreams;
+static CSoundDecoder *_psdcDecoding = NULL; // Decoder that's being used without holding the lock
+static std::thread _thStreaming;
+static BOOL _bStreamingStarted = FALSE;
+static BOOL _bStopStreaming = FALSE;
+
+// Decode as much as fits into the ring buffer of one stream (returns TRUE if anything has been decoded)
+// NOTE: The lock is released while decoding into the pass buffer and only held to publish the result
+static BOOL FillStream(CSoundDecoder *psdc, UBYTE *pubPass, std::unique_lock<std::mutex> &lock) {
+  CDecodeStream *pds = psdc->sdc_pstream;
+  if (pds->ds_bEnd.load(std::memory_order_relaxed)) return FALSE;
+
+  const ULONG ulRead = pds->ds_ulRead.load(std::memory_order_acquire);
+  const ULONG ulWritten = pds->ds_ulWritten.load(std::memory_order_relaxed);
+  const ULONG ulFree = Min(pds->ds_ulSize - (ulWritten - ulRead), _ulMaxStreamPass);
+  if (ulFree == 0) return FALSE;
+
+  // Keep the decoder from being destroyed while the lock is released
+  _psdcDecoding = psdc;
+  lock.unlock();
+
+  ULONG ulDecoded = 0;
+  bool bEnd = false;
+
+  while (ulDecoded < ulFree) {
+    const ULONG ulWanted = ulFree - ulDecoded;
+    const INDEX ctDecoded = ClampDn(psdc->Decode(pubPass + ulDecoded, ulWanted), (INDEX)0);
+
+    if (ctDecoded > 0) {
+      ulDecoded += ctDecoded;
+      pds->ds_ulEmptyPasses = 0;
+    }
+
+    // Reached the end of the stream
+    if ((ULONG)ctDecoded < ulWanted) {
+      // Restart it unless it's empty
+      if (psdc->sdc_bLoop && pds->ds_ulEmptyPasses < 2) {
+        psdc->Reset();
+        pds->ds_ulEmptyPasses++;
+        continue;
+      }
+
+      bEnd = true;
+      break;
+    }
+  }
+
+  lock.lock();
+
+  // Publish decoded data with wrapping around the ring buffer
+  const ULONG ulOffset = ulWritten & (pds->ds_ulSize - 1);
+  const ULONG ulFirst = Min(ulDecoded, pds->ds_ulSize - ulOffset);
+
+  memcpy(pds->ds_pubBuffer + ulOffset, pubPass, ulFirst);
+  memcpy(pds->ds_pubBuffer, pubPass + ulFirst, ulDecoded - ulFirst);
+
+  pds->ds_ulWritten.store(ulWritten + ulDecoded, std::memory_order_release);
+
+  if (bEnd) {
+    pds->ds_bEnd.store(true, std::memory_order_release);
+  }
+
+  _psdcDecoding = NULL;
+  _cvStreamDecoded.notify_all();
+
+  return ulDecoded > 0;
+};
+
+// Loop of the streaming thread
+static void StreamingThread(void) {
+  UBYTE *pubPass = (UBYTE *)AllocMemory(_ulMaxStreamPass);
+  std::unique_lock<std::mutex> lock(_mtxStreams);
+
+  while (!_bStopStreaming) {
+    BOOL bDecoded = FALSE;
+
+    // Streams may be added or removed while one of them is being decoded
+    for (size_t i = 0; i < _apsdcStreams.size(); i++) {
+      bDecoded |= FillStream(_apsdcStreams[i], pubPass, lock);
+    }
+
+    // Wait for the mixer to consume some data
+    if (!bDecoded) {
+      _cvStreams.wait_for(lock, std::chrono::milliseconds(10));
+    }
+  }
+
+  lock.unlock();
+  FreeMemory(pubPass);
+};
+
+// Remove decoder from the streaming thread and destroy its buffer
+static void StopStreaming(CSoundDecoder *psdc) {
+  if (psdc->sdc_pstream == NULL) return;
+
+  {
+    std::unique_lock<std::mutex> lock(_mtxStreams);
+
+    for (size_t i = 0; i < _apsdcStreams.size(); i++) {
+      if (_apsdcStreams[i] != psdc) continue;
+
+      _apsdcStreams.erase(_apsdcStreams.begin() + i);
+      break;
+    }
+
+    // Wait until the streaming thread is done decoding it
+    while (_psdcDecoding == psdc) {
+      _cvStreamDecoded.wait(lock);
+    }
+  }
+
+  FreeMemory(psdc->sdc_pstream->ds_pubBuffer);
+  delete psdc->sdc_pstream;
+  psdc->sdc_pstream = NULL;
+};
+
+#else
+
+static void StopStreaming(CSoundDecoder *psdc) {
+  NOTHING;
+};
+
+#endif // SE1_WORKER_THREADS
+
+// Start decoding the stream ahead of time on the streaming thread, if enabled
+static void StartDecodeStream(CSoundDecoder *psdc)
+{
+#if SE1_WORKER_THREADS
+  if (!snd_bStreamingThread || !psdc->IsOpen() || psdc->sdc_pstream != NULL) return;
+
+  // Fully decoded sounds are simply copied from memory
+  if (psdc->sdc_ppcm != NULL) return;
+
+  WAVEFORMATEX wfe;
+  psdc->GetFormat(wfe);
+
+  const ULONG ulBlockAlign = ClampDn(wfe.nChannels * wfe.wBitsPerSample / 8, 1);
+  const ULONG ulAhead = ULONG(wfe.nSamplesPerSec * ulBlockAlign * Clamp(snd_tmStreamAhead, 0.1f, 10.0f));
+
+  // Round up to a power of two
+  ULONG ulSize = 16 * 1024;
+  while (ulSize < ulAhead) ulSize <<= 1;
+
+  CDecodeStream *pds = new CDecodeStream;
+  pds->ds_pubBuffer = (UBYTE *)AllocMemory(ulSize);
+  pds->ds_ulSize = ulSize;
+  pds->ds_ulBlockAlign = ulBlockAlign;
+  pds->ds_ulEmptyPasses = 0;
+  pds->ds_ulWritten.store(0);
+  pds->ds_ulRead.store(0);
+  pds->ds_bEnd.store(false);
+  psdc->sdc_pstream = pds;
+
+  // The beginning is decoded on the streaming thread as well and the mixer plays silence until it's ready
+  std::lock_guard<std::mutex> lock(_mtxStreams);
+  _apsdcStreams.push_back(psdc);
+
+  if (!_bStreamingStarted) {
+    _bStopStreaming = FALSE;
+    _thStreaming = std::thread(StreamingThread);
+    _bStreamingStarted = TRUE;
+  }
+
+  _cvStreams.notify_one();
+#endif
+};
+
+// Start decoding the stream for playing (ahead of time on the streaming thread, if enabled)
+void CSoundDecoder::StartStreaming(BOOL bLoop)
+{
+  sdc_bLoop = bLoop;
+
+  // [Cecil] Already playing from memory
+  if (sdc_ppcm != NULL || !IsOpen()) return;
+
+  // [Cecil] Cache short sounds while they are being played
+  StartCaching(this);
+
+  StartDecodeStream(this);
+}
+
+// [Cecil] // Read decoded bytes for mixing (underrun is set if the streaming thread couldn't keep up)
+INDEX CSoundDecoder::ReadStream(void *pvDestBuffer, INDEX ctBytes, BOOL &bUnderrun)
+{
+  bUnderrun = FALSE;
+
+#if SE1_WORKER_THREADS
+  CDecodeStream *pds = sdc_pstream;
+
+  if (pds != NULL) {
+    // Check for the end first, so that no data written before it gets missed
+    const bool bEnd = pds->ds_bEnd.load(std::memory_order_acquire);
+    const ULONG ulWritten = pds->ds_ulWritten.load(std::memory_order_acquire);
+    const ULONG ulRead = pds->ds_ulRead.load(std::memory_order_relaxed);
+
+    // Only read whole samples
+    ULONG ulCopy = Min(ulWritten - ulRead, (ULONG)ctBytes);
+    ulCopy -= ulCopy % pds->ds_ulBlockAlign;
+
+    // Copy with wrapping around the buffer
+    const ULONG ulOffset = ulRead & (pds->ds_ulSize - 1);
+    const ULONG ulFirst = Min(ulCopy, pds->ds_ulSize - ulOffset);
+
+    memcpy(pvDestBuffer, pds->ds_pubBuffer + ulOffset, ulFirst);
+    memcpy((UBYTE *)pvDestBuffer + ulFirst, pds->ds_pubBuffer, ulCopy - ulFirst);
+
+    pds->ds_ulRead.store(ulRead + ulCopy, std::memory_order_release);
+
+    // Not enough data yet
+    if ((INDEX)ulCopy < ctBytes && !bEnd) {
+      bUnderrun = TRUE;
+    }
+
+    // Let the streaming thread refill the buffer
+    _cvStreams.notify_one();
+    return ulCopy;
+  }
+#endif
+
+  // Decode synchronously
+  INDEX ctDecoded = Decode(pvDestBuffer, ctBytes);
+
+  // Decode looping sounds again and again if they're shorter than the buffer
+  if (sdc_bLoop) {
+    while (ctDecoded < ctBytes) {
+      Reset();
+      const INDEX ctMore = Decode((UBYTE *)pvDestBuffer + ctDecoded, ctBytes - ctDecoded);
+
+      // Nothing to decode
+      if (ctMore <= 0) break;
+      ctDecoded += ctMore;
+    }
+  }
+
+  return ctDecoded;
+}
+
+// Stop the streaming thread
+void CSoundDecoder::EndStreamingThread(void)
+{
+#if SE1_WORKER_THREADS
+  {
+    std::lock_guard<std::mutex> lock(_mtxStreams);
+    if (!_bStreamingStarted) return;
+
+    _bStopStreaming = TRUE;
+    _cvStreams.notify_one();
+  }
+
+  _thStreaming.join();
+  _bStreamingStarted = FALSE;
+#endif
+}
+
 // decoder that streams from file
 CSoundDecoder::CSoundDecoder(const CTFileName &fnm)
 {
   sdc_pogg = NULL;
   sdc_pmpeg = NULL;
+  sdc_pstream = NULL; // [Cecil]
+  sdc_bLoop = FALSE; // [Cecil]
+  sdc_ppcm = NULL; // [Cecil]
+  sdc_slPCMOffset = 0; // [Cecil]
+  sdc_pcache = NULL; // [Cecil]
+  sdc_fnmSound = fnm; // [Cecil]
 
   // [Cecil] Ignore sounds on a dedicated server
   if (_SE1Setup.IsAppServer()) return;
 
+  // [Cecil] Play from the decoded audio cache
+  sdc_ppcm = ObtainCachedPCM(fnm);
+  if (sdc_ppcm != NULL) return;
+
   ExpandPath expath;
 
   // [Cecil] No file to read
@@ -498,6 +1053,17 @@ CSoundDecoder::~CSoundDecoder(void)
 
 void CSoundDecoder::Clear(void)
 {
+  // [Cecil] Stop streaming before throwing away decoded audio and closing the decoder
+  StopStreaming(this);
+  CancelCaching(this);
+
+  // [Cecil] Release fully decoded sound
+  if (sdc_ppcm != NULL) {
+    ReleasePCM(sdc_ppcm);
+    sdc_ppcm = NULL;
+    sdc_slPCMOffset = 0;
+  }
+
   if (sdc_pmpeg!=NULL) {
     if (sdc_pmpeg->mpeg_hDecoder!=0)  palClose(sdc_pmpeg->mpeg_hDecoder);
     if (sdc_pmpeg->mpeg_hFile!=0)     palClose(sdc_pmpeg->mpeg_hFile);
@@ -528,7 +1094,13 @@ void CSoundDecoder::Clear(void)
 // reset decoder to start of sample
 void CSoundDecoder::Reset(void)
 {
-  if (sdc_pmpeg!=NULL) {
+  // [Cecil] Audio collected so far isn't the whole sound anymore
+  CancelCaching(this);
+
+  // [Cecil] Fully decoded sound
+  if (sdc_ppcm!=NULL) {
+    sdc_slPCMOffset = 0;
+  } else if (sdc_pmpeg!=NULL) {
     palDecSeekAbs(sdc_pmpeg->mpeg_hDecoder, 0.0f);
   } else if (sdc_pogg!=NULL) {
     // so instead, we reinit
@@ -540,7 +1112,10 @@ void CSoundDecoder::Reset(void)
 
 BOOL CSoundDecoder::IsOpen(void) 
 {
-  if (sdc_pmpeg!=NULL && sdc_pmpeg->mpeg_hDecoder!=0) {
+  // [Cecil] Fully decoded sound
+  if (sdc_ppcm!=NULL) {
+    return TRUE;
+  } else if (sdc_pmpeg!=NULL && sdc_pmpeg->mpeg_hDecoder!=0) {
     return TRUE;
   } else if (sdc_pogg!=NULL && sdc_pogg->ogg_vfVorbisFile!=0) {
     return TRUE;
@@ -551,7 +1126,11 @@ BOOL CSoundDecoder::IsOpen(void)
 
 void CSoundDecoder::GetFormat(WAVEFORMATEX &wfe)
 {
-  if (sdc_pmpeg!=NULL) {
+  // [Cecil] Fully decoded sound
+  if (sdc_ppcm!=NULL) {
+    wfe = sdc_ppcm->pcm_wfeFormat;
+
+  } else if (sdc_pmpeg!=NULL) {
     wfe = sdc_pmpeg->mpeg_wfeFormat;
 
   } else if (sdc_pogg!=NULL) {
@@ -565,27 +1144,45 @@ void CSoundDecoder::GetFormat(WAVEFORMATEX &wfe)
 // decode a block of bytes
 INDEX CSoundDecoder::Decode(void *pvDestBuffer, INDEX ctBytesToDecode)
 {
+  // [Cecil] Copy from the fully decoded sound
+  if (sdc_ppcm!=NULL) {
+    const INDEX ctCopy = Min(ctBytesToDecode, INDEX(sdc_ppcm->pcm_slSize - sdc_slPCMOffset));
+    memcpy(pvDestBuffer, sdc_ppcm->pcm_pubData + sdc_slPCMOffset, ctCopy);
+    sdc_slPCMOffset += ctCopy;
+    return ctCopy;
+
   // if ogg
-  if (sdc_pogg!=NULL && sdc_pogg->ogg_vfVorbisFile!=0) {
+  } else if (sdc_pogg!=NULL && sdc_pogg->ogg_vfVorbisFile!=0) {
     // decode ogg
-    static int iCurrrentSection = -1; // we don't care about this
+    int iCurrrentSection = -1; // we don't care about this ([Cecil] not static for thread safety)
     char *pch = (char *)pvDestBuffer;
     INDEX ctDecoded = 0;
     while (ctDecoded<ctBytesToDecode) {
       long iRes = pov_read(sdc_pogg->ogg_vfVorbisFile, pch, ctBytesToDecode-ctDecoded, 
         0, 2, 1, &iCurrrentSection);
       if (iRes<=0) {
-        return ctDecoded;
+        break;
       }
       ctDecoded+=iRes;
       pch+=iRes;
     }
+
+    // [Cecil] Collect decoded audio for the cache
+    if (sdc_pcache!=NULL) {
+      CaptureDecoded(this, pvDestBuffer, ctDecoded, ctBytesToDecode);
+    }
     return ctDecoded;
 
   // if mpeg
   } else if (sdc_pmpeg!=NULL && sdc_pmpeg->mpeg_hDecoder!=0) {
     // decode mpeg
-    return palRead(sdc_pmpeg->mpeg_hDecoder, pvDestBuffer, ctBytesToDecode);
+    const INDEX ctDecoded = palRead(sdc_pmpeg->mpeg_hDecoder, pvDestBuffer, ctBytesToDecode);
+
+    // [Cecil] Collect decoded audio for the cache
+    if (sdc_pcache!=NULL) {
+      CaptureDecoded(this, pvDestBuffer, ctDecoded, ctBytesToDecode);
+    }
+    return ctDecoded;
 
   // if no decoder
   } else {
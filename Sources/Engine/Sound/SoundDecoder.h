@@ -19,10 +19,18 @@ class CSoundDecoder {
 public:
   class CDecodeData_MPEG *sdc_pmpeg;
   class CDecodeData_OGG  *sdc_pogg ;
+  class CDecodeStream    *sdc_pstream; // [Cecil] Decoded audio that is filled ahead of time on the streaming thread
+  BOOL sdc_bLoop; // [Cecil] Restart decoding upon reaching the end of the stream
+  class CDecodeData_PCM  *sdc_ppcm; // [Cecil] Fully decoded sound shared between decoders
+  SLONG sdc_slPCMOffset; // [Cecil] Current position in the fully decoded sound
+  class CDecodeCapture   *sdc_pcache; // [Cecil] Decoded audio that is collected for the cache during the first playback
+  CTFileName sdc_fnmSound; // [Cecil] Sound file that's being decoded
 
   // initialize/end the decoding support engine(s)
   static void InitPlugins(void);
   static void EndPlugins(void);
+  // [Cecil] Declare decoded audio cache settings
+  static void InitCache(void);
 
   // create a decoder that streams from file
   CSoundDecoder(const CTFileName &fnmStream);
@@ -38,4 +46,11 @@ public:
   INDEX Decode(void *pvDestBuffer, INDEX ctBytesToDecode);
   // reset decoder to start of sample
   void Reset(void);
+
+  // [Cecil] Start decoding the stream for playing (ahead of time on the streaming thread, if enabled)
+  void StartStreaming(BOOL bLoop);
+  // [Cecil] Read decoded bytes for mixing (underrun is set if the streaming thread couldn't keep up)
+  INDEX ReadStream(void *pvDestBuffer, INDEX ctBytes, BOOL &bUnderrun);
+  // [Cecil] Stop the streaming thread
+  static void EndStreamingThread(void);
 };
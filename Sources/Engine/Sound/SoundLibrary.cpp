@@ -74,6 +74,13 @@ FLOAT snd_tmOpenFailDelay = 0.5f;
 FLOAT snd_fEAXPanning = 0.0f;
 
 static FLOAT snd_fNormalizer = 0.9f;
+
+// [Cecil] Blocked mixer
+extern INDEX snd_bBlockedMixer;
+
+// [Cecil] Streaming thread settings
+extern INDEX snd_bStreamingThread;
+extern FLOAT snd_tmStreamAhead;
 static FLOAT _fLastNormalizeValue = 1;
 
 static BOOL _bMutedForMixing = FALSE;
@@ -133,6 +140,9 @@ void CSoundLibrary::DestroyInterface(void) {
     delete sl_pInterface;
     sl_pInterface = NULL;
   }
+
+  // [Cecil] Free decode buffers of the blocked mixer
+  FreeBlockedMixer();
 };
 
 // post sound console variables' functions
@@ -351,6 +361,12 @@ void CSoundLibrary::Init(void)
   _pShell->DeclareSymbol( "persistent user INDEX snd_iMaxOpenRetries;",   &snd_iMaxOpenRetries);
   _pShell->DeclareSymbol( "persistent user FLOAT snd_tmOpenFailDelay;",   &snd_tmOpenFailDelay);
   _pShell->DeclareSymbol( "persistent user FLOAT snd_fEAXPanning;", &snd_fEAXPanning);
+  _pShell->DeclareSymbol( "persistent user INDEX snd_bBlockedMixer;", &snd_bBlockedMixer); // [Cecil]
+  _pShell->DeclareSymbol( "persistent user INDEX snd_bStreamingThread;", &snd_bStreamingThread); // [Cecil]
+  _pShell->DeclareSymbol( "persistent user FLOAT snd_tmStreamAhead;", &snd_tmStreamAhead); // [Cecil]
+
+  // [Cecil] Decoded audio cache settings
+  CSoundDecoder::InitCache();
 
   // [Cecil] Display available audio devices for the current sound API
   _pShell->DeclareSymbol("user void snd_ListDevices(void);", &PrintAudioDevices);
@@ -595,6 +611,10 @@ void CSoundLibrary::MixSounds(void)
 
   BOOL bGamePaused = _pNetwork->IsPaused() || (_pNetwork->IsServer() && _pNetwork->GetLocalPause());
 
+  // [Cecil] Mix all sounds together in blocks
+  const BOOL bBlockedMixer = snd_bBlockedMixer;
+  if (bBlockedMixer) BeginBlockedMix();
+
   // for each sound
   FOREACHINLIST( CSoundData, sd_Node, _pSound->sl_ClhAwareList, itCsdSoundData) {
     FORDELETELIST( CSoundObject, so_Node, itCsdSoundData->sd_ClhLinkList, itCsoSoundObject) {
@@ -609,14 +629,25 @@ void CSoundLibrary::MixSounds(void)
           so.so_slFlags&SOF_PREPARE &&
         !(so.so_slFlags&SOF_PAUSED)) {
         // mix it
-        MixSound(&so);
+        if (bBlockedMixer) {
+          AddBlockedSound(&so); // [Cecil]
+        } else {
+          MixSound(&so);
+        }
       }
     }
   }
 
   // eventually normalize mixed sounds
   snd_fNormalizer = Clamp( snd_fNormalizer, 0.0f, 1.0f);
-  NormalizeMixerBuffer( snd_fNormalizer, slDataToMix, _fLastNormalizeValue);
+
+  // [Cecil] Mix all sounds and normalize them during conversion
+  if (bBlockedMixer) {
+    EndBlockedMix();
+    NormalizeFloatMixerBuffer(snd_fNormalizer, slDataToMix, _fLastNormalizeValue);
+  } else {
+    NormalizeMixerBuffer( snd_fNormalizer, slDataToMix, _fLastNormalizeValue);
+  }
 
   // TEMP! - write mixer buffer to file
   /*
@@ -41,6 +41,17 @@ void NormalizeMixerBuffer( const FLOAT snd_fNormalizer, const SLONG slBytes, FLO
 // mix in one sound object to mixer buffer
 void MixSound( class CSoundObject *pso);
 
+// [Cecil] Mix all sounds at once in small blocks into a float mixer buffer
+void BeginBlockedMix(void);
+void AddBlockedSound(class CSoundObject *pso);
+void EndBlockedMix(void);
+// [Cecil] Normalize float mixer buffer while converting it
+void NormalizeFloatMixerBuffer(const FLOAT fNormStrength, const SLONG slBytes, FLOAT &fLastNormValue);
+// [Cecil] Free memory used by the blocked mixer
+void FreeBlockedMixer(void);
+// [Cecil] Compare speed and output of the per-sound and the blocked mixers
+void BenchmarkMixers(INDEX ctIterations);
+
 
 /*
  * Timer handler for sound mixing.
@@ -26,6 +26,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Sound/SoundObject.h>
 #include <Engine/Base/Statistics_internal.h>
 #include <Engine/Base/Console.h>
+#include <Engine/Base/SIMDKernels.h> // [Cecil]
 
 // asm shortcuts
 #define O offset
@@ -126,35 +127,8 @@ void CopyMixerBuffer_mono( const SLONG slSrcOffset, void *pDstBuffer, const SLON
   ASSERT( slBytes%2==0);
   if( slBytes<4) return;
 
-#if SE1_USE_ASM
-  __asm {
-    mov     esi,D [slSrcOffset]
-    add     esi,D [pvMixerBuffer]
-    mov     edi,D [pDstBuffer]
-    mov     ecx,D [slBytes]
-    shr     ecx,2   // bytes to samples
-copyLoop:
-    movzx   eax,W [esi]
-    mov     W [edi],ax
-    add     esi,4
-    add     edi,2
-    dec     ecx
-    jnz     copyLoop
-  }
-
-#else
-  WORD *dst = (WORD *)pDstBuffer;
-  WORD *src = (WORD *)(((UBYTE *)pvMixerBuffer) + slSrcOffset);
-
-  SLONG max = slBytes / 4;
-
-  for (SLONG i = 0; i < max; i++)
-  {
-    *dst = *src;
-    dst += 1; // Move 16 bits
-    src += 2; // Move 32 bits
-  }
-#endif
+  // [Cecil] Use dispatched kernel
+  Kernel_ExtractSamples((const ULONG *)((UBYTE *)pvMixerBuffer + slSrcOffset), (UWORD *)pDstBuffer, slBytes / 4);
 }
 
 
@@ -164,41 +138,8 @@ static void ConvertMixerBuffer( const SLONG slBytes)
   ASSERT( slBytes%4==0);
   if( slBytes<4) return;
 
-#if SE1_USE_ASM
-  __asm {
-    cld
-    mov     esi,D [pvMixerBuffer]
-    mov     edi,D [pvMixerBuffer]
-    mov     ecx,D [slBytes]
-    shr     ecx,2 // bytes to samples (2 channels)
-copyLoop:
-    movq    mm0,Q [esi]
-    packssdw mm0,mm0
-    movd    D [edi],mm0
-    add     esi,8
-    add     edi,4
-    dec     ecx
-    jnz     copyLoop
-    emms
-  }
-
-#else
-  WORD *dst = (WORD *)pvMixerBuffer;
-  DWORD *src = (DWORD *)pvMixerBuffer;
-  SLONG max = slBytes / 2;
-
-  int tmp;
-  for (SLONG i = 0; i < max; i++)
-  {
-    tmp = *src;
-    tmp = Clamp(tmp, -32767, 32767);
-
-    *dst = tmp;
-
-    dst++;
-    src++;
-  }
-#endif
+  // [Cecil] Use dispatched kernel
+  Kernel_ConvertSamples((const SLONG *)pvMixerBuffer, (SWORD *)pvMixerBuffer, slBytes / 2);
 }
 
 
@@ -406,9 +347,6 @@ loopEnd:
   SQUAD fixSoundBufferSize = ((SQUAD)slSoundBufferSize) << 16;
   mmSurroundFactor = (SQUAD)(SWORD)mmSurroundFactor;
 
-  SLONG slLeftVolTmp = slLeftVolume >> 16;
-  SLONG slRightVolTmp = slRightVolume >> 16;
-
   // Loop through source buffer
   INDEX iCt = slMixerBufferSize;
   FOREVER
@@ -445,8 +383,8 @@ loopEnd:
     slLastRightSample += ((slRightSample - slLastRightSample) * slRightFilter) >> 15;
 
     // Apply stereo volume to current sample
-    slLeftSample = (slLastLeftSample * slLeftVolTmp) >> 15;
-    slRightSample = (slLastRightSample * slRightVolTmp) >> 15;
+    slLeftSample = (slLastLeftSample * (slLeftVolume >> 16)) >> 15;
+    slRightSample = (slLastRightSample * (slRightVolume >> 16)) >> 15;
 
     slLeftSample ^= (SLONG)((mmSurroundFactor >> 0) & 0xFFFFFFFF);
     slRightSample ^= (SLONG)((mmSurroundFactor >> 32) & 0xFFFFFFFF);
@@ -463,9 +401,9 @@ loopEnd:
     pslDstBuffer[0] = slLeftSample;
     pslDstBuffer[1] = slRightSample;
 
-    // Modify volume
-    slLeftVolume += (SWORD)((mmVolumeGain >>  0) & 0xFFFF);
-    slRightVolume += (SWORD)((mmVolumeGain >> 16) & 0xFFFF);
+    // [Cecil] Modify volume by 32-bit gains of both channels like the asm code does
+    slLeftVolume += (SLONG)(mmVolumeGain & 0xFFFFFFFF);
+    slRightVolume += (SLONG)(mmVolumeGain >> 32);
 
     // Advance to the next sample
     fixLeftOfs += fixLeftStep;
@@ -631,9 +569,6 @@ loopEnd:
   SQUAD fixSoundBufferSize = ((SQUAD)slSoundBufferSize) << 16;
   mmSurroundFactor = (SQUAD)(SWORD)mmSurroundFactor;
 
-  SLONG slLeftVolTmp = slLeftVolume >> 16;
-  SLONG slRightVolTmp = slRightVolume >> 16;
-
   // Loop through source buffer
   INDEX iCt = slMixerBufferSize;
   FOREVER
@@ -667,20 +602,20 @@ loopEnd:
     slRightSample = pswSrcBuffer[fixRightShift + 1];
     slNextRightSample = pswSrcBuffer[fixRightShift + 3];
 
-    // [Cecil] Shortcuts
-    const SWORD swLOffset = fixLeftOfs & 0xFFFF;
-    const SWORD swROffset = fixRightOfs & 0xFFFF;
+    // [Cecil] Shortcuts (fractions don't fit into signed words)
+    const SLONG slLOffset = fixLeftOfs & 0xFFFF;
+    const SLONG slROffset = fixRightOfs & 0xFFFF;
 
-    slLeftSample = (slLeftSample * (0xFFFF - swLOffset) + slNextLeftSample * swLOffset) >> 16;
-    slRightSample = (slRightSample * (0xFFFF - swROffset) + slNextRightSample * swROffset) >> 16;
+    slLeftSample = (slLeftSample * (0xFFFF - slLOffset) + slNextLeftSample * slLOffset) >> 16;
+    slRightSample = (slRightSample * (0xFFFF - slROffset) + slNextRightSample * slROffset) >> 16;
 
     // Filter samples
     slLastLeftSample += ((slLeftSample - slLastLeftSample) * slLeftFilter) >> 15;
     slLastRightSample += ((slRightSample - slLastRightSample) * slRightFilter) >> 15;
 
     // Apply stereo volume to current sample
-    slLeftSample = (slLastLeftSample * slLeftVolTmp) >> 15;
-    slRightSample = (slLastRightSample * slRightVolTmp) >> 15;
+    slLeftSample = (slLastLeftSample * (slLeftVolume >> 16)) >> 15;
+    slRightSample = (slLastRightSample * (slRightVolume >> 16)) >> 15;
 
     slLeftSample ^= (SLONG)((mmSurroundFactor >> 0) & 0xFFFFFFFF);
     slRightSample ^= (SLONG)((mmSurroundFactor >> 32) & 0xFFFFFFFF);
@@ -697,9 +632,9 @@ loopEnd:
     pslDstBuffer[0] = slLeftSample;
     pslDstBuffer[1] = slRightSample;
 
-    // Modify volume
-    slLeftVolume += (SWORD)((mmVolumeGain >> 0) & 0xFFFF);
-    slRightVolume += (SWORD)((mmVolumeGain >> 16) & 0xFFFF);
+    // [Cecil] Modify volume by 32-bit gains of both channels like the asm code does
+    slLeftVolume += (SLONG)(mmVolumeGain & 0xFFFFFFFF);
+    slRightVolume += (SLONG)(mmVolumeGain >> 32);
 
     // Advance to the next sample
     fixLeftOfs += fixLeftStep;
@@ -713,22 +648,50 @@ loopEnd:
 }
 
 
-// mixes one sound to destination buffer
-void MixSound( CSoundObject *pso)
+// [Cecil] State of one sound that is being mixed
+struct SMixerVoice {
+  CSoundObject *mv_pso;
+  BOOL mv_bRender; // Has anything to mix
+
+  // Source sound
+  const SWORD *mv_pswSrc;
+  SLONG mv_slSrcSize; // In samples per channel
+  SLONG mv_ctChannels;
+  BOOL mv_bNotLoop;
+  BOOL mv_bEndOfSound;
+
+  // Mixer parameters
+  SQUAD mv_fixLeftOfs, mv_fixRightOfs; // Fixed integers 48:16
+  SQUAD mv_fixLeftStep, mv_fixRightStep;
+  SLONG mv_slLeftVolume, mv_slRightVolume; // Fixed integers 16:16
+  SLONG mv_slLeftGain, mv_slRightGain; // Volume change per sample
+  SLONG mv_slLeftFilter, mv_slRightFilter;
+  SLONG mv_slLastLeftSample, mv_slLastRightSample;
+  SLONG mv_slSurround;
+
+  // For updating the sound after mixing
+  BOOL mv_bDecodingFinished;
+  FLOAT mv_fStepDelta;
+  FLOAT mv_fNewLeftVolume, mv_fNewRightVolume;
+};
+
+
+// [Cecil] Prepare one sound for mixing (returns FALSE if there's nothing to mix)
+static BOOL BeginMixSound(CSoundObject *pso, SMixerVoice &mv, void *pvDecodeBuffer)
 {
   psd = pso->so_pCsdLink;
 
   // if don't mix encoded sounds if they are not opened properly
   if((psd->sd_ulFlags&SDF_ENCODED) && 
     (pso->so_psdcDecoder==NULL || !pso->so_psdcDecoder->IsOpen()) ) {
-    return;
+    return FALSE;
   }
 
   // check for supported sound formats
   const SLONG slChannels = pso->so_pCsdLink->sd_wfeFormat.nChannels;
   const SLONG slBytes    = pso->so_pCsdLink->sd_wfeFormat.wBitsPerSample/8;
   // unsupported sound formats will be ignored
-  if( (slChannels!=1 && slChannels!=2) || slBytes!=2) return;
+  if( (slChannels!=1 && slChannels!=2) || slBytes!=2) return FALSE;
 
   // check for delay
   const FLOAT f1oMixerBufferSampleRate = 1.0f / slMixerBufferSampleRate;
@@ -736,7 +699,7 @@ void MixSound( CSoundObject *pso)
   pso->so_fDelayed += fSecondsToMix;
   if( pso->so_fDelayed < pso->so_sp.sp_fDelay) {
     _pfSoundProfile.IncrementCounter(CSoundProfile::PCI_SOUNDSDELAYED, 1);
-    return;
+    return FALSE;
   }
   // playing started, so skip further delays
   pso->so_fDelayed = 9999.9999f;
@@ -801,7 +764,7 @@ void MixSound( CSoundObject *pso)
     pso->so_fLastRightVolume = fNewRightVolume;
 
     _pfSoundProfile.IncrementCounter(CSoundProfile::PCI_SOUNDSSKIPPED, 1);
-    return;
+    return FALSE;
   }
   _sfStats.IncrementCounter(CStatForm::SCI_SOUNDSMIXING);
 
@@ -836,26 +799,22 @@ void MixSound( CSoundObject *pso)
     _pfSoundProfile.StartTimer(CSoundProfile::PTI_DECODESOUND);
     // decode some samples from it
     SLONG slWantedBytes  = FloatToInt(slMixerBufferSize*fStep*pso->so_pCsdLink->sd_wfeFormat.nChannels) *2;
-    void *pvDecodeBuffer = _pSound->sl_pInterface->m_pswDecodeBuffer;
     ASSERT(slWantedBytes<=_pSound->sl_pInterface->m_slDecodeBufferSize);
-    SLONG slDecodedBytes = pso->so_psdcDecoder->Decode( pvDecodeBuffer, slWantedBytes);
+    // [Cecil] Read samples that have been decoded ahead of time
+    BOOL bUnderrun = FALSE;
+    SLONG slDecodedBytes = pso->so_psdcDecoder->ReadStream( pvDecodeBuffer, slWantedBytes, bUnderrun);
     ASSERT(slDecodedBytes<=slWantedBytes);
-    // if it has a loop
-    if (!bNotLoop) {
-      // if sound is shorter than buffer
-      while(slDecodedBytes<slWantedBytes) {
-        // decode it again and again
-        pso->so_psdcDecoder->Reset();
-        slDecodedBytes += pso->so_psdcDecoder->Decode( ((UBYTE*)pvDecodeBuffer) +
-                                                       slDecodedBytes, slWantedBytes-slDecodedBytes);
-      }
-    // if it doesn't have a loop
-    } else {
-      // if sound is shorter than buffer
-      if(slDecodedBytes<slWantedBytes) {
-        // mark that it is finished
-        bDecodingFinished = TRUE;
-      }
+
+    // [Cecil] If the streaming thread couldn't keep up, fill the rest with silence
+    if (bUnderrun) {
+      _pfSoundProfile.IncrementCounter(CSoundProfile::PCI_STREAMUNDERRUNS, 1);
+      memset(((UBYTE*)pvDecodeBuffer) + slDecodedBytes, 0, slWantedBytes-slDecodedBytes);
+      slDecodedBytes = slWantedBytes;
+
+    // if it doesn't have a loop and sound is shorter than buffer
+    } else if (bNotLoop && slDecodedBytes<slWantedBytes) {
+      // mark that it is finished
+      bDecodingFinished = TRUE;
     }
     // copy first sample to the last one (this is needed for linear interpolation)
     (ULONG&)(((UBYTE*)pvDecodeBuffer)[slDecodedBytes]) = *(ULONG*)pvDecodeBuffer;
@@ -898,6 +857,14 @@ void MixSound( CSoundObject *pso)
   fRightStep += fStepDeltaR;
   fStepDelta  = fStepDeltaR-fStepDeltaL;
 
+  // [Cecil] Remember everything needed for updating the sound after mixing
+  mv.mv_pso = pso;
+  mv.mv_bRender = FALSE;
+  mv.mv_bDecodingFinished = bDecodingFinished;
+  mv.mv_fStepDelta = fStepDelta;
+  mv.mv_fNewLeftVolume = fNewLeftVolume;
+  mv.mv_fNewRightVolume = fNewRightVolume;
+
   // if there is anything to mix (could be nothing when encoded file just finished)
   if( slSoundBufferSize>0) {
     // safety check (needed because of bad-bug!)
@@ -923,49 +890,585 @@ void MixSound( CSoundObject *pso)
       slRightFilter = slLeftFilter;
     }
 
-    // call corresponding mixer routine for current sound format
-    bEndOfSound = FALSE;
-    if( slChannels==2) {
-      // mix as 16-bit stereo
-      MixStereo( pso);
-    } else {
-      // mix as 16-bit mono
-      MixMono( pso);
-    }
+    // [Cecil] Mix the sound from here
+    mv.mv_bRender = TRUE;
   }
 
+  // [Cecil] Remember mixer state of this sound
+  mv.mv_pswSrc = pswSrcBuffer;
+  mv.mv_slSrcSize = slSoundBufferSize;
+  mv.mv_ctChannels = slChannels;
+  mv.mv_bNotLoop = bNotLoop;
+  mv.mv_bEndOfSound = FALSE;
+  mv.mv_fixLeftOfs = (SQUAD)(fLeftOfs * 65536.0f);
+  mv.mv_fixRightOfs = (SQUAD)(fRightOfs * 65536.0f);
+  mv.mv_fixLeftStep = (SQUAD)(fLeftStep * 65536.0f);
+  mv.mv_fixRightStep = (SQUAD)(fRightStep * 65536.0f);
+  mv.mv_slLeftVolume = slLeftVolume;
+  mv.mv_slRightVolume = slRightVolume;
+  mv.mv_slLeftGain = (SLONG)(mmVolumeGain & 0xFFFFFFFF);
+  mv.mv_slRightGain = (SLONG)(mmVolumeGain >> 32);
+  mv.mv_slLeftFilter = slLeftFilter;
+  mv.mv_slRightFilter = slRightFilter;
+  mv.mv_slLastLeftSample = slLastLeftSample;
+  mv.mv_slLastRightSample = slLastRightSample;
+  mv.mv_slSurround = (mmSurroundFactor != 0 ? -1 : 0);
+
+  _pfSoundProfile.StopTimer(CSoundProfile::PTI_MIXSOUND);
+  return TRUE;
+}
+
+// [Cecil] Update sound object after mixing it
+static void EndMixSound(SMixerVoice &mv)
+{
+  _pfSoundProfile.StartTimer(CSoundProfile::PTI_MIXSOUND);
+
+  CSoundObject *pso = mv.mv_pso;
+  BOOL bEnd = mv.mv_bEndOfSound;
+
   // if encoded sound
-  if( psd->sd_ulFlags&SDF_ENCODED) {
+  if( pso->so_pCsdLink->sd_ulFlags&SDF_ENCODED) {
     // ignore mixing finished flag, but use decoding finished flag
-    bEndOfSound = bDecodingFinished;
+    bEnd = mv.mv_bDecodingFinished;
   }
 
   // if sound ended, not buffer
-  if( bEndOfSound) {
+  if( bEnd) {
     // reset some sound vars
-    slLastLeftSample  = 0;
-    slLastRightSample = 0;
+    mv.mv_slLastLeftSample  = 0;
+    mv.mv_slLastRightSample = 0;
     pso->so_slFlags  &= ~SOF_PLAY;
     pso->so_fDelayed     = 0.0f;
     pso->so_sp.sp_fDelay = 0.0f;
   }
 
   // rememer last samples for the next mix in
-  pso->so_swLastLeftSample  = (SWORD)slLastLeftSample;
-  pso->so_swLastRightSample = (SWORD)slLastRightSample;
+  pso->so_swLastLeftSample  = (SWORD)mv.mv_slLastLeftSample;
+  pso->so_swLastRightSample = (SWORD)mv.mv_slLastRightSample;
   // determine new phase shift offset
-  pso->so_fOffsetDelta += fStepDelta*slMixerBufferSize;
+  pso->so_fOffsetDelta += mv.mv_fStepDelta*slMixerBufferSize;
   // update play offset for the next mix iteration
-  pso->so_fLeftOffset  = fixLeftOfs  * (1.0f/65536.0f);
-  pso->so_fRightOffset = fixRightOfs * (1.0f/65536.0f);
+  pso->so_fLeftOffset  = mv.mv_fixLeftOfs  * (1.0f/65536.0f);
+  pso->so_fRightOffset = mv.mv_fixRightOfs * (1.0f/65536.0f);
   // update volume
-  pso->so_fLastLeftVolume  = fNewLeftVolume;
-  pso->so_fLastRightVolume = fNewRightVolume;
+  pso->so_fLastLeftVolume  = mv.mv_fNewLeftVolume;
+  pso->so_fLastRightVolume = mv.mv_fNewRightVolume;
 
-  //if( pso->so_fLastLeftVolume>0 || pso->so_fLastRightVolume>0 || fNewLeftVolume>0 || fNewRightVolume>0) {
-  //  CPrintF( "SO: 0x%8X; OV: %.4f / %.4f, NV: %.4f / %.4f\n", pso,
-  //            pso->so_fLastLeftVolume,pso->so_fLastRightVolume, fNewLeftVolume,fNewRightVolume);
-  //}
   _pfSoundProfile.StopTimer(CSoundProfile::PTI_MIXSOUND);
 }
 
+// mixes one sound to destination buffer
+void MixSound( CSoundObject *pso)
+{
+  // [Cecil] Prepare the sound
+  SMixerVoice mv;
+  if (!BeginMixSound(pso, mv, _pSound->sl_pInterface->m_pswDecodeBuffer)) return;
+
+  _pfSoundProfile.StartTimer(CSoundProfile::PTI_MIXSOUND);
+
+  // [Cecil] Mix it through the whole buffer
+  if (mv.mv_bRender) {
+    // call corresponding mixer routine for current sound format
+    bEndOfSound = FALSE;
+    if( mv.mv_ctChannels==2) {
+      // mix as 16-bit stereo
+      MixStereo( pso);
+    } else {
+      // mix as 16-bit mono
+      MixMono( pso);
+    }
+
+    mv.mv_fixLeftOfs = fixLeftOfs;
+    mv.mv_fixRightOfs = fixRightOfs;
+    mv.mv_slLastLeftSample = slLastLeftSample;
+    mv.mv_slLastRightSample = slLastRightSample;
+    mv.mv_bEndOfSound = bEndOfSound;
+  }
+
+  _pfSoundProfile.StopTimer(CSoundProfile::PTI_MIXSOUND);
+
+  // [Cecil] Update the sound
+  EndMixSound(mv);
+}
+
+
+// [Cecil] Blocked mixer
+
+// Mix all sounds together in small blocks of samples instead of mixing each sound through the whole buffer
+INDEX snd_bBlockedMixer = TRUE;
+
+// Sample frames per block (small enough to keep the block in the cache while all sounds are mixed into it)
+static const INDEX _ctMixerBlockFrames = 256;
+
+// Sounds that are being mixed
+static CStaticStackArray<SMixerVoice> _amvVoices;
+
+// Separate decode buffers for each encoded sound
+static CStaticStackArray<SWORD *> _apswDecodeBuffers;
+static SLONG _slDecodeBuffersSize = 0;
+static INDEX _ctDecodeBuffersUsed = 0;
+
+// Highest absolute sample in the mixed buffer
+static FLOAT _fMixerPeak = 0.0f;
+
+// Mix one block of a sound into 32-bit samples (returns amount of mixed sample frames)
+template<BOOL bStereo> static
+INDEX MixVoiceBlock(SMixerVoice &mv, SLONG *pslDst, INDEX ctFrames)
+{
+  // Cache sound parameters
+  const SWORD *pswSrc = mv.mv_pswSrc;
+  const SQUAD fixSoundBufferSize = ((SQUAD)mv.mv_slSrcSize) << 16;
+  const SQUAD fixLeftStep = mv.mv_fixLeftStep;
+  const SQUAD fixRightStep = mv.mv_fixRightStep;
+  const SLONG slLeftGain = mv.mv_slLeftGain;
+  const SLONG slRightGain = mv.mv_slRightGain;
+  const SLONG slLeftFilter = mv.mv_slLeftFilter;
+  const SLONG slRightFilter = mv.mv_slRightFilter;
+  const SLONG slSurround = mv.mv_slSurround;
+
+  SQUAD fixLeft = mv.mv_fixLeftOfs;
+  SQUAD fixRight = mv.mv_fixRightOfs;
+  SLONG slLastLeft = mv.mv_slLastLeftSample;
+  SLONG slLastRight = mv.mv_slLastRightSample;
+  SLONG slLeftVolume = mv.mv_slLeftVolume;
+  SLONG slRightVolume = mv.mv_slRightVolume;
+  INDEX iFrame = 0;
+
+  // Same math as the per-sound mixer loops
+  FOREVER {
+    // If source samples came to the end of sample buffer
+    if (fixLeft >= fixSoundBufferSize) {
+      fixLeft -= fixSoundBufferSize;
+      mv.mv_bEndOfSound = mv.mv_bNotLoop;
+    }
+
+    if (fixRight >= fixSoundBufferSize) {
+      fixRight -= fixSoundBufferSize;
+      mv.mv_bEndOfSound = mv.mv_bNotLoop;
+    }
+
+    // End of block
+    if (iFrame >= ctFrames || mv.mv_bEndOfSound) break;
+
+    SLONG slLeft, slRight;
+
+    // Fetch lineary interpolated samples
+    if (bStereo) {
+      const SQUAD fixLeftShift = (fixLeft >> 16) << 1;
+      const SQUAD fixRightShift = (fixRight >> 16) << 1;
+      const SLONG slLOffset = fixLeft & 0xFFFF;
+      const SLONG slROffset = fixRight & 0xFFFF;
+
+      slLeft  = ((SLONG)pswSrc[fixLeftShift  + 0] * (0xFFFF - slLOffset) + (SLONG)pswSrc[fixLeftShift  + 2] * slLOffset) >> 16;
+      slRight = ((SLONG)pswSrc[fixRightShift + 1] * (0xFFFF - slROffset) + (SLONG)pswSrc[fixRightShift + 3] * slROffset) >> 16;
+
+    } else {
+      const SQUAD fixLeftFrac = fixLeft & 0xFFFF;
+      const SQUAD fixRightFrac = fixRight & 0xFFFF;
+
+      slLeft  = (pswSrc[(fixLeft  >> 16) + 0] * (0xFFFF - fixLeftFrac)  + pswSrc[(fixLeft  >> 16) + 1] * fixLeftFrac)  >> 16;
+      slRight = (pswSrc[(fixRight >> 16) + 0] * (0xFFFF - fixRightFrac) + pswSrc[(fixRight >> 16) + 1] * fixRightFrac) >> 16;
+    }
+
+    // Filter samples
+    slLastLeft  += ((slLeft  - slLastLeft)  * slLeftFilter)  >> 15;
+    slLastRight += ((slRight - slLastRight) * slRightFilter) >> 15;
+
+    // Apply stereo volume and ramp it towards the new one
+    pslDst[iFrame * 2 + 0] = ((slLastLeft  * (slLeftVolume  >> 16)) >> 15) ^ slSurround;
+    pslDst[iFrame * 2 + 1] = ((slLastRight * (slRightVolume >> 16)) >> 15) ^ slSurround;
+    slLeftVolume  += slLeftGain;
+    slRightVolume += slRightGain;
+
+    // Advance to the next sample
+    fixLeft  += fixLeftStep;
+    fixRight += fixRightStep;
+    iFrame++;
+  }
+
+  mv.mv_fixLeftOfs = fixLeft;
+  mv.mv_fixRightOfs = fixRight;
+  mv.mv_slLastLeftSample = slLastLeft;
+  mv.mv_slLastRightSample = slLastRight;
+  mv.mv_slLeftVolume = slLeftVolume;
+  mv.mv_slRightVolume = slRightVolume;
+
+  return iFrame;
+}
+
+// Start mixing sounds in blocks
+void BeginBlockedMix(void)
+{
+  _amvVoices.PopAll();
+  _ctDecodeBuffersUsed = 0;
+
+  // Reallocate decode buffers if their size has changed
+  const SLONG slDecodeSize = _pSound->sl_pInterface->m_slDecodeBufferSize;
+
+  if (_slDecodeBuffersSize != slDecodeSize) {
+    FreeBlockedMixer();
+    _slDecodeBuffersSize = slDecodeSize;
+  }
+}
+
+// Prepare one sound for mixing in blocks
+void AddBlockedSound(CSoundObject *pso)
+{
+  // Encoded sounds need their own decode buffer while all sounds are mixed at once
+  const BOOL bEncoded = (pso->so_pCsdLink->sd_ulFlags & SDF_ENCODED);
+  SWORD *pswDecodeBuffer = NULL;
+
+  if (bEncoded) {
+    if (_ctDecodeBuffersUsed == _apswDecodeBuffers.Count()) {
+      _apswDecodeBuffers.Push() = (SWORD *)AllocMemory(_slDecodeBuffersSize + 4);
+    }
+
+    pswDecodeBuffer = _apswDecodeBuffers[_ctDecodeBuffersUsed];
+  }
+
+  SMixerVoice &mv = _amvVoices.Push();
+
+  if (!BeginMixSound(pso, mv, pswDecodeBuffer)) {
+    _amvVoices.Pop();
+    return;
+  }
+
+  if (bEncoded) _ctDecodeBuffersUsed++;
+}
+
+// Mix all prepared sounds into the float mixer buffer
+static void MixBlockedVoices(void)
+{
+  // Mixer buffer is zeroed, which is the same in floats
+  FLOAT *pfMixerBuffer = (FLOAT *)pvMixerBuffer;
+  SLONG aslBlock[_ctMixerBlockFrames * 2];
+  const INDEX ctVoices = _amvVoices.Count();
+  _fMixerPeak = 0.0f;
+
+  for (INDEX iFirstFrame = 0; iFirstFrame < slMixerBufferSize; iFirstFrame += _ctMixerBlockFrames) {
+    const INDEX ctFrames = Min(_ctMixerBlockFrames, INDEX(slMixerBufferSize - iFirstFrame));
+    FLOAT *pfBlock = pfMixerBuffer + iFirstFrame * 2;
+
+    for (INDEX iVoice = 0; iVoice < ctVoices; iVoice++) {
+      SMixerVoice &mv = _amvVoices[iVoice];
+      if (!mv.mv_bRender || mv.mv_bEndOfSound) continue;
+
+      INDEX ctMixed;
+
+      if (mv.mv_ctChannels == 2) {
+        ctMixed = MixVoiceBlock<TRUE>(mv, aslBlock, ctFrames);
+      } else {
+        ctMixed = MixVoiceBlock<FALSE>(mv, aslBlock, ctFrames);
+      }
+
+      Kernel_AccumulateSamples(pfBlock, aslBlock, ctMixed * 2);
+    }
+
+    // Find peak while the block is still in the cache
+    _fMixerPeak = Max(_fMixerPeak, Kernel_FindPeak(pfBlock, ctFrames * 2));
+  }
+}
+
+// Mix all prepared sounds into the float mixer buffer and update them
+void EndBlockedMix(void)
+{
+  _pfSoundProfile.StartTimer(CSoundProfile::PTI_RAWMIXER);
+  MixBlockedVoices();
+  _pfSoundProfile.StopTimer(CSoundProfile::PTI_RAWMIXER);
+
+  const INDEX ctVoices = _amvVoices.Count();
+
+  for (INDEX iVoice = 0; iVoice < ctVoices; iVoice++) {
+    EndMixSound(_amvVoices[iVoice]);
+  }
+
+  _amvVoices.PopAll();
+}
+
+// Normalize float mixer buffer while converting it into 16-bit samples
+void NormalizeFloatMixerBuffer(const FLOAT fNormStrength, const SLONG slBytes, FLOAT &fLastNormValue)
+{
+  ASSERT( slBytes%4==0);
+  if( slBytes<8) return;
+
+  const FLOAT *pfSrc = (const FLOAT *)pvMixerBuffer;
+  SWORD *pswDst = (SWORD *)pvMixerBuffer;
+  const INDEX iSamples = slBytes/2; // 16-bit was assumed -> samples (treat as mono)
+
+  // just convert to 16-bit if normalization isn't required
+  if( fNormStrength<0.01f) {
+    Kernel_ConvertFloatSamples(pfSrc, pswDst, iSamples, 1.0f, 0.0f, 1.0f);
+    return;
+  }
+
+  // avoid division by zero
+  if (_fMixerPeak == 0.0f) {
+    fLastNormValue = 1.0f;
+    Kernel_ConvertFloatSamples(pfSrc, pswDst, iSamples, 1.0f, 0.0f, 1.0f);
+    return;
+  }
+
+  // determine normalize value and skip normalization if maximize is required (do not increase volume!)
+  FLOAT fNormValue = 32767.0f / _fMixerPeak;
+  if( fNormValue>0.99f && fLastNormValue>0.99f) { // should be enough to tolerate
+    fLastNormValue = 1.0f;
+    Kernel_ConvertFloatSamples(pfSrc, pswDst, iSamples, 1.0f, 0.0f, 1.0f);
+    return;
+  }
+
+  // adjust normalize value by strength
+  ASSERT( fNormStrength>=0 && fNormStrength<=1);
+  fNormValue = Lerp( 1.0f, fNormValue, fNormStrength);
+  const FLOAT fNormAdd = (fNormValue-fLastNormValue) / (iSamples/4);
+
+  // normalize and convert to 16-bit in one pass
+  Kernel_ConvertFloatSamples(pfSrc, pswDst, iSamples, fLastNormValue, fNormAdd, fNormValue);
+
+  // remember normalization value at the end of the buffer
+  FLOAT fCurrentNormValue = fLastNormValue + fNormAdd * iSamples;
+       if( fCurrentNormValue<fNormValue && fNormAdd<0) fCurrentNormValue = fNormValue;
+  else if( fCurrentNormValue>fNormValue && fNormAdd>0) fCurrentNormValue = fNormValue;
+  fLastNormValue = fCurrentNormValue;
+}
+
+// Free memory used by the blocked mixer
+void FreeBlockedMixer(void)
+{
+  for (INDEX i = 0; i < _apswDecodeBuffers.Count(); i++) {
+    FreeMemory(_apswDecodeBuffers[i]);
+  }
+
+  _apswDecodeBuffers.Clear();
+  _amvVoices.Clear();
+  _slDecodeBuffersSize = 0;
+  _ctDecodeBuffersUsed = 0;
+}
+
+// Set up the same test sound for the per-sound mixer and for a blocked mixer voice
+static void SetBenchmarkVoice(SMixerVoice &mv, const SWORD *pswSrc, SLONG slSrcFrames, SLONG slChannels, SLONG slDstFrames,
+  INDEX iVoice = 0)
+{
+  pswSrcBuffer = (SWORD *)pswSrc;
+  slSoundBufferSize = slSrcFrames;
+  bNotLoop = FALSE;
+  bEndOfSound = FALSE;
+
+  // Slightly different pitch on each channel (and different positions and pitch for each voice)
+  fLeftOfs = 0.25f + iVoice * 1009.0f;
+  fRightOfs = 0.75f + iVoice * 1013.0f;
+  fLeftStep = 0.9071f + iVoice * 0.0517f;
+  fRightStep = 1.0813f - iVoice * 0.0431f;
+
+  // Volumes fading in opposite directions over the whole buffer
+  slLeftVolume  = FloatToInt(0.3f * 65536 * 32767.0f);
+  slRightVolume = FloatToInt(0.9f * 65536 * 32767.0f);
+  const SLONG slLeftGain  = FloatToInt(( 0.6f * 65536 * 32767.0f) / slDstFrames);
+  const SLONG slRightGain = FloatToInt((-0.7f * 65536 * 32767.0f) / slDstFrames);
+  mmVolumeGain = ((SQUAD)(slRightGain) << 32) | ((SQUAD)(slLeftGain) & 0xFFFFFFFF);
+
+  slLeftFilter = 0x5000;
+  slRightFilter = 0x7FFF;
+  slLastLeftSample = 0;
+  slLastRightSample = 0;
+  mmSurroundFactor = 0;
+
+  mv.mv_pso = NULL;
+  mv.mv_bRender = TRUE;
+  mv.mv_pswSrc = pswSrc;
+  mv.mv_slSrcSize = slSrcFrames;
+  mv.mv_ctChannels = slChannels;
+  mv.mv_bNotLoop = bNotLoop;
+  mv.mv_bEndOfSound = FALSE;
+  mv.mv_fixLeftOfs = (SQUAD)(fLeftOfs * 65536.0f);
+  mv.mv_fixRightOfs = (SQUAD)(fRightOfs * 65536.0f);
+  mv.mv_fixLeftStep = (SQUAD)(fLeftStep * 65536.0f);
+  mv.mv_fixRightStep = (SQUAD)(fRightStep * 65536.0f);
+  mv.mv_slLeftVolume = slLeftVolume;
+  mv.mv_slRightVolume = slRightVolume;
+  mv.mv_slLeftGain = slLeftGain;
+  mv.mv_slRightGain = slRightGain;
+  mv.mv_slLeftFilter = slLeftFilter;
+  mv.mv_slRightFilter = slRightFilter;
+  mv.mv_slLastLeftSample = slLastLeftSample;
+  mv.mv_slLastRightSample = slLastRightSample;
+  mv.mv_slSurround = 0;
+}
+
+// Compare speed and output of the per-sound and the blocked mixers
+void BenchmarkMixers(INDEX ctIterations)
+{
+  if (_pSound == NULL) return;
+
+  // Mixer variables are shared with the sound thread
+  CTSingleLock slSounds(&_pSound->sl_csSound, TRUE);
+
+  void *pvOldBuffer = pvMixerBuffer;
+  const SLONG slOldBufferSize = slMixerBufferSize;
+
+  // One second of 44.1 kHz stereo sound mixed into 4096 sample frames
+  const SLONG slSrcFrames = 44100;
+  const SLONG slDstFrames = 4096;
+
+  // One extra frame for interpolating the last one
+  SWORD *pswSrc = (SWORD *)AllocMemory((slSrcFrames + 1) * 2 * sizeof(SWORD));
+  SLONG *pslOld = (SLONG *)AllocMemory(slDstFrames * 2 * sizeof(SLONG));
+  SLONG *pslNew = (SLONG *)AllocMemory(slDstFrames * 2 * sizeof(SLONG));
+
+  ULONG ulRandom = 0x1234567;
+
+  for (INDEX iSample = 0; iSample < slSrcFrames * 2; iSample++) {
+    ulRandom = ulRandom * 1103515245 + 12345;
+    pswSrc[iSample] = (SWORD)(ulRandom >> 16);
+  }
+
+  pswSrc[slSrcFrames * 2 + 0] = pswSrc[0];
+  pswSrc[slSrcFrames * 2 + 1] = pswSrc[1];
+
+  CPutString(TRANS("Mixer benchmark:\n"));
+
+  for (SLONG slChannels = 2; slChannels >= 1; slChannels--) {
+    // Mono sounds use the same data as twice as many frames
+    const SLONG slFrames = slSrcFrames * 2 / slChannels;
+    SMixerVoice mv;
+
+    // Mix the sound through the whole buffer
+    pvMixerBuffer = pslOld;
+    slMixerBufferSize = slDstFrames;
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+    for (INDEX iIter = 0; iIter < ctIterations; iIter++) {
+      memset(pslOld, 0, slDstFrames * 2 * sizeof(SLONG));
+      SetBenchmarkVoice(mv, pswSrc, slFrames, slChannels, slDstFrames);
+
+      if (slChannels == 2) {
+        MixStereo(NULL);
+      } else {
+        MixMono(NULL);
+      }
+    }
+
+    const DOUBLE dOld = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+    // Mix the sound in blocks
+    tvStart = _pTimer->GetHighPrecisionTimer();
+
+    for (INDEX iIter = 0; iIter < ctIterations; iIter++) {
+      SetBenchmarkVoice(mv, pswSrc, slFrames, slChannels, slDstFrames);
+
+      for (INDEX iFirstFrame = 0; iFirstFrame < slDstFrames; iFirstFrame += _ctMixerBlockFrames) {
+        const INDEX ctFrames = Min(_ctMixerBlockFrames, INDEX(slDstFrames - iFirstFrame));
+
+        if (slChannels == 2) {
+          MixVoiceBlock<TRUE>(mv, pslNew + iFirstFrame * 2, ctFrames);
+        } else {
+          MixVoiceBlock<FALSE>(mv, pslNew + iFirstFrame * 2, ctFrames);
+        }
+      }
+    }
+
+    const DOUBLE dNew = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+    // Compare clamped samples (assembly mixers interpolate with less precision)
+    INDEX ctDifferent = 0;
+    SLONG slMaxDiff = 0;
+
+    for (INDEX iSample = 0; iSample < slDstFrames * 2; iSample++) {
+      const SLONG slNew = Clamp(pslNew[iSample], (SLONG)MIN_SWORD, (SLONG)MAX_SWORD);
+      const SLONG slDiff = Abs(slNew - pslOld[iSample]);
+
+      if (slDiff != 0) {
+        ctDifferent++;
+        slMaxDiff = Max(slMaxDiff, slDiff);
+      }
+    }
+
+    CPrintF("  %s:\n", slChannels == 2 ? "MixStereo" : "MixMono");
+    CPrintF("    %-7s %8.3f ms\n", "old", dOld * 1000.0);
+    CPrintF("    %-7s %8.3f ms (x%.2f, ", "blocked", dNew * 1000.0, dOld / ClampDn(dNew, 1e-9));
+
+    if (ctDifferent == 0) {
+      CPutString(TRANS("exact)\n"));
+    } else {
+      CPrintF(TRANS("%d of %d samples differ by up to %d)\n"), ctDifferent, slDstFrames * 2, slMaxDiff);
+    }
+  }
+
+  // Mix several mono and stereo voices together and normalize the result, like the sound thread does
+  const INDEX ctBenchVoices = 8;
+  const SLONG slBytes = slDstFrames * 2 * sizeof(SWORD);
+  FLOAT fOldNorm = 1.0f;
+  FLOAT fNewNorm = 1.0f;
+
+  pvMixerBuffer = pslOld;
+  slMixerBufferSize = slDstFrames;
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX iIter = 0; iIter < ctIterations; iIter++) {
+    memset(pslOld, 0, slDstFrames * 2 * sizeof(SLONG));
+
+    for (INDEX iVoice = 0; iVoice < ctBenchVoices; iVoice++) {
+      const SLONG slChannels = (iVoice & 1) ? 1 : 2;
+      SMixerVoice mv;
+      SetBenchmarkVoice(mv, pswSrc, slSrcFrames * 2 / slChannels, slChannels, slDstFrames, iVoice);
+
+      if (slChannels == 2) {
+        MixStereo(NULL);
+      } else {
+        MixMono(NULL);
+      }
+    }
+
+    fOldNorm = 1.0f;
+    NormalizeMixerBuffer(1.0f, slBytes, fOldNorm);
+  }
+
+  const DOUBLE dOld = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+  // Voices of the sound thread are mixed by now
+  ASSERT(_amvVoices.Count() == 0);
+  const FLOAT fOldPeak = _fMixerPeak;
+
+  pvMixerBuffer = pslNew;
+  tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX iIter = 0; iIter < ctIterations; iIter++) {
+    memset(pslNew, 0, slDstFrames * 2 * sizeof(SLONG));
+    _amvVoices.PopAll();
+
+    for (INDEX iVoice = 0; iVoice < ctBenchVoices; iVoice++) {
+      const SLONG slChannels = (iVoice & 1) ? 1 : 2;
+      SetBenchmarkVoice(_amvVoices.Push(), pswSrc, slSrcFrames * 2 / slChannels, slChannels, slDstFrames, iVoice);
+    }
+
+    MixBlockedVoices();
+
+    fNewNorm = 1.0f;
+    NormalizeFloatMixerBuffer(1.0f, slBytes, fNewNorm);
+  }
+
+  const DOUBLE dNew = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+  _amvVoices.PopAll();
+  _fMixerPeak = fOldPeak;
+
+  // Compare normalized 16-bit samples
+  const SWORD *pswOld = (const SWORD *)pslOld;
+  const SWORD *pswNew = (const SWORD *)pslNew;
+  SLONG slMaxDiff = 0;
+
+  for (INDEX iSample = 0; iSample < slDstFrames * 2; iSample++) {
+    slMaxDiff = Max(slMaxDiff, (SLONG)Abs(pswNew[iSample] - pswOld[iSample]));
+  }
+
+  CPrintF(TRANS("  %d voices with normalization:\n"), ctBenchVoices);
+  CPrintF("    %-7s %8.3f ms\n", "old", dOld * 1000.0);
+  CPrintF("    %-7s %8.3f ms (x%.2f, ", "blocked", dNew * 1000.0, dOld / ClampDn(dNew, 1e-9));
+  CPrintF(TRANS("max difference %d, %s)\n"), slMaxDiff, slMaxDiff <= 1 ? TRANS("within 1 LSB") : TRANS("over 1 LSB"));
+
+  FreeMemory(pswSrc);
+  FreeMemory(pslOld);
+  FreeMemory(pslNew);
+
+  pvMixerBuffer = pvOldBuffer;
+  slMixerBufferSize = slOldBufferSize;
+}
@@ -31,6 +31,8 @@ CDynamicContainer<Type>::CDynamicContainer(void) {
   // Not locked
   dc_LockCt = 0;
 #endif
+
+  dc_bIndexed = FALSE; // [Cecil]
 };
 
 // Copy constructor
@@ -41,6 +43,8 @@ CDynamicContainer<Type>::CDynamicContainer(const CDynamicContainer<Type> &dcOrig
   dc_LockCt = 0;
 #endif
 
+  dc_bIndexed = FALSE; // [Cecil]
+
   // Copy container contents
   (*this) = dcOriginal;
 };
@@ -56,6 +60,9 @@ template<class Type>
 void CDynamicContainer<Type>::Clear(void) {
   ASSERT(this != NULL);
   CStaticStackArray<Type *>::Clear();
+
+  // [Cecil] Index will be recreated for new members
+  dc_aisIndex.Clear();
 };
 
 // Add a given object to the container
@@ -63,6 +70,16 @@ template<class Type>
 void CDynamicContainer<Type>::Add(Type *ptNewObject) {
   // Set the new pointer
   this->Push() = ptNewObject;
+
+  // [Cecil] Remember its position
+  if (dc_bIndexed) {
+    // Keep the index at most half full
+    if (this->Count() * 2 > dc_aisIndex.Count()) {
+      IndexRebuild();
+    } else {
+      IndexSet(ptNewObject, this->Count() - 1);
+    }
+  }
 };
 
 // Insert a given object in the container at a specified position
@@ -80,6 +97,11 @@ void CDynamicContainer<Type>::Insert(Type *ptNewObject, const INDEX iPos)
 
   // Store pointer to the newly inserted member at a specified position
   *pptInsertAt = ptNewObject;
+
+  // [Cecil] Positions of all following members have changed
+  if (dc_bIndexed) {
+    IndexRebuild();
+  }
 };
 
 // Remove a given object from the container
@@ -103,9 +125,19 @@ void CDynamicContainer<Type>::Remove(Type *ptOldObject)
 
   // Move last pointer here
   INDEX iLast = this->Count() - 1;
-  this->sa_Array[iMember] = this->sa_Array[iLast];
+  Type *ptLast = this->sa_Array[iLast];
+  this->sa_Array[iMember] = ptLast;
   this->sa_Array[iLast] = NULL;
   this->Pop();
+
+  // [Cecil] Forget the removed member and update position of the moved one
+  if (dc_bIndexed) {
+    IndexRemove(ptOldObject);
+
+    if (iMember != iLast) {
+      IndexSet(ptLast, iMember);
+    }
+  }
 };
 
 // Check if a given object is in the container
@@ -114,6 +146,11 @@ BOOL CDynamicContainer<Type>::IsMember(Type *ptOldObject)
 {
   ASSERT(this != NULL);
 
+  // [Cecil] Look it up
+  if (dc_bIndexed) {
+    return IndexFind(ptOldObject) != -1;
+  }
+
   // Check all members (slow!)
   for (INDEX iMember = 0; iMember < this->Count(); iMember++) {
     if (this->sa_Array[iMember] == ptOldObject) {
@@ -204,6 +241,19 @@ template<class Type>
 INDEX CDynamicContainer<Type>::GetIndex(Type *ptMember) {
   ASSERT(this != NULL);
 
+  // [Cecil] Look it up
+  if (dc_bIndexed) {
+    const INDEX iMember = IndexFind(ptMember);
+
+    // Index must be in sync with the container
+    ASSERT(iMember == -1 || this->sa_Array[iMember] == ptMember);
+
+    if (iMember != -1) return iMember;
+
+    ASSERTALWAYS("CDynamicContainer<Type><>::Index(): Not a member of this container!");
+    return -1;
+  }
+
   // Check all members (slow!)
   for (INDEX iMember = 0; iMember < this->Count(); iMember++) {
     if (this->sa_Array[iMember] == ptMember) {
@@ -220,6 +270,12 @@ template<class Type>
 CDynamicContainer<Type> &CDynamicContainer<Type>::operator=(const CDynamicContainer<Type> &coOriginal)
 {
   CStaticStackArray<Type *>::operator=(coOriginal);
+
+  // [Cecil] Index new members
+  if (dc_bIndexed) {
+    IndexRebuild();
+  }
+
   return *this;
 };
 
@@ -235,6 +291,153 @@ void CDynamicContainer<Type>::MoveContainer(CDynamicContainer<Type> &coOther)
 #endif
 
   CStaticStackArray<Type *>::MoveArray(coOther);
+
+  // [Cecil] Index new members
+  if (dc_bIndexed) {
+    IndexRebuild();
+  }
+
+  if (coOther.dc_bIndexed) {
+    coOther.IndexRebuild();
+  }
+};
+
+// [Cecil] Enable or disable the member index
+template<class Type>
+void CDynamicContainer<Type>::SetIndexed(BOOL bState)
+{
+  dc_bIndexed = bState;
+
+  if (dc_bIndexed) {
+    IndexRebuild();
+  } else {
+    dc_aisIndex.Clear();
+  }
+};
+
+// [Cecil] Get home slot of a member in the index
+template<class Type>
+inline INDEX CDynamicContainer<Type>::IndexHomeSlot(const Type *ptMember) const
+{
+  // Fibonacci hashing of the address without the alignment bits
+  const ULONG ulHash = ULONG(size_t(ptMember) >> 3) * 0x9E3779B1UL;
+  return INDEX(ulHash & (dc_aisIndex.Count() - 1));
+};
+
+// [Cecil] Find member's position using the index (-1 if not a member)
+template<class Type>
+INDEX CDynamicContainer<Type>::IndexFind(const Type *ptMember) const
+{
+  const INDEX ctSlots = dc_aisIndex.Count();
+  if (ctSlots == 0) return -1;
+
+  INDEX iSlot = IndexHomeSlot(ptMember);
+
+  // Linear probing until an empty slot
+  FOREVER {
+    const SIndexSlot &is = dc_aisIndex[iSlot];
+
+    if (is.is_ptMember == NULL) return -1;
+    if (is.is_ptMember == ptMember) return is.is_iMember;
+
+    iSlot = (iSlot + 1) & (ctSlots - 1);
+  }
+};
+
+// [Cecil] Set member's position in the index
+template<class Type>
+void CDynamicContainer<Type>::IndexSet(Type *ptMember, INDEX iMember)
+{
+  const INDEX ctSlots = dc_aisIndex.Count();
+  ASSERT(ctSlots > 0);
+
+  INDEX iSlot = IndexHomeSlot(ptMember);
+
+  // Find its slot or the first empty one
+  FOREVER {
+    SIndexSlot &is = dc_aisIndex[iSlot];
+
+    if (is.is_ptMember == NULL || is.is_ptMember == ptMember) {
+      is.is_ptMember = ptMember;
+      is.is_iMember = iMember;
+      return;
+    }
+
+    iSlot = (iSlot + 1) & (ctSlots - 1);
+  }
+};
+
+// [Cecil] Remove a member from the index
+template<class Type>
+void CDynamicContainer<Type>::IndexRemove(const Type *ptMember)
+{
+  const INDEX ctSlots = dc_aisIndex.Count();
+  if (ctSlots == 0) return;
+
+  // Find its slot
+  INDEX iSlot = IndexHomeSlot(ptMember);
+
+  FOREVER {
+    const Type *ptSlot = dc_aisIndex[iSlot].is_ptMember;
+
+    if (ptSlot == NULL) return;
+    if (ptSlot == ptMember) break;
+
+    iSlot = (iSlot + 1) & (ctSlots - 1);
+  }
+
+  // Shift following members of the same probe sequence back into the freed slot
+  INDEX iFree = iSlot;
+
+  FOREVER {
+    dc_aisIndex[iFree].is_ptMember = NULL;
+    INDEX iNext = iFree;
+
+    FOREVER {
+      iNext = (iNext + 1) & (ctSlots - 1);
+      const SIndexSlot &is = dc_aisIndex[iNext];
+
+      // End of the sequence
+      if (is.is_ptMember == NULL) return;
+
+      // Distances from the home slot to the free slot and to the current one
+      const INDEX iHome = IndexHomeSlot(is.is_ptMember);
+      const INDEX iDistFree = (iFree - iHome) & (ctSlots - 1);
+      const INDEX iDistNext = (iNext - iHome) & (ctSlots - 1);
+
+      // Can be moved into the free slot
+      if (iDistFree < iDistNext) {
+        dc_aisIndex[iFree] = is;
+        iFree = iNext;
+        break;
+      }
+    }
+  }
+};
+
+// [Cecil] Rebuild the index for all current members
+template<class Type>
+void CDynamicContainer<Type>::IndexRebuild(void)
+{
+  const INDEX ctMembers = this->Count();
+
+  // Keep at most a quarter of slots used after rebuilding
+  INDEX ctSlots = 16;
+
+  while (ctSlots < ctMembers * 4) {
+    ctSlots *= 2;
+  }
+
+  dc_aisIndex.Clear();
+  dc_aisIndex.New(ctSlots);
+
+  for (INDEX iSlot = 0; iSlot < ctSlots; iSlot++) {
+    dc_aisIndex[iSlot].is_ptMember = NULL;
+  }
+
+  for (INDEX iMember = 0; iMember < ctMembers; iMember++) {
+    IndexSet(this->sa_Array[iMember], iMember);
+  }
 };
 
 // CDynamicContainerIterator
@@ -30,6 +30,17 @@ class CDynamicContainer : public CStaticStackArray<Type *> {
     INDEX da_LockCt; // Lock counter for getting indices
   #endif
 
+    // [Cecil] Slot of the optional member index
+    struct SIndexSlot {
+      Type *is_ptMember; // NULL if unused
+      INDEX is_iMember;
+    };
+
+    // [Cecil] Optional hash table that maps members to their positions in the container
+    // (makes Remove(), IsMember() and GetIndex() take constant time instead of linear)
+    CStaticArray<SIndexSlot> dc_aisIndex;
+    BOOL dc_bIndexed;
+
   public:
     // Default constructor
     CDynamicContainer(void);
@@ -93,6 +104,27 @@ class CDynamicContainer : public CStaticStackArray<Type *> {
 
     // Move all elements of another container into this one
     void MoveContainer(CDynamicContainer<Type> &coOther);
+
+  public:
+    // [Cecil] Enable or disable the member index
+    // NOTE: Indexed containers must only be modified through the methods of this class
+    void SetIndexed(BOOL bState);
+
+  private:
+    // [Cecil] Get home slot of a member in the index
+    inline INDEX IndexHomeSlot(const Type *ptMember) const;
+
+    // [Cecil] Find member's position using the index (-1 if not a member)
+    INDEX IndexFind(const Type *ptMember) const;
+
+    // [Cecil] Set member's position in the index
+    void IndexSet(Type *ptMember, INDEX iMember);
+
+    // [Cecil] Remove a member from the index
+    void IndexRemove(const Type *ptMember);
+
+    // [Cecil] Rebuild the index for all current members
+    void IndexRebuild(void);
 };
 
 // [Cecil] Inline definition
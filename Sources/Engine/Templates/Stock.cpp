@@ -15,6 +15,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
 
 #include <Engine/Base/Stream.h>
+#include <Engine/Base/Timer.h>
 
 #include <Engine/Templates/DynamicContainer.cpp>
 
@@ -23,6 +24,13 @@ template<class Type>
 CResourceStock<Type>::CResourceStock()
 {
   st_ntObjects.SetAllocationParameters(50, 2, 2);
+
+  // [Cecil] Stocks are locked in any order
+  st_csLock.cs_eIndex = EThreadMutexType::E_MTX_IGNORE;
+  st_slUnusedMemory = 0;
+
+  // [Cecil] Index objects for fast removal
+  st_ctObjects.SetIndexed(TRUE);
 };
 
 // Destructor
@@ -30,38 +38,67 @@ template<class Type>
 CResourceStock<Type>::~CResourceStock()
 {
   // Free all unused elements of the stock
-  FreeUnused_internal();
+  FreeAllUnused();
 };
 
 // Obtain an object from stock - loads if not loaded
 template<class Type>
 Type *CResourceStock<Type>::Obtain_internal_t(const CTFileName &fnmFileName)
 {
-  // Find stocked object with same name
-  Type *pExisting = st_ntObjects.Find(fnmFileName);
+  CTSingleLock slStock(&st_csLock, TRUE); // [Cecil]
+  BOOL bWaiting = FALSE; // [Cecil]
+
+  FOREVER {
+    // Find stocked object with same name
+    Type *pExisting = st_ntObjects.Find(fnmFileName);
+
+    // Not found
+    if (pExisting == NULL) break;
+
+    // [Cecil] Wait until another thread finishes loading it, unless it's loaded by this thread
+    // (when it obtains itself) or by threads that wait for this one, in which case it's returned as is
+    if (IsLoading(pExisting) && pExisting->StartWaitingForLoad()) {
+      bWaiting = TRUE;
+
+      slStock.Unlock();
+      _pTimer->Suspend(0);
+      slStock.Lock();
+      continue;
+    }
+
+    if (bWaiting) CSerial::StopWaitingForLoad(); // [Cecil]
 
-  // If found
-  if (pExisting != NULL) {
     // Mark that it is used once again
+    // [Cecil] This also removes it from unused objects
     pExisting->MarkUsed();
 
     // Return its pointer
     return pExisting;
   }
 
+  if (bWaiting) CSerial::StopWaitingForLoad(); // [Cecil]
+
   // Create a new stock object, if not found
   Type *ptNew = new Type;
   ptNew->ser_FileName = fnmFileName;
+  ptNew->ser_pcsStock = &st_csLock; // [Cecil]
+  ptNew->ser_pslStockUnused = &st_slUnusedMemory; // [Cecil]
 
   st_ctObjects.Add(ptNew);
   st_ntObjects.Add(ptNew);
 
+  // [Cecil] Let other threads use the stock while it's loading
+  ptNew->StartLoadingInStock();
+  slStock.Unlock();
+
   // Try to load it
   try {
     ptNew->Load_t(fnmFileName);
 
   // Failed to load
   } catch (char *) {
+    slStock.Lock();
+    ptNew->StopLoadingInStock(); // [Cecil]
     st_ctObjects.Remove(ptNew);
     st_ntObjects.Remove(ptNew);
 
@@ -69,6 +106,9 @@ Type *CResourceStock<Type>::Obtain_internal_t(const CTFileName &fnmFileName)
     throw;
   }
 
+  slStock.Lock();
+  ptNew->StopLoadingInStock(); // [Cecil]
+
   // Mark that it is used for the first time
   //ASSERT(!ptNew->IsUsed());
   ptNew->MarkUsed();
@@ -77,19 +117,81 @@ Type *CResourceStock<Type>::Obtain_internal_t(const CTFileName &fnmFileName)
   return ptNew;
 };
 
+// [Cecil] Start obtaining an object from stock on a worker thread
+template<class Type>
+void CResourceStock<Type>::ObtainAsync_internal(const CTFileName &fnmFileName, CStockRequest<Type> &sr)
+{
+  // Previous request must be finished
+  sr.sr_jg.Wait();
+
+  sr.sr_pStock = this;
+  sr.sr_fnmFileName = fnmFileName;
+  sr.sr_ptObject = NULL;
+  sr.sr_strError = "";
+
+  sr.sr_jg.Add(&CStockRequest<Type>::ObtainJob, &sr, 0);
+};
+
+// [Cecil] Job for obtaining the object on a worker thread
+template<class Type>
+void CStockRequest<Type>::ObtainJob(void *pData, INDEX iItem)
+{
+  CStockRequest<Type> &sr = *(CStockRequest<Type> *)pData;
+
+  // Let the object defer whatever has to be done on the main thread
+  const BOOL bWasInBackground = IsObtainingInBackground();
+  SetObtainingInBackground(TRUE);
+
+  try {
+    sr.sr_ptObject = sr.sr_pStock->Obtain_internal_t(sr.sr_fnmFileName);
+
+  } catch (char *strError) {
+    sr.sr_strError = strError;
+  }
+
+  SetObtainingInBackground(bWasInBackground);
+};
+
+// [Cecil] Wait for the object and return it (throws the error if it couldn't be obtained)
+template<class Type>
+Type *CStockRequest<Type>::Get_t(void)
+{
+  sr_jg.Wait();
+
+  if (sr_ptObject == NULL) {
+    ThrowF_t("%s", sr_strError.ConstData());
+  }
+
+  return sr_ptObject;
+};
+
 // Release an object when it's not needed any more
 template<class Type>
 void CResourceStock<Type>::Release_internal(Type *ptObject) {
+  CTSingleLock slStock(&st_csLock, TRUE); // [Cecil]
+
   // Mark that it is used once less
   ptObject->MarkUnused();
 
-  // If it is not used at all anymore and should be freed automatically
-  if (!ptObject->IsUsed() && ptObject->IsAutoFreed()) {
+  // Still used
+  if (ptObject->IsUsed()) return;
+
+  // If it should be freed automatically
+  if (ptObject->IsAutoFreed()) {
     // Remove and delete it
     st_ctObjects.Remove(ptObject);
     st_ntObjects.Remove(ptObject);
 
     delete ptObject;
+    return;
+  }
+
+  // [Cecil] Remember it as the most recently used one
+  AddUnused(ptObject);
+
+  // [Cecil] Keep only as many objects as the budget allows
+  if (res_iUnusedStockKB > 0) {
+    FreeUnusedOverBudget(res_iUnusedStockKB * 1024);
   }
 };
 
@@ -97,41 +199,108 @@ void CResourceStock<Type>::Release_internal(Type *ptObject) {
 template<class Type>
 void CResourceStock<Type>::FreeUnused_internal(void)
 {
-  BOOL bAnyRemoved;
+  CTSingleLock slStock(&st_csLock, TRUE); // [Cecil]
+
+  // [Cecil] Keep the most recently used objects in the budget
+  if (res_iUnusedStockKB > 0) {
+    FreeUnusedOverBudget(res_iUnusedStockKB * 1024);
+  } else {
+    FreeAllUnused();
+  }
+};
+
+// [Cecil] Free all unused elements from the stock regardless of the budget
+template<class Type>
+void CResourceStock<Type>::FreeAllUnused(void)
+{
+  CTSingleLock slStock(&st_csLock, TRUE);
 
+  // Deleted objects release their dependencies into the unused list, so they are freed in the same loop
+  // and objects are only rescanned in case some of them have been unreferenced without being released
   do {
-    // Fill a container with objects that should be freed
-    CDynamicContainer<Type> ctToFree;
+    FreeUnusedOverBudget(0);
+  } while (AddUnreleased() > 0);
+};
+
+// [Cecil] Remember an object as the most recently used one among unused objects
+template<class Type>
+void CResourceStock<Type>::AddUnused(Type *ptObject)
+{
+  ASSERT(!ptObject->ser_lnUnused.IsLinked());
+
+  ptObject->ser_slUnusedMemory = ClampDn(ptObject->GetUsedMemory(), (SLONG)0);
+  st_slUnusedMemory += ptObject->ser_slUnusedMemory;
+  st_lhUnused.AddTail(ptObject->ser_lnUnused);
+};
+
+// [Cecil] Forget that an object is unused
+template<class Type>
+void CResourceStock<Type>::RemoveUnused(Type *ptObject)
+{
+  ptObject->RemoveFromUnused();
+};
+
+// [Cecil] Add objects that became unused without being released to the unused list
+template<class Type>
+INDEX CResourceStock<Type>::AddUnreleased(void)
+{
+  INDEX ctAdded = 0;
+
+  FOREACHINDYNAMICCONTAINER(st_ctObjects, Type, itt) {
+    Type *ptObject = itt;
 
-    {FOREACHINDYNAMICCONTAINER(st_ctObjects, Type, itt) {
-      if (!itt->IsUsed()) {
-        ctToFree.Add(itt);
-      }
-    }}
+    if (!ptObject->IsUsed() && !IsLoading(ptObject) && !ptObject->ser_lnUnused.IsLinked()) {
+      AddUnused(ptObject);
+      ctAdded++;
+    }
+  }
+
+  return ctAdded;
+};
+
+// [Cecil] Delete least recently used objects until their memory fits into the budget
+template<class Type>
+void CResourceStock<Type>::FreeUnusedOverBudget(SLONG slBudget)
+{
+  // Deleting an object may release more objects from this stock, which are added to the end
+  while (!st_lhUnused.IsEmpty() && (slBudget == 0 || st_slUnusedMemory > slBudget))
+  {
+    // Take the least recently used object
+    Type *ptObject = static_cast<Type *>(LIST_HEAD(st_lhUnused, CSerial, ser_lnUnused));
+    RemoveUnused(ptObject);
 
-    bAnyRemoved = ctToFree.Count() > 0;
+    // Never free objects that have been marked as used again
+    if (ptObject->IsUsed()) continue;
 
-    // Go through objects that should be freed
-    {FOREACHINDYNAMICCONTAINER(ctToFree, Type, itt) {
-      // Remove and delete it
-      st_ctObjects.Remove(itt);
-      st_ntObjects.Remove(itt);
+    // Remove and delete it
+    st_ctObjects.Remove(ptObject);
+    st_ntObjects.Remove(ptObject);
 
-      delete (&*itt);
-    }}
+    delete ptObject;
+  }
+};
 
-  // Go for as long as there is something to remove
-  } while (bAnyRemoved);
+// [Cecil] Check if an object with some file name is in the stock
+template<class Type>
+BOOL CResourceStock<Type>::IsStocked(const CTFileName &fnmFileName)
+{
+  CTSingleLock slStock(&st_csLock, TRUE);
+  return st_ntObjects.Find(fnmFileName) != NULL;
 };
 
 // Calculate amount of memory used by all objects in the stock
 template<class Type>
 SLONG CResourceStock<Type>::CalculateUsedMemory(void)
 {
+  CTSingleLock slStock(&st_csLock, TRUE); // [Cecil]
+
   SLONG slUsedTotal = 0;
 
   // Go through all stock objects
   FOREACHINDYNAMICCONTAINER(st_ctObjects, Type, itt) {
+    // [Cecil] Not loaded yet
+    if (IsLoading(itt)) continue;
+
     SLONG slUsedByObject = itt->GetUsedMemory();
 
     // Invalid memory
@@ -150,11 +319,16 @@ SLONG CResourceStock<Type>::CalculateUsedMemory(void)
 template<class Type>
 void CResourceStock<Type>::DumpMemoryUsage_t(CTStream &strm)
 {
+  CTSingleLock slStock(&st_csLock, TRUE); // [Cecil]
+
   CTString strLine;
   SLONG slUsedTotal = 0;
 
   // Go through all stock objects
   FOREACHINDYNAMICCONTAINER(st_ctObjects, Type, itt) {
+    // [Cecil] Not loaded yet
+    if (IsLoading(itt)) continue;
+
     SLONG slUsedByObject = itt->GetUsedMemory();
 
     // Invalid memory
@@ -181,6 +355,8 @@ INDEX CResourceStock<Type>::GetTotalCount(void) {
 template<class Type>
 INDEX CResourceStock<Type>::GetUsedCount(void)
 {
+  CTSingleLock slStock(&st_csLock, TRUE); // [Cecil]
+
   INDEX ctUsed = 0;
 
   // Go through all stock objects
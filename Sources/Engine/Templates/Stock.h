@@ -21,8 +21,55 @@ with this program; if not, write to the Free Software Foundation, Inc.,
   #pragma once
 #endif
 
+#include <Engine/Base/Lists.h>
+#include <Engine/Base/ListIterator.inl>
+#include <Engine/Base/Synchronization.h>
+#include <Engine/Base/WorkerThreads.h>
 #include <Engine/Templates/DynamicContainer.h>
 #include <Engine/Templates/NameTable.h>
+#include <Engine/Templates/StaticStackArray.h>
+
+// [Cecil] Memory in KB of unused objects that each stock keeps cached (0 keeps all of them until FreeUnused())
+ENGINE_API extern INDEX res_iUnusedStockKB;
+
+// [Cecil] Check if this thread is obtaining an object in the background
+// (resources that must be created on the main thread should be deferred, if it is)
+ENGINE_API BOOL IsObtainingInBackground(void);
+
+// [Cecil] Mark that this thread is obtaining an object in the background
+ENGINE_API void SetObtainingInBackground(BOOL bState);
+
+template<class Type> class CResourceStock;
+
+// [Cecil] Handle of an object that's being obtained from a stock in the background
+// NOTE: The handle must stay alive until the request is finished
+template<class Type>
+class CStockRequest {
+  public:
+    CResourceStock<Type> *sr_pStock; // Stock to obtain the object from
+    CTFileName sr_fnmFileName; // File of the object
+    Type *sr_ptObject; // Obtained object (NULL until finished or if failed)
+    CTString sr_strError; // Error from obtaining the object
+    CJobGroup sr_jg; // Job that obtains the object
+
+  public:
+    // Constructor
+    CStockRequest(void) : sr_pStock(NULL), sr_ptObject(NULL) {};
+
+    // Check if the object has been obtained or failed to be
+    inline BOOL IsReady(void) const {
+      return sr_jg.IsDone();
+    };
+
+    // Wait for the object and return it (throws the error if it couldn't be obtained)
+    Type *Get_t(void);
+
+  private:
+    // Job for obtaining the object on a worker thread
+    static void ObtainJob(void *pData, INDEX iItem);
+
+    friend class CResourceStock<Type>;
+};
 
 // Stock template of some kind of objects which can be saved and loaded
 template<class Type>
@@ -31,6 +78,10 @@ class CResourceStock {
     CDynamicContainer<Type> st_ctObjects; // Objects in the stock
     CNameTable<Type, false> st_ntObjects; // Name table for fast lookup
 
+    CTCriticalSection st_csLock; // [Cecil] Guards all stock data
+    CListHead st_lhUnused; // [Cecil] Unused objects from least to most recently used (linked via CSerial::ser_lnUnused)
+    SLONG st_slUnusedMemory; // [Cecil] Total memory used by unused objects
+
   public:
     // Default constructor
     CResourceStock();
@@ -42,6 +93,7 @@ class CResourceStock {
   public:
 
     static inline Type *Obtain_t(const CTFileName &fnmFileName);
+    static inline void ObtainAsync(const CTFileName &fnmFileName, CStockRequest<Type> &sr);
     static inline void Release(Type *ptObject);
     static inline void FreeUnused(void);
 
@@ -51,13 +103,41 @@ class CResourceStock {
     // Obtain an object from stock - loads if not loaded
     Type *Obtain_internal_t(const CTFileName &fnmFileName);
 
+    // [Cecil] Start obtaining an object from stock on a worker thread
+    void ObtainAsync_internal(const CTFileName &fnmFileName, CStockRequest<Type> &sr);
+
     // Release an object when it's not needed any more
     void Release_internal(Type *ptObject);
 
     // Free all unused elements from the stock
     void FreeUnused_internal(void);
 
+    // [Cecil] Free all unused elements from the stock regardless of the budget
+    void FreeAllUnused(void);
+
+    // [Cecil] Remember an object as the most recently used one among unused objects
+    void AddUnused(Type *ptObject);
+
+    // [Cecil] Forget that an object is unused
+    void RemoveUnused(Type *ptObject);
+
+    // [Cecil] Add objects that became unused without being released to the unused list
+    INDEX AddUnreleased(void);
+
+    // [Cecil] Delete least recently used objects until their memory fits into the budget
+    void FreeUnusedOverBudget(SLONG slBudget);
+
+    friend class CStockRequest<Type>;
+
   public:
+    // [Cecil] Check if an object is still being loaded (objects should only be accessed through the stock lock while loading)
+    static inline BOOL IsLoading(Type *ptObject) {
+      return ptObject->ser_bLoading;
+    };
+
+    // [Cecil] Check if an object with some file name is in the stock
+    BOOL IsStocked(const CTFileName &fnmFileName);
+
     // Calculate amount of memory used by all objects in the stock
     SLONG CalculateUsedMemory(void);
 
@@ -36,3 +36,19 @@ CStock_CShader *_pShaderStock = NULL;
 CStock_CSkeleton *_pSkeletonStock = NULL;
 CStock_CSoundData *_pSoundStock = NULL;
 CStock_CTextureData *_pTextureStock = NULL;
+
+// [Cecil] Memory in KB of unused objects that each stock keeps cached (0 keeps all of them until FreeUnused())
+INDEX res_iUnusedStockKB = 0;
+
+// [Cecil] Set on worker threads while they are obtaining objects for stock requests
+static SE1_THREADLOCAL BOOL _bObtainingInBackground = FALSE;
+
+// [Cecil] Check if this thread is obtaining an object in the background
+BOOL IsObtainingInBackground(void) {
+  return _bObtainingInBackground;
+};
+
+// [Cecil] Mark that this thread is obtaining an object in the background
+void SetObtainingInBackground(BOOL bState) {
+  _bObtainingInBackground = bState;
+};
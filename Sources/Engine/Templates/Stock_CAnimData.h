@@ -38,6 +38,17 @@ CAnimData *CStock_CAnimData::Obtain_t(const CTFileName &fnmFileName) {
   return _pAnimStock->Obtain_internal_t(fnmFileName);
 };
 
+// [Cecil] Obtain the resource on a worker thread
+template<> inline
+void CStock_CAnimData::ObtainAsync(const CTFileName &fnmFileName, CStockRequest<CAnimData> &sr) {
+  if (_pAnimStock == NULL) {
+    ASSERTALWAYS("No stock to obtain the resource from!");
+    return;
+  }
+
+  _pAnimStock->ObtainAsync_internal(fnmFileName, sr);
+};
+
 template<> inline
 void CStock_CAnimData::Release(CAnimData *ptObject) {
   if (_pAnimStock == NULL) return;
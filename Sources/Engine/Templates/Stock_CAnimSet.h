@@ -38,6 +38,17 @@ CAnimSet *CStock_CAnimSet::Obtain_t(const CTFileName &fnmFileName) {
   return _pAnimSetStock->Obtain_internal_t(fnmFileName);
 };
 
+// [Cecil] Obtain the resource on a worker thread
+template<> inline
+void CStock_CAnimSet::ObtainAsync(const CTFileName &fnmFileName, CStockRequest<CAnimSet> &sr) {
+  if (_pAnimSetStock == NULL) {
+    ASSERTALWAYS("No stock to obtain the resource from!");
+    return;
+  }
+
+  _pAnimSetStock->ObtainAsync_internal(fnmFileName, sr);
+};
+
 template<> inline
 void CStock_CAnimSet::Release(CAnimSet *ptObject) {
   if (_pAnimSetStock == NULL) return;
@@ -38,6 +38,17 @@ CMesh *CStock_CMesh::Obtain_t(const CTFileName &fnmFileName) {
   return _pMeshStock->Obtain_internal_t(fnmFileName);
 };
 
+// [Cecil] Obtain the resource on a worker thread
+template<> inline
+void CStock_CMesh::ObtainAsync(const CTFileName &fnmFileName, CStockRequest<CMesh> &sr) {
+  if (_pMeshStock == NULL) {
+    ASSERTALWAYS("No stock to obtain the resource from!");
+    return;
+  }
+
+  _pMeshStock->ObtainAsync_internal(fnmFileName, sr);
+};
+
 template<> inline
 void CStock_CMesh::Release(CMesh *ptObject) {
   if (_pMeshStock == NULL) return;
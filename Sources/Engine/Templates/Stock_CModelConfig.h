@@ -38,6 +38,17 @@ CModelConfig *CStock_CModelConfig::Obtain_t(const CTFileName &fnmFileName) {
   return _pModelConfigStock->Obtain_internal_t(fnmFileName);
 };
 
+// [Cecil] Obtain the resource on a worker thread
+template<> inline
+void CStock_CModelConfig::ObtainAsync(const CTFileName &fnmFileName, CStockRequest<CModelConfig> &sr) {
+  if (_pModelConfigStock == NULL) {
+    ASSERTALWAYS("No stock to obtain the resource from!");
+    return;
+  }
+
+  _pModelConfigStock->ObtainAsync_internal(fnmFileName, sr);
+};
+
 template<> inline
 void CStock_CModelConfig::Release(CModelConfig *ptObject) {
   if (_pModelConfigStock == NULL) return;
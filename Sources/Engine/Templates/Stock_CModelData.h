@@ -39,6 +39,17 @@ CModelData *CStock_CModelData::Obtain_t(const CTFileName &fnmFileName) {
   return _pModelStock->Obtain_internal_t(fnmFileName);
 };
 
+// [Cecil] Obtain the resource on a worker thread
+template<> inline
+void CStock_CModelData::ObtainAsync(const CTFileName &fnmFileName, CStockRequest<CModelData> &sr) {
+  if (_pModelStock == NULL) {
+    ASSERTALWAYS("No stock to obtain the resource from!");
+    return;
+  }
+
+  _pModelStock->ObtainAsync_internal(fnmFileName, sr);
+};
+
 template<> inline
 void CStock_CModelData::Release(CModelData *ptObject) {
   if (_pModelStock == NULL) return;
@@ -38,6 +38,17 @@ CSkeleton *CStock_CSkeleton::Obtain_t(const CTFileName &fnmFileName) {
   return _pSkeletonStock->Obtain_internal_t(fnmFileName);
 };
 
+// [Cecil] Obtain the resource on a worker thread
+template<> inline
+void CStock_CSkeleton::ObtainAsync(const CTFileName &fnmFileName, CStockRequest<CSkeleton> &sr) {
+  if (_pSkeletonStock == NULL) {
+    ASSERTALWAYS("No stock to obtain the resource from!");
+    return;
+  }
+
+  _pSkeletonStock->ObtainAsync_internal(fnmFileName, sr);
+};
+
 template<> inline
 void CStock_CSkeleton::Release(CSkeleton *ptObject) {
   if (_pSkeletonStock == NULL) return;
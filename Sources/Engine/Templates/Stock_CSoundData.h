@@ -38,6 +38,17 @@ CSoundData *CStock_CSoundData::Obtain_t(const CTFileName &fnmFileName) {
   return _pSoundStock->Obtain_internal_t(fnmFileName);
 };
 
+// [Cecil] Obtain the resource on a worker thread
+template<> inline
+void CStock_CSoundData::ObtainAsync(const CTFileName &fnmFileName, CStockRequest<CSoundData> &sr) {
+  if (_pSoundStock == NULL) {
+    ASSERTALWAYS("No stock to obtain the resource from!");
+    return;
+  }
+
+  _pSoundStock->ObtainAsync_internal(fnmFileName, sr);
+};
+
 template<> inline
 void CStock_CSoundData::Release(CSoundData *ptObject) {
   if (_pSoundStock == NULL) return;
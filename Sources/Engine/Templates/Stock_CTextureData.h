@@ -38,6 +38,17 @@ CTextureData *CStock_CTextureData::Obtain_t(const CTFileName &fnmFileName) {
   return _pTextureStock->Obtain_internal_t(fnmFileName);
 };
 
+// [Cecil] Obtain the resource on a worker thread
+template<> inline
+void CStock_CTextureData::ObtainAsync(const CTFileName &fnmFileName, CStockRequest<CTextureData> &sr) {
+  if (_pTextureStock == NULL) {
+    ASSERTALWAYS("No stock to obtain the resource from!");
+    return;
+  }
+
+  _pTextureStock->ObtainAsync_internal(fnmFileName, sr);
+};
+
 template<> inline
 void CStock_CTextureData::Release(CTextureData *ptObject) {
   if (_pTextureStock == NULL) return;
@@ -0,0 +1,345 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#include "StdH.h"
+
+#include <Engine/World/ShadowBaking.h>
+#include <Engine/World/World.h>
+#include <Engine/Brushes/Brush.h>
+#include <Engine/Brushes/BrushArchive.h>
+#include <Engine/Base/Stream.h>
+#include <Engine/Base/ListIterator.inl>
+#include <Engine/Base/ErrorReporting.h>
+#include <Engine/Base/Translation.h>
+
+// Version of baked shadow map parts
+#define SHADOWBAKE_VERSION 1
+
+// Render flags that are set on sectors and polygons while calculating shadow maps
+#define SECTOR_RENDERFLAGS  (BSCF_INVISIBLE | BSCF_NEEDSCLIPPING)
+#define POLYGON_RENDERFLAGS (BPOF_RENDERASPORTAL | BPOF_RENDERTRANSLUCENT)
+
+CShadowBaker *_psbRendering = NULL;
+
+// Reset shadow map indices for each sector or polygon
+static void ResetMapIndices(CStaticArray<INDEX> &aiMaps, INDEX ct) {
+  aiMaps.Clear();
+  aiMaps.New(ct);
+
+  for (INDEX i = 0; i < ct; i++) {
+    aiMaps[i] = -1;
+  }
+};
+
+// Discard all shadows in the world and remember polygons that need their shadow maps recalculated
+void CShadowBaker::Prepare(CWorld &wo) {
+  sb_pwoWorld = &wo;
+  sb_apbpoQueued.PopAll();
+
+  // Discard and queue shadow maps the same way as when recalculating shadows in the editor
+  wo.DiscardAllShadows();
+
+  // Polygons and sectors are identified by their indices, which are the same in every copy of the world
+  CBrushArchive &ba = wo.wo_baBrushes;
+  ba.MakeIndices();
+
+  const INDEX ctPolygons = ba.ba_apbpo.Count();
+  const INDEX ctSectors = ba.ba_apbsc.Count();
+
+  ResetMapIndices(sb_aiPolygonMap, ctPolygons);
+  ResetMapIndices(sb_aiPolygonWritten, ctPolygons);
+  ResetMapIndices(sb_aiSectorTouched, ctSectors);
+  ResetMapIndices(sb_aiSectorVisible, ctSectors);
+  ResetMapIndices(sb_aiSectorVisiblePrev, ctSectors);
+
+  // Queue shadow maps in the same order as CWorld::CalculateDirectionalShadows() goes through them
+  FOREACHINLIST(CBrushShadowMap, bsm_lnInUncalculatedShadowMaps, ba.ba_lhUncalculatedShadowMaps, itbsm) {
+    CBrushPolygon *pbpo = itbsm->GetBrushPolygon();
+
+    sb_aiPolygonMap[pbpo->bpo_iInWorld] = sb_apbpoQueued.Count();
+    sb_apbpoQueued.Push() = pbpo;
+  }
+};
+
+// Calculate every ctParts-th shadow map starting from iPart (returns number of calculated shadow maps)
+INDEX CShadowBaker::Bake(INDEX iPart, INDEX ctParts) {
+  ASSERT(sb_pwoWorld != NULL);
+  ASSERT(iPart >= 0 && iPart < ctParts);
+
+  INDEX ctBaked = 0;
+  _psbRendering = this;
+
+  for (INDEX iMap = iPart; iMap < Count(); iMap += ctParts) {
+    // Calculate all layers at once, like CWorld::CalculateDirectionalShadows() does
+    sb_iCurrentMap = iMap;
+    sb_apbpoQueued[iMap]->MakeShadowMap(sb_pwoWorld, TRUE);
+    ctBaked++;
+  }
+
+  _psbRendering = NULL;
+  sb_iCurrentMap = -1;
+
+  return ctBaked;
+};
+
+// Remember a sector that has been added to rendering of the current shadow map
+void CShadowBaker::SectorRendered(CBrushSector &bsc) {
+  const INDEX iSector = bsc.bsc_iInWorld;
+
+  // Visibility flag is set on every added sector
+  sb_aiSectorTouched[iSector] = sb_iCurrentMap;
+
+  // The rest is only set on visible sectors and their polygons
+  if (bsc.bsc_ulFlags & BSCF_INVISIBLE) return;
+
+  if (sb_aiSectorVisible[iSector] != sb_iCurrentMap) {
+    sb_aiSectorVisiblePrev[iSector] = sb_aiSectorVisible[iSector];
+    sb_aiSectorVisible[iSector] = sb_iCurrentMap;
+  }
+};
+
+// Write shadow layers calculated by Bake() with the same part into a stream
+void CShadowBaker::WritePart_t(CTStream &strm, INDEX iPart, INDEX ctParts) {
+  ASSERT(sb_pwoWorld != NULL);
+
+  strm.WriteID_t("SHBK");
+  strm << INDEX(SHADOWBAKE_VERSION);
+
+  // Total amount is used for making sure that both worlds match
+  const INDEX ctQueued = Count();
+  strm << ctQueued;
+
+  const INDEX ctMaps = (iPart < ctQueued) ? (ctQueued - iPart + ctParts - 1) / ctParts : 0;
+  strm << ctMaps;
+
+  for (INDEX iMap = iPart; iMap < ctQueued; iMap += ctParts) {
+    CBrushPolygon &bpo = *sb_apbpoQueued[iMap];
+    CBrushShadowMap &bsm = bpo.bpo_smShadowMap;
+
+    strm << bpo.bpo_iInWorld;
+    strm << INDEX(bsm.bsm_lnInUncalculatedShadowMaps.IsLinked());
+    strm << bsm.bsm_lhLayers.Count();
+
+    // Layers are listed in the same order in every copy of the world
+    FOREACHINLIST(CBrushShadowLayer, bsl_lnInShadowMap, bsm.bsm_lhLayers, itbsl) {
+      const CBrushShadowLayer &bsl = *itbsl;
+      strm << bsl.bsl_ulFlags;
+      strm << bsl.bsl_pixMinU;
+      strm << bsl.bsl_pixMinV;
+      strm << bsl.bsl_pixSizeU;
+      strm << bsl.bsl_pixSizeV;
+      strm << bsl.bsl_slSizeInPixels;
+
+      // Bit packed layer mask
+      const SLONG slLayerSize = (bsl.bsl_pubLayer != NULL) ? (bsl.bsl_slSizeInPixels + 7) / 8 : 0;
+      strm << slLayerSize;
+
+      if (slLayerSize > 0) {
+        strm.Write_t(bsl.bsl_pubLayer, slLayerSize);
+      }
+    }
+  }
+
+  // Render flags of sectors that have been added to rendering
+  CBrushArchive &ba = sb_pwoWorld->wo_baBrushes;
+  const INDEX ctSectors = ba.ba_apbsc.Count();
+  INDEX iSector, ctTouched = 0;
+
+  for (iSector = 0; iSector < ctSectors; iSector++) {
+    if (sb_aiSectorTouched[iSector] != -1) ctTouched++;
+  }
+
+  strm << ctTouched;
+
+  for (iSector = 0; iSector < ctSectors; iSector++) {
+    if (sb_aiSectorTouched[iSector] == -1) continue;
+
+    strm << iSector;
+    strm << sb_aiSectorTouched[iSector];
+    strm << sb_aiSectorVisible[iSector];
+    strm << ULONG(ba.ba_apbsc[iSector]->bsc_ulFlags & SECTOR_RENDERFLAGS);
+  }
+
+  // Render flags of polygons in visible sectors
+  CStaticStackArray<CBrushPolygon *> apbpoWritten;
+
+  for (iSector = 0; iSector < ctSectors; iSector++) {
+    if (sb_aiSectorVisible[iSector] == -1) continue;
+
+    FOREACHINSTATICARRAY(ba.ba_apbsc[iSector]->bsc_abpoPolygons, CBrushPolygon, itbpo) {
+      CBrushPolygon &bpo = *itbpo;
+
+      // Calculated polygon is hidden while rendering its own shadow map and its flags are restored afterwards
+      INDEX iWritten = sb_aiSectorVisible[iSector];
+
+      if (iWritten == sb_aiPolygonMap[bpo.bpo_iInWorld]) {
+        iWritten = sb_aiSectorVisiblePrev[iSector];
+      }
+
+      if (iWritten == -1) continue;
+
+      sb_aiPolygonWritten[bpo.bpo_iInWorld] = iWritten;
+      apbpoWritten.Push() = &bpo;
+    }
+  }
+
+  strm << apbpoWritten.Count();
+
+  for (INDEX iPolygon = 0; iPolygon < apbpoWritten.Count(); iPolygon++) {
+    const CBrushPolygon &bpo = *apbpoWritten[iPolygon];
+
+    strm << bpo.bpo_iInWorld;
+    strm << sb_aiPolygonWritten[bpo.bpo_iInWorld];
+    strm << ULONG(bpo.bpo_ulFlags & POLYGON_RENDERFLAGS);
+  }
+};
+
+// Read shadow layers calculated in another copy of the same world (returns number of read shadow maps)
+INDEX CShadowBaker::ReadPart_t(CTStream &strm) {
+  ASSERT(sb_pwoWorld != NULL);
+  CBrushArchive &ba = sb_pwoWorld->wo_baBrushes;
+
+  strm.ExpectID_t("SHBK");
+
+  INDEX iVersion;
+  strm >> iVersion;
+
+  if (iVersion != SHADOWBAKE_VERSION) {
+    ThrowF_t(TRANS("Invalid version of baked shadow maps: %d"), iVersion);
+  }
+
+  INDEX ctQueued, ctMaps;
+  strm >> ctQueued;
+  strm >> ctMaps;
+
+  if (ctQueued != Count()) {
+    ThrowF_t(TRANS("Shadow maps have been baked for a different world"));
+  }
+
+  for (INDEX iMap = 0; iMap < ctMaps; iMap++) {
+    INDEX iPolygon, bQueued, ctLayers;
+    strm >> iPolygon;
+    strm >> bQueued;
+    strm >> ctLayers;
+
+    if (iPolygon < 0 || iPolygon >= ba.ba_apbpo.Count()) {
+      ThrowF_t(TRANS("Invalid polygon index in baked shadow maps: %d"), iPolygon);
+    }
+
+    CBrushPolygon &bpo = *ba.ba_apbpo[iPolygon];
+    CBrushShadowMap &bsm = bpo.bpo_smShadowMap;
+
+    if (ctLayers != bsm.bsm_lhLayers.Count()) {
+      ThrowF_t(TRANS("Shadow layers of polygon %d don't match the world"), iPolygon);
+    }
+
+    FOREACHINLIST(CBrushShadowLayer, bsl_lnInShadowMap, bsm.bsm_lhLayers, itbsl) {
+      CBrushShadowLayer &bsl = *itbsl;
+      strm >> bsl.bsl_ulFlags;
+      strm >> bsl.bsl_pixMinU;
+      strm >> bsl.bsl_pixMinV;
+      strm >> bsl.bsl_pixSizeU;
+      strm >> bsl.bsl_pixSizeV;
+      strm >> bsl.bsl_slSizeInPixels;
+
+      SLONG slLayerSize;
+      strm >> slLayerSize;
+
+      if (bsl.bsl_pubLayer != NULL) {
+        FreeMemory(bsl.bsl_pubLayer);
+        bsl.bsl_pubLayer = NULL;
+      }
+
+      if (slLayerSize > 0) {
+        bsl.bsl_pubLayer = (UBYTE *)AllocMemory(slLayerSize);
+        strm.Read_t(bsl.bsl_pubLayer, slLayerSize);
+      }
+    }
+
+    // Unqueue the shadow map and mix its layers again, like CBrushPolygon::MakeShadowMap() does
+    if (!bQueued && bsm.bsm_lnInUncalculatedShadowMaps.IsLinked()) {
+      bsm.bsm_lnInUncalculatedShadowMaps.Remove();
+    }
+
+    bsm.Invalidate();
+  }
+
+  // Take render flags from whichever part has set them last
+  INDEX ctSectors, ctPolygons, i;
+  strm >> ctSectors;
+
+  for (i = 0; i < ctSectors; i++) {
+    INDEX iSector, iTouched, iVisible;
+    ULONG ulFlags;
+    strm >> iSector;
+    strm >> iTouched;
+    strm >> iVisible;
+    strm >> ulFlags;
+
+    if (iSector < 0 || iSector >= ba.ba_apbsc.Count()) {
+      ThrowF_t(TRANS("Invalid sector index in baked shadow maps: %d"), iSector);
+    }
+
+    ULONG &ulSectorFlags = ba.ba_apbsc[iSector]->bsc_ulFlags;
+
+    if (iTouched > sb_aiSectorTouched[iSector]) {
+      sb_aiSectorTouched[iSector] = iTouched;
+      ulSectorFlags = (ulSectorFlags & ~BSCF_INVISIBLE) | (ulFlags & BSCF_INVISIBLE);
+    }
+
+    if (iVisible > sb_aiSectorVisible[iSector]) {
+      sb_aiSectorVisible[iSector] = iVisible;
+      ulSectorFlags = (ulSectorFlags & ~BSCF_NEEDSCLIPPING) | (ulFlags & BSCF_NEEDSCLIPPING);
+    }
+  }
+
+  strm >> ctPolygons;
+
+  for (i = 0; i < ctPolygons; i++) {
+    INDEX iPolygon, iWritten;
+    ULONG ulFlags;
+    strm >> iPolygon;
+    strm >> iWritten;
+    strm >> ulFlags;
+
+    if (iPolygon < 0 || iPolygon >= ba.ba_apbpo.Count()) {
+      ThrowF_t(TRANS("Invalid polygon index in baked shadow maps: %d"), iPolygon);
+    }
+
+    ULONG &ulPolygonFlags = ba.ba_apbpo[iPolygon]->bpo_ulFlags;
+
+    // Portal flag is overwritten every time the polygon's sector is seen
+    if (iWritten > sb_aiPolygonWritten[iPolygon]) {
+      sb_aiPolygonWritten[iPolygon] = iWritten;
+      ulPolygonFlags = (ulPolygonFlags & ~BPOF_RENDERASPORTAL) | (ulFlags & BPOF_RENDERASPORTAL);
+    }
+
+    // Translucency flag is only ever cleared when rendering shadows
+    if (!(ulFlags & BPOF_RENDERTRANSLUCENT)) {
+      ulPolygonFlags &= ~BPOF_RENDERTRANSLUCENT;
+    }
+  }
+
+  return ctMaps;
+};
+
+// Calculate shadow maps that are still queued after reading all parts, like CWorld::CalculateNonDirectionalShadows()
+void CShadowBaker::Finish(void) {
+  ASSERT(sb_pwoWorld != NULL);
+
+  // These are calculated after all other shadow maps in the editor as well
+  sb_pwoWorld->CalculateNonDirectionalShadows();
+};
@@ -0,0 +1,75 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#ifndef SE_INCL_SHADOWBAKING_H
+#define SE_INCL_SHADOWBAKING_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#include <Engine/Templates/StaticArray.h>
+#include <Engine/Templates/StaticStackArray.h>
+
+// Recalculation of all brush shadow maps in a world that can be split between multiple processes.
+// The renderer keeps per-view data inside the world itself (working planes, sector flags and indices),
+// so each process bakes its part in its own copy of the world and the results are merged afterwards.
+// Render flags that the renderer leaves on sectors and polygons are saved with the world, so each process
+// also remembers which shadow map has last set them, and the merged world ends up with the same flags as
+// if all shadow maps have been calculated one after another in a single world.
+class ENGINE_API CShadowBaker {
+  public:
+    CWorld *sb_pwoWorld; // world that's being baked
+    CStaticStackArray<CBrushPolygon *> sb_apbpoQueued; // polygons with queued shadow maps (in the order of calculation)
+
+    CStaticArray<INDEX> sb_aiPolygonMap; // queued shadow map of each polygon (-1 if none)
+    CStaticArray<INDEX> sb_aiSectorTouched; // last shadow map that has added each sector to rendering
+    CStaticArray<INDEX> sb_aiSectorVisible; // last shadow map that has seen each sector
+    CStaticArray<INDEX> sb_aiSectorVisiblePrev; // shadow map that has seen each sector before the last one
+    CStaticArray<INDEX> sb_aiPolygonWritten; // last shadow map that has set render flags of each polygon
+    INDEX sb_iCurrentMap; // shadow map that's being calculated
+
+  public:
+    // Constructor
+    CShadowBaker(void) : sb_pwoWorld(NULL), sb_iCurrentMap(-1) {};
+
+    // Discard all shadows in the world and remember polygons that need their shadow maps recalculated
+    void Prepare(CWorld &wo);
+
+    // Get number of shadow maps that need to be calculated
+    inline INDEX Count(void) const {
+      return sb_apbpoQueued.Count();
+    };
+
+    // Calculate every ctParts-th shadow map starting from iPart (returns number of calculated shadow maps)
+    INDEX Bake(INDEX iPart, INDEX ctParts);
+
+    // Write shadow layers calculated by Bake() with the same part into a stream
+    void WritePart_t(CTStream &strm, INDEX iPart, INDEX ctParts); // throw char *
+
+    // Read shadow layers calculated in another copy of the same world (returns number of read shadow maps)
+    INDEX ReadPart_t(CTStream &strm); // throw char *
+
+    // Calculate shadow maps that are still queued after reading all parts, like CWorld::CalculateNonDirectionalShadows()
+    void Finish(void);
+
+    // Remember a sector that has been added to rendering of the current shadow map
+    void SectorRendered(CBrushSector &bsc);
+};
+
+// Shadow baker that's currently calculating shadow maps in this process
+ENGINE_API extern CShadowBaker *_psbRendering;
+
+#endif  /* include-once check. */
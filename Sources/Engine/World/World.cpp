@@ -16,6 +16,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "StdH.h"
 
 #include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
 #include <Engine/Math/Float.h>
 #include <Engine/World/World.h>
 #include <Engine/World/WorldEditingProfile.h>
@@ -39,6 +41,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Templates/Selection.cpp>
 #include <Engine/Terrain/Terrain.h>
+#include <Engine/World/WorldPVS.h> // [Cecil]
+#include <Engine/Base/WorkerThreads.h> // [Cecil]
+#include <Engine/Templates/StaticStackArray.cpp> // [Cecil]
 
 #include <Engine/Templates/Stock_CEntityClass.h>
 
@@ -46,6 +51,12 @@ extern BOOL _bPortalSectorLinksPreLoaded;
 extern BOOL _bEntitySectorLinksPreLoaded;
 extern INDEX _ctPredictorEntities;
 
+// [Cecil] Track which entities point to each entity for faster untargeting (applied to new worlds and after clearing)
+INDEX wld_bReferrerIndex = TRUE;
+
+// [Cecil] Find sectors around all entities on worker threads when linking them after loading
+INDEX wld_bParallelSectorLinks = TRUE;
+
 // calculate ray placement from origin and target positions (obsolete?)
 static inline CPlacement3D CalculateRayPlacement(
   const FLOAT3D &vOrigin, const FLOAT3D &vTarget)
@@ -89,6 +100,10 @@ CWorld::CWorld(void)
   wo_baBrushes.ba_pwoWorld = this;
   wo_taTerrains.ta_pwoWorld = this;
 
+  // [Cecil] Index entities for fast removal
+  wo_cenEntities.SetIndexed(TRUE);
+  wo_cenAllEntities.SetIndexed(TRUE);
+
   // create empty texture movements
   wo_attTextureTransformations.New(256);
   wo_atbTextureBlendings.New(256);
@@ -110,6 +125,9 @@ CWorld::CWorld(void)
   wo_fRtL = wo_fRtH = 1.0f; wo_fRtCZ = wo_fRtCY = 0.0f;
 
   wo_ulNextEntityID = 1;
+  wo_ctEntitiesByID = 0; // [Cecil]
+  wo_bReferrerIndex = wld_bReferrerIndex; // [Cecil]
+  wo_ppvsSectors = NULL; // [Cecil]
 
   // set default placement
   wo_plFocus = CPlacement3D( FLOAT3D(3.0f, 4.0f, 10.0f),
@@ -170,6 +188,20 @@ void CWorld::Clear(void)
     wo_cenAllEntities.Clear();
     cenToDestroy.Clear();
     wo_ulNextEntityID = 1;
+
+    // [Cecil] Clear ID hash table
+    ASSERT(wo_ctEntitiesByID==0);
+    wo_apenByID.Clear();
+    wo_ctEntitiesByID = 0;
+
+    // [Cecil] Apply referrer tracking while there are no entities
+    wo_bReferrerIndex = wld_bReferrerIndex;
+  }
+
+  // [Cecil] Discard sector visibility
+  if (wo_ppvsSectors != NULL) {
+    delete wo_ppvsSectors;
+    wo_ppvsSectors = NULL;
   }
 
   // clear brushes
@@ -184,6 +216,23 @@ void CWorld::Clear(void)
   ClearCollisionGrid();
 }
 
+// [Cecil] Mark all entity pointer properties of an entity as its own
+static void TrackPropertyPointers(CEntity *pen)
+{
+  // for all classes in hierarchy of this entity
+  for (CDLLEntityClass *pdecDLLClass = pen->en_pecClass->ec_pdecDLLClass;
+       pdecDLLClass != NULL; pdecDLLClass = pdecDLLClass->dec_pdecBase) {
+    // for all properties
+    for (INDEX iProperty = 0; iProperty < pdecDLLClass->dec_ctProperties; iProperty++) {
+      CEntityProperty &epProperty = pdecDLLClass->dec_aepProperties[iProperty];
+
+      if (epProperty.ep_eptType == CEntityProperty::EPT_ENTITYPTR) {
+        ENTITYPROPERTY(pen, epProperty.ep_slOffset, CEntityPointer).SetOwner(pen);
+      }
+    }
+  }
+}
+
 /*
  * Create a new entity of given class.
  */
@@ -212,11 +261,19 @@ CEntity *CWorld::CreateEntity(const CPlacement3D &plPlacement, CEntityClass *pec
 
   // set the entity's world pointer to this world
   penEntity->en_pwoWorld = this;
+
+  // [Cecil] let entities that this one points to know about it
+  if (wo_bReferrerIndex) {
+    TrackPropertyPointers(penEntity);
+  }
+
   // add the new member to this world's entity container
   wo_cenEntities.Add(penEntity);
   wo_cenAllEntities.Add(penEntity);
   // set a new identifier
   penEntity->en_ulID = wo_ulNextEntityID++;
+  // [Cecil] remember it by its identifier
+  AddEntityID(penEntity);
   // set up the placement
   penEntity->en_plPlacement = plPlacement;
   // calculate rotation matrix
@@ -290,34 +347,107 @@ void CWorld::DestroyEntities(CEntitySelection &senToDestroy)
   senToDestroy.CDynamicContainer<CEntity>::Clear();
 }
 
+// [Cecil] Entity property that points to an entity that is being untargeted
+struct SReferrer {
+  CEntity *re_penOwner; // entity with the property
+  CEntityPointer *re_pepProperty; // the property itself
+  INDEX re_iOwner; // position of the owner among entities in the world
+};
+
+// [Cecil] Sort referrers in the same order as entities in the world
+static int qsort_CompareReferrers(const void *pElement1, const void *pElement2)
+{
+  const SReferrer &re1 = *(const SReferrer *)pElement1;
+  const SReferrer &re2 = *(const SReferrer *)pElement2;
+
+  if (re1.re_iOwner != re2.re_iOwner) {
+    return (re1.re_iOwner < re2.re_iOwner) ? -1 : +1;
+  }
+
+  if (re1.re_pepProperty != re2.re_pepProperty) {
+    return (re1.re_pepProperty < re2.re_pepProperty) ? -1 : +1;
+  }
+
+  return 0;
+}
+
 /*
  * Clear all entity pointers that point to this entity.
  */
 void CWorld::UntargetEntity(CEntity *penToUntarget)
 {
-  // for all entities in this world
-  FOREACHINDYNAMICCONTAINER(wo_cenEntities, CEntity, itenInWorld){
-    // get the DLL class of this entity
-    CDLLEntityClass *pdecDLLClass = itenInWorld->en_pecClass->ec_pdecDLLClass;
-
-    // for all classes in hierarchy of this entity
-    for(;
-        pdecDLLClass!=NULL;
-        pdecDLLClass = pdecDLLClass->dec_pdecBase) {
-      // for all properties
-      for(INDEX iProperty=0; iProperty<pdecDLLClass->dec_ctProperties; iProperty++) {
-        CEntityProperty &epProperty = pdecDLLClass->dec_aepProperties[iProperty];
-
-        // if the property type is entity pointer
-        if (epProperty.ep_eptType == CEntityProperty::EPT_ENTITYPTR) {
-          // get the pointer
-          CEntityPointer &penPointed = ENTITYPROPERTY(&*itenInWorld, epProperty.ep_slOffset, CEntityPointer);
-          // if it points to the entity to be untargeted
-          if (penPointed == penToUntarget) {
-            itenInWorld->End();
-            // clear the pointer
-            penPointed = NULL;
-            itenInWorld->Initialize();
+  // [Cecil] only visit entities that actually point to this one
+  if (wo_bReferrerIndex) {
+    CStaticStackArray<SReferrer> aReferrers;
+
+    FOREACHINLIST(CEntityPointer, ep_lnInReferrers, penToUntarget->en_lhReferrers, itep) {
+      CEntity *penOwner = itep->ep_penOwner;
+
+      // skip deleted entities and entities from other worlds
+      if (penOwner->en_pwoWorld != this || (penOwner->en_ulFlags & ENF_DELETED)) {
+        continue;
+      }
+
+      SReferrer &re = aReferrers.Push();
+      re.re_penOwner = penOwner;
+      re.re_pepProperty = &*itep;
+      re.re_iOwner = wo_cenEntities.GetIndex(penOwner);
+    }
+
+    const INDEX ctReferrers = aReferrers.Count();
+
+    if (ctReferrers > 1) {
+      qsort(&aReferrers[0], ctReferrers, sizeof(SReferrer), qsort_CompareReferrers);
+    }
+
+    // keep referrers alive while reinitializing them
+    INDEX iReferrer;
+
+    for (iReferrer = 0; iReferrer < ctReferrers; iReferrer++) {
+      aReferrers[iReferrer].re_penOwner->AddReference();
+    }
+
+    for (iReferrer = 0; iReferrer < ctReferrers; iReferrer++) {
+      SReferrer &re = aReferrers[iReferrer];
+
+      // if it still points to the entity to be untargeted
+      if (re.re_pepProperty->ep_pen == penToUntarget) {
+        re.re_penOwner->End();
+        // clear the pointer
+        *re.re_pepProperty = NULL;
+        re.re_penOwner->Initialize();
+      }
+    }
+
+    for (iReferrer = 0; iReferrer < ctReferrers; iReferrer++) {
+      aReferrers[iReferrer].re_penOwner->RemReference();
+    }
+
+  } else {
+    // for all entities in this world
+    FOREACHINDYNAMICCONTAINER(wo_cenEntities, CEntity, itenInWorld){
+      // get the DLL class of this entity
+      CDLLEntityClass *pdecDLLClass = itenInWorld->en_pecClass->ec_pdecDLLClass;
+
+      // for all classes in hierarchy of this entity
+      for(;
+          pdecDLLClass!=NULL;
+          pdecDLLClass = pdecDLLClass->dec_pdecBase) {
+        // for all properties
+        for(INDEX iProperty=0; iProperty<pdecDLLClass->dec_ctProperties; iProperty++) {
+          CEntityProperty &epProperty = pdecDLLClass->dec_aepProperties[iProperty];
+
+          // if the property type is entity pointer
+          if (epProperty.ep_eptType == CEntityProperty::EPT_ENTITYPTR) {
+            // get the pointer
+            CEntityPointer &penPointed = ENTITYPROPERTY(&*itenInWorld, epProperty.ep_slOffset, CEntityPointer);
+            // if it points to the entity to be untargeted
+            if (penPointed == penToUntarget) {
+              itenInWorld->End();
+              // clear the pointer
+              penPointed = NULL;
+              itenInWorld->Initialize();
+            }
           }
         }
       }
@@ -818,12 +948,67 @@ void CWorld::FilterEntitiesBySpawnFlags(ULONG ulFlags)
   _pNetwork->ga_sesSessionState.ses_bAllowRandom = bOldAllowRandom;
 }
 
+// [Cecil] Amount of entities that one worker job finds sectors for
+#define SECTOR_SEARCH_BATCH 32
+
+// [Cecil] Sectors found around one entity
+struct SSectorSearch {
+  CEntity *ss_pen;
+  CStaticStackArray<CBrushSector *> ss_apbsc;
+};
+
+// [Cecil] Find sectors around one batch of entities
+static void FindSectorsJob(void *pData, INDEX iItem) {
+  CStaticArray<SSectorSearch> &aSearches = *(CStaticArray<SSectorSearch> *)pData;
+
+  const INDEX iFirst = iItem * SECTOR_SEARCH_BATCH;
+  const INDEX iLast = Min(iFirst + SECTOR_SEARCH_BATCH, aSearches.Count());
+
+  for (INDEX i = iFirst; i < iLast; i++) {
+    SSectorSearch &ss = aSearches[i];
+    ss.ss_pen->GetSectorsAroundEntity(ss.ss_apbsc);
+  }
+};
+
+// [Cecil] Find sectors around multiple entities on worker threads and link them in the same order as one by one
+void CWorld::FindSectorsAroundEntities(CDynamicContainer<CEntity> &cenEntities)
+{
+  const INDEX ctEntities = cenEntities.Count();
+  if (ctEntities == 0) return;
+
+  CStaticArray<SSectorSearch> aSearches;
+  aSearches.New(ctEntities);
+
+  INDEX iEntity = 0;
+
+  FOREACHINDYNAMICCONTAINER(cenEntities, CEntity, iten) {
+    aSearches[iEntity++].ss_pen = iten;
+  }
+
+  // Searching only reads sector boxes and BSP trees of zoning brushes
+  ParallelFor((ctEntities + SECTOR_SEARCH_BATCH - 1) / SECTOR_SEARCH_BATCH, &FindSectorsJob, &aSearches);
+
+  // Links modify lists of sectors, so they are added on this thread
+  for (iEntity = 0; iEntity < ctEntities; iEntity++) {
+    SSectorSearch &ss = aSearches[iEntity];
+
+    // Entities outside spatial classification keep their links
+    if (ss.ss_pen->en_fSpatialClassificationRadius < 0) continue;
+
+    ss.ss_pen->LinkToSectors(ss.ss_apbsc);
+  }
+};
+
 // create links between zoning-brush sectors and non-zoning entities in sectors
 void CWorld::LinkEntitiesToSectors(void)
 {
   _pfWorldEditingProfile.StartTimer(CWorldEditingProfile::PTI_LINKENTITIESTOSECTORS);
   // must be in 24bit mode when managing entities
   CSetFPUPrecision FPUPrecision(FPT_24BIT);
+
+  // [Cecil] Link all entities at once after finding their spatial ranges
+  const BOOL bLinkOneByOne = !_bEntitySectorLinksPreLoaded && !wld_bParallelSectorLinks;
+
   // for each entity in the world
   FOREACHINDYNAMICCONTAINER(wo_cenEntities, CEntity, iten) {
     CEntity &en = *iten;
@@ -831,10 +1016,15 @@ void CWorld::LinkEntitiesToSectors(void)
     en.FindCollisionInfo();
     en.UpdateSpatialRange();
     // link it
-    if (!_bEntitySectorLinksPreLoaded) {
+    if (bLinkOneByOne) {
       en.FindSectorsAroundEntity();
     }
   }
+
+  // [Cecil] Link all entities at once
+  if (!_bEntitySectorLinksPreLoaded && wld_bParallelSectorLinks) {
+    FindSectorsAroundEntities(wo_cenEntities);
+  }
   // NOTE: this is here to force relinking for all moving zoning brushes after loading!
   // for each entity in the world
   {FOREACHINDYNAMICCONTAINER(wo_cenEntities, CEntity, iten) {
@@ -1103,16 +1293,131 @@ void CWorld::DeletePredictors(void)
   }
 }
 
+// [Cecil] Get home slot of an entity ID in the hash table
+static inline INDEX EntityIDSlot(ULONG ulID, INDEX ctSlots)
+{
+  return INDEX((ulID * 0x9E3779B1UL) & (ctSlots - 1));
+}
+
 // get entity by its ID
 CEntity *CWorld::EntityFromID(ULONG ulID)
 {
-  FOREACHINDYNAMICCONTAINER(wo_cenAllEntities, CEntity, iten) {
-    if (iten->en_ulID==ulID) {
-      return iten;
+  // [Cecil] Look it up in the hash table
+  const INDEX ctSlots = wo_apenByID.Count();
+  CEntity *penFound = NULL;
+
+  if (ctSlots > 0) {
+    INDEX iSlot = EntityIDSlot(ulID, ctSlots);
+
+    FOREVER {
+      CEntity *pen = wo_apenByID[iSlot];
+      if (pen == NULL) break;
+
+      // Predictors may reuse IDs of other entities, so prefer the first one in the container like before
+      if (pen->en_ulID == ulID) {
+        if (penFound == NULL
+         || wo_cenAllEntities.GetIndex(pen) < wo_cenAllEntities.GetIndex(penFound)) {
+          penFound = pen;
+        }
+      }
+
+      iSlot = (iSlot + 1) & (ctSlots - 1);
+    }
+  }
+
+  ASSERT(penFound != NULL);
+  return penFound;
+}
+
+// [Cecil] Add entity to the ID hash table
+void CWorld::AddEntityID(CEntity *pen)
+{
+  ASSERT(pen != NULL);
+
+  // Keep the table at most half full
+  if ((wo_ctEntitiesByID + 1) * 2 > wo_apenByID.Count()) {
+    INDEX ctNewSlots = 256;
+
+    while (ctNewSlots < (wo_ctEntitiesByID + 1) * 4) {
+      ctNewSlots *= 2;
+    }
+
+    // Move existing entities into a new table
+    CStaticArray<CEntity *> apenOld;
+    apenOld.MoveArray(wo_apenByID);
+
+    wo_apenByID.New(ctNewSlots);
+
+    for (INDEX iSlot = 0; iSlot < ctNewSlots; iSlot++) {
+      wo_apenByID[iSlot] = NULL;
+    }
+
+    wo_ctEntitiesByID = 0;
+
+    for (INDEX iOld = 0; iOld < apenOld.Count(); iOld++) {
+      if (apenOld[iOld] != NULL) {
+        AddEntityID(apenOld[iOld]);
+      }
+    }
+  }
+
+  const INDEX ctSlots = wo_apenByID.Count();
+  INDEX iSlot = EntityIDSlot(pen->en_ulID, ctSlots);
+
+  while (wo_apenByID[iSlot] != NULL) {
+    ASSERT(wo_apenByID[iSlot] != pen);
+    iSlot = (iSlot + 1) & (ctSlots - 1);
+  }
+
+  wo_apenByID[iSlot] = pen;
+  wo_ctEntitiesByID++;
+}
+
+// [Cecil] Remove entity from the ID hash table
+void CWorld::RemoveEntityID(CEntity *pen)
+{
+  const INDEX ctSlots = wo_apenByID.Count();
+  if (ctSlots == 0) return;
+
+  // Find its slot
+  INDEX iFree = EntityIDSlot(pen->en_ulID, ctSlots);
+
+  FOREVER {
+    CEntity *penSlot = wo_apenByID[iFree];
+
+    if (penSlot == NULL) {
+      ASSERTALWAYS("Entity is not in the ID hash table!");
+      return;
+    }
+
+    if (penSlot == pen) break;
+    iFree = (iFree + 1) & (ctSlots - 1);
+  }
+
+  wo_ctEntitiesByID--;
+
+  // Shift following entities of the same probe sequence back into the freed slot
+  FOREVER {
+    wo_apenByID[iFree] = NULL;
+    INDEX iNext = iFree;
+
+    FOREVER {
+      iNext = (iNext + 1) & (ctSlots - 1);
+      CEntity *penNext = wo_apenByID[iNext];
+
+      // End of the sequence
+      if (penNext == NULL) return;
+
+      const INDEX iHome = EntityIDSlot(penNext->en_ulID, ctSlots);
+
+      // Can be moved into the free slot
+      if (((iFree - iHome) & (ctSlots - 1)) < ((iNext - iHome) & (ctSlots - 1))) {
+        wo_apenByID[iFree] = penNext;
+        iFree = iNext;
+        break;
+      }
     }
   }
-  ASSERT(FALSE);
-  return NULL;
 }
 
 /* Triangularize selected polygons. */
@@ -1160,3 +1465,193 @@ void CWorld::ClearMarkedForUseFlag(void)
     }
   }
 }
+
+// [Cecil] Time how long it takes to destroy entities in a temporary world
+static DOUBLE TimeEntityRemoval(INDEX ctEntities, const CTFileName &fnmClass, BOOL bIndexed) {
+  CWorld woTemp;
+  woTemp.wo_cenEntities.SetIndexed(bIndexed);
+  woTemp.wo_cenAllEntities.SetIndexed(bIndexed);
+
+  CSetFPUPrecision FPUPrecision(FPT_24BIT);
+  CPlacement3D plOrigin(FLOAT3D(0.0f, 0.0f, 0.0f), ANGLE3D(0.0f, 0.0f, 0.0f));
+
+  for (INDEX iEntity = 0; iEntity < ctEntities; iEntity++) {
+    woTemp.CreateEntity_t(plOrigin, fnmClass);
+  }
+
+  // Destroy them in the same order as CWorld::Clear()
+  CDynamicContainer<CEntity> cenToDestroy = woTemp.wo_cenEntities;
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  FOREACHINDYNAMICCONTAINER(cenToDestroy, CEntity, iten) {
+    iten->Destroy();
+  }
+
+  DOUBLE dTime = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+  cenToDestroy.Clear();
+
+  return dTime;
+};
+
+// [Cecil] Compare entity removal with and without the entity index
+void BenchmarkEntityRemoval(void *pArgs) {
+  INDEX ctEntities = NEXTARGUMENT(INDEX);
+  CTFileName fnmClass = *NEXTARGUMENT(CTString *);
+
+  if (ctEntities <= 0) ctEntities = 50000;
+  if (fnmClass == "") fnmClass = CTString("Classes\\Marker.ecl");
+
+  DOUBLE dIndexed, dLinear;
+
+  try {
+    dIndexed = TimeEntityRemoval(ctEntities, fnmClass, TRUE);
+    dLinear = TimeEntityRemoval(ctEntities, fnmClass, FALSE);
+
+  } catch (char *strError) {
+    CPrintF(TRANS("Cannot create entities of class '%s':\n%s\n"), fnmClass.ConstData(), strError);
+    return;
+  }
+
+  CPrintF(TRANS("Destroyed %d entities of class '%s':\n"), ctEntities, fnmClass.ConstData());
+  CPrintF(TRANS("  Indexed: %.2f ms\n"), dIndexed * 1000.0);
+  CPrintF(TRANS("  Linear:  %.2f ms\n"), dLinear * 1000.0);
+};
+
+// [Cecil] Find entity by its ID by going through all of them
+static CEntity *LinearEntityFromID(CWorld &wo, ULONG ulID) {
+  FOREACHINDYNAMICCONTAINER(wo.wo_cenAllEntities, CEntity, iten) {
+    if (iten->en_ulID == ulID) return iten;
+  }
+
+  return NULL;
+};
+
+// [Cecil] Compare resolving IDs of all entities in the current world with and without the ID hash table
+void BenchmarkEntityLookup(void *pArgs) {
+  INDEX ctPasses = NEXTARGUMENT(INDEX);
+  if (ctPasses <= 0) ctPasses = 1;
+
+  CWorld &wo = *_pNetwork->ga_pWorld;
+  const INDEX ctEntities = wo.wo_cenAllEntities.Count();
+
+  if (ctEntities == 0) {
+    CPutString(TRANS("No entities in the current world!\n"));
+    return;
+  }
+
+  // Gather IDs beforehand
+  CStaticArray<ULONG> aulIDs;
+  aulIDs.New(ctEntities);
+
+  INDEX iEntity = 0;
+
+  FOREACHINDYNAMICCONTAINER(wo.wo_cenAllEntities, CEntity, iten) {
+    aulIDs[iEntity++] = iten->en_ulID;
+  }
+
+  // Resolve them using the hash table
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+  INDEX ctMismatches = 0;
+
+  for (INDEX iPass = 0; iPass < ctPasses; iPass++) {
+    for (iEntity = 0; iEntity < ctEntities; iEntity++) {
+      if (wo.EntityFromID(aulIDs[iEntity]) == NULL) ctMismatches++;
+    }
+  }
+
+  const DOUBLE dHashed = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+  // Resolve them by going through all entities
+  tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX iPass = 0; iPass < ctPasses; iPass++) {
+    for (iEntity = 0; iEntity < ctEntities; iEntity++) {
+      if (LinearEntityFromID(wo, aulIDs[iEntity]) == NULL) ctMismatches++;
+    }
+  }
+
+  const DOUBLE dLinear = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+  // Make sure that both methods agree
+  for (iEntity = 0; iEntity < ctEntities; iEntity++) {
+    if (wo.EntityFromID(aulIDs[iEntity]) != LinearEntityFromID(wo, aulIDs[iEntity])) ctMismatches++;
+  }
+
+  CPrintF(TRANS("Resolved %d entity IDs %d times:\n"), ctEntities, ctPasses);
+  CPrintF(TRANS("  Hashed: %.2f ms\n"), dHashed * 1000.0);
+  CPrintF(TRANS("  Linear: %.2f ms\n"), dLinear * 1000.0);
+
+  if (ctMismatches > 0) {
+    CPrintF(TRANS("  %d lookups have failed!\n"), ctMismatches);
+  }
+};
+
+// [Cecil] Gather sectors that each entity is linked to, separated by NULL
+static void GatherEntitySectorLinks(CWorld &wo, CStaticStackArray<CBrushSector *> &apbsc) {
+  apbsc.PopAll();
+
+  FOREACHINDYNAMICCONTAINER(wo.wo_cenEntities, CEntity, iten) {
+    {FOREACHSRCOFDST(iten->en_rdSectors, CBrushSector, bsc_rsEntities, pbsc)
+      apbsc.Push() = pbsc;
+    ENDFOR}
+
+    apbsc.Push() = NULL;
+  }
+};
+
+// [Cecil] Compare linking all entities in the current world to sectors one by one and on worker threads
+void BenchmarkSectorLinking(void *pArgs) {
+  INDEX ctPasses = NEXTARGUMENT(INDEX);
+  if (ctPasses <= 0) ctPasses = 10;
+
+  CWorld &wo = *_pNetwork->ga_pWorld;
+  const INDEX ctEntities = wo.wo_cenEntities.Count();
+
+  if (ctEntities == 0) {
+    CPutString(TRANS("No entities in the current world!\n"));
+    return;
+  }
+
+  // Must be in 24-bit mode when managing entities
+  CSetFPUPrecision FPUPrecision(FPT_24BIT);
+
+  CStaticStackArray<CBrushSector *> apbscSerial, apbscParallel;
+  DOUBLE dSerial = 0.0, dParallel = 0.0;
+  INDEX ctMismatches = 0;
+
+  for (INDEX iPass = 0; iPass < ctPasses; iPass++) {
+    // Link entities one by one
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+    FOREACHINDYNAMICCONTAINER(wo.wo_cenEntities, CEntity, iten) {
+      iten->FindSectorsAroundEntity();
+    }
+
+    dSerial += (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+    GatherEntitySectorLinks(wo, apbscSerial);
+
+    // Link all of them at once
+    tvStart = _pTimer->GetHighPrecisionTimer();
+    wo.FindSectorsAroundEntities(wo.wo_cenEntities);
+    dParallel += (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+    // Make sure that both methods link to the same sectors in the same order
+    GatherEntitySectorLinks(wo, apbscParallel);
+
+    if (apbscSerial.Count() != apbscParallel.Count()
+     || memcmp(&apbscSerial[0], &apbscParallel[0], apbscSerial.Count() * sizeof(CBrushSector *)) != 0) {
+      ctMismatches++;
+    }
+  }
+
+  const INDEX ctLinks = apbscSerial.Count() - ctEntities;
+
+  CPrintF(TRANS("Linked %d entities to sectors (%d links) %d times using %d worker threads:\n"),
+    ctEntities, ctLinks, ctPasses, GetWorkerThreadCount());
+  CPrintF(TRANS("  One by one: %.2f ms\n"), dSerial * 1000.0 / ctPasses);
+  CPrintF(TRANS("  Parallel:   %.2f ms\n"), dParallel * 1000.0 / ctPasses);
+
+  if (ctMismatches > 0) {
+    CPrintF(TRANS("  %d passes have produced different links!\n"), ctMismatches);
+  }
+};
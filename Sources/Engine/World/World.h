@@ -94,9 +94,13 @@ public:
   CTString wo_strDescription; // description of the level (intro, mission, etc.)
 
   ULONG wo_ulNextEntityID;    // next free ID for entities
+  CStaticArray<CEntity *> wo_apenByID; // [Cecil] Hash table of all entities by their IDs
+  INDEX wo_ctEntitiesByID; // [Cecil] Amount of entities in the ID hash table
   CListHead wo_lhTimers;      // timer scheduled entities
   CListHead wo_lhMovers;        // entities that want to/have to move
   BOOL wo_bPortalLinksUpToDate; // set if portal-sector links are up to date
+  BOOL wo_bReferrerIndex; // [Cecil] property pointers of entities are tracked by the entities they point to
+  class CWorldPVS *wo_ppvsSectors; // [Cecil] potentially visible sectors loaded with the world (NULL if none)
 
   /* Initialize collision grid. */
   void InitCollisionGrid(void);
@@ -179,6 +183,10 @@ public:
 
   // get entity by its ID
   CEntity *EntityFromID(ULONG ulID);
+  // [Cecil] Add entity to the ID hash table
+  void AddEntityID(CEntity *pen);
+  // [Cecil] Remove entity from the ID hash table
+  void RemoveEntityID(CEntity *pen);
   // triangularize selected polygons
   void TriangularizePolygons(CDynamicContainer<CBrushPolygon> &dcPolygons);
 public:
@@ -253,6 +261,8 @@ public:
   void Save_t(const CTFileName &fnmWorld); // throw char *
   /* Load entire world (both brushes and current state). */
   void Load_t(const CTFileName &fnmWorld); // throw char *
+  // [Cecil] Load potentially visible sectors from a file next to the world
+  void LoadPVS(const CTFileName &fnmWorld);
   /* Reinitialize entities from their properties. (use only in WEd!) */
   void ReinitializeEntities(void);
   /* Precache data needed by entities. */
@@ -353,6 +363,8 @@ public:
 
   // create links between zoning brush sectors and non-zoning entities in sectors
   void LinkEntitiesToSectors(void);
+  // [Cecil] Find sectors around multiple entities on worker threads and link them in the same order as one by one
+  void FindSectorsAroundEntities(CDynamicContainer<CEntity> &cenEntities);
 
   // rebuild all links in world
   void RebuildLinks(void);
@@ -29,6 +29,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Network/Network.h>
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Terrain/Terrain.h>
+#include <Engine/Base/WorkerThreads.h> // [Cecil]
+#include <Engine/World/WorldPVS.h> // [Cecil]
 
 #define WORLDSTATEVERSION_NOCLASSCONTAINER 9
 #define WORLDSTATEVERSION_MULTITEXTURING 8
@@ -40,6 +42,37 @@ extern BOOL _bEntitySectorLinksPreLoaded;
 extern BOOL _bFileReplacingApplied;
 BOOL _bReadEntitiesByID = FALSE;
 
+// [Cecil] Report time spent in each stage of loading a world
+INDEX wld_bReportLoadTimes = FALSE;
+
+// [Cecil] Stages of loading a world
+enum EWorldLoadStage {
+  WLS_TEXTURES = 0, // Brush dictionary
+  WLS_BRUSHES,      // Brushes and terrains
+  WLS_MODELS,       // State dictionary
+  WLS_ENTITIES,     // World state and entities
+  WLS_MODELWAIT,    // Waiting for models that are loaded in the background
+  WLS_PRECACHE,     // Precaching entity data
+  WLS_COUNT,
+};
+
+static const char *_astrLoadStages[WLS_COUNT] = {
+  "textures", "brushes", "models", "entities", "model wait", "precache",
+};
+
+static DOUBLE _adLoadStageTime[WLS_COUNT]; // [Cecil] Time spent in each stage
+static CTimerValue _tvLoadStage; // [Cecil] When the current stage has begun
+
+// [Cecil] Begin timing the next stage
+static void BeginLoadStage(void) {
+  _tvLoadStage = _pTimer->GetHighPrecisionTimer();
+};
+
+// [Cecil] Add time since the beginning of the stage
+static void EndLoadStage(EWorldLoadStage eStage) {
+  _adLoadStageTime[eStage] += (_pTimer->GetHighPrecisionTimer() - _tvLoadStage).GetSeconds();
+};
+
 /*
  * Save entire world (both brushes  current state).
  */
@@ -56,6 +89,38 @@ void CWorld::Save_t(const CTFileName &fnmWorld) // throw char *
   Write_t(&strmFile);
 }
 
+// [Cecil] Load potentially visible sectors from a file next to the world
+void CWorld::LoadPVS(const CTFileName &fnmWorld)
+{
+  if (wo_ppvsSectors != NULL) {
+    delete wo_ppvsSectors;
+    wo_ppvsSectors = NULL;
+  }
+
+  const CTFileName fnmPVS = CWorldPVS::GetFileName(fnmWorld);
+  if (!FileExists(fnmPVS)) return;
+
+  CWorldPVS *ppvs = new CWorldPVS;
+
+  try {
+    CTFileStream strm;
+    strm.Open_t(fnmPVS);
+    ppvs->Read_t(strm);
+
+    // Must match the world that has been loaded
+    if (!ppvs->IsValid(*this)) {
+      ThrowF_t(TRANS("PVS has been made for a different version of the world"));
+    }
+
+  } catch (char *strError) {
+    CPrintF(TRANS("Cannot load PVS '%s': %s\n"), fnmPVS.ConstData(), strError);
+    delete ppvs;
+    return;
+  }
+
+  wo_ppvsSectors = ppvs;
+}
+
 /*
  * Load entire world (both brushes and current state).
  */
@@ -77,6 +142,9 @@ void CWorld::Load_t(const CTFileName &fnmWorld) // throw char *
   // close the file
   strmFile.Close();
 
+  // [Cecil] Load potentially visible sectors if they have been calculated for this world
+  LoadPVS(fnmWorld);
+
   // if reinit is needed
   if (bNeedsReinit) {
     // reinitialize
@@ -127,6 +195,19 @@ void CWorld::Read_t(CTStream *pistrm) // throw char *
   _pfWorldEditingProfile.IncrementAveragingCounter();
   _bFileReplacingApplied = FALSE;
 
+  // [Cecil] Start timing all loading stages
+  CTimerValue tvLoadStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX iStage = 0; iStage < WLS_COUNT; iStage++) {
+    _adLoadStageTime[iStage] = 0.0;
+  }
+
+  // [Cecil] Reset stats of files read ahead
+  ClearPrefetchedFiles();
+  INDEX ctPrefetched;
+  DOUBLE dPrefetchWait;
+  GetPrefetchStats(ctPrefetched, dPrefetchWait);
+
   // need high FPU precision
   CSetFPUPrecision FPUPrecision(FPT_53BIT);
 
@@ -146,6 +227,22 @@ void CWorld::Read_t(CTStream *pistrm) // throw char *
   // unlock all arrays and containers
   UnlockAll();
 
+  // [Cecil] Files that have been read ahead
+  GetPrefetchStats(ctPrefetched, dPrefetchWait);
+
+  // [Cecil] Report loading stages
+  if (wld_bReportLoadTimes) {
+    const DOUBLE dTotal = (_pTimer->GetHighPrecisionTimer() - tvLoadStart).GetSeconds();
+    CPrintF(TRANS("World loaded in %.3fs:"), dTotal);
+
+    for (INDEX iStage = 0; iStage < WLS_COUNT; iStage++) {
+      CPrintF(" %s %.3fs", _astrLoadStages[iStage], _adLoadStageTime[iStage]);
+    }
+
+    CPrintF(TRANS("\n  %d files read ahead on %d threads, %.3fs spent waiting for them\n"),
+      ctPrefetched, GetWorkerThreadCount(), dPrefetchWait);
+  }
+
   if( _bFileReplacingApplied)
     WarningMessage("Some of files needed to load world have been replaced while loading");
 }
@@ -185,13 +282,16 @@ void CWorld::ReadBrushes_t( CTStream *istrm)// throw char *
 
   SetProgressDescription(TRANS("loading world textures"));
   CallProgressHook_t(0.0f);
+  BeginLoadStage(); // [Cecil]
   // read the brushes from the file
   _pwoCurrentLoading = this;
   istrm->DictionaryReadBegin_t();
   istrm->DictionaryPreload_t();
+  EndLoadStage(WLS_TEXTURES); // [Cecil]
   CallProgressHook_t(1.0f);
   SetProgressDescription(TRANS("loading brushes"));
   CallProgressHook_t(0.0f);
+  BeginLoadStage(); // [Cecil]
   wo_baBrushes.Read_t(istrm);
   CallProgressHook_t(1.0f);
 
@@ -202,6 +302,7 @@ void CWorld::ReadBrushes_t( CTStream *istrm)// throw char *
     wo_taTerrains.Read_t(istrm);
     CallProgressHook_t(1.0f);
   }
+  EndLoadStage(WLS_BRUSHES); // [Cecil]
 
   istrm->DictionaryReadEnd_t();
   _pwoCurrentLoading = NULL;
@@ -236,9 +337,12 @@ void CWorld::ReadState_t( CTStream *istr) // throw char *
 
   SetProgressDescription(TRANS("loading models"));
   CallProgressHook_t(0.0f);
+  BeginLoadStage(); // [Cecil]
   wo_slStateDictionaryOffset = istr->DictionaryReadBegin_t();
   istr->DictionaryPreload_t();
+  EndLoadStage(WLS_MODELS); // [Cecil]
   CallProgressHook_t(1.0f);
+  BeginLoadStage(); // [Cecil]
   istr->ExpectID_t("WSTA"); // world state
 
   // read the version number
@@ -278,14 +382,23 @@ void CWorld::ReadState_t( CTStream *istr) // throw char *
         iSavedVersion, WORLDSTATEVERSION_CURRENT);
     }
   }
+  EndLoadStage(WLS_ENTITIES); // [Cecil]
+
+  // [Cecil] Wait for models that are still being loaded in the background
+  BeginLoadStage();
+  istr->FinishPreloading();
+  EndLoadStage(WLS_MODELWAIT);
+
   istr->DictionaryReadEnd_t();
 
   SetProgressDescription(TRANS("precaching"));
   CallProgressHook_t(0.0f);
+  BeginLoadStage(); // [Cecil]
   // precache data needed by entities
   if( gam_iPrecachePolicy==PRECACHE_SMART) {
     PrecacheEntities_t();
   }
+  EndLoadStage(WLS_PRECACHE); // [Cecil]
   CallProgressHook_t(1.0f);
 
   _pfWorldEditingProfile.StopTimer(CWorldEditingProfile::PTI_READSTATE);
@@ -622,7 +735,9 @@ void CWorld::ReadState_new_t( CTStream *istr) // throw char *
     // adjust id if needed
     if (_bReadEntitiesByID) {
       wo_ulNextEntityID--;
+      RemoveEntityID(penNew); // [Cecil]
       penNew->en_ulID = ulID;
+      AddEntityID(penNew); // [Cecil]
     }
     CallProgressHook_t(FLOAT(iEntity)/ctEntities);
   }}
@@ -0,0 +1,370 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#include "StdH.h"
+
+#include <Engine/World/WorldPVS.h>
+#include <Engine/World/World.h>
+#include <Engine/Brushes/Brush.h>
+#include <Engine/Brushes/BrushArchive.h>
+#include <Engine/Entities/Entity.h>
+#include <Engine/Base/Relations.h>
+#include <Engine/Base/Stream.h>
+#include <Engine/Base/ErrorReporting.h>
+#include <Engine/Base/Translation.h>
+#include <Engine/Base/WorkerThreads.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Base/CRC.h>
+#include <Engine/Math/Float.h>
+#include <Engine/Templates/StaticStackArray.cpp>
+
+// Version of PVS files
+#define PVS_VERSION 2
+
+// Tolerance for testing portals against each other, which keeps the PVS conservative
+#define PVS_EPSILON 0.01f
+
+CWorldPVS::CWorldPVS(void) : pvs_ctSectors(0), pvs_ctPolygons(0), pvs_ctRowWords(0), pvs_ulChecksum(0)
+{
+};
+
+void CWorldPVS::Clear(void) {
+  pvs_ctSectors = 0;
+  pvs_ctPolygons = 0;
+  pvs_ctRowWords = 0;
+  pvs_ulChecksum = 0;
+  pvs_aulTracked.Clear();
+  pvs_aulRows.Clear();
+  pvs_aulReported.Clear();
+};
+
+// Calculate checksum of the tracked geometry that the PVS has been made for
+ULONG CWorldPVS::CalculateChecksum(const CWorld &wo) const {
+  const CBrushArchive &ba = wo.wo_baBrushes;
+
+  ULONG ulCRC;
+  CRC_Start(ulCRC);
+
+  const INDEX ctSectors = Min(pvs_ctSectors, ba.ba_apbsc.Count());
+
+  for (INDEX iSector = 0; iSector < ctSectors; iSector++) {
+    if (!IsBitSet(&pvs_aulTracked[0], iSector)) continue;
+
+    const CBrushSector &bsc = *ba.ba_apbsc[iSector];
+    const INDEX ctPolygons = bsc.bsc_abpoPolygons.Count();
+    CRC_AddLONG(ulCRC, ctPolygons);
+
+    // Moved polygons or added and removed portals change what can be seen
+    for (INDEX iPolygon = 0; iPolygon < ctPolygons; iPolygon++) {
+      const CBrushPolygon &bpo = bsc.bsc_abpoPolygons[iPolygon];
+      const FLOATaabbox3D &box = bpo.bpo_boxBoundingBox;
+
+      for (INDEX i = 1; i <= 3; i++) {
+        CRC_AddFLOAT(ulCRC, box.minvect(i));
+        CRC_AddFLOAT(ulCRC, box.maxvect(i));
+      }
+
+      CRC_AddLONG(ulCRC, bpo.bpo_ulFlags & BPOF_PORTAL);
+    }
+  }
+
+  CRC_Finish(ulCRC);
+  return ulCRC;
+};
+
+// Check if the PVS has been made for the current state of the world
+BOOL CWorldPVS::IsValid(const CWorld &wo) const {
+  const CBrushArchive &ba = wo.wo_baBrushes;
+
+  if (pvs_ctSectors <= 0 || pvs_ctSectors != ba.ba_apbsc.Count() || pvs_ctPolygons != ba.ba_apbpo.Count()) {
+    return FALSE;
+  }
+
+  // Same amount of sectors and polygons doesn't mean that the geometry is the same
+  return pvs_ulChecksum == CalculateChecksum(wo);
+};
+
+// Get index of a tracked sector (-1 if it isn't tracked)
+INDEX CWorldPVS::GetSectorIndex(const CWorld &wo, const CBrushSector &bsc) const {
+  const INDEX iSector = bsc.bsc_iInWorld;
+
+  // Indices may be outdated if the world has been edited
+  if (iSector < 0 || iSector >= pvs_ctSectors) return -1;
+  if (wo.wo_baBrushes.ba_apbsc[iSector] != &bsc) return -1;
+
+  if (!IsBitSet(&pvs_aulTracked[0], iSector)) return -1;
+  return iSector;
+};
+
+// Check if visibility can be calculated for some sector
+static BOOL CanTrackSector(const CBrushSector &bsc) {
+  const CEntity *pen = bsc.bsc_pbmBrushMip->bm_pbrBrush->br_penEntity;
+  if (pen == NULL) return FALSE;
+
+  // Geometry and portal links of moving brushes change over time
+  return (pen->en_ulFlags & ENF_ZONING) && !(pen->en_ulPhysicsFlags & EPF_MOVABLE);
+};
+
+// Check if any vertex of a portal is behind the plane of another portal
+static BOOL IsAnyVertexBehind(const CBrushPolygon &bpo, const CBrushPolygon &bpoPlane) {
+  const FLOATplane3D &pl = bpoPlane.bpo_pbplPlane->bpl_plAbsolute;
+  const INDEX ctVtx = bpo.bpo_apbvxTriangleVertices.Count();
+
+  for (INDEX iVtx = 0; iVtx < ctVtx; iVtx++) {
+    if (pl.PointDistance(bpo.bpo_apbvxTriangleVertices[iVtx]->bvx_vAbsolute) < PVS_EPSILON) return TRUE;
+  }
+
+  return FALSE;
+};
+
+// Check if any vertex of a portal is in front of the plane of another portal
+static BOOL IsAnyVertexInFront(const CBrushPolygon &bpo, const CBrushPolygon &bpoPlane) {
+  const FLOATplane3D &pl = bpoPlane.bpo_pbplPlane->bpl_plAbsolute;
+  const INDEX ctVtx = bpo.bpo_apbvxTriangleVertices.Count();
+
+  for (INDEX iVtx = 0; iVtx < ctVtx; iVtx++) {
+    if (pl.PointDistance(bpo.bpo_apbvxTriangleVertices[iVtx]->bvx_vAbsolute) > -PVS_EPSILON) return TRUE;
+  }
+
+  return FALSE;
+};
+
+// Check if a line that has passed through the first and the previous portal can also pass through the next one.
+// Polygon planes face inside their sectors, so the line continues behind the planes of portals it has passed.
+static BOOL CanSeeThroughPortal(const CBrushPolygon &bpoFirst, const CBrushPolygon &bpoPrev, const CBrushPolygon &bpoNext) {
+  return IsAnyVertexBehind(bpoNext, bpoFirst) && IsAnyVertexInFront(bpoFirst, bpoNext)
+      && IsAnyVertexBehind(bpoNext, bpoPrev)  && IsAnyVertexInFront(bpoPrev, bpoNext);
+};
+
+// Portal that has been reached while flooding through sectors
+struct PVSPortal {
+  CBrushPolygon *pbpo;
+  BOOL bUnbounded; // passed through an untracked sector, so the following portals aren't tested
+};
+
+// Data for calculating rows on worker threads
+struct PVSJob {
+  CWorld *pwo;
+  CWorldPVS *ppvs;
+};
+
+// Calculate one row of the PVS
+static void CalculateRow(void *pData, INDEX iSource) {
+  PVSJob &job = *(PVSJob *)pData;
+  CWorldPVS &pvs = *job.ppvs;
+  CBrushArchive &ba = job.pwo->wo_baBrushes;
+
+  if (!CWorldPVS::IsBitSet(&pvs.pvs_aulTracked[0], iSource)) return;
+
+  ULONG *pulRow = &pvs.pvs_aulRows[iSource * pvs.pvs_ctRowWords];
+  pulRow[iSource >> 5] |= (1UL << (iSource & 31));
+
+  // Portals that have been flooded through from the current first portal (1 = tested, 2 = unbounded)
+  const INDEX ctPolygons = ba.ba_apbpo.Count();
+  CStaticArray<UBYTE> aubVisited;
+  aubVisited.New(ctPolygons);
+  memset(&aubVisited[0], 0, ctPolygons);
+
+  CStaticStackArray<PVSPortal> aStack;
+  CStaticStackArray<INDEX> aiVisited;
+
+  CBrushSector &bscSource = *ba.ba_apbsc[iSource];
+
+  FOREACHINSTATICARRAY(bscSource.bsc_abpoPolygons, CBrushPolygon, itbpo) {
+    CBrushPolygon &bpoFirst = *itbpo;
+    if (!(bpoFirst.bpo_ulFlags & BPOF_PORTAL)) continue;
+
+    // Reset portals from the previous flood
+    for (INDEX iVisited = 0; iVisited < aiVisited.Count(); iVisited++) {
+      aubVisited[aiVisited[iVisited]] = 0;
+    }
+    aiVisited.PopAll();
+
+    PVSPortal &portalFirst = aStack.Push();
+    portalFirst.pbpo = &bpoFirst;
+    portalFirst.bUnbounded = FALSE;
+
+    while (aStack.Count() > 0) {
+      const PVSPortal portal = aStack.Pop();
+      CBrushPolygon &bpoPrev = *portal.pbpo;
+
+      // For all sectors behind the portal
+      {FOREACHDSTOFSRC(bpoPrev.bpo_rsOtherSideSectors, CBrushSector, bsc_rdOtherSidePortals, pbsc)
+        const INDEX iSector = pbsc->bsc_iInWorld;
+        pulRow[iSector >> 5] |= (1UL << (iSector & 31));
+
+        // Lines may go anywhere behind untracked sectors
+        const BOOL bUnbounded = portal.bUnbounded || !CWorldPVS::IsBitSet(&pvs.pvs_aulTracked[0], iSector);
+        const UBYTE ubVisit = bUnbounded ? 2 : 1;
+
+        FOREACHINSTATICARRAY(pbsc->bsc_abpoPolygons, CBrushPolygon, itbpoNext) {
+          CBrushPolygon &bpoNext = *itbpoNext;
+          if (!(bpoNext.bpo_ulFlags & BPOF_PORTAL)) continue;
+
+          UBYTE &ubVisited = aubVisited[bpoNext.bpo_iInWorld];
+          if (ubVisited & ubVisit) continue;
+
+          if (!bUnbounded && !CanSeeThroughPortal(bpoFirst, bpoPrev, bpoNext)) continue;
+
+          if (ubVisited == 0) aiVisited.Push() = bpoNext.bpo_iInWorld;
+          ubVisited |= ubVisit;
+
+          PVSPortal &portalNext = aStack.Push();
+          portalNext.pbpo = &bpoNext;
+          portalNext.bUnbounded = bUnbounded;
+        }
+      ENDFOR}
+    }
+  }
+};
+
+void CWorldPVS::Calculate(CWorld &wo) {
+  Clear();
+
+  // Make sure that portals lead to the right sectors
+  if (!wo.wo_bPortalLinksUpToDate) {
+    CSetFPUPrecision FPUPrecision(FPT_53BIT);
+    wo.wo_baBrushes.LinkPortalsAndSectors();
+    wo.wo_bPortalLinksUpToDate = TRUE;
+  }
+
+  CBrushArchive &ba = wo.wo_baBrushes;
+  ba.MakeIndices();
+
+  pvs_ctSectors = ba.ba_apbsc.Count();
+  pvs_ctPolygons = ba.ba_apbpo.Count();
+  pvs_ctRowWords = (pvs_ctSectors + 31) / 32;
+
+  if (pvs_ctSectors == 0) return;
+
+  pvs_aulTracked.New(pvs_ctRowWords);
+  pvs_aulRows.New(pvs_ctSectors * pvs_ctRowWords);
+  pvs_aulReported.New(pvs_ctRowWords);
+  memset(&pvs_aulTracked[0], 0, pvs_ctRowWords * sizeof(ULONG));
+  memset(&pvs_aulRows[0], 0, pvs_ctSectors * pvs_ctRowWords * sizeof(ULONG));
+  memset(&pvs_aulReported[0], 0, pvs_ctRowWords * sizeof(ULONG));
+
+  for (INDEX iSector = 0; iSector < pvs_ctSectors; iSector++) {
+    if (CanTrackSector(*ba.ba_apbsc[iSector])) {
+      pvs_aulTracked[iSector >> 5] |= (1UL << (iSector & 31));
+    }
+  }
+
+  pvs_ulChecksum = CalculateChecksum(wo);
+
+  // Rows only read the world, so they can be calculated independently
+  PVSJob job;
+  job.pwo = &wo;
+  job.ppvs = this;
+  ParallelFor(pvs_ctSectors, &CalculateRow, &job);
+};
+
+void CWorldPVS::Read_t(CTStream &strm) {
+  Clear();
+
+  strm.ExpectID_t("PVS ");
+
+  INDEX iVersion;
+  strm >> iVersion;
+
+  if (iVersion != PVS_VERSION) {
+    ThrowF_t(TRANS("Invalid PVS version: %d"), iVersion);
+  }
+
+  INDEX ctSectors, ctPolygons;
+  strm >> ctSectors;
+  strm >> ctPolygons;
+  strm >> pvs_ulChecksum;
+
+  if (ctSectors <= 0 || ctPolygons < 0) {
+    ThrowF_t(TRANS("Invalid amount of sectors in the PVS: %d"), ctSectors);
+  }
+
+  pvs_ctSectors = ctSectors;
+  pvs_ctPolygons = ctPolygons;
+  pvs_ctRowWords = (pvs_ctSectors + 31) / 32;
+
+  pvs_aulTracked.New(pvs_ctRowWords);
+  pvs_aulRows.New(pvs_ctSectors * pvs_ctRowWords);
+  pvs_aulReported.New(pvs_ctRowWords);
+  memset(&pvs_aulReported[0], 0, pvs_ctRowWords * sizeof(ULONG));
+
+  strm.Read_t(&pvs_aulTracked[0], pvs_ctRowWords * sizeof(ULONG));
+  strm.Read_t(&pvs_aulRows[0], pvs_ctSectors * pvs_ctRowWords * sizeof(ULONG));
+};
+
+void CWorldPVS::Write_t(CTStream &strm) {
+  strm.WriteID_t("PVS ");
+  strm << INDEX(PVS_VERSION);
+  strm << pvs_ctSectors;
+  strm << pvs_ctPolygons;
+  strm << pvs_ulChecksum;
+
+  if (pvs_ctSectors == 0) return;
+
+  strm.Write_t(&pvs_aulTracked[0], pvs_ctRowWords * sizeof(ULONG));
+  strm.Write_t(&pvs_aulRows[0], pvs_ctSectors * pvs_ctRowWords * sizeof(ULONG));
+};
+
+// Get file that holds the PVS of some world
+CTFileName CWorldPVS::GetFileName(const CTFileName &fnmWorld) {
+  return fnmWorld.NoExt() + ".pvs";
+};
+
+// Calculate PVS of some world and save it next to the world file
+void MakeWorldPVS(void *pArgs) {
+  const CTFileName fnmWorld = *NEXTARGUMENT(CTString *);
+  const CTFileName fnmPVS = CWorldPVS::GetFileName(fnmWorld);
+
+  try {
+    CWorld wo;
+    wo.Load_t(fnmWorld);
+
+    const CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+    CWorldPVS pvs;
+    pvs.Calculate(wo);
+
+    const DOUBLE dTime = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+
+    CTFileStream strm;
+    strm.Create_t(fnmPVS);
+    pvs.Write_t(strm);
+    strm.Close();
+
+    // Count tracked sectors and sectors that are visible from them
+    INDEX ctTracked = 0, ctVisible = 0;
+
+    for (INDEX iSector = 0; iSector < pvs.pvs_ctSectors; iSector++) {
+      if (!CWorldPVS::IsBitSet(&pvs.pvs_aulTracked[0], iSector)) continue;
+      ctTracked++;
+
+      const ULONG *pulRow = pvs.GetRow(iSector);
+
+      for (INDEX iOther = 0; iOther < pvs.pvs_ctSectors; iOther++) {
+        ctVisible += CWorldPVS::IsBitSet(pulRow, iOther);
+      }
+    }
+
+    CPrintF(TRANS("Saved PVS for %d out of %d sectors into '%s' (%.1f visible sectors on average, %.2f seconds)\n"),
+      ctTracked, pvs.pvs_ctSectors, fnmPVS.ConstData(), ctVisible / FLOAT(Max(ctTracked, (INDEX)1)), dTime);
+
+  } catch (char *strError) {
+    CPrintF(TRANS("Cannot make PVS for '%s':\n%s\n"), fnmWorld.ConstData(), strError);
+  }
+};
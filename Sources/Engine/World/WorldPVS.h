@@ -0,0 +1,77 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#ifndef SE_INCL_WORLDPVS_H
+#define SE_INCL_WORLDPVS_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#include <Engine/Templates/StaticArray.h>
+
+// Potentially visible set of brush sectors that is calculated offline and stored next to the world file.
+// Each sector has a row of bits for all sectors in the world that may be seen from any point inside it,
+// which lets the renderer skip portals and sectors that can never be visible before scanning their edges.
+// Only sectors of static zoning brushes are tracked; other sectors are never culled.
+class ENGINE_API CWorldPVS {
+  public:
+    INDEX pvs_ctSectors;  // amount of sectors in the world when the PVS was made
+    INDEX pvs_ctPolygons; // amount of polygons in the world when the PVS was made
+    INDEX pvs_ctRowWords; // amount of 32-bit words in each row
+    ULONG pvs_ulChecksum; // checksum of the tracked geometry when the PVS was made
+
+    CStaticArray<ULONG> pvs_aulTracked; // sectors that the PVS has been calculated for
+    CStaticArray<ULONG> pvs_aulRows; // rows of visible sectors for each sector
+    CStaticArray<ULONG> pvs_aulReported; // sectors that have already been reported during verification
+
+  public:
+    // Constructor
+    CWorldPVS(void);
+
+    // Clear all data
+    void Clear(void);
+
+    // Calculate checksum of the tracked geometry that the PVS has been made for
+    ULONG CalculateChecksum(const CWorld &wo) const;
+
+    // Check if the PVS has been made for the current state of the world
+    BOOL IsValid(const CWorld &wo) const;
+
+    // Get index of a tracked sector (-1 if it isn't tracked)
+    INDEX GetSectorIndex(const CWorld &wo, const CBrushSector &bsc) const;
+
+    // Check if some bit is set in a bit array
+    static inline BOOL IsBitSet(const ULONG *pulBits, INDEX iBit) {
+      return (pulBits[iBit >> 5] >> (iBit & 31)) & 1;
+    };
+
+    // Get row of sectors that are visible from some sector
+    inline const ULONG *GetRow(INDEX iSector) const {
+      return &pvs_aulRows[iSector * pvs_ctRowWords];
+    };
+
+    // Calculate visibility between all tracked sectors in the world (spread over worker threads)
+    void Calculate(CWorld &wo);
+
+    // Read/write from/to stream
+    void Read_t(CTStream &strm); // throw char *
+    void Write_t(CTStream &strm); // throw char *
+
+    // Get file that holds the PVS of some world
+    static CTFileName GetFileName(const CTFileName &fnmWorld);
+};
+
+#endif  /* include-once check. */
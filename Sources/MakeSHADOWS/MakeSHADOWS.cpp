@@ -0,0 +1,383 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+// MakeSHADOWS - Parallel Shadow Map Baker
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if SE1_WIN
+  #include <process.h>
+#else
+  #include <sys/wait.h>
+#endif
+
+#include <Engine/Engine.h>
+#include <Engine/Base/WorkerThreads.h>
+#include <Engine/World/ShadowBaking.h>
+
+// Command line arguments
+static CTString _strWorld;
+static CTString _strOutput;
+static INDEX _ctJobs = 0; // Use all cores by default
+static BOOL _bCompare = FALSE;
+
+// Worker process arguments
+static INDEX _iPart = -1;
+static INDEX _ctParts = 0;
+static CTString _strPartFile;
+
+// Parsed arguments
+static INDEX _ctParsedArgs = 0;
+
+// Handle program's launch arguments
+static void HandleInitialArgs(const CommandLineArgs_t &aArgs) {
+  _ctParsedArgs = aArgs.Count();
+  _strWorld = aArgs[0];
+};
+
+static void HandleJobs(const CommandLineArgs_t &aArgs) {
+  _ctJobs = Clamp(atoi(aArgs[0].ConstData()), 1, 64);
+};
+
+static void HandleOutput(const CommandLineArgs_t &aArgs) {
+  _strOutput = aArgs[0];
+};
+
+static void HandleCompare(const CommandLineArgs_t &aArgs) {
+  _bCompare = TRUE;
+};
+
+// Internal option for worker processes
+static void HandlePart(const CommandLineArgs_t &aArgs) {
+  _iPart = atoi(aArgs[0].ConstData());
+  _ctParts = atoi(aArgs[1].ConstData());
+  _strPartFile = aArgs[2];
+};
+
+// Load the world and prepare it for calculating shadows the same way as the editor does
+static void LoadWorld_t(CWorld &wo, CShadowBaker &sb) {
+  wo.Load_t(_strWorld);
+  wo.ReinitializeEntities();
+
+  _pShell->Execute("FreeUnusedStock();");
+
+  wo.ShowAllSectors();
+  wo.ShowAllEntities();
+
+  sb.Prepare(wo);
+};
+
+// Start a worker process that bakes one part of the shadow maps (returns process handle or -1 on failure)
+static SQUAD StartWorker(INDEX iPart, INDEX ctParts, const CTString &strPartFile) {
+  CTString strApp = _fnmFullExecutablePath;
+  strApp.ReplaceChar('\\', '/'); // For execv()
+
+  CTString strPart(0, "%d", iPart);
+  CTString strParts(0, "%d", ctParts);
+
+  const char *aArgs[] = {
+    strApp.ConstData(), _strWorld.ConstData(),
+    "-part", strPart.ConstData(), strParts.ConstData(), strPartFile.ConstData(),
+    NULL,
+  };
+
+#if SE1_WIN
+  // Arguments are joined into one command line, so paths with spaces need to be quoted
+  const INDEX ctArgs = ARRAYCOUNT(aArgs) - 1;
+  CTString astrQuoted[ARRAYCOUNT(aArgs) - 1];
+  const char *aQuoted[ARRAYCOUNT(aArgs)];
+
+  for (INDEX iArg = 0; iArg < ctArgs; iArg++) {
+    astrQuoted[iArg] = CTString(0, "\"%s\"", aArgs[iArg]);
+    aQuoted[iArg] = astrQuoted[iArg].ConstData();
+  }
+
+  aQuoted[ctArgs] = NULL;
+  return _spawnv(_P_NOWAIT, aArgs[0], aQuoted);
+
+#else
+  pid_t pid = fork();
+
+  // Replace the child process with a worker
+  if (pid == 0) {
+    execv(aArgs[0], (char *const *)aArgs);
+    _exit(EXIT_FAILURE);
+  }
+
+  return pid;
+#endif
+};
+
+// Wait until a worker process finishes (returns TRUE if it succeeded)
+static BOOL WaitForWorker(SQUAD hProcess) {
+#if SE1_WIN
+  int iStatus = EXIT_FAILURE;
+  if (_cwait(&iStatus, (intptr_t)hProcess, 0) == -1) return FALSE;
+
+  return iStatus == EXIT_SUCCESS;
+
+#else
+  int iStatus = 0;
+  if (waitpid((pid_t)hProcess, &iStatus, 0) == -1) return FALSE;
+
+  return WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == EXIT_SUCCESS;
+#endif
+};
+
+// Bake one part of the shadow maps in a worker process
+static void BakePart(void) {
+  try {
+    CWorld wo;
+    CShadowBaker sb;
+    LoadWorld_t(wo, sb);
+
+    sb.Bake(_iPart, _ctParts);
+
+    CTFileStream strm;
+    strm.Create_t(_strPartFile);
+    sb.WritePart_t(strm, _iPart, _ctParts);
+    strm.Close();
+
+  } catch (char *strError) {
+    printf("! Cannot bake part %d of '%s':\n  %s\n", _iPart, _strWorld.ConstData(), strError);
+    exit(EXIT_FAILURE);
+  }
+
+  exit(EXIT_SUCCESS);
+};
+
+// Calculate all shadow maps in this process exactly like the editor does
+static void BakeSerially(CWorld &wo) {
+  wo.CalculateDirectionalShadows();
+  wo.CalculateNonDirectionalShadows();
+};
+
+// Calculate shadow maps in worker processes and gather them (returns FALSE on failure)
+static BOOL BakeInParallel(CShadowBaker &sb, INDEX ctJobs) {
+  BOOL bFailed = FALSE;
+
+  // Start all workers at once
+  CStaticArray<CTString> astrParts;
+  CStaticArray<SQUAD> ahWorkers;
+  astrParts.New(ctJobs);
+  ahWorkers.New(ctJobs);
+
+  INDEX iJob;
+
+  for (iJob = 0; iJob < ctJobs; iJob++) {
+    astrParts[iJob] = ExpandPath::ToTemp(CTString(0, "Shadows_%d_%d.bin", (INDEX)getpid(), iJob));
+    ahWorkers[iJob] = StartWorker(iJob, ctJobs, astrParts[iJob]);
+
+    if (ahWorkers[iJob] == -1) {
+      printf("! Cannot start worker process %d:\n  %s\n", iJob, strerror(errno));
+      bFailed = TRUE;
+    }
+  }
+
+  // Wait for all workers before reading any parts
+  for (iJob = 0; iJob < ctJobs; iJob++) {
+    if (ahWorkers[iJob] == -1) continue;
+
+    if (!WaitForWorker(ahWorkers[iJob])) {
+      printf("! Worker process %d has failed\n", iJob);
+      bFailed = TRUE;
+    }
+  }
+
+  // Gather calculated shadow maps
+  for (iJob = 0; iJob < ctJobs && !bFailed; iJob++) {
+    try {
+      CTFileStream strm;
+      strm.Open_t(astrParts[iJob]);
+      sb.ReadPart_t(strm);
+
+    } catch (char *strError) {
+      printf("! Cannot read part %d:\n  %s\n", iJob, strError);
+      bFailed = TRUE;
+    }
+  }
+
+  for (iJob = 0; iJob < ctJobs; iJob++) {
+    RemoveFile(astrParts[iJob]);
+  }
+
+  if (bFailed) return FALSE;
+
+  sb.Finish();
+  return TRUE;
+};
+
+// Calculate shadow maps in another copy of the world in this process and compare both worlds (returns FALSE if they differ)
+static BOOL CompareWithSerial(CWorld &woParallel) {
+  CWorld woSerial;
+  CShadowBaker sbSerial;
+
+  CTMemoryStream strmParallel, strmSerial;
+
+  try {
+    LoadWorld_t(woSerial, sbSerial);
+    BakeSerially(woSerial);
+
+    woParallel.Write_t(&strmParallel);
+    woSerial.Write_t(&strmSerial);
+
+  } catch (char *strError) {
+    printf("! Cannot compare with serial calculation:\n  %s\n", strError);
+    return FALSE;
+  }
+
+  UBYTE *pubParallel, *pubSerial;
+  SLONG slParallel, slSerial;
+  strmParallel.LockBuffer((void **)&pubParallel, &slParallel);
+  strmSerial.LockBuffer((void **)&pubSerial, &slSerial);
+
+  SLONG slDifferent = -1;
+
+  for (SLONG sl = 0; sl < Min(slParallel, slSerial); sl++) {
+    if (pubParallel[sl] != pubSerial[sl]) {
+      slDifferent = sl;
+      break;
+    }
+  }
+
+  if (slDifferent == -1 && slParallel != slSerial) {
+    slDifferent = Min(slParallel, slSerial);
+  }
+
+  strmParallel.UnlockBuffer();
+  strmSerial.UnlockBuffer();
+
+  if (slDifferent != -1) {
+    printf("! World differs from serial calculation at byte %d (%d and %d bytes)\n", slDifferent, slParallel, slSerial);
+    return FALSE;
+  }
+
+  printf("- World is identical to serial calculation (%d bytes).\n", slSerial);
+  return TRUE;
+};
+
+void SubMain(int argc, char **argv) {
+  // Parse command line arguments
+  {
+    CommandLineSetup cmd(argc, argv);
+    cmd.AddInitialParser(&HandleInitialArgs, 1);
+    cmd.AddCommand("-jobs", &HandleJobs, 1);
+    cmd.AddCommand("-out", &HandleOutput, 1);
+    cmd.AddCommand("-compare", &HandleCompare, 0);
+    cmd.AddCommand("-part", &HandlePart, 3);
+    SE_ParseCommandLine(cmd);
+  }
+
+  const BOOL bWorker = (_ctParts > 0);
+
+  if (!bWorker) {
+    printf("\nMakeSHADOWS - Parallel Shadow Map Baker\n\n");
+
+    // Command line output in the console
+    printf("%s", SE_CommandLineOutput().ConstData());
+  }
+
+  if (_ctParsedArgs != 1 || (bWorker && (_iPart < 0 || _iPart >= _ctParts)))
+  {
+    printf("USAGE: MakeSHADOWS <world> [-jobs <count>] [-out <world>] [-compare]\n");
+    printf("\n");
+    printf("world: world file relative to the game directory\n");
+    printf("-jobs: amount of processes that calculate shadow maps at the same time (all cores by default)\n");
+    printf("-out: save the world under a different file instead of overwriting it\n");
+    printf("-compare: also calculate shadows in one process and check that both worlds are identical\n");
+    printf("\n");
+    printf("NOTES: - shadows are recalculated on all brush polygons the same way as when converting worlds\n");
+    printf("         in the editor, with all sectors and entities shown\n");
+    printf("       - each process loads its own copy of the world and calculates every N-th shadow map,\n");
+    printf("         which are then gathered in the main process and saved with the world\n");
+    printf("       - shadow maps of each polygon don't depend on the amount of processes, and render flags\n");
+    printf("         of sectors and polygons are taken from whichever process has set them last, so the saved\n");
+    printf("         world is the same as when using one process\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // Initialize engine
+  SeriousEngineSetup se1setup("MakeSHADOWS");
+  se1setup.eAppType = SeriousEngineSetup::E_OTHER;
+  SE_InitEngine(se1setup);
+
+  // Only calculate one part in a worker process
+  if (bWorker) {
+    BakePart();
+    return;
+  }
+
+  if (_ctJobs <= 0) {
+    _ctJobs = Clamp(GetWorkerThreadCount(), 1, 64);
+  }
+
+  if (_strOutput == "") {
+    _strOutput = _strWorld;
+  }
+
+  const CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  CWorld wo;
+  CShadowBaker sb;
+
+  try {
+    LoadWorld_t(wo, sb);
+
+  } catch (char *strError) {
+    printf("! Cannot load '%s':\n  %s\n", _strWorld.ConstData(), strError);
+    exit(EXIT_FAILURE);
+  }
+
+  // No need for more processes than there are shadow maps
+  const INDEX ctJobs = Clamp(_ctJobs, 1, Max(sb.Count(), 1));
+  printf("- Baking %d shadow maps in '%s' using %d processes.\n", sb.Count(), _strWorld.ConstData(), ctJobs);
+
+  // Calculate everything in this process
+  if (ctJobs == 1 && !_bCompare) {
+    BakeSerially(wo);
+
+  } else if (!BakeInParallel(sb, ctJobs)) {
+    exit(EXIT_FAILURE);
+  }
+
+  try {
+    wo.Save_t(_strOutput);
+
+  } catch (char *strError) {
+    printf("! Cannot save '%s':\n  %s\n", _strOutput.ConstData(), strError);
+    exit(EXIT_FAILURE);
+  }
+
+  const DOUBLE dTotal = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+  printf("- Saved '%s' in %.2f seconds.\n", _strOutput.ConstData(), dTotal);
+
+  if (_bCompare && !CompareWithSerial(wo)) {
+    exit(EXIT_FAILURE);
+  }
+
+  exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char **argv) {
+  CTSTREAM_BEGIN {
+    SubMain(argc, argv);
+  } CTSTREAM_END;
+
+  return 0;
+}
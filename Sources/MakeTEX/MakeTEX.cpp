@@ -0,0 +1,183 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+// MakeTEX - Batch Texture Recreator
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Engine/Engine.h>
+#include <Engine/Base/WorkerThreads.h>
+
+// Command line arguments
+static CTString _strDirectory;
+static BOOL _bRecursive = FALSE;
+static INDEX _iCompression = 0; // Value for tex_iWriteCompression
+
+// Parsed arguments
+static INDEX _ctParsedArgs = 0;
+
+// Handle program's launch arguments
+static void HandleInitialArgs(const CommandLineArgs_t &aArgs) {
+  _ctParsedArgs = aArgs.Count();
+  _strDirectory = aArgs[0];
+
+  // Optional arguments in any order
+  for (INDEX iArg = 1; iArg < _ctParsedArgs; iArg++) {
+    const CTString &strArg = aArgs[iArg];
+
+    if (strArg.HasPrefix("-R")) {
+      _bRecursive = TRUE;
+
+    } else if (strArg.HasPrefix("-BC7")) {
+      _iCompression = 2;
+
+    } else if (strArg.HasPrefix("-BC")) {
+      _iCompression = 1;
+    }
+  }
+};
+
+// Find picture or script file that a texture has been created from
+static BOOL FindTextureSource(const CTFileName &fnmTexture, CTFileName &fnmSource) {
+  static const char *astrExtensions[] = { ".tga", ".pcx", ".scr" };
+
+  for (INDEX iExt = 0; iExt < ARRAYCOUNT(astrExtensions); iExt++) {
+    fnmSource = fnmTexture.NoExt() + astrExtensions[iExt];
+    if (FileExists(fnmSource)) return TRUE;
+  }
+
+  return FALSE;
+};
+
+// Recreate one texture from its source with the same settings
+static void RecreateTexture_t(const CTFileName &fnmTexture, const CTFileName &fnmSource) {
+  // Read settings of the existing texture
+  MEX mexWidth;
+  INDEX ctFineMips;
+  BOOL bForce32bit;
+  {
+    CTextureData td;
+    td.Load_t(fnmTexture);
+
+    mexWidth = td.GetWidth();
+    ctFineMips = td.GetNoOfFineMips();
+    bForce32bit = (td.GetFlags() & TEX_32BIT) != 0;
+  }
+
+  // Scripts specify their own settings
+  CreateTexture_t(fnmSource, fnmTexture, mexWidth, ctFineMips, bForce32bit);
+};
+
+void SubMain(int argc, char **argv) {
+  // Parse command line arguments
+  {
+    CommandLineSetup cmd(argc, argv);
+    cmd.AddInitialParser(&HandleInitialArgs, Clamp(argc - 1, 1, 3)); // Take optional arguments into account
+    SE_ParseCommandLine(cmd);
+  }
+
+  printf("\nMakeTEX - Batch Texture Recreator\n\n");
+
+  // Command line output in the console
+  printf("%s", SE_CommandLineOutput().ConstData());
+
+  // Should only parse 1 to 3 of own arguments
+  if (_ctParsedArgs < 1 || _ctParsedArgs > 3)
+  {
+    printf("USAGE: MakeTEX <directory> [-R] [-BC | -BC7]\n");
+    printf("\n");
+    printf("directory: directory with texture files relative to the game directory\n");
+    printf("-R: also recreate textures in all subdirectories\n");
+    printf("-BC: save frames as compressed blocks (BC1 for opaque textures, BC3 for textures with alpha)\n");
+    printf("-BC7: save frames as compressed BC7 blocks\n");
+    printf("\n");
+    printf("NOTES: - each texture is recreated from a picture (.tga or .pcx) or a script (.scr)\n");
+    printf("         with the same name, keeping its size, fine mipmaps and 32-bit quality\n");
+    printf("       - textures without source files (e.g. effect textures) are skipped\n");
+    printf("       - texture processing is spread over all worker threads\n");
+    printf("       - compressed textures are uploaded as they are if the driver supports their format\n");
+    printf("         and are decoded on load otherwise\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // Initialize engine
+  SeriousEngineSetup se1setup("MakeTEX");
+  se1setup.eAppType = SeriousEngineSetup::E_OTHER;
+  SE_InitEngine(se1setup);
+
+  // Encode frames of recreated textures
+  _pShell->SetINDEX("tex_iWriteCompression", _iCompression);
+
+  // Directory relative to the game directory with a slash at the end
+  CTFileName fnmDir = _strDirectory;
+  fnmDir.SetFullDirectory();
+  fnmDir.RemoveApplicationPath_t();
+
+  CDynamicStackArray<CTFileName> afnmTextures;
+  MakeDirList(afnmTextures, fnmDir, "*.tex", _bRecursive ? DLI_RECURSIVE : 0);
+
+  const INDEX ctTextures = afnmTextures.Count();
+  printf("- Recreating %d textures in '%s' using %d worker threads.\n", ctTextures, fnmDir.ConstData(), GetWorkerThreadCount());
+
+  if (_iCompression != 0) {
+    printf("- Frames are saved as %s blocks.\n", _iCompression == 2 ? "BC7" : "BC1/BC3");
+  }
+
+  // Textures are created one by one because texture creation uses global state,
+  // but bitmap processing of each one is split between worker threads
+  INDEX ctCreated = 0, ctSkipped = 0, ctFailed = 0;
+  const CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for (INDEX iTex = 0; iTex < ctTextures; iTex++) {
+    const CTFileName &fnmTexture = afnmTextures[iTex];
+    CTFileName fnmSource;
+
+    if (!FindTextureSource(fnmTexture, fnmSource)) {
+      printf("  '%s' skipped (no source file)\n", fnmTexture.ConstData());
+      ctSkipped++;
+      continue;
+    }
+
+    const CTimerValue tvTexture = _pTimer->GetHighPrecisionTimer();
+
+    try {
+      RecreateTexture_t(fnmTexture, fnmSource);
+
+    } catch (char *strError) {
+      printf("! Cannot recreate '%s':\n  %s\n", fnmTexture.ConstData(), strError);
+      ctFailed++;
+      continue;
+    }
+
+    const DOUBLE dTime = (_pTimer->GetHighPrecisionTimer() - tvTexture).GetSeconds();
+    printf("  '%s' created from '%s' (%.1f ms)\n", fnmTexture.ConstData(), fnmSource.FileExt().ConstData(), dTime * 1000.0);
+    ctCreated++;
+  }
+
+  const DOUBLE dTotal = (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+  printf("- %d created, %d skipped, %d failed in %.2f seconds.\n", ctCreated, ctSkipped, ctFailed, dTotal);
+
+  exit(ctFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  CTSTREAM_BEGIN {
+    SubMain(argc, argv);
+  } CTSTREAM_END;
+
+  return 0;
+}
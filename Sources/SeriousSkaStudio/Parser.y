@@ -62,6 +62,7 @@ float _fCurentMaxDistance;// max distance for next lod
 float _fTreshold = 0;// treshold for next animation
 float _fAnimSpeed = -1;
 BOOL bCompresion = FALSE;// is animation is using compresions
+float _fQuantize = 0;// position tolerance for quantized keyframes of next animation
 %}
 
 %{
@@ -130,6 +131,7 @@ void SKAyyerror(const char *strFormat, ...)
 %token k_SKELETONLODLIST
 %token k_TRESHOLD
 %token k_COMPRESION
+%token k_QUANTIZE
 %token k_LENGTH
 %token k_ANIMSPEED
 %token k_SHADER_PARAMS
@@ -225,7 +227,7 @@ animset_array
 ;
 
 animset
-: treshold_opt compresion_opt animspeed_opt animset_begin animation_header bone_envelopes morph_envelopes animset_end
+: treshold_opt compresion_opt quantize_opt animspeed_opt animset_begin animation_header bone_envelopes morph_envelopes animset_end
 ;
 
 compresion_opt
@@ -234,6 +236,13 @@ compresion_opt
 | k_COMPRESION boolean
 { bCompresion  = $2; }
 
+quantize_opt
+: /*null*/
+{ _fQuantize = 0.0f; }
+| k_QUANTIZE float_const ';'
+{ _fQuantize = $2; }
+;
+
 treshold_opt 
 : /*null*/
 { _fTreshold = 0.0f; }
@@ -265,6 +274,9 @@ animset_begin
   an.an_fTreshold = _fTreshold;
   // set animation allready read compresion flag
   an.an_bCompresed =  bCompresion;
+  // set animation allready read quantization tolerance
+  an.an_fQuantize = _fQuantize;
+  an.an_bQuantized = FALSE;
 }
 ;
 
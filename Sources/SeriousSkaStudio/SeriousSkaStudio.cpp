@@ -739,9 +739,11 @@ BOOL CSeriousSkaStudioApp::ConvertAnimationInAnimSet(CAnimSet *pas,Animation *pa
   CTString strCustomSpeed;
   CTString strCompresion = "FALSE";
   if(pan->an_bCompresed) strCompresion = "TRUE";
+  CTString strQuantize;
   if(pan->an_bCustomSpeed) strCustomSpeed.PrintF("  ANIMSPEED %g;",pan->an_fSecPerFrame);
-  strAnimSet.PrintF("ANIMSETLIST\n{\n  TRESHOLD %g;\n  COMPRESION %s;\n%s\n  #INCLUDE \"%s\"\n}\n",
-    pan->an_fTreshold, strCompresion.ConstData(), strCustomSpeed.ConstData(), pan->an_fnSourceFile.ConstData());
+  if(pan->an_fQuantize>0) strQuantize.PrintF("  QUANTIZE %g;\n",pan->an_fQuantize);
+  strAnimSet.PrintF("ANIMSETLIST\n{\n  TRESHOLD %g;\n  COMPRESION %s;\n%s%s\n  #INCLUDE \"%s\"\n}\n",
+    pan->an_fTreshold, strCompresion.ConstData(), strQuantize.ConstData(), strCustomSpeed.ConstData(), pan->an_fnSourceFile.ConstData());
 
   try
   {
@@ -1125,6 +1127,7 @@ void CSeriousSkaStudioApp::SaveAnimSet_t(CAnimSet &as,CTFileStream &ostrFile)
     ostrFile.FPrintF_t("  TRESHOLD %g;\n",an.an_fTreshold);
     if(an.an_bCompresed) ostrFile.FPrintF_t("  COMPRESION TRUE;\n");
     else ostrFile.FPrintF_t("  COMPRESION FALSE;\n");
+    if(an.an_fQuantize>0) ostrFile.FPrintF_t("  QUANTIZE %g;\n",an.an_fQuantize);
     if(an.an_bCustomSpeed) ostrFile.FPrintF_t("  ANIMSPEED %g;\n",an.an_fSecPerFrame);
     ostrFile.FPrintF_t("  #INCLUDE \"%s\"\n", fnSource.ConstData());
   }
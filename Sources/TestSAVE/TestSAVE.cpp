@@ -0,0 +1,150 @@
+/* Copyright (c) 2024 Dreamy Cecil
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+// TestSAVE - Saved Game Format Test
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Engine/Engine.h>
+#include <Engine/Base/CRC.h>
+
+// Command line arguments
+static CTString _strSave;
+
+// Parsed arguments
+static INDEX _ctParsedArgs = 0;
+
+// Handle program's launch arguments
+static void HandleInitialArgs(const CommandLineArgs_t &aArgs) {
+  _ctParsedArgs = aArgs.Count();
+  _strSave = aArgs[0];
+};
+
+// Load a saved game and calculate checksum of its state
+static ULONG LoadAndChecksum_t(const CTFileName &fnmSave) {
+  if (_pNetwork->IsServer()) {
+    _pNetwork->StopGame();
+  }
+
+  _pNetwork->Load_t(fnmSave);
+
+  ULONG ulCRC;
+  CRC_Start(ulCRC);
+  _pNetwork->ga_sesSessionState.ChecksumForSync(ulCRC, 1);
+  CRC_Finish(ulCRC);
+  return ulCRC;
+};
+
+// Save the game in a specific format and return time in seconds that the game was stalled for
+static DOUBLE SaveGame_t(const CTFileName &fnmSave, BOOL bCompress, BOOL bAsync) {
+  _pShell->SetINDEX("gam_bCompressSaves", bCompress);
+  _pShell->SetINDEX("gam_bAsyncSaves", bAsync);
+
+  const CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+  _pNetwork->Save_t(fnmSave);
+  return (_pTimer->GetHighPrecisionTimer() - tvStart).GetSeconds();
+};
+
+// Get size of a file in bytes
+static SLONG GetSaveSize_t(const CTFileName &fnmSave) {
+  CTFileStream strm;
+  strm.Open_t(fnmSave);
+  return strm.GetStreamSize();
+};
+
+void SubMain(int argc, char **argv) {
+  // Parse command line arguments
+  {
+    CommandLineSetup cmd(argc, argv);
+    cmd.AddInitialParser(&HandleInitialArgs, 1);
+    SE_ParseCommandLine(cmd);
+  }
+
+  printf("\nTestSAVE - Saved Game Format Test\n\n");
+
+  // Command line output in the console
+  printf("%s", SE_CommandLineOutput().ConstData());
+
+  if (_ctParsedArgs != 1)
+  {
+    printf("USAGE: TestSAVE <save>\n");
+    printf("\n");
+    printf("save: saved game relative to the game directory (in either format)\n");
+    printf("\n");
+    printf("NOTES: - the game is saved again in the old uncompressed format and in the new compressed format\n");
+    printf("         under the Temp directory, then both files are loaded back\n");
+    printf("       - state checksums of all three loaded games must match\n");
+    printf("       - prints time that the game is stalled for while saving in each format\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // Initialize engine
+  SeriousEngineSetup se1setup("TestSAVE");
+  se1setup.eAppType = SeriousEngineSetup::E_OTHER;
+  SE_InitEngine(se1setup);
+
+  const CTFileName fnmLegacy = CTString("Temp\\TestSAVE_Legacy.sav");
+  const CTFileName fnmCompressed = CTString("Temp\\TestSAVE_Compressed.sav");
+
+  ULONG ulOriginal, ulLegacy, ulCompressed;
+
+  try {
+    ulOriginal = LoadAndChecksum_t(_strSave);
+    printf("- Loaded '%s' (checksum 0x%08X).\n", _strSave.ConstData(), ulOriginal);
+
+    // Save in both formats
+    const DOUBLE dLegacy = SaveGame_t(fnmLegacy, FALSE, FALSE);
+
+    const DOUBLE dCompressed = SaveGame_t(fnmCompressed, TRUE, TRUE);
+    const CTimerValue tvWrite = _pTimer->GetHighPrecisionTimer();
+    _pNetwork->FinishSaving_t();
+    const DOUBLE dWrite = (_pTimer->GetHighPrecisionTimer() - tvWrite).GetSeconds();
+
+    printf("- Uncompressed: %d bytes, game stalled for %.1f ms\n", GetSaveSize_t(fnmLegacy), dLegacy * 1000.0);
+    printf("- Compressed: %d bytes, game stalled for %.1f ms (%.1f ms more in the background)\n",
+      GetSaveSize_t(fnmCompressed), dCompressed * 1000.0, dWrite * 1000.0);
+
+    // Load both of them back
+    ulLegacy = LoadAndChecksum_t(fnmLegacy);
+    ulCompressed = LoadAndChecksum_t(fnmCompressed);
+
+    _pNetwork->StopGame();
+
+  } catch (char *strError) {
+    printf("! Test failed:\n  %s\n", strError);
+    exit(EXIT_FAILURE);
+  }
+
+  printf("- Checksums: original 0x%08X, uncompressed 0x%08X, compressed 0x%08X\n", ulOriginal, ulLegacy, ulCompressed);
+
+  if (ulOriginal != ulLegacy || ulLegacy != ulCompressed) {
+    printf("! Checksums don't match!\n");
+    exit(EXIT_FAILURE);
+  }
+
+  printf("- OK\n");
+  exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char **argv) {
+  CTSTREAM_BEGIN {
+    SubMain(argc, argv);
+  } CTSTREAM_END;
+
+  return 0;
+}